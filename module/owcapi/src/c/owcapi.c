@@ -25,6 +25,17 @@
 static ssize_t OW_init_both(const char *params, enum restart_init repeat) ;
 static ssize_t OW_init_args_both(int argc, char **argv, enum restart_init repeat);
 
+/* Form of the values wanted by OW_get_double, OW_get_int and OW_get_bool */
+enum value_form {
+	value_form_double,
+	value_form_long,
+	value_form_bool,
+} ;
+
+static ssize_t OW_get_value(const char *path, enum value_form form, void *values, size_t count) ;
+static SIZE_OR_ERROR OW_value_binary(const BYTE * data, size_t length, enum value_form form, void *values, size_t count) ;
+static SIZE_OR_ERROR OW_value_text(const char * text, enum value_form form, void *values, size_t count) ;
+
 static ssize_t ReturnAndErrno(ssize_t ret)
 {
 	if (ret < 0) {
@@ -115,6 +126,40 @@ ssize_t OW_get(const char *path, char **return_buffer, size_t * buffer_length)
 	return ReturnAndErrno(size_or_error);
 }
 
+ssize_t OW_get_many(const char **paths, size_t count, char **return_buffers, ssize_t * buffer_lengths)
+{
+	SIZE_OR_ERROR size_or_error = -EACCES ;		/* number of values read */
+	SIZE_OR_ERROR * lengths ;
+	size_t i ;
+
+	/* Check the parameters */
+	if (paths == NULL || return_buffers == NULL || count > INT_MAX) {
+		return ReturnAndErrno(-EINVAL);
+	}
+
+	for ( i = 0 ; i < count ; ++i ) {
+		return_buffers[i] = NULL ;		/* default return string on error */
+	}
+
+	lengths = owcalloc( count+1, sizeof(SIZE_OR_ERROR) ) ;
+	if ( lengths == NULL ) {
+		return ReturnAndErrno(-ENOMEM);
+	}
+
+	if (API_access_start() == 0) {	/* Check for prior init */
+		size_or_error = FS_get_many( paths, (int) count, return_buffers, lengths );
+		API_access_end();
+	}
+
+	if ( buffer_lengths != NULL ) {
+		for ( i = 0 ; i < count ; ++i ) {
+			buffer_lengths[i] = ( size_or_error < 0 ) ? size_or_error : lengths[i] ;
+		}
+	}
+	owfree( lengths ) ;
+	return ReturnAndErrno(size_or_error);
+}
+
 int OW_present(const char *path)
 {
 	ssize_t ret = -ENOENT;		/* current buffer string length */
@@ -181,6 +226,232 @@ ssize_t OW_put(const char *path, const char *buffer, size_t buffer_length)
 	return ReturnAndErrno(ret);
 }
 
+ssize_t OW_get_double(const char *path, double *values, size_t count)
+{
+	return OW_get_value(path, value_form_double, values, count);
+}
+
+ssize_t OW_get_int(const char *path, long *values, size_t count)
+{
+	return OW_get_value(path, value_form_long, values, count);
+}
+
+ssize_t OW_get_bool(const char *path, int *values, size_t count)
+{
+	return OW_get_value(path, value_form_bool, values, count);
+}
+
+ssize_t OW_get_bytes(const char *path, unsigned char *buffer, size_t size)
+{
+	ssize_t ret = -EACCES;
+
+	/* Check the parameters */
+	if (buffer == NULL || path == NULL) {
+		return ReturnAndErrno(-EINVAL);
+	}
+
+	if (API_access_start() == 0) {
+		ret = FS_read(path, (char *) buffer, size, 0);
+		API_access_end();
+	}
+	return ReturnAndErrno(ret);
+}
+
+/* Read with the VALUE_BINARY control flag -- numbers come back unformatted */
+static ssize_t OW_get_value(const char *path, enum value_form form, void *values, size_t count)
+{
+	ssize_t ret = -EACCES;
+
+	/* Check the parameters */
+	if (values == NULL || path == NULL || count == 0) {
+		return ReturnAndErrno(-EINVAL);
+	}
+
+	if (API_access_start() == 0) {
+		struct one_wire_query *owq = OWQ_create_from_path(path);
+		if (owq == NO_ONE_WIRE_QUERY) {
+			ret = -ENOENT;
+		} else {
+			PN(owq)->control_flags |= VALUE_BINARY;
+			if (BAD(OWQ_allocate_read_buffer(owq))) {
+				ret = -ENOMEM;
+			} else {
+				ret = FS_read_postparse(owq);
+				if (ret >= 0) {
+					BYTE *data = (BYTE *) OWQ_buffer(owq);
+					if (ret > 0 && data[0] >= value_binary_float && data[0] <= value_binary_date) {
+						ret = OW_value_binary(data, ret, form, values, count);
+					} else {
+						// text: not a number property, or an owserver without binary values
+						OWQ_buffer(owq)[ret] = '\0';
+						ret = OW_value_text(OWQ_buffer(owq), form, values, count);
+					}
+				}
+			}
+			OWQ_destroy(owq);
+		}
+		API_access_end();
+	}
+	return ReturnAndErrno(ret);
+}
+
+static SIZE_OR_ERROR OW_value_binary(const BYTE * data, size_t length, enum value_form form, void *values, size_t count)
+{
+	enum value_binary_type type = data[0];
+	size_t elements = (length - 1) / VALUE_BINARY_ELEMENT;
+	size_t element;
+
+	if (elements * VALUE_BINARY_ELEMENT != length - 1) {
+		return -EBADMSG;
+	}
+	switch (form) {
+	case value_form_long:
+		if (type == value_binary_float) {
+			return -EINVAL;
+		}
+		break;
+	case value_form_bool:
+		if (type != value_binary_yesno) {
+			return -EINVAL;
+		}
+		break;
+	case value_form_double:
+		break;
+	}
+
+	if (elements > count) {
+		elements = count;
+	}
+	for (element = 0; element < elements; ++element) {
+		const BYTE *b = &data[1 + VALUE_BINARY_ELEMENT * element];
+		uint64_t bits = 0;
+		double F;
+		int i;
+
+		for (i = 0; i < VALUE_BINARY_ELEMENT; ++i) {
+			bits = (bits << 8) | b[i];
+		}
+		switch (type) {
+		case value_binary_float:
+			memcpy(&F, &bits, sizeof(F));
+			break;
+		case value_binary_unsigned:
+		case value_binary_yesno:
+			F = (double) bits;
+			break;
+		default:
+			F = (double) (int64_t) bits;
+			break;
+		}
+		switch (form) {
+		case value_form_double:
+			((double *) values)[element] = F;
+			break;
+		case value_form_long:
+			((long *) values)[element] = (type == value_binary_unsigned) ? (long) bits : (long) (int64_t) bits;
+			break;
+		case value_form_bool:
+			((int *) values)[element] = (bits != 0);
+			break;
+		}
+	}
+	return elements;
+}
+
+/* Comma separated numbers, as OW_get would return them */
+static SIZE_OR_ERROR OW_value_text(const char * text, enum value_form form, void *values, size_t count)
+{
+	size_t elements = 0;
+
+	while (elements < count) {
+		char *end;
+		double F = 0.;
+		long L = 0;
+
+		errno = 0;
+		if (form == value_form_double) {
+			F = strtod(text, &end);
+		} else {
+			L = strtol(text, &end, 10);
+		}
+		if (end == text || errno != 0) {
+			return -EINVAL;
+		}
+		while (*end == ' ') {
+			++end;
+		}
+		switch (form) {
+		case value_form_double:
+			((double *) values)[elements] = F;
+			break;
+		case value_form_long:
+			((long *) values)[elements] = L;
+			break;
+		case value_form_bool:
+			if (L != 0 && L != 1) {
+				return -EINVAL;
+			}
+			((int *) values)[elements] = (int) L;
+			break;
+		}
+		++elements;
+		if (*end == '\0') {
+			break;
+		} else if (*end != ',') {
+			return -EINVAL;			// not a number of this form
+		}
+		text = end + 1;
+	}
+	return elements;
+}
+
+OW_HANDLE OW_open_handle(const char *path)
+{
+	struct property_handle * handle = NULL;
+	ssize_t ret = -EACCES;
+
+	/* Check the parameters */
+	if (path == NULL) {
+		ReturnAndErrno(-EINVAL);
+		return NULL;
+	}
+
+	if (API_access_start() == 0) {
+		ret = FS_handle_open(path, &handle);
+		API_access_end();
+	}
+	ReturnAndErrno(ret);
+	return handle;
+}
+
+ssize_t OW_read_handle(OW_HANDLE handle, char *buffer, size_t size)
+{
+	ssize_t ret = -EACCES;
+
+	/* Check the parameters */
+	if (handle == NULL || buffer == NULL) {
+		return ReturnAndErrno(-EINVAL);
+	}
+
+	if (API_access_start() == 0) {
+		ret = FS_handle_read(handle, buffer, size);
+		API_access_end();
+	}
+	return ReturnAndErrno(ret);
+}
+
+void OW_close_handle(OW_HANDLE handle)
+{
+	if (handle == NULL) {
+		return;
+	}
+
+	if (API_access_start() == 0) {
+		FS_handle_close(handle);
+		API_access_end();
+	}
+}
+
 void OW_finish(void)
 {
 	
@@ -79,6 +79,52 @@ extern "C" {
 	 */
 	ssize_t OW_get(const char *path, char **buffer, size_t * buffer_length);
 
+	/* OW_get_many -- read several properties at once
+	   paths is an array of count OWFS style names (file properties, not directories)
+	   Properties of the same device are read together with a single device lock
+
+	   buffers is an array of count char pointers, each assigned by OW_get_many.
+	   Each non-NULL buffers[i] MUST BE "free"ed after use.
+	   buffers[i] is NULL if that read failed
+	   buffer_lengths, if not NULL, is an array of count values:
+	   the length of each returned value, or <0 (negative errno) for that read's error
+
+	   return value >=0 ok, number of values successfully read
+	   <0 error
+	 */
+	ssize_t OW_get_many(const char **paths, size_t count, char **buffers, ssize_t * buffer_lengths);
+
+	/* OW_get_double, OW_get_int, OW_get_bool -- numeric property read, no text
+	   path is OWFS style name of a number, yes/no or date property
+	   "10.468ACE13579B/temperature" one value
+	   "20.468ACE13579B/volt.ALL" every element
+
+	   values is an array of count entries, filled from the start
+	   Temperatures and pressures are in the current scale
+	   Dates are seconds since the epoch (OW_get_int or OW_get_double)
+	   OW_get_int needs an integer, unsigned, yes/no or date property
+	   OW_get_bool needs a yes/no property (1 or 0)
+
+	   Values come without ascii formatting and parsing, also from an owserver
+	   that supports it (older ones send text, which is read the same way)
+
+	   return value >=0 ok, number of values assigned
+	   <0 error (EINVAL for a property of another type)
+	 */
+	ssize_t OW_get_double(const char *path, double *values, size_t count);
+	ssize_t OW_get_int(const char *path, long *values, size_t count);
+	ssize_t OW_get_bool(const char *path, int *values, size_t count);
+
+	/* OW_get_bytes -- whole property read into a caller buffer
+	   for binary and ascii properties (memory pages, ids...) as they are
+
+	   buffer must be size long
+
+	   return value >=0 ok, number of bytes
+	   <0 error
+	 */
+	ssize_t OW_get_bytes(const char *path, unsigned char *buffer, size_t size);
+
 	/* OW_present -- check if path is present
 	   path is OWFS style name,
 	   "" or "/" for root directory
@@ -129,6 +175,26 @@ extern "C" {
 */
 	ssize_t OW_lwrite(const char *path, const char *buf, const size_t size, const off_t offset);
 
+/* Property handles -- for reading the same properties over and over
+  OW_open_handle parses the path and finds the device once
+    path is OWFS style name of a property (not a directory)
+    "10.468ACE13579B/temperature"
+    returns NULL on error (errno set)
+  OW_read_handle reads the whole value into buffer, like OW_lread at offset 0
+    without parsing the path or searching for the device again.
+    If the device has moved to another bus it is found again.
+    buffer must be size long
+    return value >=0 ok, length of value
+    <0 error
+  OW_close_handle frees the handle -- call before OW_finish
+
+  A handle is for one thread at a time
+*/
+	typedef struct property_handle * OW_HANDLE;
+	OW_HANDLE OW_open_handle(const char *path);
+	ssize_t OW_read_handle(OW_HANDLE handle, char *buffer, size_t size);
+	void OW_close_handle(OW_HANDLE handle);
+
 /* cleanup
   Clears internal buffer, frees file descriptors
   Normal process cleanup will work if program ends before OW_finish is called
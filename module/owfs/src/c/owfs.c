@@ -110,7 +110,7 @@ int main(int argc, char *argv[])
 	/* Set up "command line" for main fuse routines */
 	Fuse_setup(&fuse_options);	// command line setup
 	Fuse_add(Outbound_Control.head->name, &fuse_options);	// mount point
-#if FUSE_VERSION >= 22
+#if FUSE_VERSION >= 22 && ! OWFS_LOWLEVEL
 	Fuse_add("-o", &fuse_options);	// add "-o direct_io" to prevent buffering
 	Fuse_add("direct_io", &fuse_options);
 #endif							/* FUSE_VERSION >= 22 */
@@ -144,7 +144,10 @@ int main(int argc, char *argv[])
 	}
 
 
-#if FUSE_VERSION > 25
+#if OWFS_LOWLEVEL
+	// direct_io and cache timeouts are chosen per file
+	Fuse_lowlevel_main(fuse_options.argc, fuse_options.argv);
+#elif FUSE_VERSION > 25
 	fuse_main(fuse_options.argc, fuse_options.argv, &owfs_oper, NULL);
 #else							/* FUSE_VERSION <= 25 */
 	fuse_main(fuse_options.argc, fuse_options.argv, &owfs_oper);
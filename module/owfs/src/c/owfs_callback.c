@@ -121,8 +121,14 @@ static int FS_chown(const char *path, uid_t uid, gid_t gid)
 static int FS_open(const char *path, FUSEFLAG flags)
 {
 #if FUSE_VERSION < 23
+	// no init callback, so the first open is the first call after the fork
+	static int threads_started = 0;
 	if (!pid_created)
 		PIDstart();
+	if (!threads_started) {
+		threads_started = 1;
+		LibStartThreads();
+	}
 #endif							/* FUSE_VERSION < 23 */
 	LEVEL_CALL("OPEN path=%s", SAFESTRING(path));
 	(void) flags;
@@ -251,6 +257,8 @@ static void *FS_init(void)
 {
 #endif							/* FUSE_VERSION > 25 */
 	PIDstart();
+	// after fuse_main has forked, the threads wouldn't survive it
+	LibStartThreads();
 	return VOID_RETURN;
 }
 #endif							/* FUSE_VERSION > 22 */
@@ -0,0 +1,1096 @@
+/*
+    OW -- One-Wire filesystem
+
+    FUSE low-level interface
+
+    The kernel caches names and attributes for as long as we say,
+    so each node gets timeouts from how often its property changes
+    (the fc_change class of the filetype). Static properties (family,
+    address...) can be kept in the page cache as well.
+
+    inode numbers map to owfs paths (never reused)
+    open files keep their path and a snapshot of the value
+      so partial reads (and the read at end-of-file) don't go back to the bus
+    open directories keep their listing for the readdir calls
+
+    Reads, writes and directory listings of a 1-wire bus go to a queue
+    for that bus (--fuse_workers threads each), so a slow bus only
+    holds up its own requests and not every FUSE thread
+
+    Devices added or removed (the owlib registry) are passed to the kernel
+    so stale directory entries don't wait for their timeout (FUSE 2.8+)
+
+    Written 2003 Paul H Alfille
+*/
+
+#include "owfs.h"
+#include "ow_pid.h"
+
+#if OWFS_LOWLEVEL
+
+#include <fuse_lowlevel.h>
+
+/* ---------------------------------------------- */
+/* inode <-> path table                           */
+/* ---------------------------------------------- */
+#define INODE_BUCKETS  1024
+
+struct owfs_inode {
+	struct owfs_inode * next_by_path ;
+	struct owfs_inode * next_by_ino ;
+	fuse_ino_t ino ;
+	unsigned long lookups ; // kernel references, freed at 0 (forget)
+	unsigned int hash ;
+	char path[] ;
+} ;
+
+static struct owfs_inode * inode_by_path[INODE_BUCKETS] ;
+static struct owfs_inode * inode_by_ino[INODE_BUCKETS] ;
+static fuse_ino_t inode_next = FUSE_ROOT_ID + 1 ;
+static pthread_mutex_t inode_mutex = PTHREAD_MUTEX_INITIALIZER ;
+
+#define INODELOCK      _MUTEX_LOCK(   inode_mutex )
+#define INODEUNLOCK    _MUTEX_UNLOCK( inode_mutex )
+
+/* bus serving a request -- the instance tells a re-added bus from the old one */
+struct owfs_bus {
+	INDEX_OR_ERROR index ; // or INDEX_BAD to serve directly
+	UINT instance ;
+} ;
+
+/* open file */
+struct owfs_file {
+	pthread_mutex_t lock ; // one handle can be read by several threads
+	char * path ;
+	struct property_handle * handle ; // parsed query, made at the first read (under lock)
+	char * snapshot ; // value read at first read
+	SIZE_OR_ERROR snapshot_size ; // or error
+	int have_snapshot ;
+	size_t length ; // FullFileLength
+	struct owfs_bus bus ; // queue serving this file
+} ;
+
+/* open directory */
+struct owfs_dir {
+	int count ;
+	int allocated ;
+	char ** name ;
+	mode_t * mode ;
+} ;
+
+static unsigned int Inode_hash( const char * path )
+{
+	unsigned int hash = 5381 ;
+	for ( ; *path != '\0' ; ++path ) {
+		hash = ( hash * 33 ) ^ (unsigned char) *path ;
+	}
+	return hash ;
+}
+
+/* Find or create the inode for path and add a kernel reference */
+static fuse_ino_t Inode_Get( const char * path )
+{
+	unsigned int hash = Inode_hash( path ) ;
+	struct owfs_inode * node ;
+
+	if ( strcmp( path, "/" ) == 0 ) {
+		return FUSE_ROOT_ID ;
+	}
+
+	INODELOCK ;
+	for ( node = inode_by_path[hash % INODE_BUCKETS] ; node != NULL ; node = node->next_by_path ) {
+		if ( node->hash == hash && strcmp( node->path, path ) == 0 ) {
+			++node->lookups ;
+			INODEUNLOCK ;
+			return node->ino ;
+		}
+	}
+
+	node = owmalloc( sizeof( struct owfs_inode ) + strlen( path ) + 1 ) ;
+	if ( node == NULL ) {
+		INODEUNLOCK ;
+		return 0 ;
+	}
+	node->ino = inode_next++ ;
+	node->lookups = 1 ;
+	node->hash = hash ;
+	strcpy( node->path, path ) ;
+	node->next_by_path = inode_by_path[hash % INODE_BUCKETS] ;
+	inode_by_path[hash % INODE_BUCKETS] = node ;
+	node->next_by_ino = inode_by_ino[node->ino % INODE_BUCKETS] ;
+	inode_by_ino[node->ino % INODE_BUCKETS] = node ;
+	INODEUNLOCK ;
+
+	return node->ino ;
+}
+
+/* Copy the path of an inode into path (PATH_MAX+1) */
+static GOOD_OR_BAD Inode_Path( fuse_ino_t ino, char * path )
+{
+	struct owfs_inode * node ;
+
+	if ( ino == FUSE_ROOT_ID ) {
+		strcpy( path, "/" ) ;
+		return gbGOOD ;
+	}
+
+	INODELOCK ;
+	for ( node = inode_by_ino[ino % INODE_BUCKETS] ; node != NULL ; node = node->next_by_ino ) {
+		if ( node->ino == ino ) {
+			strcpy( path, node->path ) ;
+			INODEUNLOCK ;
+			return gbGOOD ;
+		}
+	}
+	INODEUNLOCK ;
+	LEVEL_DEBUG("Unknown inode %lu", (unsigned long) ino ) ;
+	return gbBAD ;
+}
+
+/* Inode of path if the kernel knows it, without adding a reference, else 0 */
+static fuse_ino_t Inode_Find( const char * path )
+{
+	unsigned int hash = Inode_hash( path ) ;
+	struct owfs_inode * node ;
+	fuse_ino_t ino = 0 ;
+
+	INODELOCK ;
+	for ( node = inode_by_path[hash % INODE_BUCKETS] ; node != NULL ; node = node->next_by_path ) {
+		if ( node->hash == hash && strcmp( node->path, path ) == 0 ) {
+			ino = node->ino ;
+			break ;
+		}
+	}
+	INODEUNLOCK ;
+	return ino ;
+}
+
+/* Kernel dropped nlookup references */
+static void Inode_Forget( fuse_ino_t ino, unsigned long nlookup )
+{
+	struct owfs_inode ** link ;
+
+	if ( ino == FUSE_ROOT_ID ) {
+		return ;
+	}
+
+	INODELOCK ;
+	for ( link = &inode_by_ino[ino % INODE_BUCKETS] ; *link != NULL ; link = &((*link)->next_by_ino) ) {
+		struct owfs_inode * node = *link ;
+		struct owfs_inode ** path_link ;
+
+		if ( node->ino != ino ) {
+			continue ;
+		}
+		if ( node->lookups > nlookup ) {
+			node->lookups -= nlookup ;
+			break ;
+		}
+		// last reference
+		*link = node->next_by_ino ;
+		for ( path_link = &inode_by_path[node->hash % INODE_BUCKETS] ; *path_link != NULL ; path_link = &((*path_link)->next_by_path) ) {
+			if ( *path_link == node ) {
+				*path_link = node->next_by_path ;
+				break ;
+			}
+		}
+		owfree( node ) ;
+		break ;
+	}
+	INODEUNLOCK ;
+}
+
+/* ---------------------------------------------- */
+/* Cache timeouts                                 */
+/* ---------------------------------------------- */
+/* How long the kernel can trust a name or attributes */
+static double Owfs_timeout( const struct parsedname * pn )
+{
+	if ( ! NotUncachedDir( pn ) ) {
+		// asked for fresh data
+		return 0. ;
+	}
+	if ( IsDir( pn ) ) {
+		return (double) Globals.timeout_directory ;
+	}
+	switch ( pn->selected_filetype->change ) {
+		case fc_static:
+		case fc_stable:
+		case fc_read_stable:
+		case fc_persistent:
+		case fc_presence:
+		case fc_link:
+		case fc_page:
+			return (double) Globals.timeout_stable ;
+		case fc_volatile:
+		case fc_simultaneous_temperature:
+		case fc_simultaneous_voltage:
+			return (double) Globals.timeout_volatile ;
+		case fc_uncached:
+		case fc_second:
+		case fc_statistic:
+		default:
+			return 0. ;
+	}
+}
+
+/* Only values that never change can live in the page cache */
+static int Owfs_keep_cache( const struct parsedname * pn )
+{
+	return NotUncachedDir( pn ) && ! IsDir( pn ) && pn->selected_filetype->change == fc_static ;
+}
+
+/* ---------------------------------------------- */
+/* Per-bus request queues                         */
+/* ---------------------------------------------- */
+enum owfs_job_type { job_read, job_write, job_opendir, } ;
+
+struct owfs_job {
+	struct owfs_job * next ;
+	enum owfs_job_type type ;
+	fuse_req_t req ;
+	struct fuse_file_info fi ;
+	size_t size ;
+	off_t offset ;
+	char * data ; // write data or opendir path
+} ;
+
+struct bus_queue {
+	struct bus_queue * next ;
+	struct owfs_bus bus ;
+	pthread_mutex_t lock ;
+	pthread_cond_t cond ;
+	struct owfs_job * head ;
+	struct owfs_job * tail ;
+	UINT depth ;
+	UINT max_depth ;
+} ;
+
+// queues are created on first use and kept. They are keyed by the bus
+// instance, not the bus number: a removed bus gives its number back, and
+// the next bus to take that number gets a queue of its own.
+static struct bus_queue * bus_queue_head = NULL ;
+static pthread_mutex_t bus_queue_mutex = PTHREAD_MUTEX_INITIALIZER ;
+
+static void File_read( fuse_req_t req, struct owfs_file * file, size_t size, off_t offset ) ;
+static void File_write( fuse_req_t req, struct owfs_file * file, const char * buffer, size_t size, off_t offset ) ;
+static void Dir_open( fuse_req_t req, const char * path, struct fuse_file_info * fi ) ;
+
+/* The bus whose queue serves this path, index INDEX_BAD to serve it directly */
+static struct owfs_bus Owfs_bus( const struct parsedname * pn )
+{
+	struct owfs_bus bus = { INDEX_BAD, 0, } ;
+
+	if ( Globals.fuse_workers < 1 || pn->type != ePN_real || pn->selected_connection == NO_CONNECTION ) {
+		// statistics, settings, structure are internal
+		return bus ;
+	}
+	if ( pn->selected_device == NO_DEVICE && ! KnownBus( pn ) ) {
+		// root directory spans all the buses
+		return bus ;
+	}
+	bus.index = pn->selected_connection->index ;
+	bus.instance = pn->selected_connection->instance ;
+	return bus ;
+}
+
+/* Show the queue in /bus.n/interface/statistics/queue */
+static void Queue_stat( struct owfs_bus bus, UINT depth, UINT max_depth, int queued )
+{
+	struct connection_in * in ;
+	int reader = Connection_Read_Begin() ;
+
+	in = find_connection_in( bus.index ) ;
+	if ( in != NO_CONNECTION && in->instance == bus.instance ) {
+		in->bus_stat[e_bus_queue_depth] = depth ;
+		in->bus_stat[e_bus_queue_max] = max_depth ;
+		if ( queued ) {
+			STAT_ADD1_BUS( e_bus_queued, in ) ;
+		}
+	}
+	Connection_Read_End( reader ) ;
+}
+
+static void Job_run( struct owfs_job * job )
+{
+	switch ( job->type ) {
+		case job_read:
+			File_read( job->req, (struct owfs_file *) (uintptr_t) job->fi.fh, job->size, job->offset ) ;
+			break ;
+		case job_write:
+			File_write( job->req, (struct owfs_file *) (uintptr_t) job->fi.fh, job->data, job->size, job->offset ) ;
+			break ;
+		case job_opendir:
+			Dir_open( job->req, job->data, &(job->fi) ) ;
+			break ;
+	}
+	SAFEFREE( job->data ) ;
+	owfree( job ) ;
+}
+
+static void * Queue_worker( void * v )
+{
+	struct bus_queue * bq = v ;
+
+	DETACH_THREAD ;
+
+	while ( 1 ) {
+		struct owfs_job * job ;
+		UINT depth ;
+		UINT max_depth ;
+
+		_MUTEX_LOCK( bq->lock ) ;
+		while ( bq->head == NULL ) {
+			my_pthread_cond_wait( &(bq->cond), &(bq->lock) ) ;
+		}
+		job = bq->head ;
+		bq->head = job->next ;
+		if ( bq->head == NULL ) {
+			bq->tail = NULL ;
+		}
+		depth = --bq->depth ;
+		max_depth = bq->max_depth ;
+		_MUTEX_UNLOCK( bq->lock ) ;
+
+		Queue_stat( bq->bus, depth, max_depth, 0 ) ;
+		Job_run( job ) ;
+	}
+	return VOID_RETURN ;
+}
+
+/* Find the queue for a bus, starting its workers the first time */
+static struct bus_queue * Queue_find( struct owfs_bus bus )
+{
+	struct bus_queue * bq ;
+	int worker ;
+
+	_MUTEX_LOCK( bus_queue_mutex ) ;
+	for ( bq = bus_queue_head ; bq != NULL ; bq = bq->next ) {
+		if ( bq->bus.instance == bus.instance ) {
+			_MUTEX_UNLOCK( bus_queue_mutex ) ;
+			return bq ;
+		}
+	}
+
+	bq = owcalloc( 1, sizeof( struct bus_queue ) ) ;
+	if ( bq == NULL ) {
+		_MUTEX_UNLOCK( bus_queue_mutex ) ;
+		return NULL ;
+	}
+	bq->bus = bus ;
+	_MUTEX_INIT( bq->lock ) ;
+	my_pthread_cond_init( &(bq->cond), NULL ) ;
+
+	for ( worker = 0 ; worker < Globals.fuse_workers ; ++worker ) {
+		pthread_t thread ;
+		if ( pthread_create( &thread, DEFAULT_THREAD_ATTR, Queue_worker, bq ) != 0 ) {
+			ERROR_DEBUG( "Cannot start worker for bus.%d", (int) bus.index ) ;
+			break ;
+		}
+	}
+	if ( worker == 0 ) {
+		// no threads, serve directly
+		_MUTEX_DESTROY( bq->lock ) ;
+		my_pthread_cond_destroy( &(bq->cond) ) ;
+		owfree( bq ) ;
+		_MUTEX_UNLOCK( bus_queue_mutex ) ;
+		return NULL ;
+	}
+	LEVEL_DEBUG( "%d workers serve bus.%d", worker, (int) bus.index ) ;
+
+	bq->next = bus_queue_head ;
+	bus_queue_head = bq ;
+	_MUTEX_UNLOCK( bus_queue_mutex ) ;
+	return bq ;
+}
+
+/* Hand the job to the bus workers, or run it here if there are none */
+static void Queue_job( struct owfs_bus bus, struct owfs_job * job )
+{
+	struct bus_queue * bq = ( bus.index == INDEX_BAD ) ? NULL : Queue_find( bus ) ;
+	UINT depth ;
+	UINT max_depth ;
+
+	if ( bq == NULL ) {
+		Job_run( job ) ;
+		return ;
+	}
+
+	job->next = NULL ;
+	_MUTEX_LOCK( bq->lock ) ;
+	if ( bq->tail == NULL ) {
+		bq->head = job ;
+	} else {
+		bq->tail->next = job ;
+	}
+	bq->tail = job ;
+	depth = ++bq->depth ;
+	if ( depth > bq->max_depth ) {
+		bq->max_depth = depth ;
+	}
+	max_depth = bq->max_depth ;
+	my_pthread_cond_signal( &(bq->cond) ) ;
+	_MUTEX_UNLOCK( bq->lock ) ;
+
+	Queue_stat( bus, depth, max_depth, 1 ) ;
+}
+
+static struct owfs_job * Job_new( fuse_req_t req, enum owfs_job_type type, struct fuse_file_info * fi, size_t size, off_t offset )
+{
+	struct owfs_job * job = owcalloc( 1, sizeof( struct owfs_job ) ) ;
+	if ( job == NULL ) {
+		fuse_reply_err( req, ENOMEM ) ;
+		return NULL ;
+	}
+	job->type = type ;
+	job->req = req ;
+	job->fi = *fi ;
+	job->size = size ;
+	job->offset = offset ;
+	return job ;
+}
+
+/* ---------------------------------------------- */
+/* Device changes                                 */
+/* ---------------------------------------------- */
+#if FUSE_VERSION >= 28
+/* Registry watchers are called from whichever thread searched the bus,
+   possibly serving a request, so the kernel is told from a thread of our own */
+struct owfs_change {
+	struct owfs_change * next ;
+	INDEX_OR_ERROR bus ;
+	BYTE sn[SERIAL_NUMBER_SIZE] ;
+} ;
+
+static struct fuse_chan * change_channel = NULL ;
+static struct owfs_change * change_head = NULL ;
+static pthread_mutex_t change_mutex = PTHREAD_MUTEX_INITIALIZER ;
+static pthread_cond_t change_cond ;
+
+static void Change_entry( fuse_ino_t parent, const char * name )
+{
+	int err = fuse_lowlevel_notify_inval_entry( change_channel, parent, name, strlen( name ) ) ;
+	if ( err != 0 && err != -ENOENT ) {
+		LEVEL_DEBUG( "Cannot invalidate %s (%d)", name, err ) ;
+	}
+}
+
+static void * Change_thread( void * v )
+{
+	(void) v ;
+	DETACH_THREAD ;
+
+	while ( 1 ) {
+		struct owfs_change * change ;
+		struct parsedname s_pn ;
+		char name[PROPERTY_LENGTH_ALIAS + 1] ;
+		char bus_path[32] ;
+		fuse_ino_t bus_ino ;
+
+		_MUTEX_LOCK( change_mutex ) ;
+		while ( change_head == NULL ) {
+			my_pthread_cond_wait( &change_cond, &change_mutex ) ;
+		}
+		change = change_head ;
+		change_head = change->next ;
+		_MUTEX_UNLOCK( change_mutex ) ;
+
+		// name as listed (--format)
+		FS_ParsedName_Placeholder( &s_pn ) ;
+		FS_devicename( name, sizeof( name ), change->sn, &s_pn ) ;
+		Change_entry( FUSE_ROOT_ID, name ) ;
+		snprintf( bus_path, sizeof( bus_path ), "/bus.%d", (int) change->bus ) ;
+		bus_ino = Inode_Find( bus_path ) ;
+		if ( bus_ino != 0 ) {
+			Change_entry( bus_ino, name ) ;
+		}
+		owfree( change ) ;
+	}
+	return VOID_RETURN ;
+}
+
+/* Registry watcher, queue the name for Change_thread */
+static void Change_notify( void * v, INDEX_OR_ERROR bus, const BYTE * sn, int present )
+{
+	struct owfs_change * change = owmalloc( sizeof( struct owfs_change ) ) ;
+
+	(void) v ;
+	(void) present ; // either way the old entry is wrong
+	if ( change == NULL ) {
+		return ;
+	}
+	change->bus = bus ;
+	memcpy( change->sn, sn, SERIAL_NUMBER_SIZE ) ;
+	_MUTEX_LOCK( change_mutex ) ;
+	change->next = change_head ;
+	change_head = change ;
+	my_pthread_cond_signal( &change_cond ) ;
+	_MUTEX_UNLOCK( change_mutex ) ;
+}
+
+static void Change_start( struct fuse_chan * channel )
+{
+	pthread_t thread ;
+
+	change_channel = channel ;
+	my_pthread_cond_init( &change_cond, NULL ) ;
+	if ( pthread_create( &thread, DEFAULT_THREAD_ATTR, Change_thread, NULL ) != 0 ) {
+		ERROR_DEBUG( "Cannot start the device change thread" ) ;
+		return ;
+	}
+	if ( BAD( Registry_Watch( Change_notify, NULL ) ) ) {
+		LEVEL_DEBUG( "Cannot watch for device changes" ) ;
+	}
+}
+#endif							/* FUSE_VERSION >= 28 */
+
+/* ---------------------------------------------- */
+/* Low-level callbacks                            */
+/* ---------------------------------------------- */
+static void LL_init( void * userdata, struct fuse_conn_info * conn )
+{
+	(void) userdata ;
+	(void) conn ;
+	PIDstart();
+}
+
+static void LL_lookup( fuse_req_t req, fuse_ino_t parent, const char * name )
+{
+	char path[PATH_MAX+1] ;
+	struct parsedname pn ;
+	struct fuse_entry_param entry ;
+	size_t length ;
+
+	if ( BAD( Inode_Path( parent, path ) ) ) {
+		fuse_reply_err( req, ENOENT ) ;
+		return ;
+	}
+	length = strlen( path ) ;
+	if ( length + strlen( name ) + 1 > PATH_MAX ) {
+		fuse_reply_err( req, ENAMETOOLONG ) ;
+		return ;
+	}
+	if ( path[length-1] != '/' ) {
+		strcat( path, "/" ) ;
+	}
+	strcat( path, name ) ;
+	LEVEL_CALL("LOOKUP path=%s", path ) ;
+
+	if ( FS_ParsedName( path, &pn ) != 0 ) {
+		fuse_reply_err( req, ENOENT ) ;
+		return ;
+	}
+
+	memset( &entry, 0, sizeof( entry ) ) ;
+	if ( FS_fstat_postparse( &(entry.attr), &pn ) != 0 ) {
+		FS_ParsedName_destroy( &pn ) ;
+		fuse_reply_err( req, ENOENT ) ;
+		return ;
+	}
+	entry.attr_timeout = Owfs_timeout( &pn ) ;
+	entry.entry_timeout = NotUncachedDir( &pn ) ? (double) Globals.timeout_directory : 0. ;
+	FS_ParsedName_destroy( &pn ) ;
+
+	entry.ino = Inode_Get( path ) ;
+	if ( entry.ino == 0 ) {
+		fuse_reply_err( req, ENOMEM ) ;
+		return ;
+	}
+	entry.generation = 1 ;
+	entry.attr.st_ino = entry.ino ;
+	if ( fuse_reply_entry( req, &entry ) != 0 ) {
+		// kernel didn't take the reference
+		Inode_Forget( entry.ino, 1 ) ;
+	}
+}
+
+static void LL_forget( fuse_req_t req, fuse_ino_t ino, unsigned long nlookup )
+{
+	Inode_Forget( ino, nlookup ) ;
+	fuse_reply_none( req ) ;
+}
+
+static void LL_getattr( fuse_req_t req, fuse_ino_t ino, struct fuse_file_info * fi )
+{
+	char path[PATH_MAX+1] ;
+	struct parsedname pn ;
+	struct stat stbuf ;
+	ZERO_OR_ERROR fstat_return ;
+	double timeout ;
+
+	(void) fi ;
+
+	if ( BAD( Inode_Path( ino, path ) ) || FS_ParsedName( path, &pn ) != 0 ) {
+		fuse_reply_err( req, ENOENT ) ;
+		return ;
+	}
+	LEVEL_CALL("GETATTR path=%s", path ) ;
+	fstat_return = FS_fstat_postparse( &stbuf, &pn ) ;
+	timeout = Owfs_timeout( &pn ) ;
+	FS_ParsedName_destroy( &pn ) ;
+
+	if ( fstat_return != 0 ) {
+		fuse_reply_err( req, -fstat_return ) ;
+		return ;
+	}
+	stbuf.st_ino = ino ;
+	fuse_reply_attr( req, &stbuf, timeout ) ;
+}
+
+/* truncate, chmod, chown and utime are accepted and ignored (as before) */
+static void LL_setattr( fuse_req_t req, fuse_ino_t ino, struct stat * attr, int to_set, struct fuse_file_info * fi )
+{
+	(void) attr ;
+	(void) to_set ;
+	LL_getattr( req, ino, fi ) ;
+}
+
+static void LL_open( fuse_req_t req, fuse_ino_t ino, struct fuse_file_info * fi )
+{
+	char path[PATH_MAX+1] ;
+	struct parsedname pn ;
+	struct owfs_file * file ;
+
+	if ( BAD( Inode_Path( ino, path ) ) || FS_ParsedName( path, &pn ) != 0 ) {
+		fuse_reply_err( req, ENOENT ) ;
+		return ;
+	}
+	LEVEL_CALL("OPEN path=%s", path ) ;
+
+	if ( IsDir( &pn ) ) {
+		FS_ParsedName_destroy( &pn ) ;
+		fuse_reply_err( req, EISDIR ) ;
+		return ;
+	}
+
+	file = owcalloc( 1, sizeof( struct owfs_file ) ) ;
+	if ( file == NULL || ( file->path = owstrdup( path ) ) == NULL ) {
+		SAFEFREE( file ) ;
+		FS_ParsedName_destroy( &pn ) ;
+		fuse_reply_err( req, ENOMEM ) ;
+		return ;
+	}
+	_MUTEX_INIT( file->lock ) ;
+	file->length = FullFileLength( &pn ) ;
+	file->bus = Owfs_bus( &pn ) ;
+
+	// changing values must bypass the page cache
+	fi->keep_cache = Owfs_keep_cache( &pn ) ;
+	fi->direct_io = ! fi->keep_cache ;
+	FS_ParsedName_destroy( &pn ) ;
+
+	fi->fh = (uint64_t) (uintptr_t) file ;
+	if ( fuse_reply_open( req, fi ) != 0 ) {
+		// interrupted
+		_MUTEX_DESTROY( file->lock ) ;
+		owfree( file->path ) ;
+		owfree( file ) ;
+	}
+}
+
+/* The path is parsed once per open file, not on every read */
+/* Called with file->lock */
+static ZERO_OR_ERROR File_handle( struct owfs_file * file )
+{
+	if ( file->handle != NULL ) {
+		return 0 ;
+	}
+	return FS_handle_open( file->path, &(file->handle) ) ;
+}
+
+/* Read the whole value once per open (and after a write) */
+/* Called with file->lock */
+static void File_snapshot( struct owfs_file * file )
+{
+	ZERO_OR_ERROR handle_error ;
+
+	file->have_snapshot = 1 ;
+	file->snapshot_size = -ENOMEM ;
+	SAFEFREE( file->snapshot ) ;
+
+	file->snapshot = owmalloc( file->length + 1 ) ;
+	if ( file->snapshot == NULL ) {
+		return ;
+	}
+	handle_error = File_handle( file ) ;
+	if ( handle_error != 0 ) {
+		file->snapshot_size = handle_error ;
+		return ;
+	}
+	file->snapshot_size = FS_handle_read( file->handle, file->snapshot, file->length ) ;
+}
+
+/* Large files (memory) are read piece by piece as before */
+static SIZE_OR_ERROR File_read_direct( struct owfs_file * file, char * buffer, size_t size, off_t offset )
+{
+	SIZE_OR_ERROR read_return ;
+
+	if ( size > MAX_OWSERVER_PROTOCOL_PAYLOAD_SIZE ) {
+		LEVEL_DEBUG( "Requested read length %ld will be trimmed to owfs max %ld",(long int) size, (long int) MAX_OWSERVER_PROTOCOL_PAYLOAD_SIZE ) ;
+		size = MAX_OWSERVER_PROTOCOL_PAYLOAD_SIZE ;
+	}
+	// the handle is for one thread at a time
+	_MUTEX_LOCK( file->lock ) ;
+	read_return = File_handle( file ) ;
+	if ( read_return == 0 ) {
+		read_return = FS_handle_read_offset( file->handle, buffer, size, offset ) ;
+	}
+	_MUTEX_UNLOCK( file->lock ) ;
+	return read_return ;
+}
+
+static void File_read( fuse_req_t req, struct owfs_file * file, size_t size, off_t offset )
+{
+	char * slice = NULL ;
+	SIZE_OR_ERROR slice_size ;
+
+	LEVEL_CALL("READ path=%s size=%ld offset=%ld", file->path, (long int) size, (long int) offset ) ;
+
+	if ( offset >= (off_t) file->length ) {
+		// fuse requests a useless read at end of file -- just return ok.
+		fuse_reply_buf( req, NULL, 0 ) ;
+		return ;
+	}
+
+	if ( file->length > MAX_OWSERVER_PROTOCOL_PAYLOAD_SIZE ) {
+		char * buffer = owmalloc( size ) ;
+		SIZE_OR_ERROR read_return ;
+		if ( buffer == NULL ) {
+			fuse_reply_err( req, ENOMEM ) ;
+			return ;
+		}
+		read_return = File_read_direct( file, buffer, size, offset ) ;
+		if ( read_return < 0 ) {
+			fuse_reply_err( req, -read_return ) ;
+		} else {
+			fuse_reply_buf( req, buffer, read_return ) ;
+		}
+		owfree( buffer ) ;
+		return ;
+	}
+
+	// copy the slice under the lock, reply after -- once the reply is in,
+	// the file can be released (and freed) by another FUSE thread
+
+	_MUTEX_LOCK( file->lock ) ;
+	if ( ! file->have_snapshot || offset == 0 ) {
+		// a read from the start gets a fresh value, later offsets continue the same one
+		File_snapshot( file ) ;
+	}
+	if ( file->snapshot_size < 0 ) {
+		slice_size = file->snapshot_size ;
+	} else if ( offset >= (off_t) file->snapshot_size ) {
+		slice_size = 0 ;
+	} else {
+		size_t available = file->snapshot_size - offset ;
+		slice_size = ( size < available ) ? size : available ;
+		slice = owmalloc( slice_size ) ;
+		if ( slice == NULL ) {
+			slice_size = -ENOMEM ;
+		} else {
+			memcpy( slice, &(file->snapshot[offset]), slice_size ) ;
+		}
+	}
+	_MUTEX_UNLOCK( file->lock ) ;
+
+	if ( slice_size < 0 ) {
+		fuse_reply_err( req, -slice_size ) ;
+	} else {
+		fuse_reply_buf( req, slice, slice_size ) ;
+	}
+	SAFEFREE( slice ) ;
+}
+
+static void LL_read( fuse_req_t req, fuse_ino_t ino, size_t size, off_t offset, struct fuse_file_info * fi )
+{
+	struct owfs_file * file = (struct owfs_file *) (uintptr_t) fi->fh ;
+	struct owfs_job * job ;
+
+	(void) ino ;
+	if ( file->bus.index == INDEX_BAD || offset >= (off_t) file->length ) {
+		File_read( req, file, size, offset ) ;
+		return ;
+	}
+	job = Job_new( req, job_read, fi, size, offset ) ;
+	if ( job != NULL ) {
+		Queue_job( file->bus, job ) ;
+	}
+}
+
+static void File_write( fuse_req_t req, struct owfs_file * file, const char * buffer, size_t size, off_t offset )
+{
+	SIZE_OR_ERROR write_return ;
+
+	write_return = FS_write( file->path, buffer, size, offset ) ;
+
+	_MUTEX_LOCK( file->lock ) ;
+	file->have_snapshot = 0 ; // read back the new value
+	_MUTEX_UNLOCK( file->lock ) ;
+
+	if ( write_return < 0 ) {
+		fuse_reply_err( req, -write_return ) ;
+	} else {
+		fuse_reply_write( req, write_return ) ;
+	}
+}
+
+static void LL_write( fuse_req_t req, fuse_ino_t ino, const char * buffer, size_t size, off_t offset, struct fuse_file_info * fi )
+{
+	struct owfs_file * file = (struct owfs_file *) (uintptr_t) fi->fh ;
+	struct owfs_job * job ;
+
+	(void) ino ;
+	if ( file->bus.index == INDEX_BAD ) {
+		File_write( req, file, buffer, size, offset ) ;
+		return ;
+	}
+	job = Job_new( req, job_write, fi, size, offset ) ;
+	if ( job == NULL ) {
+		return ;
+	}
+	// the buffer belongs to the FUSE thread
+	job->data = owmalloc( size + 1 ) ;
+	if ( job->data == NULL ) {
+		owfree( job ) ;
+		fuse_reply_err( req, ENOMEM ) ;
+		return ;
+	}
+	memcpy( job->data, buffer, size ) ;
+	Queue_job( file->bus, job ) ;
+}
+
+static void LL_release( fuse_req_t req, fuse_ino_t ino, struct fuse_file_info * fi )
+{
+	struct owfs_file * file = (struct owfs_file *) (uintptr_t) fi->fh ;
+
+	(void) ino ;
+	LEVEL_CALL("RELEASE path=%s", file->path ) ;
+	FS_handle_close( file->handle ) ;
+	_MUTEX_DESTROY( file->lock ) ;
+	SAFEFREE( file->snapshot ) ;
+	owfree( file->path ) ;
+	owfree( file ) ;
+	fuse_reply_err( req, 0 ) ;
+}
+
+static void Dir_add( struct owfs_dir * dir, const char * name, mode_t mode )
+{
+	if ( dir->count == dir->allocated ) {
+		int allocated = dir->allocated + 32 ;
+		char ** new_name = owrealloc( dir->name, allocated * sizeof( char * ) ) ;
+		mode_t * new_mode ;
+		if ( new_name == NULL ) {
+			return ;
+		}
+		dir->name = new_name ;
+		new_mode = owrealloc( dir->mode, allocated * sizeof( mode_t ) ) ;
+		if ( new_mode == NULL ) {
+			return ;
+		}
+		dir->mode = new_mode ;
+		dir->allocated = allocated ;
+	}
+	dir->name[dir->count] = owstrdup( name ) ;
+	if ( dir->name[dir->count] != NULL ) {
+		dir->mode[dir->count] = mode ;
+		++dir->count ;
+	}
+}
+
+/* Callback function to FS_dir */
+static void LL_opendir_callback( void * v, const struct parsedname * pn_entry )
+{
+	Dir_add( (struct owfs_dir *) v, FS_DirName( pn_entry ), IsDir( pn_entry ) ? S_IFDIR : S_IFREG ) ;
+}
+
+static void Dir_free( struct owfs_dir * dir )
+{
+	int entry ;
+	for ( entry = 0 ; entry < dir->count ; ++entry ) {
+		owfree( dir->name[entry] ) ;
+	}
+	SAFEFREE( dir->name ) ;
+	SAFEFREE( dir->mode ) ;
+	owfree( dir ) ;
+}
+
+/* The listing is made once, readdir just hands it out */
+static void Dir_list( fuse_req_t req, struct parsedname * pn, struct fuse_file_info * fi )
+{
+	struct owfs_dir * dir = owcalloc( 1, sizeof( struct owfs_dir ) ) ;
+
+	if ( dir == NULL ) {
+		fuse_reply_err( req, ENOMEM ) ;
+		return ;
+	}
+	Dir_add( dir, ".", S_IFDIR ) ;
+	Dir_add( dir, "..", S_IFDIR ) ;
+	FS_dir( LL_opendir_callback, dir, pn ) ;
+
+	fi->fh = (uint64_t) (uintptr_t) dir ;
+	if ( fuse_reply_open( req, fi ) != 0 ) {
+		Dir_free( dir ) ;
+	}
+}
+
+/* Queued directory listing */
+static void Dir_open( fuse_req_t req, const char * path, struct fuse_file_info * fi )
+{
+	struct parsedname pn ;
+
+	if ( FS_ParsedName( path, &pn ) != 0 ) {
+		fuse_reply_err( req, ENOENT ) ;
+		return ;
+	}
+	Dir_list( req, &pn, fi ) ;
+	FS_ParsedName_destroy( &pn ) ;
+}
+
+static void LL_opendir( fuse_req_t req, fuse_ino_t ino, struct fuse_file_info * fi )
+{
+	char path[PATH_MAX+1] ;
+	struct parsedname pn ;
+	struct owfs_job * job ;
+	struct owfs_bus bus ;
+
+	if ( BAD( Inode_Path( ino, path ) ) || FS_ParsedName( path, &pn ) != 0 ) {
+		fuse_reply_err( req, ENOENT ) ;
+		return ;
+	}
+	LEVEL_CALL("OPENDIR path=%s", path ) ;
+
+	if ( pn.selected_filetype != NO_FILETYPE && ! IsDir( &pn ) ) {
+		FS_ParsedName_destroy( &pn ) ;
+		fuse_reply_err( req, ENOTDIR ) ;
+		return ;
+	}
+
+	bus = Owfs_bus( &pn ) ;
+	if ( bus.index == INDEX_BAD ) {
+		Dir_list( req, &pn, fi ) ;
+		FS_ParsedName_destroy( &pn ) ;
+		return ;
+	}
+	FS_ParsedName_destroy( &pn ) ;
+
+	job = Job_new( req, job_opendir, fi, 0, 0 ) ;
+	if ( job == NULL ) {
+		return ;
+	}
+	job->data = owstrdup( path ) ;
+	if ( job->data == NULL ) {
+		owfree( job ) ;
+		fuse_reply_err( req, ENOMEM ) ;
+		return ;
+	}
+	Queue_job( bus, job ) ;
+}
+
+static void LL_readdir( fuse_req_t req, fuse_ino_t ino, size_t size, off_t offset, struct fuse_file_info * fi )
+{
+	struct owfs_dir * dir = (struct owfs_dir *) (uintptr_t) fi->fh ;
+	char * buffer = owmalloc( size ) ;
+	size_t used = 0 ;
+	off_t entry ;
+
+	(void) ino ;
+	if ( buffer == NULL ) {
+		fuse_reply_err( req, ENOMEM ) ;
+		return ;
+	}
+
+	// offset is the index of the next entry
+	for ( entry = offset ; entry < dir->count ; ++entry ) {
+		struct stat stbuf ;
+		size_t entry_size ;
+
+		memset( &stbuf, 0, sizeof( stbuf ) ) ;
+		stbuf.st_mode = dir->mode[entry] ;
+		entry_size = fuse_add_direntry( req, &buffer[used], size - used, dir->name[entry], &stbuf, entry + 1 ) ;
+		if ( entry_size > size - used ) {
+			// no room, rest in the next call
+			break ;
+		}
+		used += entry_size ;
+	}
+	fuse_reply_buf( req, buffer, used ) ;
+	owfree( buffer ) ;
+}
+
+static void LL_releasedir( fuse_req_t req, fuse_ino_t ino, struct fuse_file_info * fi )
+{
+	(void) ino ;
+	Dir_free( (struct owfs_dir *) (uintptr_t) fi->fh ) ;
+	fuse_reply_err( req, 0 ) ;
+}
+
+static struct fuse_lowlevel_ops owfs_lowlevel_oper = {
+	.init = LL_init,
+	.lookup = LL_lookup,
+	.forget = LL_forget,
+	.getattr = LL_getattr,
+	.setattr = LL_setattr,
+	.open = LL_open,
+	.read = LL_read,
+	.write = LL_write,
+	.release = LL_release,
+	.opendir = LL_opendir,
+	.readdir = LL_readdir,
+	.releasedir = LL_releasedir,
+};
+
+/* Mount and serve until unmounted, instead of fuse_main */
+int Fuse_lowlevel_main( int argc, char * argv[] )
+{
+	struct fuse_args args = FUSE_ARGS_INIT( argc, argv ) ;
+	struct fuse_chan * channel ;
+	char * mountpoint = NULL ;
+	int multithreaded = 1 ;
+	int foreground = 0 ;
+	int err = -1 ;
+
+	if ( fuse_parse_cmdline( &args, &mountpoint, &multithreaded, &foreground ) == -1 ) {
+		LEVEL_DEFAULT( "Cannot parse FUSE options" ) ;
+		return -1 ;
+	}
+
+	channel = fuse_mount( mountpoint, &args ) ;
+	if ( channel == NULL ) {
+		LEVEL_DEFAULT( "Cannot mount %s", SAFESTRING( mountpoint ) ) ;
+	} else {
+		struct fuse_session * session = fuse_lowlevel_new( &args, &owfs_lowlevel_oper, sizeof( owfs_lowlevel_oper ), NULL ) ;
+		if ( session == NULL ) {
+			// bad FUSE options end up here (e.g. --fuse_open_opt)
+			LEVEL_DEFAULT( "Cannot start the FUSE session on %s -- check the FUSE options", SAFESTRING( mountpoint ) ) ;
+		} else {
+			if ( fuse_set_signal_handlers( session ) == -1 ) {
+				LEVEL_DEFAULT( "Cannot set the FUSE signal handlers" ) ;
+			} else {
+				fuse_session_add_chan( session, channel ) ;
+#if FUSE_VERSION >= 27
+				fuse_daemonize( foreground ) ;
+#else							/* FUSE_VERSION < 27 */
+				if ( ! foreground && daemon( 0, 0 ) != 0 ) {
+					ERROR_DEFAULT( "Cannot enter background mode" ) ;
+				}
+#endif							/* FUSE_VERSION */
+				// after daemonizing, the threads wouldn't survive the fork
+				LibStartThreads() ;
+#if FUSE_VERSION >= 28
+				Change_start( channel ) ;
+#endif							/* FUSE_VERSION >= 28 */
+				err = multithreaded ? fuse_session_loop_mt( session ) : fuse_session_loop( session ) ;
+				fuse_remove_signal_handlers( session ) ;
+				fuse_session_remove_chan( channel ) ;
+			}
+			fuse_session_destroy( session ) ;
+		}
+		fuse_unmount( mountpoint, channel ) ;
+	}
+
+	free( mountpoint ) ; // allocated by fuse_parse_cmdline
+	fuse_opt_free_args( &args ) ;
+	return err ;
+}
+
+#endif							/* OWFS_LOWLEVEL */
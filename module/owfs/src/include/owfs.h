@@ -35,6 +35,14 @@
 
 extern struct fuse_operations owfs_oper;
 
+/* FUSE low-level interface (inode based, kernel caching) */
+#if FUSE_VERSION >= 26
+#define OWFS_LOWLEVEL 1
+int Fuse_lowlevel_main(int argc, char *argv[]);
+#else							/* FUSE_VERSION < 26 */
+#define OWFS_LOWLEVEL 0
+#endif							/* FUSE_VERSION */
+
 struct Fuse_option {
 	int allocated_slots;
 	char **argv;
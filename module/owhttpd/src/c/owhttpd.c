@@ -97,7 +97,13 @@ int main(int argc, char *argv[])
 	set_exit_signal_handlers(exit_handler);
 	set_signal_handlers(NULL);
 
-	ServerProcess(Acceptor);
+	if ( Globals.server_workers > 0 && GOOD( EventSetup() ) ) {
+		// event mode -- keep-alive connections served by a worker pool
+		ServerProcessEvents( EventAccept );
+		EventCleanup() ;
+	} else {
+		ServerProcess(Acceptor);
+	}
 
 	LEVEL_DEBUG("ServerProcess done");
 	ow_exit(0);
@@ -0,0 +1,437 @@
+/*
+    OW_HTML -- OWFS used for the web
+    OW -- One-Wire filesystem
+
+    Written 2003 Paul H Alfille
+
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/* owhttpd event mode (--workers n)
+         The shared event loop (ow_event.c) watches every client socket and expires idle ones.
+         The event thread buffers each request header, then one of the
+           fixed pool of worker threads answers the request.
+         HTTP/1.1 connections stay open (keep-alive), pipelined requests
+           are answered in order, and the body is sent in chunks as it is made.
+         The handler sees a stdio stream on top of the connection buffers,
+           so it reads and prints exactly as for a thread per connection.
+         That stream needs fopencookie (GNU), without it (or epoll)
+           owhttpd stays with a thread per connection.
+*/
+
+/* fopencookie is hidden by the _XOPEN_SOURCE / _POSIX_C_SOURCE build flags */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE 1
+#endif
+
+#include "owhttpd.h"
+
+#if defined(HAVE_SYS_EPOLL_H) && defined(HAVE_FOPENCOOKIE)
+
+// input buffer, also the largest chunk sent
+#define HTTP_BUFFER   4096
+
+#ifndef MSG_MORE
+#define MSG_MORE 0
+#endif
+
+/* One accepted client socket */
+struct HttpConnection {
+	FILE_DESCRIPTOR_OR_ERROR file_descriptor ;
+	FILE * stream ; // what the handler reads and prints to
+	BYTE in[HTTP_BUFFER] ; // received, not yet read by the handler
+	size_t in_start ;
+	size_t in_end ;
+	BYTE out[HTTP_BUFFER] ; // header, or body of the current chunk
+	size_t out_length ;
+	int chunked ; // out is a chunk of the body
+	int broken ; // send failed
+	struct event_timer timer ; // idle lists
+	struct event_job job ; // worker queue
+} ;
+
+static struct {
+	struct event_loop loop ; // its mutex protects the lists
+	struct event_list idle_new ; // accepted, waiting for first request
+	struct event_list idle_keep ; // keep-alive, waiting for next request
+	struct event_list * lists[3] ;
+} Event ;
+
+#define EVENTLOCK     _MUTEX_LOCK(   Event.loop.mutex )
+#define EVENTUNLOCK   _MUTEX_UNLOCK( Event.loop.mutex )
+
+static void EventClose( struct HttpConnection * hc ) ;
+static void EventDispatch( struct HttpConnection * hc ) ;
+static void EventReady( void * v ) ;
+static void EventTimers( const struct timeval * now ) ;
+static void EventRequest( void * v ) ;
+static void HttpSend( struct HttpConnection * hc, const BYTE * data, size_t length, int flags ) ;
+static void HttpFlush( struct HttpConnection * hc, int last ) ;
+static ssize_t HttpFill( struct HttpConnection * hc ) ;
+static int HttpHeaderComplete( struct HttpConnection * hc ) ;
+static ssize_t HttpRead( void * cookie, char * buffer, size_t size ) ;
+static ssize_t HttpWrite( void * cookie, const char * buffer, size_t size ) ;
+
+/* ---------------------------------------------- */
+/* Connection stream                              */
+/* ---------------------------------------------- */
+
+/* Write straight to the socket, MSG_MORE holds partial packets for what follows */
+static void HttpSend( struct HttpConnection * hc, const BYTE * data, size_t length, int flags )
+{
+	while ( length > 0 && ! hc->broken ) {
+		ssize_t sent = send( hc->file_descriptor, data, length, MSG_NOSIGNAL | flags ) ;
+		if ( sent < 0 ) {
+			if ( errno == EINTR ) {
+				continue ;
+			}
+			ERROR_CONNECT("Trouble writing data to http client") ;
+			hc->broken = 1 ;
+			return ;
+		}
+		data += sent ;
+		length -= sent ;
+	}
+}
+
+/* Send what is buffered -- header as is, body as one chunk */
+/* last ends the response (with the empty chunk if chunked) */
+static void HttpFlush( struct HttpConnection * hc, int last )
+{
+	if ( hc->chunked ) {
+		if ( hc->out_length > 0 ) {
+			char chunk_size[20] ;
+			int l = snprintf( chunk_size, sizeof(chunk_size), "%lX\r\n", (unsigned long) hc->out_length ) ;
+			HttpSend( hc, (BYTE *) chunk_size, l, MSG_MORE ) ;
+			HttpSend( hc, hc->out, hc->out_length, MSG_MORE ) ;
+			// each chunk goes out as it is made
+			HttpSend( hc, (const BYTE *) "\r\n", 2, last ? MSG_MORE : 0 ) ;
+		}
+		if ( last ) {
+			HttpSend( hc, (const BYTE *) "0\r\n\r\n", 5, 0 ) ;
+		}
+	} else {
+		HttpSend( hc, hc->out, hc->out_length, last ? 0 : MSG_MORE ) ;
+	}
+	hc->out_length = 0 ;
+}
+
+/* Refill the empty input buffer with one recv */
+static ssize_t HttpFill( struct HttpConnection * hc )
+{
+	ssize_t got ;
+
+	do {
+		// blocks at most timeout_server (SO_RCVTIMEO) for the rest of a request
+		got = recv( hc->file_descriptor, hc->in, HTTP_BUFFER, 0 ) ;
+	} while ( got < 0 && errno == EINTR ) ;
+	hc->in_start = 0 ;
+	hc->in_end = ( got > 0 ) ? (size_t) got : 0 ;
+	return got ;
+}
+
+/* The buffered input holds a whole request header (up to the empty line) */
+static int HttpHeaderComplete( struct HttpConnection * hc )
+{
+	size_t i ;
+
+	for ( i = hc->in_start + 1 ; i < hc->in_end ; ++i ) {
+		if ( hc->in[i] != '\n' ) {
+			continue ;
+		}
+		if ( hc->in[i-1] == '\n' ) {
+			return 1 ;
+		}
+		if ( hc->in[i-1] == '\r' && i >= hc->in_start + 2 && hc->in[i-2] == '\n' ) {
+			return 1 ;
+		}
+	}
+	return 0 ;
+}
+
+/* stdio read -- serve from the buffer */
+static ssize_t HttpRead( void * cookie, char * buffer, size_t size )
+{
+	struct HttpConnection * hc = cookie ;
+	size_t available ;
+
+	if ( hc->in_start == hc->in_end ) {
+		ssize_t got = HttpFill( hc ) ;
+		if ( got <= 0 ) {
+			return got ;
+		}
+	}
+	available = hc->in_end - hc->in_start ;
+	if ( size > available ) {
+		size = available ;
+	}
+	memcpy( buffer, &(hc->in[hc->in_start]), size ) ;
+	hc->in_start += size ;
+	return size ;
+}
+
+/* stdio write -- collect, send when the buffer fills */
+static ssize_t HttpWrite( void * cookie, const char * buffer, size_t size )
+{
+	struct HttpConnection * hc = cookie ;
+	size_t left = size ;
+
+	while ( left > 0 ) {
+		size_t room = HTTP_BUFFER - hc->out_length ;
+		if ( room == 0 ) {
+			HttpFlush( hc, 0 ) ;
+			room = HTTP_BUFFER ;
+		}
+		if ( room > left ) {
+			room = left ;
+		}
+		memcpy( &(hc->out[hc->out_length]), buffer, room ) ;
+		hc->out_length += room ;
+		buffer += room ;
+		left -= room ;
+	}
+	return hc->broken ? 0 : (ssize_t) size ;
+}
+
+/* Header is complete, the rest of the response is chunked body */
+/* Called from HTTPstart */
+void EventChunked( struct HttpConnection * hc )
+{
+	HttpFlush( hc, 0 ) ; // header waits for the first chunk
+	hc->chunked = 1 ;
+}
+
+/* ---------------------------------------------- */
+/* Event loop                                     */
+/* ---------------------------------------------- */
+
+/* Called with EVENTLOCK, not queued or being served */
+static void EventClose( struct HttpConnection * hc )
+{
+	Event_List_Remove( &(hc->timer) ) ;
+	Event_Unwatch( &Event.loop, hc->file_descriptor ) ;
+	if ( hc->stream != NULL ) {
+		fclose( hc->stream ) ; // doesn't close the socket
+	}
+	Test_and_Close( &(hc->file_descriptor) ) ;
+	owfree( hc ) ;
+}
+
+/* Request arriving -- queue the connection for a worker */
+/* Called with EVENTLOCK */
+static void EventDispatch( struct HttpConnection * hc )
+{
+	Event_List_Remove( &(hc->timer) ) ;
+	Event_Queue( &Event.loop, &(hc->job) ) ;
+}
+
+/* Readable -- buffer what came, a worker only gets a complete request header */
+/* (handle_request reads with blocking stdio, a slow client would hold the worker) */
+/* Called with EVENTLOCK */
+static void EventReady( void * v )
+{
+	struct HttpConnection * hc = v ;
+	ssize_t got ;
+
+	if ( hc->in_start > 0 ) {
+		// room at the end for the rest
+		memmove( hc->in, &(hc->in[hc->in_start]), hc->in_end - hc->in_start ) ;
+		hc->in_end -= hc->in_start ;
+		hc->in_start = 0 ;
+	}
+
+	got = recv( hc->file_descriptor, &(hc->in[hc->in_end]), HTTP_BUFFER - hc->in_end, MSG_DONTWAIT ) ;
+	if ( got < 0 && ( errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ) ) {
+		// false alarm
+		if ( BAD( Event_Rearm( &Event.loop, hc->file_descriptor, hc ) ) ) {
+			EventClose( hc ) ;
+		}
+		return ;
+	}
+	if ( got <= 0 ) {
+		LEVEL_DEBUG("Http client closed the connection") ;
+		EventClose( hc ) ;
+		return ;
+	}
+	hc->in_end += got ;
+
+	if ( HttpHeaderComplete( hc ) || hc->in_end == HTTP_BUFFER ) {
+		// a header longer than the buffer is read by the worker as it comes
+		EventDispatch( hc ) ;
+	} else if ( BAD( Event_Rearm( &Event.loop, hc->file_descriptor, hc ) ) ) {
+		EventClose( hc ) ;
+	}
+	// else the rest of the header is still to come, the idle timer keeps running
+}
+
+/* Close connections idle too long */
+/* Called with EVENTLOCK */
+static void EventTimers( const struct timeval * now )
+{
+	struct event_timer * et ;
+
+	// never sent a request
+	while ( (et = Event.idle_new.head) != NULL && timercmp( &(et->deadline), now, <= ) ) {
+		LEVEL_DEBUG("No request from new http connection");
+		EventClose( et->owner ) ;
+	}
+
+	// keep-alive connections
+	while ( (et = Event.idle_keep.head) != NULL && timercmp( &(et->deadline), now, <= ) ) {
+		LEVEL_DEBUG("Keep-alive http connection idle too long");
+		EventClose( et->owner ) ;
+	}
+}
+
+/* Worker -- answer one request, its header already buffered */
+static void EventRequest( void * v )
+{
+	struct HttpConnection * hc = v ;
+	int keep_alive ;
+
+	clearerr( hc->stream ) ;
+	hc->chunked = 0 ;
+	keep_alive = handle_request( hc->stream, hc ) ;
+	fflush( hc->stream ) ;
+
+	if ( ! hc->chunked ) {
+		// not HTTP/1.1, or never reached the body -- the length isn't known
+		keep_alive = 0 ;
+	}
+	HttpFlush( hc, 1 ) ;
+	hc->chunked = 0 ;
+	if ( hc->broken || ferror( hc->stream ) ) {
+		keep_alive = 0 ;
+	}
+
+	EVENTLOCK ;
+	if ( ! keep_alive || Event.loop.shutdown ) {
+		EventClose( hc ) ;
+	} else if ( HttpHeaderComplete( hc ) ) {
+		// pipelined request already here
+		EventDispatch( hc ) ;
+	} else if ( hc->in_start < hc->in_end ) {
+		// start of a pipelined request, wait for the rest of the header
+		Event_List_Add( &Event.idle_new, &(hc->timer), Globals.timeout_server ) ;
+		if ( BAD( Event_Rearm( &Event.loop, hc->file_descriptor, hc ) ) ) {
+			EventClose( hc ) ;
+		}
+	} else {
+		LEVEL_DEBUG("Http keep-alive -- wait for next request.");
+		Event_List_Add( &Event.idle_keep, &(hc->timer), Globals.timeout_persistent_low ) ;
+		if ( BAD( Event_Rearm( &Event.loop, hc->file_descriptor, hc ) ) ) {
+			EventClose( hc ) ;
+		}
+	}
+	EVENTUNLOCK ;
+}
+
+/* Called from the listening thread for each accepted socket */
+void EventAccept(FILE_DESCRIPTOR_OR_ERROR file_descriptor)
+{
+	cookie_io_functions_t http_io = { HttpRead, HttpWrite, NULL, NULL, } ;
+	struct timeval tv = { Globals.timeout_server, 0, } ;
+	struct HttpConnection * hc = owcalloc( 1, sizeof(struct HttpConnection) ) ;
+
+	if ( hc == NULL ) {
+		LEVEL_DEBUG("Could not allocate memory to handle this connection");
+		close( file_descriptor ) ;
+		return ;
+	}
+
+	hc->file_descriptor = file_descriptor ;
+	hc->timer.owner = hc ;
+	hc->job.owner = hc ;
+	hc->stream = fopencookie( hc, "w+", http_io ) ;
+	if ( hc->stream == NULL ) {
+		LEVEL_DEBUG("Could not open a stream for this connection");
+		Test_and_Close( &(hc->file_descriptor) ) ;
+		owfree( hc ) ;
+		return ;
+	}
+	// the connection does its own buffering, and read ahead would hide pipelined requests
+	setvbuf( hc->stream, NULL, _IONBF, 0 ) ;
+	setsockopt( file_descriptor, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv) ) ;
+
+	EVENTLOCK ;
+	if ( Event.loop.shutdown ) {
+		EventClose( hc ) ;
+	} else {
+		Event_List_Add( &Event.idle_new, &(hc->timer), Globals.timeout_server ) ;
+		if ( BAD( Event_Watch( &Event.loop, hc->file_descriptor, hc ) ) ) {
+			EventClose( hc ) ;
+		}
+	}
+	EVENTUNLOCK ;
+}
+
+GOOD_OR_BAD EventSetup(void)
+{
+	memset( &Event, 0, sizeof(Event) ) ;
+	Event.lists[0] = &Event.idle_new ;
+	Event.lists[1] = &Event.idle_keep ;
+	Event.lists[2] = NULL ;
+	Event.loop.lists = Event.lists ;
+	Event.loop.ready = EventReady ;
+	Event.loop.timers = EventTimers ;
+	Event.loop.work = EventRequest ;
+
+	return Event_Loop_Start( &Event.loop, Globals.server_workers ) ;
+}
+
+void EventCleanup(void)
+{
+	struct event_list * idle[] = { &Event.idle_new, &Event.idle_keep, } ;
+	size_t l ;
+
+	// workers finish the queued requests first
+	Event_Loop_Stop( &Event.loop ) ;
+
+	EVENTLOCK ;
+	for ( l = 0 ; l < sizeof(idle)/sizeof(idle[0]) ; ++l ) {
+		while ( idle[l]->head != NULL ) {
+			EventClose( idle[l]->head->owner ) ;
+		}
+	}
+	EVENTUNLOCK ;
+
+	Event_Loop_Destroy( &Event.loop ) ;
+}
+
+#else /* HAVE_SYS_EPOLL_H && HAVE_FOPENCOOKIE */
+
+GOOD_OR_BAD EventSetup(void)
+{
+	LEVEL_DEFAULT("Event mode (--workers) needs epoll and fopencookie -- use a thread per connection") ;
+	return gbBAD ;
+}
+
+void EventAccept(FILE_DESCRIPTOR_OR_ERROR file_descriptor)
+{
+	// never called without EventSetup
+	close( file_descriptor ) ;
+}
+
+void EventCleanup(void)
+{
+}
+
+void EventChunked( struct HttpConnection * hc )
+{
+	(void) hc ;
+}
+
+#endif /* HAVE_SYS_EPOLL_H && HAVE_FOPENCOOKIE */
@@ -139,5 +139,5 @@ void Favicon(struct OutputControl * oc)
 	for (i = 0; i < 894; ++i) {
 		fprintf(out, "%c", favicon[i]);
 	}
-	HTTPfoot(oc);
+	// exactly Content-Length bytes, no HTML footer
 }
@@ -24,7 +24,7 @@ struct urlparse {
 	char *value;
 };
 
-enum http_return { http_ok, http_dir, http_icon, http_400, http_404 } ;
+enum http_return { http_ok, http_dir, http_icon, http_snapshot, http_400, http_404 } ;
 
 	/* Error page functions */
 enum content_type PoorMansParser( char * bad_url ) ;
@@ -40,27 +40,42 @@ static void TrimBoundary( char ** boundary ) ;
 static int GetPostData( char * boundary, struct memblob * mb, struct OutputControl * oct ) ;
 static char * GetPostPath(  struct OutputControl * oc ) ;
 static GOOD_OR_BAD GetHostURL( struct OutputControl * oc ) ;
+static void HeaderConnection( struct OutputControl * oc, const char * line ) ;
 
 /* --------------- Functions ---------------- */
 
 /* Main handler for a web page */
 int handle_socket(FILE * out)
+{
+	handle_request( out, NULL ) ;
+	return 0 ;
+}
+
+/* Handle one request, returns non-zero if the connection can stay open (event mode) */
+int handle_request(FILE * out, struct HttpConnection * hc)
 {
 	enum http_return http_code ;
 	enum content_type pmp = ct_html;
 
 	struct urlparse up;
 	
-	struct OutputControl s_oc = { out, 0, NULL, NULL, } ;
+	struct OutputControl s_oc = { out, 0, NULL, NULL, hc, 0, 0, 0, } ;
 	struct OutputControl * oc = &s_oc ;
 
 	struct parsedname s_pn;
 	struct parsedname * pn = &s_pn ;
+	const char * snapshot_path ;
 	
 	up.line = NULL ; // prep for getline with null. Will be allocated by getline.
 	if ( getline(&(up.line), &(up.line_length), out) >= 0 ) {
 		LEVEL_CALL("PreParse line=%s", up.line);
 		URLparse(&up);				/* Break up URL */
+		if ( hc != NULL && up.version != NULL && strcmp( up.version, "HTTP/1.1" ) == 0 ) {
+			// persistent unless the client says "Connection: close"
+			oc->http11 = 1 ;
+			oc->chunked = 1 ;
+			oc->keep_alive = 1 ;
+		}
 		httpunescape((BYTE *) up.file    );
 		httpunescape((BYTE *) up.request );
 		httpunescape((BYTE *) up.value   );
@@ -90,6 +105,16 @@ int handle_socket(FILE * out)
 			ReadToCRLF(oc) ;
 			pn = NO_PARSEDNAME ;
 			http_code = http_icon ;
+		} else if ( (snapshot_path = SnapshotPath(up.file)) != NULL ) {
+			// whole subtree as one json document
+			LEVEL_DEBUG("http snapshot of %s.",snapshot_path);
+			ReadToCRLF(oc) ;
+			if (FS_ParsedName(snapshot_path, pn) != 0) {
+				pn = NO_PARSEDNAME ;
+				http_code = http_404 ;
+			} else {
+				http_code = http_snapshot ;
+			}
 		} else 	if (FS_ParsedName(up.file, pn) != 0) {
 			// Can't understand the file name = URL
 			LEVEL_DEBUG("http %s not understood.",up.file);
@@ -103,6 +128,8 @@ int handle_socket(FILE * out)
 			http_code = http_dir ;
 		} else if (strcmp(up.cmd, "POST") == 0) {
 			LEVEL_DEBUG("http POST request.");
+			// upload body isn't delimited by length
+			oc->keep_alive = 0 ;
 			http_code = handle_POST( oc, &up ) ;
 		} else if (strcmp(up.cmd, "GET") == 0) {
 			LEVEL_DEBUG("http GET request.");
@@ -128,6 +155,9 @@ int handle_socket(FILE * out)
 		}
 		switch ( http_code ) {
 			case http_400:
+				// request may not have been read to the end
+				oc->keep_alive = 0 ;
+				// fall through
 			case http_404:
 				// need to call this before freeing up.file
 				pmp = PoorMansParser(up.file) ;
@@ -142,6 +172,7 @@ int handle_socket(FILE * out)
 		LEVEL_DEBUG("No http data.");
 		pn = NO_PARSEDNAME ;
 		http_code = http_400 ;
+		oc->keep_alive = 0 ;
 	}
 
 	// This is necessary for SunOS
@@ -160,6 +191,9 @@ int handle_socket(FILE * out)
 		case http_dir:
 			ShowDir(oc, pn);
 			break ;
+		case http_snapshot:
+			Snapshot(oc, pn);
+			break ;
 		case http_ok:
 			ShowDevice(oc, pn);
 			break ;
@@ -175,7 +209,7 @@ int handle_socket(FILE * out)
 		owfree( oc->host ) ;
 	}
 	
-	return 0 ;
+	return oc->keep_alive ;
 }	
 
 /* The HTTP request is a GET message */
@@ -431,6 +465,7 @@ static void ReadToCRLF( struct OutputControl * oc )
 		if ( strcmp(text_in, "\r\n")==0 || strcmp(text_in, "\n")==0 ) {
 			break ;
 		}
+		HeaderConnection( oc, text_in ) ;
 	}
 	
 	
@@ -564,8 +599,15 @@ static GOOD_OR_BAD GetHostURL( struct OutputControl * oc )
 			return gbBAD ;
 		}
 		LEVEL_DEBUG("Test line <%s>",line ) ;
+		if ( strcmp(line, "\r\n")==0 || strcmp(line, "\n")==0 ) {
+			// end of header, don't read into the next request
+			free( line ) ;
+			LEVEL_DEBUG("Couldn't find Host: line in HTTP header") ;
+			return gbBAD ;
+		}
 		if ( ow_regexec( &rx_host, line, &orm ) != 0 ) {
 			LEVEL_DEBUG("No match <%s>",line) ;
+			HeaderConnection( oc, line ) ;
 			continue ;
 		}
 		oc->host = owstrdup( orm.match[1] ) ;
@@ -574,3 +616,20 @@ static GOOD_OR_BAD GetHostURL( struct OutputControl * oc )
 		return gbGOOD ;				
 	} while (1) ;
 }
+
+// "Connection: close" ends a keep-alive connection after this response
+static void HeaderConnection( struct OutputControl * oc, const char * line )
+{
+	const char * value ;
+
+	if ( strncasecmp( line, "Connection:", 11 ) != 0 ) {
+		return ;
+	}
+	for ( value = &line[11] ; value[0] != '\0' ; ++value ) {
+		if ( strncasecmp( value, "close", 5 ) == 0 ) {
+			LEVEL_DEBUG("Client asks to close the connection") ;
+			oc->keep_alive = 0 ;
+			return ;
+		}
+	}
+}
@@ -23,8 +23,8 @@ void HTTPstart(struct OutputControl * oc, const char *status, const enum content
 	time_t t = NOW_TIME;
 	size_t l = strftime(d, sizeof(d), "%a, %d %b %Y %T GMT", gmtime(&t));
 
-	fprintf(out, "HTTP/1.0 %s\r\n", status);
-	fprintf(out, "Date: %*s\n", (int) l, d);
+	fprintf(out, "HTTP/1.%d %s\r\n", oc->http11, status);
+	fprintf(out, "Date: %*s\r\n", (int) l, d);
 	fprintf(out, "Server: %s\r\n", SVERSION);
 	fprintf(out, "Last-Modified: %*s\r\n", (int) l, d);
 	/*
@@ -35,8 +35,12 @@ void HTTPstart(struct OutputControl * oc, const char *status, const enum content
 		fprintf(out, "Content-Type: text/html\r\n");
 		break;
 	case ct_icon:
-		fprintf(out, "Content-Length: 894\r\n");
-		fprintf(out, "Connection: close\r\n");
+		if ( ! oc->chunked ) {
+			fprintf(out, "Content-Length: 894\r\n");
+		}
+		if ( oc->hc == NULL ) {
+			fprintf(out, "Connection: close\r\n");
+		}
 		break ;
 	case ct_text:
 		fprintf(out, "Content-Type: text/plain\r\n");
@@ -46,7 +50,18 @@ void HTTPstart(struct OutputControl * oc, const char *status, const enum content
 		fprintf(out, "Content-Type: application/json\r\n");
 		break ;
 	}
+	if ( oc->hc != NULL ) {
+		// event mode
+		if ( oc->chunked ) {
+			fprintf(out, "Transfer-Encoding: chunked\r\n");
+		}
+		fprintf(out, "Connection: %s\r\n", oc->keep_alive ? "keep-alive" : "close" );
+	}
 	fprintf(out, "\r\n");
+	if ( oc->chunked ) {
+		// the body is streamed out a chunk at a time
+		EventChunked( oc->hc ) ;
+	}
 }
 
 void HTTPtitle(struct OutputControl * oc, const char *title)
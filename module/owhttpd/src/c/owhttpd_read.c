@@ -594,10 +594,15 @@ static void StructureDetailJson(struct OutputControl * oc, const char * structur
 
 /* Device entry -- table line for a filetype */
 static void ShowJsonReadWrite(struct OutputControl * oc, struct one_wire_query *owq)
+{
+	JSON_value( oc, owq, FS_read_postparse(owq) ) ;
+}
+
+/* JSON form of a value already read (or null for an error) */
+void JSON_value(struct OutputControl * oc, struct one_wire_query *owq, SIZE_OR_ERROR read_return)
 {
 	FILE * out = oc->out ;
 	struct parsedname * pn = PN(owq) ;
-	SIZE_OR_ERROR read_return = FS_read_postparse(owq);
 
 	if (read_return < 0) {
 		fprintf(out, "null");
@@ -0,0 +1,287 @@
+/*
+ * http.c for owhttpd (1-wire web server)
+ * By Paul Alfille 2003, using libow
+ * offshoot of the owfs ( 1wire file system )
+ *
+ * GPL license ( Gnu Public Lincense )
+ *
+ * Based on chttpd. copyright(c) 0x7d0 greg olszewski <noop@nwonknu.org>
+ *
+ */
+
+/* Snapshot -- every readable property below a path in one JSON document
+ *   /snapshot                        all devices
+ *   /snapshot/bus.0                  devices on one bus
+ *   /snapshot/uncached/10.67C6697351FF   one device, fresh values
+ * Output is { "device":{ "property":"value", "subdir":{ ... } }, ... }
+ * Each device is listed, then all its properties are read together
+ * (FS_read_many -- one device lock, cached values don't reach the bus)
+ * and written out before the next device, so the reply streams.
+ */
+
+#include "owhttpd.h"
+
+/* One property or subdirectory of a device, in listing order */
+struct snapshot_entry {
+	char * path ;
+	int depth ; // 0 for properties of the device itself
+	int is_dir ;
+} ;
+
+struct snapshot {
+	struct snapshot_entry * entry ;
+	int count ;
+	int allocated ;
+} ;
+
+/* Names collected by one FS_dir call */
+struct snapshot_list {
+	char ** path ;
+	int * is_dir ;
+	int count ;
+	int allocated ;
+} ;
+
+static void SnapshotDevice( struct OutputControl * oc, const char * path ) ;
+static void SnapshotListAdd( struct snapshot_list * sl, const char * path, int is_dir ) ;
+static void SnapshotListFree( struct snapshot_list * sl ) ;
+static void SnapshotPropertyCallback( void * v, const struct parsedname * pn_entry ) ;
+static void SnapshotDeviceCallback( void * v, const struct parsedname * pn_entry ) ;
+static void SnapshotCollect( struct snapshot * ss, const char * path, int depth ) ;
+static void SnapshotPrint( struct OutputControl * oc, struct snapshot * ss, struct one_wire_query ** owq_array, SIZE_OR_ERROR * read_results, int * index, int depth ) ;
+
+/* The subtree path for a snapshot URL, or NULL if it isn't one */
+const char * SnapshotPath( const char * file )
+{
+	if ( strncasecmp( file, "/snapshot", 9 ) != 0 ) {
+		return NULL ;
+	}
+	switch ( file[9] ) {
+		case '\0':
+			return "/" ;
+		case '/':
+			return &file[9] ;
+		default:
+			return NULL ;
+	}
+}
+
+static void SnapshotListAdd( struct snapshot_list * sl, const char * path, int is_dir )
+{
+	if ( sl->count == sl->allocated ) {
+		int allocated = sl->allocated + 32 ;
+		char ** new_path = owrealloc( sl->path, allocated * sizeof(char *) ) ;
+		int * new_is_dir ;
+		if ( new_path == NULL ) {
+			return ;
+		}
+		sl->path = new_path ;
+		new_is_dir = owrealloc( sl->is_dir, allocated * sizeof(int) ) ;
+		if ( new_is_dir == NULL ) {
+			return ;
+		}
+		sl->is_dir = new_is_dir ;
+		sl->allocated = allocated ;
+	}
+	sl->path[sl->count] = owstrdup( path ) ;
+	if ( sl->path[sl->count] != NULL ) {
+		sl->is_dir[sl->count] = is_dir ;
+		++sl->count ;
+	}
+}
+
+static void SnapshotListFree( struct snapshot_list * sl )
+{
+	int i ;
+	for ( i = 0 ; i < sl->count ; ++i ) {
+		SAFEFREE( sl->path[i] ) ;
+	}
+	SAFEFREE( sl->path ) ;
+	SAFEFREE( sl->is_dir ) ;
+}
+
+/* FS_dir callback -- readable properties and subdirectories */
+static void SnapshotPropertyCallback( void * v, const struct parsedname * pn_entry )
+{
+	struct snapshot_list * sl = v ;
+	struct filetype * ft = pn_entry->selected_filetype ;
+
+	if ( IsDir( pn_entry ) ) {
+		// device subdirectory (e.g. pages)
+		SnapshotListAdd( sl, pn_entry->path, 1 ) ;
+	} else if ( ft->read == NO_READ_FUNCTION ) {
+		// write only
+	} else if ( pn_entry->extension == EXTENSION_UNKNOWN && ft->ag != NON_AGGREGATE && ft->ag->combined == ag_sparse ) {
+		// sparse array needs an extension chosen
+	} else {
+		SnapshotListAdd( sl, pn_entry->path, 0 ) ;
+	}
+}
+
+/* FS_dir callback -- devices only (not bus, settings, statistics...) */
+static void SnapshotDeviceCallback( void * v, const struct parsedname * pn_entry )
+{
+	if ( pn_entry->type != ePN_real
+		|| pn_entry->selected_device == NO_DEVICE
+		|| pn_entry->selected_device == DeviceSimultaneous
+		|| IsAlarmDir( pn_entry ) ) {
+		return ;
+	}
+	SnapshotListAdd( v, pn_entry->path, 1 ) ;
+}
+
+/* List a device directory (depth first) into ss */
+static void SnapshotCollect( struct snapshot * ss, const char * path, int depth )
+{
+	struct parsedname s_pn ;
+	struct snapshot_list sl = { NULL, NULL, 0, 0, } ;
+	int i ;
+
+	if ( FS_ParsedName( path, &s_pn ) != 0 ) {
+		return ;
+	}
+	FS_dir( SnapshotPropertyCallback, &sl, &s_pn ) ;
+	FS_ParsedName_destroy( &s_pn ) ;
+
+	for ( i = 0 ; i < sl.count ; ++i ) {
+		if ( ss->count == ss->allocated ) {
+			int allocated = ss->allocated + 32 ;
+			struct snapshot_entry * new_entry = owrealloc( ss->entry, allocated * sizeof(struct snapshot_entry) ) ;
+			if ( new_entry == NULL ) {
+				break ;
+			}
+			ss->entry = new_entry ;
+			ss->allocated = allocated ;
+		}
+		ss->entry[ss->count].path = sl.path[i] ;
+		ss->entry[ss->count].depth = depth ;
+		ss->entry[ss->count].is_dir = sl.is_dir[i] ;
+		sl.path[i] = NULL ; // owned by ss now
+		++ss->count ;
+		if ( sl.is_dir[i] ) {
+			SnapshotCollect( ss, ss->entry[ss->count-1].path, depth + 1 ) ;
+		}
+	}
+	SnapshotListFree( &sl ) ;
+}
+
+/* Print one level as a JSON object, index moves past it */
+static void SnapshotPrint( struct OutputControl * oc, struct snapshot * ss, struct one_wire_query ** owq_array, SIZE_OR_ERROR * read_results, int * index, int depth )
+{
+	FILE * out = oc->out ;
+	int not_first = 0 ;
+
+	fprintf( out, "{" ) ;
+	while ( *index < ss->count && ss->entry[*index].depth == depth ) {
+		struct snapshot_entry * se = &(ss->entry[*index]) ;
+		const char * name = strrchr( se->path, '/' ) ;
+
+		fprintf( out, "%s\n\"%s\":", not_first ? "," : "", name == NULL ? se->path : &name[1] ) ;
+		not_first = 1 ;
+		if ( se->is_dir ) {
+			++*index ;
+			SnapshotPrint( oc, ss, owq_array, read_results, index, depth + 1 ) ;
+		} else {
+			if ( owq_array[*index] == NO_ONE_WIRE_QUERY ) {
+				fprintf( out, "null" ) ;
+			} else {
+				JSON_value( oc, owq_array[*index], read_results[*index] ) ;
+			}
+			++*index ;
+		}
+	}
+	fprintf( out, "\n}" ) ;
+}
+
+/* All properties of one device, read together */
+static void SnapshotDevice( struct OutputControl * oc, const char * path )
+{
+	struct snapshot ss = { NULL, 0, 0, } ;
+	struct one_wire_query ** owq_array ;
+	SIZE_OR_ERROR * read_results ;
+	int index = 0 ;
+	int i ;
+
+	SnapshotCollect( &ss, path, 0 ) ;
+
+	owq_array = owcalloc( ss.count + 1, sizeof(struct one_wire_query *) ) ;
+	read_results = owcalloc( ss.count + 1, sizeof(SIZE_OR_ERROR) ) ;
+	if ( owq_array == NULL || read_results == NULL ) {
+		fprintf( oc->out, "null" ) ;
+	} else {
+		for ( i = 0 ; i < ss.count ; ++i ) {
+			struct one_wire_query * owq = NO_ONE_WIRE_QUERY ;
+			if ( ! ss.entry[i].is_dir ) {
+				owq = OWQ_create_from_path( ss.entry[i].path ) ;
+				if ( owq != NO_ONE_WIRE_QUERY && BAD( OWQ_allocate_read_buffer(owq) ) ) {
+					OWQ_destroy( owq ) ;
+					owq = NO_ONE_WIRE_QUERY ;
+				}
+			}
+			owq_array[i] = owq ;
+		}
+
+		FS_read_many( owq_array, read_results, ss.count ) ;
+		SnapshotPrint( oc, &ss, owq_array, read_results, &index, 0 ) ;
+
+		for ( i = 0 ; i < ss.count ; ++i ) {
+			if ( owq_array[i] != NO_ONE_WIRE_QUERY ) {
+				OWQ_destroy( owq_array[i] ) ;
+			}
+		}
+	}
+
+	SAFEFREE( owq_array ) ;
+	SAFEFREE( read_results ) ;
+	for ( i = 0 ; i < ss.count ; ++i ) {
+		owfree( ss.entry[i].path ) ;
+	}
+	SAFEFREE( ss.entry ) ;
+}
+
+void Snapshot( struct OutputControl * oc, struct parsedname * pn )
+{
+	FILE * out = oc->out ;
+
+	HTTPstart( oc, "200 OK", ct_json ) ;
+
+	if ( pn->selected_device != NO_DEVICE && pn->selected_filetype == NO_FILETYPE ) {
+		// one device
+		fprintf( out, "{\n\"%s\":", FS_DirName(pn) ) ;
+		SnapshotDevice( oc, pn->path ) ;
+		fprintf( out, "\n}" ) ;
+	} else if ( pn->selected_device == NO_DEVICE ) {
+		// root or bus -- every device in it
+		struct snapshot_list devices = { NULL, NULL, 0, 0, } ;
+		int i ;
+
+		FS_dir( SnapshotDeviceCallback, &devices, pn ) ;
+		fprintf( out, "{" ) ;
+		for ( i = 0 ; i < devices.count ; ++i ) {
+			const char * name = strrchr( devices.path[i], '/' ) ;
+			fprintf( out, "%s\n\"%s\":", i > 0 ? "," : "", &name[1] ) ;
+			SnapshotDevice( oc, devices.path[i] ) ;
+		}
+		fprintf( out, "\n}" ) ;
+		SnapshotListFree( &devices ) ;
+	} else {
+		// a single property or subdirectory of a device
+		fprintf( out, "{\n\"%s\":", FS_DirName(pn) ) ;
+		if ( IsDir( pn ) ) {
+			SnapshotDevice( oc, pn->path ) ;
+		} else {
+			struct one_wire_query * owq = OWQ_create_from_path( pn->path ) ;
+			if ( owq == NO_ONE_WIRE_QUERY ) {
+				fprintf( out, "null" ) ;
+			} else {
+				if ( GOOD( OWQ_allocate_read_buffer(owq) ) ) {
+					JSON_value( oc, owq, FS_read_postparse(owq) ) ;
+				} else {
+					fprintf( out, "null" ) ;
+				}
+				OWQ_destroy( owq ) ;
+			}
+		}
+		fprintf( out, "\n}" ) ;
+	}
+}
@@ -34,13 +34,19 @@
  * deals with a conncection
  */
 /* in owhttpd_handler.c */
+struct HttpConnection ;
 int handle_socket(FILE * out);
+int handle_request(FILE * out, struct HttpConnection * hc);
 
 struct OutputControl {
 	FILE * out ;
 	int not_first ;
 	char * base_url ;
 	char * host ;
+	struct HttpConnection * hc ; // event mode connection, NULL for a thread per connection
+	int http11 ; // answer as HTTP/1.1
+	int chunked ; // body sent with chunked transfer encoding
+	int keep_alive ; // wait for another request after this one
 } ;
 
 /* in owhttpd_present */
@@ -56,6 +62,11 @@ void ChangeData(struct one_wire_query *owq);
 
 /* in owhttpd_read.c */
 void ShowDevice( struct OutputControl * oc, struct parsedname *const pn);
+void JSON_value( struct OutputControl * oc, struct one_wire_query *owq, SIZE_OR_ERROR read_return);
+
+/* in owhttpd_snapshot.c */
+const char * SnapshotPath( const char * file ) ;
+void Snapshot( struct OutputControl * oc, struct parsedname * pn ) ;
 
 /* in owhttpd_dir.c */
 struct JsonCBstruct {
@@ -69,6 +80,13 @@ void JSON_dir_init(  struct OutputControl * oc ) ;
 void JSON_dir_entry(  struct OutputControl * oc, const char * format, const char * data ) ;
 void JSON_dir_finish(  struct OutputControl * oc ) ;
 
+/* in owhttpd_event.c */
+/* Event driven server (epoll) with keep-alive and a fixed worker pool */
+GOOD_OR_BAD EventSetup(void) ;
+void EventAccept(FILE_DESCRIPTOR_OR_ERROR file_descriptor) ;
+void EventCleanup(void) ;
+void EventChunked( struct HttpConnection * hc ) ;
+
 /* in ow_favicon.c */
 void Favicon( struct OutputControl * oc);
 
@@ -0,0 +1,140 @@
+/*
+    OWFS -- One-Wire filesystem
+    OWHTTPD -- One-Wire Web Server
+    Written 2003 Paul H Alfille
+	email: paul.alfille@gmail.com
+	Released under the GPL
+	See the header file: ow.h for full attribution
+	1wire/iButton system from Dallas Semiconductor
+*/
+
+/* CRC throughput benchmark -- not installed, build with "make crcbench"
+ * Compares the library CRC8compute / CRC16compute against the plain
+ * byte-at-a-time algorithms (checking the results agree) over a range
+ * of buffer sizes.
+ *   ./crcbench [megabytes per size]
+ * */
+
+#include <config.h>
+#include "owfs_config.h"
+#include "ow.h"
+
+/* The previous CRC8compute loop (one table lookup per byte)
+ * table built bitwise from x^8 + x^5 + x^4 + 1, bit reversed */
+static BYTE bench_crc8_table[256];
+
+static void Bench_CRC8_table(void)
+{
+	UINT x;
+
+	for (x = 0; x < 256; ++x) {
+		BYTE crc = x;
+		int bit;
+		for (bit = 0; bit < 8; ++bit) {
+			crc = (crc & 1) ? ((crc >> 1) ^ 0x8C) : (crc >> 1);
+		}
+		bench_crc8_table[x] = crc;
+	}
+}
+
+static BYTE Bench_CRC8(const BYTE * bytes, const size_t length, const UINT seed)
+{
+	BYTE crc = seed;
+	size_t i = 0;
+
+	while (i < length) {
+		crc = bench_crc8_table[crc ^ bytes[i++]];
+	}
+	return crc;
+}
+
+/* The previous CRC16seeded loop (parity of each byte) */
+static UINT Bench_CRC16(const BYTE * bytes, const size_t length, const UINT seed)
+{
+	static const UINT parity[16] = { 0, 1, 1, 0, 1, 0, 0, 1, 1, 0, 0, 1, 0, 1, 1, 0 };
+	UINT sd = seed;
+	size_t i;
+
+	for (i = 0; i < length; ++i) {
+		UINT c = (bytes[i] ^ (sd & 0xFF)) & 0xFF;
+		sd >>= 8;
+		if (parity[c & 0x0F] ^ parity[c >> 4]) {
+			sd ^= 0xC001;
+		}
+		sd ^= (c <<= 6);
+		sd ^= (c << 1);
+	}
+	return sd;
+}
+
+static double Bench_now(void)
+{
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec + tv.tv_usec / 1000000.;
+}
+
+int main(int argc, char **argv)
+{
+	static const size_t sizes[] = { 8, 10, 32, 64, 256, 512, 4096, };
+	size_t max_size = sizes[sizeof(sizes) / sizeof(sizes[0]) - 1];
+	double megabytes = (argc > 1) ? atof(argv[1]) : 64.;
+	BYTE *buffer;
+	size_t s;
+	size_t i;
+	UINT sink = 0;
+
+	buffer = malloc(max_size);
+	if (buffer == NULL) {
+		return 1;
+	}
+	Bench_CRC8_table();
+	srand(1);
+	for (i = 0; i < max_size; ++i) {
+		buffer[i] = rand() & 0xFF;
+	}
+
+	// same answers for every length and a few seeds
+	for (i = 0; i <= max_size; ++i) {
+		UINT seed = i & 0x3F;
+		if (CRC8compute(buffer, i, seed) != Bench_CRC8(buffer, i, seed)
+			|| CRC16compute(buffer, i, seed) != Bench_CRC16(buffer, i, seed)) {
+			fprintf(stderr, "CRC mismatch at length %d\n", (int) i);
+			return 1;
+		}
+	}
+
+	printf("%8s %14s %14s %14s %14s\n", "bytes", "crc8 old MB/s", "crc8 new MB/s", "crc16 old MB/s", "crc16 new MB/s");
+	for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s) {
+		size_t size = sizes[s];
+		long loops = (long) (megabytes * 1000000. / size) + 1;
+		double mb = loops * (double) size / 1000000.;
+		double t[4];
+		long l;
+
+		t[0] = Bench_now();
+		for (l = 0; l < loops; ++l) {
+			sink += Bench_CRC8(buffer, size, l);
+		}
+		t[1] = Bench_now();
+		for (l = 0; l < loops; ++l) {
+			sink += CRC8compute(buffer, size, l);
+		}
+		t[2] = Bench_now();
+		printf("%8d %14.1f %14.1f ", (int) size, mb / (t[1] - t[0]), mb / (t[2] - t[1]));
+
+		t[0] = Bench_now();
+		for (l = 0; l < loops; ++l) {
+			sink += Bench_CRC16(buffer, size, l & 0xFFFF);
+		}
+		t[1] = Bench_now();
+		for (l = 0; l < loops; ++l) {
+			sink += CRC16compute(buffer, size, l & 0xFFFF);
+		}
+		t[2] = Bench_now();
+		printf("%14.1f %14.1f\n", mb / (t[1] - t[0]), mb / (t[2] - t[1]));
+	}
+
+	free(buffer);
+	return sink == 0x12345678;	// keep the loops from being optimised away
+}
@@ -53,6 +53,11 @@ struct global Globals = {
 
 	.readonly = 0,
 	.max_clients = 250,
+	.server_workers = 0,
+	.server_pool = 8,
+	.fanout_threads = 16,
+	.fuse_workers = 2,
+	.registry = 0,
 
 	.cache_size = 0,
 
@@ -84,6 +89,7 @@ struct global Globals = {
 	.no_dirall = 0,
 	.no_get = 0,
 	.no_persistence = 0,
+	.no_pipeline = 0,
 	.eightbit_serial = 0,
 	.trim = 0, // don't whitespace trim results by default
 	.zero = zero_unknown ,
@@ -308,7 +308,8 @@ static GOOD_OR_BAD OW_temperature_ready( enum temperature_problem_flag accept_85
 
 static GOOD_OR_BAD OW_read_piostate(UINT * piostate, const struct parsedname *pn) ;
 static _FLOAT OW_masked_temperature( BYTE * data, struct tempresolution * Resolution ) ;
-static GOOD_OR_BAD OW_poll_convert(const struct parsedname *pn) ;
+static GOOD_OR_BAD OW_poll_convert(UINT delay, const struct parsedname *pn) ;
+static GOOD_OR_BAD OW_powered_convert( UINT delay, const struct parsedname *pn ) ;
 
 static GOOD_OR_BAD OW_r_mem(BYTE * data, size_t size, off_t offset, struct parsedname *pn) ;
 static GOOD_OR_BAD OW_w_mem( BYTE * data, size_t size, off_t offset, struct parsedname * pn ) ;
@@ -768,8 +769,29 @@ static GOOD_OR_BAD OW_test_resolution( int * resolution_changed, struct tempreso
 	return gbGOOD;	
 }
 
+/* Convert a single powered chip */
+static GOOD_OR_BAD OW_powered_convert( UINT delay, const struct parsedname *pn )
+{
+	BYTE convert[] = { _1W_CONVERT_T, };
+	GOOD_OR_BAD ret;
+	struct transaction_log tpowered[] = {
+		TRXN_START,
+		TRXN_WRITE1(convert),
+		TRXN_END,
+	};
+
+	// powered, so poll bus for faster conversion
+	// (or release the bus to others for the conversion time)
+	LEVEL_DEBUG("Powered temperature conversion -- poll for completion");
+	BUSLOCK(pn);
+	ret = BUS_transaction_nolock(tpowered, pn) || OW_poll_convert(delay, pn);
+	BUSUNLOCK(pn);
+	return ret ;
+}
+
 /* returns when temperature is ready for reading
- * Based on cache, simultaneous, or delay */
+ * Based on cache, simultaneous, or delay
+ * Concurrent readers of powered chips share one bus-wide conversion */
 static GOOD_OR_BAD OW_temperature_ready( enum temperature_problem_flag accept_85C, int simul_good, struct tempresolution * Resolution, const struct parsedname *pn)
 {
 	BYTE convert[] = { _1W_CONVERT_T, };
@@ -783,11 +805,6 @@ static GOOD_OR_BAD OW_temperature_ready( enum temperature_problem_flag accept_85
 		TRXN_POWER(convert, delay),
 		TRXN_END,
 	};
-	struct transaction_log tpowered[] = {
-		TRXN_START,
-		TRXN_WRITE1(convert),
-		TRXN_END,
-	};
 	// failsafe
 	struct transaction_log tunpowered_long[] = {
 		TRXN_START,
@@ -821,14 +838,18 @@ static GOOD_OR_BAD OW_temperature_ready( enum temperature_problem_flag accept_85
 			LEVEL_DEBUG("Powered temperature conversion just one channel -- %d msec", delay);
 			// If not powered, no Simultaneous for this chip
 			RETURN_BAD_IF_BAD(BUS_transaction(tunpowered, pn)) ;
+		} else if ( must_convert || pn->ds2409_depth > 0 ) {
+			// new resolution, or behind a branch -- convert just this chip
+			RETURN_BAD_IF_BAD( OW_powered_convert( delay, pn ) ) ;
 		} else {
-			// powered, so poll bus for faster conversion
-			GOOD_OR_BAD ret;
-			LEVEL_DEBUG("Powered temperature conversion -- poll for completion");
-			BUSLOCK(pn);
-			ret = BUS_transaction_nolock(tpowered, pn) || OW_poll_convert(pn);
-			BUSUNLOCK(pn);
-			RETURN_BAD_IF_BAD(ret);
+			// share a conversion with other readers on this bus if possible
+			UINT generation ;
+			GOOD_OR_BAD ret = FS_Convert_Join( delay, &generation, pn ) ;
+			if ( ret == gbOTHER ) {
+				ret = OW_powered_convert( delay, pn ) ;
+				FS_Convert_Leave( delay, generation, pn ) ;
+			}
+			RETURN_BAD_IF_BAD( ret ) ;
 		}
 	} else {
 		// valid simultaneous, just delay if needed
@@ -1066,9 +1087,13 @@ static enum eDie OW_die(const struct parsedname *pn)
 
 /* Powered temperature measurements -- need to poll line since it is held low during measurement */
 /* We check every 10 msec (arbitrary) up to 1.25 seconds */
-static GOOD_OR_BAD OW_poll_convert(const struct parsedname *pn)
+/* Called with the bus locked
+ * If other threads are waiting for the bus, stop polling
+ * and unlock the bus for the rest of the conversion (delay msec) instead */
+static GOOD_OR_BAD OW_poll_convert(UINT delay, const struct parsedname *pn)
 {
 	int i;
+	UINT elapsed = 0 ;
 	BYTE p[1];
 	struct transaction_log t[] = {
 		{NULL, NULL, 10, trxn_delay,},
@@ -1080,14 +1105,24 @@ static GOOD_OR_BAD OW_poll_convert(const struct parsedname *pn)
 	// subsequent polling is slower since the DS18x20 is a slower converter
 	for (i = 0; i < 22; ++i) {
 		//LEVEL_DEBUG("TEST polling %d",i);
+		if ( BUS_waiting(pn) ) {
+			// the device converts on its own power, no need to keep the bus
+			UINT remaining = ( delay > elapsed ) ? delay - elapsed : 0 ;
+			LEVEL_DEBUG("Bus wanted -- release it for the remaining %d msec", remaining);
+			BUSUNLOCK(pn);
+			UT_delay(remaining);
+			BUSLOCK(pn);
+			return gbGOOD;
+		}
 		if ( BAD( BUS_transaction_nolock(t, pn) )) {
 			LEVEL_DEBUG("BUS_transaction failed");
 			break;
 		}
 		if (p[0] != 0) {
-			LEVEL_DEBUG("BUS_transaction done after %dms", (i + 1) * 10);
+			LEVEL_DEBUG("BUS_transaction done after %dms", elapsed + t[0].size);
 			return gbGOOD;
 		}
+		elapsed += t[0].size;
 		t[0].size = 50;			// 50 msec for rest of delays
 	}
 	LEVEL_DEBUG("Temperature measurement failed");
@@ -820,7 +820,7 @@ static GOOD_OR_BAD OW_temp(_FLOAT * T, int simul_good, const struct parsedname *
 	struct transaction_log tconvert[] = {
 		TRXN_START,
 		TRXN_WRITE1(t),
-		TRXN_DELAY(delay),
+		TRXN_RELEASE_DELAY(delay),
 		TRXN_END,
 	};
 	// write conversion command
@@ -882,7 +882,7 @@ static GOOD_OR_BAD OW_volts(_FLOAT * V, enum voltage_source src, const struct pa
 	struct transaction_log tconvert[] = {
 		TRXN_START,
 		TRXN_WRITE1(v),
-		TRXN_DELAY(10), // 10 ms
+		TRXN_RELEASE_DELAY(10), // 10 ms, others may use the bus
 		TRXN_END,
 	};
 
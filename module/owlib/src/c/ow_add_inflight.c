@@ -19,6 +19,9 @@ $Id$
  * write lock is done in a separate thread when no requests are being processed */
 void Add_InFlight( GOOD_OR_BAD (*nomatch)(struct port_in * trial,struct port_in * existing), struct port_in * new_pin )
 {
+	struct connection_in * in ;
+	int reader ;
+
 	if ( new_pin == NULL ) {
 		return ;
 	}
@@ -39,5 +42,14 @@ void Add_InFlight( GOOD_OR_BAD (*nomatch)(struct port_in * trial,struct port_in
 		}
 	}
 	LinkPort(new_pin);
+	// read the new port safely once the write lock is gone
+	reader = Connection_Read_Begin() ;
 	CONNIN_WUNLOCK ;
+
+	// poll and watch the new bus like the ones found at start up
+	for ( in = new_pin->first ; in != NO_CONNECTION ; in = in->next ) {
+		Poll_Start_Bus( in ) ;
+		Registry_Start_Bus( in ) ;
+	}
+	Connection_Read_End( reader ) ;
 }
@@ -34,8 +34,13 @@ void BUS_unlock(const struct parsedname *pn)
 
 void BUS_lock_in(struct connection_in *in)
 {
+	if (!in) {
+		return;
+	}
+	STAT_ADD1(in->bus_waiting);
 	PORTLOCKIN(in) ;
 	CHANNELLOCKIN(in) ;
+	STAT_SUB(in->bus_waiting, 1);
 }
 
 void BUS_unlock_in(struct connection_in *in)
@@ -44,6 +49,16 @@ void BUS_unlock_in(struct connection_in *in)
 	PORTUNLOCKIN(in) ;
 }
 
+/* Are other threads queued for this bus? (called with the bus locked)
+ * A long wait (e.g. temperature conversion) can then release the bus */
+int BUS_waiting(const struct parsedname *pn)
+{
+	if ( pn == NULL || pn->selected_connection == NO_CONNECTION ) {
+		return 0 ;
+	}
+	return STAT_READ(pn->selected_connection->bus_waiting) > 0 ;
+}
+
 /* Lock just the bus master channel (and keep time statistics) */
 void CHANNEL_lock_in(struct connection_in *in)
 {
@@ -72,10 +87,8 @@ void CHANNEL_unlock_in(struct connection_in *in)
 	}
 	timersub( &tv, &(in->last_lock), &tv ) ;
 
-	STATLOCK;
-	timeradd( &tv, &(in->bus_time), &(in->bus_time) ) ;
-	++in->bus_stat[e_bus_unlocks];
-	STATUNLOCK;
+	STAT_ADD( in->bus_time, (uint64_t) tv.tv_sec * 1000000 + tv.tv_usec ) ;
+	STAT_ADD1_BUS(e_bus_unlocks, in);
 
 	_MUTEX_UNLOCK(in->bus_mutex);
 }
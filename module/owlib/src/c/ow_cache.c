@@ -45,25 +45,28 @@ void * Alias_Marker = &AliasMarkerLoc ;
 
 /* Put the globals into a struct to declutter the namespace */
 struct cache_data {
-	void *temporary_tree_new;			// current cache database
-	void *temporary_tree_old;			// older cache database
 	void *persistent_tree;				// persistent database
 	void *temporary_alias_tree_new;		// current cache database
 	void *temporary_alias_tree_old;		// older cache database
 	void *persistent_alias_tree;		// persistent database
-	size_t old_ram_size;				// cache size
-	size_t new_ram_size;				// cache size
-	time_t time_retired;				// start time of older
-	time_t time_to_kill;				// deathtime of older
+	size_t alias_ram_size;				// alias cache size
+	time_t alias_time_to_kill;			// deathtime of older alias tree
 	time_t retired_lifespan;			// lifetime of older
-	UINT added;					// items added
 };
 static struct cache_data cache;
 
-/* Cache elements are placed in a Red/Black binary tree
-	-- standard glibc implementation
-	-- use gnu tdestroy extension
-	-- compatibility implementation included
+/* Temporary cache elements are placed in hash tables
+	-- split into CACHE_SHARDS independent shards, each with its own lock
+	-- shard chosen by a hash of the key, so unrelated lookups don't contend
+	-- open addressing with linear probing within a shard
+	-- entries are never removed individually (deletion just marks them expired)
+	   so no tombstones are needed
+  Each shard keeps two generations ("new" and "old") and flips them
+    independently when the old generation has outlived retired_lifespan
+  The generation pushed out by a flip is not freed at once (that would stall
+    readers of the shard), but parked as "dead" and swept a few slots at a
+    time by later adds to the same shard (see CacheSweep)
+  Persistent and alias caches are still kept in tsearch trees (rarely used)
   Cache key has 3 components: (struct tree_key)
 	sn -- 8 byte serial number of 1-wire slave
 	p -- pointer to internal structure like filetype (guaranteed unique if non-portable)
@@ -75,11 +78,41 @@ static struct cache_data cache;
   Cache data is the actual data
 	allocated at same call as cache node
 	access via macro TREE_DATA
-	freed when cache node is freed
+	freed when cache node is freed (CacheNodeFree)
   Note: This means that cache data must be a copy of program data
         both on creation and retrieval
+	except directories: the data is a struct dirblob sharing a frozen
+	snapshot of the listing, a reference is handed out on retrieval
 */
 
+#define CACHE_SHARD_BITS	5
+#define CACHE_SHARDS		(1<<CACHE_SHARD_BITS)
+#define CACHE_TABLE_MIN		32	// initial slots in a table, power of 2
+#define CACHE_SWEEP_SLOTS	16	// dead slots reclaimed per add
+
+struct tree_node ;
+
+/* One generation of a shard */
+struct cache_table {
+	struct tree_node **slot;	// NULL is an empty slot
+	size_t size;				// number of slots (power of 2 or 0)
+	size_t count;				// used slots
+};
+
+struct cache_shard {
+	my_rwlock_t lock;
+	struct cache_table table_new;	// current generation
+	struct cache_table table_old;	// older generation
+	struct cache_table table_dead;	// retired generation, being reclaimed
+	size_t sweep_index;				// next slot of table_dead to reclaim
+	size_t dead_ram_size;			// cache size (not yet reclaimed)
+	size_t old_ram_size;			// cache size
+	size_t new_ram_size;			// cache size
+	time_t time_retired;			// start time of older
+	time_t time_to_kill;			// deathtime of older
+};
+static struct cache_shard cache_shard[CACHE_SHARDS];
+
 /* Key used for sorting/retrieving cache data
    sn is for device serial number
    p is a pointer to filetype, or other things (guaranteed unique and fast lookup
@@ -128,7 +161,16 @@ struct tree_opaque {
 
 enum cache_task_return { ctr_ok, ctr_not_found, ctr_expired, ctr_size_mismatch, } ;
 
-static void FlipTree( void ) ;
+static void FlipShard( struct cache_shard * shard, struct cache_table * reclaim ) ;
+static void CacheSweep( struct cache_shard * shard ) ;
+static void FlipAliasTree( void ) ;
+
+static UINT CacheHash( const struct tree_key * tk ) ;
+static struct cache_shard * CacheShard( UINT hash ) ;
+static struct tree_node * CacheTableFind( const struct cache_table * table, const struct tree_node * tn, UINT hash ) ;
+static GOOD_OR_BAD CacheTableInsert( struct cache_table * table, struct tree_node * tn, UINT hash, struct tree_node ** replaced ) ;
+static void CacheTableDestroy( struct cache_table * table ) ;
+static void CacheNodeFree( struct tree_node * tn ) ;
 
 static int IsThisPersistent( const struct parsedname * pn ) ;
 
@@ -187,6 +229,117 @@ static int alias_tree_compare(const void *a, const void *b)
 	return memcmp( CONST_ALIAS_TREE_DATA((const struct alias_tree_node *) a), CONST_ALIAS_TREE_DATA((const struct alias_tree_node *) b), da);
 }
 
+/* Hash of the cache key (FNV-1a) */
+/* The key is zeroed before loading (LoadTK) so padding bytes are consistent */
+static UINT CacheHash( const struct tree_key * tk )
+{
+	const BYTE * key_byte = (const BYTE *) tk ;
+	UINT hash = 2166136261u ;
+	size_t byte_index ;
+
+	for ( byte_index = 0 ; byte_index < sizeof(struct tree_key) ; ++byte_index ) {
+		hash ^= key_byte[byte_index] ;
+		hash *= 16777619u ;
+	}
+	return hash ;
+}
+
+/* low bits pick the shard, the rest pick the slot in the table */
+static struct cache_shard * CacheShard( UINT hash )
+{
+	return &cache_shard[ hash & (CACHE_SHARDS-1) ] ;
+}
+
+/* Find matching node in a table, or NULL. Shard lock must be held */
+static struct tree_node * CacheTableFind( const struct cache_table * table, const struct tree_node * tn, UINT hash )
+{
+	size_t mask = table->size - 1 ;
+	size_t slot_index ;
+
+	if ( table->count == 0 ) {
+		return NULL ;
+	}
+
+	for ( slot_index = (hash >> CACHE_SHARD_BITS) & mask ; table->slot[slot_index] != NULL ; slot_index = (slot_index + 1) & mask ) {
+		if ( tree_compare( tn, table->slot[slot_index] ) == 0 ) {
+			return table->slot[slot_index] ;
+		}
+	}
+	return NULL ;
+}
+
+/* Add node to table, growing it if more than 3/4 full. Shard write lock must be held */
+/* replaced is set to the displaced node with the same key (to be freed by caller) or NULL */
+static GOOD_OR_BAD CacheTableInsert( struct cache_table * table, struct tree_node * tn, UINT hash, struct tree_node ** replaced )
+{
+	size_t mask ;
+	size_t slot_index ;
+
+	replaced[0] = NULL ;
+
+	if ( 4 * (table->count + 1) > 3 * table->size ) {
+		// grow (or create) the table and rehash everything
+		size_t new_size = ( table->size == 0 ) ? CACHE_TABLE_MIN : 2 * table->size ;
+		struct tree_node ** new_slot = (struct tree_node **) owcalloc( new_size, sizeof(struct tree_node *) ) ;
+		size_t old_index ;
+
+		if ( new_slot == NULL ) {
+			return gbBAD ;
+		}
+		for ( old_index = 0 ; old_index < table->size ; ++old_index ) {
+			struct tree_node * moved = table->slot[old_index] ;
+			if ( moved != NULL ) {
+				for ( slot_index = (CacheHash( &(moved->tk) ) >> CACHE_SHARD_BITS) & (new_size-1) ; new_slot[slot_index] != NULL ; slot_index = (slot_index + 1) & (new_size-1) ) {
+				}
+				new_slot[slot_index] = moved ;
+			}
+		}
+		SAFEFREE( table->slot ) ;
+		table->slot = new_slot ;
+		table->size = new_size ;
+	}
+
+	mask = table->size - 1 ;
+	for ( slot_index = (hash >> CACHE_SHARD_BITS) & mask ; table->slot[slot_index] != NULL ; slot_index = (slot_index + 1) & mask ) {
+		if ( tree_compare( tn, table->slot[slot_index] ) == 0 ) {
+			// same key -- swap in new data
+			replaced[0] = table->slot[slot_index] ;
+			table->slot[slot_index] = tn ;
+			return gbGOOD ;
+		}
+	}
+	table->slot[slot_index] = tn ;
+	++table->count ;
+	return gbGOOD ;
+}
+
+/* Free all nodes and the table itself. Shard write lock must be held (or table detached) */
+/* Slots already swept are NULL and skipped */
+static void CacheTableDestroy( struct cache_table * table )
+{
+	size_t slot_index ;
+
+	for ( slot_index = 0 ; slot_index < table->size ; ++slot_index ) {
+		CacheNodeFree( table->slot[slot_index] ) ;
+	}
+	SAFEFREE( table->slot ) ;
+	table->size = 0 ;
+	table->count = 0 ;
+}
+
+/* Free a node of the shard tables (NULL is ignored) */
+/* a directory holds a reference to a dirblob snapshot */
+static void CacheNodeFree( struct tree_node * tn )
+{
+	if ( tn == NULL ) {
+		return ;
+	}
+	if ( tn->tk.p == Directory_Marker ) {
+		DirblobClear( (struct dirblob *) TREE_DATA(tn) ) ;
+	}
+	owfree( tn ) ;
+}
+
 /* Gives the delay for a given property type */
 /* Values in seconds (as defined in Globals structure and modified by command line and "settings") */
 static time_t TimeOut(const enum fc_change change)
@@ -249,8 +402,17 @@ static void tree_show(const void *node, const VISIT which, const int depth)
 }
 static void new_tree(void)
 {
-	fprintf(stderr,"Walk the new tree:\n");
-	twalk(cache.temporary_tree_new, tree_show);
+	int shard_index ;
+	fprintf(stderr,"Walk the new tables:\n");
+	for ( shard_index = 0 ; shard_index < CACHE_SHARDS ; ++shard_index ) {
+		struct cache_table * table = &cache_shard[shard_index].table_new ;
+		size_t slot_index ;
+		for ( slot_index = 0 ; slot_index < table->size ; ++slot_index ) {
+			if ( table->slot[slot_index] != NULL ) {
+				node_show(table->slot[slot_index]);
+			}
+		}
+	}
 }
 #else							/* CACHE_DEBUG */
 #define new_tree()
@@ -266,6 +428,9 @@ static int IsThisPersistent( const struct parsedname * pn )
 /* Note: done in single-threaded mode so locking not yet needed */
 void Cache_Open(void)
 {
+	int shard_index ;
+	time_t now = NOW_TIME ;
+
 	memset(&cache, 0, sizeof(struct cache_data));
 
 	cache.retired_lifespan = TimeOut(fc_stable);
@@ -273,8 +438,19 @@ void Cache_Open(void)
 		cache.retired_lifespan = 3600;	/* 1 hour tops */
 	}
 
-	// Flip once (at start) to set up old tree.
-	FlipTree() ;
+	// Set up empty shards as if just flipped.
+	for ( shard_index = 0 ; shard_index < CACHE_SHARDS ; ++shard_index ) {
+		struct cache_shard * shard = &cache_shard[shard_index] ;
+		memset( &(shard->table_new), 0, sizeof(struct cache_table) ) ;
+		memset( &(shard->table_old), 0, sizeof(struct cache_table) ) ;
+		memset( &(shard->table_dead), 0, sizeof(struct cache_table) ) ;
+		shard->sweep_index = 0 ;
+		shard->new_ram_size = shard->old_ram_size = shard->dead_ram_size = 0 ;
+		shard->time_retired = now ;
+		shard->time_to_kill = now + cache.retired_lifespan ;
+		RWLOCK_INIT( shard->lock ) ;
+	}
+	cache.alias_time_to_kill = now + cache.retired_lifespan ;
 }
 
 /* Note: done in a simgle single thread mode so locking not needed */
@@ -285,47 +461,123 @@ void Cache_Close(void)
 	SAFETDESTROY( cache.persistent_alias_tree, owfree_func);
 }
 
-/* Moves new to old tree, initializes new tree, and clears former old tree location */
-static void FlipTree( void )
+/* Moves new to old table, initializes new table, and parks former old table for sweeping */
+/* Shard write lock must be held */
+/* Whatever the sweep hadn't reached yet of the previous dead table is moved to reclaim,
+   to be freed by the caller after the lock is released */
+static void FlipShard( struct cache_shard * shard, struct cache_table * reclaim )
 {
-	void * flip = cache.temporary_tree_old; // old old saved for later clearing
-	void * flip_alias = cache.temporary_alias_tree_old; // old old saved for later clearing
+	UINT retired_count = shard->table_new.count ;
+	UINT dead_count = shard->table_old.count ;
 
 	/* Flip caches! old = new. New truncated, reset time and counters and flag */
-	LEVEL_DEBUG("Flipping cache tree (purging timed-out data)");
+	LEVEL_DEBUG("Flipping cache shard %d (purging timed-out data)", (int) (shard - cache_shard) );
 
-	// move "new" pointers to "old"
-	cache.temporary_tree_old = cache.temporary_tree_new;
-	cache.old_ram_size = cache.new_ram_size;
-	cache.temporary_alias_tree_old = cache.temporary_alias_tree_new;
+	// unfinished sweep goes to the caller
+	reclaim[0] = shard->table_dead ;
+
+	// move "old" to "dead" and "new" to "old"
+	shard->table_dead = shard->table_old ;
+	shard->dead_ram_size = shard->old_ram_size ;
+	shard->sweep_index = 0 ;
+	shard->table_old = shard->table_new;
+	shard->old_ram_size = shard->new_ram_size;
 
 	// New cache setup
-	cache.temporary_tree_new = NULL;
-	cache.temporary_alias_tree_new = NULL;
-	cache.new_ram_size = 0;
-	cache.added = 0;
+	memset( &(shard->table_new), 0, sizeof(struct cache_table) ) ;
+	shard->new_ram_size = 0;
 
 	// set up "old" cache times
-	cache.time_retired = NOW_TIME;
-	cache.time_to_kill = cache.time_retired + cache.retired_lifespan;
+	shard->time_retired = NOW_TIME;
+	shard->time_to_kill = shard->time_retired + cache.retired_lifespan;
+
+	STAT_ADD1(cache_flips);			/* statistics */
+	STAT_ADD(old_avg.current, retired_count) ;
+	STAT_SUB(old_avg.current, dead_count) ;
+	STAT_ADD(old_avg.count, retired_count) ;
+	STAT_ADD(old_avg.sum, STAT_READ(old_avg.current)) ;
+	StatMax( &(old_avg.max), STAT_READ(old_avg.current) ) ;
+	STAT_SUB(new_avg.current, retired_count) ;
+}
+
+/* Free a few slots of the shard's dead table */
+/* Shard write lock must be held (readers never look at the dead table) */
+static void CacheSweep( struct cache_shard * shard )
+{
+	struct cache_table * dead = &(shard->table_dead) ;
+	size_t stop = shard->sweep_index + CACHE_SWEEP_SLOTS ;
+	UINT reclaimed = 0 ;
+
+	if ( dead->size == 0 ) {
+		return ;
+	}
+
+	for ( ; shard->sweep_index < dead->size && shard->sweep_index < stop ; ++shard->sweep_index ) {
+		if ( dead->slot[shard->sweep_index] != NULL ) {
+			shard->dead_ram_size -= sizeof(struct tree_node) + dead->slot[shard->sweep_index]->dsize ;
+			CacheNodeFree( dead->slot[shard->sweep_index] ) ;
+			dead->slot[shard->sweep_index] = NULL ;
+			--dead->count ;
+			++reclaimed ;
+		}
+	}
+
+	if ( shard->sweep_index >= dead->size ) {
+		// table finished
+		SAFEFREE( dead->slot ) ;
+		dead->size = 0 ;
+		dead->count = 0 ;
+		shard->sweep_index = 0 ;
+		shard->dead_ram_size = 0 ;
+	}
+
+	if ( reclaimed > 0 ) {
+		STAT_ADD(cache_reclaims, reclaimed) ;
+	}
+}
+
+/* Moves new to old alias tree, and clears former old tree */
+/* CACHE_WLOCK must be held */
+static void FlipAliasTree( void )
+{
+	void * flip_alias = cache.temporary_alias_tree_old; // old old saved for later clearing
+
+	cache.temporary_alias_tree_old = cache.temporary_alias_tree_new;
+	cache.temporary_alias_tree_new = NULL;
+	cache.alias_ram_size = 0 ;
+	cache.alias_time_to_kill = NOW_TIME + cache.retired_lifespan;
 
-	// delete really old tree
-	LEVEL_DEBUG("flip cache. tdestroy() will be called.");
-	SAFETDESTROY( flip, owfree_func);
 	SAFETDESTROY( flip_alias, owfree_func);
-	STATLOCK;
-	++cache_flips;			/* statistics */
-	memcpy(&old_avg, &new_avg, sizeof(struct average));
-	AVERAGE_CLEAR(&new_avg);
-	STATUNLOCK;
 }
 
 /* Clear the cache (a change was made that might give stale information) */
+/* Each shard is only locked long enough to detach its tables */
 void Cache_Clear(void)
 {
+	int shard_index ;
+
+	for ( shard_index = 0 ; shard_index < CACHE_SHARDS ; ++shard_index ) {
+		struct cache_shard * shard = &cache_shard[shard_index] ;
+		struct cache_table reclaim[3] ;
+		int reclaim_index ;
+
+		RWLOCK_WLOCK( shard->lock ) ;
+		FlipShard( shard, &reclaim[0] ) ;
+		FlipShard( shard, &reclaim[1] ) ;
+		reclaim[2] = shard->table_dead ;
+		memset( &(shard->table_dead), 0, sizeof(struct cache_table) ) ;
+		shard->sweep_index = 0 ;
+		shard->dead_ram_size = 0 ;
+		RWLOCK_WUNLOCK( shard->lock ) ;
+
+		for ( reclaim_index = 0 ; reclaim_index < 3 ; ++reclaim_index ) {
+			CacheTableDestroy( &reclaim[reclaim_index] ) ;
+		}
+	}
+
 	CACHE_WLOCK;
-	FlipTree() ;
-	FlipTree() ;
+	FlipAliasTree() ;
+	FlipAliasTree() ;
 	CACHE_WUNLOCK;
 }
 
@@ -438,7 +690,7 @@ GOOD_OR_BAD Cache_Add_Dir(const struct dirblob *db, const struct parsedname *pn)
 {
 	time_t duration = TimeOut(fc_directory);
 	struct tree_node *tn;
-	size_t size = DirblobElements(db) * SERIAL_NUMBER_SIZE;
+	size_t size = sizeof(struct dirblob);
 	struct parsedname pn_directory;
 
 	if (pn==NO_PARSEDNAME || pn->selected_connection==NO_CONNECTION) {
@@ -482,8 +734,10 @@ GOOD_OR_BAD Cache_Add_Dir(const struct dirblob *db, const struct parsedname *pn)
 	LoadTK( pn_directory.sn, Directory_Marker, pn->selected_connection->index, tn );
 	tn->expires = duration + NOW_TIME;
 	tn->dsize = size;
-	if (size) {
-		memcpy(TREE_DATA(tn), db->snlist, size);
+	// shares the listing if frozen by the caller
+	if ( DirblobShare( (struct dirblob *) TREE_DATA(tn), db ) != 0 ) {
+		owfree(tn);
+		return gbBAD;
 	}
 	return Add_Stat(&cache_dir, Cache_Add_Common(tn));
 }
@@ -624,50 +878,51 @@ GOOD_OR_BAD Cache_Add_Alias(const ASCII *name, const BYTE * sn)
 }
 
 /* Add an item to the cache */
-/* retire the cache (flip) if too old, and start a new one (keep the old one for a while) */
+/* retire the shard (flip) if too old, and start a new one (keep the old one for a while) */
 /* return 0 if good, 1 if not */
 static GOOD_OR_BAD Cache_Add_Common(struct tree_node *tn)
 {
-	struct tree_opaque *opaque;
+	UINT hash = CacheHash( &(tn->tk) ) ;
+	struct cache_shard * shard = CacheShard( hash ) ;
+	struct tree_node * replaced = NULL ;
+	struct cache_table reclaim = { NULL, 0, 0, } ;
+	size_t node_size = sizeof(struct tree_node) + tn->dsize ;
 	enum { no_add, yes_add, just_update } state = no_add;
 
 	node_show(tn);
 	LEVEL_DEBUG("Add to cache sn " SNformat " pointer=%p index=%d size=%d", SNvar(tn->tk.sn), tn->tk.p, tn->tk.extension, tn->dsize);
-	CACHE_WLOCK;
-	if (cache.time_to_kill < NOW_TIME) {	// old database has timed out
-		FlipTree() ;
-	}
-	if (Globals.cache_size && (cache.old_ram_size + cache.new_ram_size > Globals.cache_size)) {
-		// failed size test
-		owfree(tn);
-	} else if ((opaque = tsearch(tn, &cache.temporary_tree_new, tree_compare))) {
-		//printf("Cache_Add_Common to %p\n",opaque);
-		if (tn != opaque->key) {
-			cache.new_ram_size += sizeof(tn) - sizeof(opaque->key);
-			owfree(opaque->key);
-			opaque->key = tn;
+	RWLOCK_WLOCK( shard->lock ) ;
+	if (shard->time_to_kill < NOW_TIME) {	// old database has timed out
+		FlipShard( shard, &reclaim ) ;
+	}
+	CacheSweep( shard ) ;
+	if (Globals.cache_size && (CACHE_SHARDS * (shard->dead_ram_size + shard->old_ram_size + shard->new_ram_size + node_size) > Globals.cache_size)) {
+		// failed size test (each shard gets an equal part of the allowance)
+		CacheNodeFree(tn);
+	} else if ( GOOD( CacheTableInsert( &(shard->table_new), tn, hash, &replaced ) ) ) {
+		shard->new_ram_size += node_size ;
+		if ( replaced != NULL ) {
+			shard->new_ram_size -= sizeof(struct tree_node) + replaced->dsize ;
+			CacheNodeFree( replaced ) ;
 			state = just_update;
 		} else {
 			state = yes_add;
-			cache.new_ram_size += sizeof(tn);
 		}
 	} else {					// nothing found or added?!? free our memory segment
-		owfree(tn);
+		CacheNodeFree(tn);
 	}
-	CACHE_WUNLOCK;
+	RWLOCK_WUNLOCK( shard->lock ) ;
+	// normally empty -- only if a flip came before the sweep finished
+	CacheTableDestroy( &reclaim ) ;
 	/* Added or updated, update statistics */
 	switch (state) {
 		case yes_add: // add new entry
-			STATLOCK;
 			AVERAGE_IN(&new_avg);
-			++cache_adds;			/* statistics */
-			STATUNLOCK;
+			STAT_ADD1(cache_adds);			/* statistics */
 			return gbGOOD;
 		case just_update: // update the time mark and data
-			STATLOCK;
 			AVERAGE_MARK(&new_avg);
-			++cache_adds;			/* statistics */
-			STATUNLOCK;
+			STAT_ADD1(cache_adds);			/* statistics */
 			return gbGOOD;
 		default: // unable to add
 			return gbBAD;
@@ -701,14 +956,10 @@ static GOOD_OR_BAD Cache_Add_Persistent(struct tree_node *tn)
 
 	switch (state) {
 	case yes_add:
-		STATLOCK;
 		AVERAGE_IN(&store_avg);
-		STATUNLOCK;
 		return gbGOOD;
 	case just_update:
-		STATLOCK;
 		AVERAGE_MARK(&store_avg);
-		STATUNLOCK;
 		return gbGOOD;
 	default:
 		return gbBAD;
@@ -719,20 +970,18 @@ static GOOD_OR_BAD Get_Stat(struct cache_stats *scache, const enum cache_task_re
 {
 	GOOD_OR_BAD gbret = gbBAD ; // default
 	
-	STATLOCK;
-	++scache->tries;
+	STAT_ADD1(scache->tries);
 	switch ( result ) {
 		case ctr_expired:
-			++scache->expires;
+			STAT_ADD1(scache->expires);
 			break ;
 		case ctr_ok:
-			++scache->hits;
+			STAT_ADD1(scache->hits);
 			gbret = gbGOOD ;
 			break ;
 		default:
 			break ;
 	}	
-	STATUNLOCK;
 	return gbret ;
 }
 
@@ -861,33 +1110,30 @@ static enum cache_task_return Cache_Get_Common_Dir(struct dirblob *db, time_t *
 {
 	enum cache_task_return ctr_ret;
 	time_t now = NOW_TIME;
-	size_t size;
-	struct tree_opaque *opaque;
+	UINT hash = CacheHash( &(tn->tk) ) ;
+	struct cache_shard * shard = CacheShard( hash ) ;
+	struct tree_node * found ;
 	LEVEL_DEBUG("Get from cache sn " SNformat " pointer=%p extension=%d", SNvar(tn->tk.sn), tn->tk.p, tn->tk.extension);
-	CACHE_RLOCK;
-	opaque = tfind(tn, &cache.temporary_tree_new, tree_compare) ;
-	if ( opaque == NULL ) {
-		// not found in new tree
-		if ( cache.time_retired + duration[0] > now ) {
-			// old tree could be new enough
-			opaque = tfind(tn, &cache.temporary_tree_old, tree_compare) ;
+	RWLOCK_RLOCK( shard->lock ) ;
+	found = CacheTableFind( &(shard->table_new), tn, hash ) ;
+	if ( found == NULL ) {
+		// not found in new table
+		if ( shard->time_retired + duration[0] > now ) {
+			// old table could be new enough
+			found = CacheTableFind( &(shard->table_old), tn, hash ) ;
 		}
 	}
-	if ( opaque != NULL ) {
-		duration[0] = opaque->key->expires - now ;
+	if ( found != NULL ) {
+		duration[0] = found->expires - now ;
 		if (duration[0] >= 0) {
 			LEVEL_DEBUG("Dir found in cache");
-			size = opaque->key->dsize;
-			if (DirblobRecreate(TREE_DATA(opaque->key), size, db) == 0) {
-				//printf("Cache: snlist=%p, devices=%lu, size=%lu\n",*snlist,devices[0],size) ;
+			// another reference, the node can't be freed while the shard is locked
+			if (DirblobShare(db, (struct dirblob *) TREE_DATA(found)) == 0) {
 				ctr_ret = ctr_ok;
 			} else {
 				ctr_ret = ctr_size_mismatch;
 			}
 		} else {
-			//char b[26];
-			//printf("GOT DEAD now:%s",ctime_r(&now,b)) ;
-			//printf("        then:%s",ctime_r(&opaque->key->expires,b)) ;
 			LEVEL_DEBUG("Dir expired in cache");
 			ctr_ret = ctr_expired;
 		}
@@ -895,7 +1141,7 @@ static enum cache_task_return Cache_Get_Common_Dir(struct dirblob *db, time_t *
 		LEVEL_DEBUG("Dir not found in cache");
 		ctr_ret = ctr_not_found;
 	}
-	CACHE_RUNLOCK;
+	RWLOCK_RUNLOCK( shard->lock ) ;
 	return ctr_ret;
 }
 
@@ -1065,36 +1311,34 @@ static enum cache_task_return Cache_Get_Common(void *data, size_t * dsize, time_
 {
 	enum cache_task_return ctr_ret;
 	time_t now = NOW_TIME;
-	struct tree_opaque *opaque;
+	UINT hash = CacheHash( &(tn->tk) ) ;
+	struct cache_shard * shard = CacheShard( hash ) ;
+	struct tree_node * found ;
 	
 	LEVEL_DEBUG("Search in cache sn " SNformat " pointer=%p index=%d size=%d", SNvar(tn->tk.sn), tn->tk.p, tn->tk.extension, (int) dsize[0]);
-	//node_show(tn);
-	//new_tree();
-	CACHE_RLOCK;
-	opaque = tfind(tn, &cache.temporary_tree_new, tree_compare) ;
-	if ( opaque == NULL ) {
-		// not found in new tree
-		if ( cache.time_retired + duration[0] > now ) {
+	RWLOCK_RLOCK( shard->lock ) ;
+	found = CacheTableFind( &(shard->table_new), tn, hash ) ;
+	if ( found == NULL ) {
+		// not found in new table
+		if ( shard->time_retired + duration[0] > now ) {
 			// retired time isn't too old for this data item
-			opaque = tfind(tn, &cache.temporary_tree_old, tree_compare) ;
+			found = CacheTableFind( &(shard->table_old), tn, hash ) ;
 		}
 	}
-	if ( opaque != NULL ) {
+	if ( found != NULL ) {
 		// modify duration to time left (can be negative if expired)
-		duration[0] = opaque->key->expires - now ;
+		duration[0] = found->expires - now ;
 		if (duration[0] > 0) {
 			LEVEL_DEBUG("Value found in cache. Remaining life: %d seconds.",duration[0]);
 			// Compared with >= before, but fc_second(1) always cache for 2 seconds in that case.
 			// Very noticable when reading time-data like "/26.80A742000000/date" for example.
-			if ( dsize[0] >= opaque->key->dsize) {
+			if ( dsize[0] >= found->dsize) {
 				// lower data size if stored value is shorter
-				dsize[0] = opaque->key->dsize;
-				//tree_show(opaque,leaf,0);
+				dsize[0] = found->dsize;
 				if (dsize[0] > 0) {
-					memcpy(data, TREE_DATA(opaque->key), dsize[0]);
+					memcpy(data, TREE_DATA(found), dsize[0]);
 				}
 				ctr_ret = ctr_ok;
-				//twalk(cache.temporary_tree_new,tree_show) ;
 			} else {
 				ctr_ret = ctr_size_mismatch;
 			}
@@ -1106,7 +1350,7 @@ static enum cache_task_return Cache_Get_Common(void *data, size_t * dsize, time_
 		LEVEL_DEBUG("Value not found in cache");
 		ctr_ret = ctr_not_found;
 	}
-	CACHE_RUNLOCK;
+	RWLOCK_RUNLOCK( shard->lock ) ;
 	return ctr_ret;
 }
 
@@ -1356,25 +1600,27 @@ void Cache_Del_Internal(const struct internal_prop *ip, const struct parsedname
 
 static GOOD_OR_BAD Cache_Del_Common(const struct tree_node *tn)
 {
-	struct tree_opaque *opaque;
 	time_t now = NOW_TIME;
 	GOOD_OR_BAD ret = gbBAD;
+	UINT hash = CacheHash( &(tn->tk) ) ;
+	struct cache_shard * shard = CacheShard( hash ) ;
+	struct tree_node * found ;
 	LEVEL_DEBUG("Delete from cache sn " SNformat " in=%p index=%d", SNvar(tn->tk.sn), tn->tk.p, tn->tk.extension);
 
-	CACHE_WLOCK;
-	opaque = tfind(tn, &cache.temporary_tree_new, tree_compare) ;
-	if ( opaque == NULL ) {
-		// not in new tree
-		if ( cache.time_to_kill > now ) {
-			// old tree still alive
-			opaque = tfind(tn, &cache.temporary_tree_old, tree_compare) ;
+	RWLOCK_WLOCK( shard->lock ) ;
+	found = CacheTableFind( &(shard->table_new), tn, hash ) ;
+	if ( found == NULL ) {
+		// not in new table
+		if ( shard->time_to_kill > now ) {
+			// old table still alive
+			found = CacheTableFind( &(shard->table_old), tn, hash ) ;
 		}
 	}
-	if ( opaque != NULL ) {
-		opaque->key->expires = now - 1;
+	if ( found != NULL ) {
+		found->expires = now - 1;
 		ret = gbGOOD;
 	}
-	CACHE_WUNLOCK;
+	RWLOCK_WUNLOCK( shard->lock ) ;
 
 	return ret;
 }
@@ -1397,9 +1643,7 @@ static GOOD_OR_BAD Cache_Del_Persistent(const struct tree_node *tn)
 	}
 
 	owfree(tn_found);
-	STATLOCK;
 	AVERAGE_OUT(&store_avg);
-	STATUNLOCK;
 	return gbGOOD;
 }
 
@@ -1491,19 +1735,18 @@ static void Cache_Add_Alias_Common(struct alias_tree_node *atn)
 	struct tree_opaque *opaque;
 
 	CACHE_WLOCK;
-	if (cache.time_to_kill < NOW_TIME) {	// old database has timed out
-		FlipTree() ;
+	if (cache.alias_time_to_kill < NOW_TIME) {	// old database has timed out
+		FlipAliasTree() ;
 	}
-	if (Globals.cache_size && (cache.old_ram_size + cache.new_ram_size > Globals.cache_size)) {
+	if (Globals.cache_size && (cache.alias_ram_size > Globals.cache_size)) {
 		// failed size test
 		owfree(atn);
 	} else if ((opaque = tsearch(atn, &cache.temporary_alias_tree_new, alias_tree_compare))) {
 		if ( (void *)atn != (void *) (opaque->key) ) {
-			cache.new_ram_size += sizeof(atn) - sizeof(opaque->key);
 			owfree(opaque->key);
 			opaque->key = (void *) atn;
 		} else {
-			cache.new_ram_size += sizeof(atn);
+			cache.alias_ram_size += sizeof(struct alias_tree_node) + atn->size + 1 ;
 		}
 	} else {					// nothing found or added?!? free our memory segment
 		owfree(atn);
@@ -14,26 +14,148 @@
 #include "ow_connection.h"
 
 static struct connection_in *AllocIn(const struct connection_in *old_in) ;
+static void Connection_Publish( void ) ;
 
 /* Routines for handling a linked list of connections in*/
 /* typical connection in would be the serial port or USB */
 
+/* Readers and writers of the bus list
+ *
+ * Every parsedname (FS_ParsedName to FS_ParsedName_destroy) is a reader:
+ * connection_in pointers it holds stay valid until it is destroyed.
+ * Readers don't lock. They count themselves in the current epoch
+ * (Connection_Read_Begin) and uncount at the end.
+ *
+ * Changes (bus added or removed) take CONNIN_WLOCK against each other only.
+ * Lists are changed so a reader walking them still finds its way
+ * (new entries are complete before being linked, removed entries keep
+ * their next pointer), and a new bus number index is built and swapped in.
+ * Before a removed bus (or an old index) is freed, Connection_Synchronize
+ * moves to a new epoch and waits for the readers of the old one to finish.
+ * New requests are never held up by a bus being added or removed.
+ * */
+static UINT connin_epoch = 0 ;
+static UINT connin_readers[2] = { 0, 0, } ;
+
+#if HAVE_SYNC_FETCH_AND_ADD
+#define READERS_ADD(x,n)	((void) __sync_fetch_and_add( &(x), (n) ))
+#define READERS_GET(x)		__sync_fetch_and_add( &(x), 0 )
+#define PUBLISH(p,v)		do { __sync_synchronize() ; (p) = (v) ; __sync_synchronize() ; } while (0)
+#else							/* HAVE_SYNC_FETCH_AND_ADD */
+static pthread_mutex_t connin_readers_mutex = PTHREAD_MUTEX_INITIALIZER ;
+static UINT Readers_Get( UINT * x )
+{
+	UINT value ;
+	_MUTEX_LOCK( connin_readers_mutex ) ;
+	value = *x ;
+	_MUTEX_UNLOCK( connin_readers_mutex ) ;
+	return value ;
+}
+#define READERS_ADD(x,n)	do { _MUTEX_LOCK( connin_readers_mutex ) ; (x) += (n) ; _MUTEX_UNLOCK( connin_readers_mutex ) ; } while (0)
+#define READERS_GET(x)		Readers_Get( &(x) )
+#define PUBLISH(p,v)		do { _MUTEX_LOCK( connin_readers_mutex ) ; (p) = (v) ; _MUTEX_UNLOCK( connin_readers_mutex ) ; } while (0)
+#endif							/* HAVE_SYNC_FETCH_AND_ADD */
+
+/* Start reading the bus list, returns the value for Connection_Read_End */
+int Connection_Read_Begin( void )
+{
+	while (1) {
+		UINT epoch = READERS_GET( connin_epoch ) ;
+		READERS_ADD( connin_readers[epoch & 1], 1 ) ;
+		if ( READERS_GET( connin_epoch ) == epoch ) {
+			return epoch & 1 ;
+		}
+		// a writer moved on meanwhile, and may not have seen us
+		READERS_ADD( connin_readers[epoch & 1], -1 ) ;
+	}
+}
+
+void Connection_Read_End( int reader )
+{
+	READERS_ADD( connin_readers[reader], -1 ) ;
+}
+
+/* Wait until every reader that could see the old lists has finished
+ * and free the replaced indexes. Called with CONNIN_WLOCK */
+void Connection_Synchronize( void )
+{
+	UINT epoch = READERS_GET( connin_epoch ) ;
+	struct connection_table * retired ;
+
+	READERS_ADD( connin_epoch, 1 ) ;
+	while ( READERS_GET( connin_readers[epoch & 1] ) != 0 ) {
+		UT_delay( 1 ) ;
+	}
+
+	retired = Inbound_Control.retired ;
+	Inbound_Control.retired = NULL ;
+	while ( retired != NULL ) {
+		struct connection_table * next = retired->retired ;
+		owfree( retired ) ;
+		retired = next ;
+	}
+}
+
+/* Build the bus number index from the lists and swap it in
+ * Called by whoever changes the lists (CONNIN_WLOCK or setup) */
+static void Connection_Publish( void )
+{
+	int size = Inbound_Control.next_index ;
+	struct connection_table * table = owcalloc( 1, sizeof( struct connection_table ) + size * sizeof( struct connection_in * ) ) ;
+	struct port_in * pin ;
+
+	if ( table == NULL ) {
+		// no index, lookups fall back to the lists
+		LEVEL_DEFAULT("Cannot allocate memory for bus index");
+	} else {
+		table->size = size ;
+		for ( pin = Inbound_Control.head_port ; pin != NULL ; pin = pin->next ) {
+			struct connection_in *cin;
+			for ( cin = pin->first; cin != NO_CONNECTION; cin = cin->next) {
+				if ( cin->index >= 0 && cin->index < size ) {
+					table->in[cin->index] = cin ;
+				}
+			}
+		}
+	}
+
+	if ( Inbound_Control.table != NULL ) {
+		Inbound_Control.table->retired = Inbound_Control.retired ;
+		Inbound_Control.retired = Inbound_Control.table ;
+	}
+	PUBLISH( Inbound_Control.table, table ) ;
+}
+
 /* Globals */
 struct inbound_control Inbound_Control = {
 	.active = 0,
 	.next_index = 0,
+	.next_instance = 0,
 	.head_port = NULL,
 	.next_fake = 0,
 	.next_tester = 0,
 	.next_mock = 0,
 	.w1_monitor = NO_CONNECTION ,
 	.external = NO_CONNECTION ,
+	.table = NULL ,
+	.retired = NULL ,
 };
 
+/* Call as a reader (e.g. with a parsedname) */
 struct connection_in *find_connection_in(int bus_number)
 {
+	struct connection_table * table = Inbound_Control.table ;
 	struct port_in * pin ;
+
+	if ( table != NULL ) {
+		if ( bus_number >= 0 && bus_number < table->size && table->in[bus_number] != NO_CONNECTION ) {
+			return table->in[bus_number] ;
+		}
+		LEVEL_DEBUG("Couldn't find bus number %d",bus_number);
+		return NO_CONNECTION;
+	}
 	
+	// no index (out of memory) -- search the lists
 	for ( pin = Inbound_Control.head_port ; pin != NULL ; pin = pin->next ) {
 		struct connection_in *cin;
 		for ( cin = pin->first; cin != NO_CONNECTION; cin = cin->next) {
@@ -115,12 +237,16 @@ static struct connection_in *AllocIn(const struct connection_in *old_in)
 		new_in->branch.branch = eBranch_bad ;
 		/* Arbitrary guess at root directory size for allocating cache blob */
 		new_in->last_root_devs = 10;
+		DirblobInit( &(new_in->registry) ) ;
+		new_in->registry_time = 0 ;
 		new_in->AnyDevices = anydevices_unknown ;
 
 		++Inbound_Control.active ;
 		new_in->index = Inbound_Control.next_index++;
+		new_in->instance = ++Inbound_Control.next_instance;
 		_MUTEX_INIT(new_in->bus_mutex);
 		_MUTEX_INIT(new_in->dev_mutex);
+		_MUTEX_INIT(new_in->convert_mutex);
 		new_in->dev_db = NULL;
 	} else {
 		LEVEL_DEFAULT("Cannot allocate memory for bus master structure");
@@ -177,10 +303,11 @@ struct port_in *LinkPort(struct port_in *pin)
 	if (pin != NULL) {
 		// Housekeeping to place in linked list
 		// Locking done at a higher level
-		pin->next = Inbound_Control.head_port;	/* put in linked list at start */
-		Inbound_Control.head_port = pin ;
-
 		_MUTEX_INIT(pin->port_mutex);
+
+		pin->next = Inbound_Control.head_port;	/* put in linked list at start */
+		PUBLISH( Inbound_Control.head_port, pin ) ; // complete before readers see it
+		Connection_Publish() ;
 	}
 	return pin;
 }
@@ -194,14 +321,41 @@ struct port_in *NewPort(const struct port_in *pin)
 /* Free all connection_in in reverse order (Added to head on creation, head-first deletion) */
 void FreeInAll( void )
 {
+	struct connection_table * table ;
+
 	while ( Inbound_Control.head_port ) {
 		RemovePort(Inbound_Control.head_port);
 	}
+
+	// shutting down, no readers left to wait for
+	for ( table = Inbound_Control.retired ; table != NULL ; ) {
+		struct connection_table * next = table->retired ;
+		owfree( table ) ;
+		table = next ;
+	}
+	Inbound_Control.retired = NULL ;
+	SAFEFREE( Inbound_Control.table ) ;
+}
+
+/* Is this port in the bus list? */
+static int PortLinked( const struct port_in * pin )
+{
+	struct port_in * now ;
+	for ( now = Inbound_Control.head_port ; now != NULL ; now = now->next ) {
+		if ( now == pin ) {
+			return 1 ;
+		}
+	}
+	return 0 ;
 }
 
+/* Unlink and free a connection
+ * If readers could be using it (port in the list after setup)
+ * take CONNIN_WLOCK and Connection_Synchronize after unlinking */
 void RemoveIn( struct connection_in * conn )
 {
 	struct port_in * pin ;
+	int linked ;
 	
 	/* NULL safe */
 	if ( conn == NO_CONNECTION ) {
@@ -210,13 +364,14 @@ void RemoveIn( struct connection_in * conn )
 
 	// owning port
 	pin = conn->pown ;
+	linked = ( pin != NULL ) && PortLinked( pin ) ;
 
 	/* First unlink from list */
 	if ( pin == NULL ) {
 		// free-floating
 	} else if ( pin->first == conn ) {
 		/* Head of list, easy */
-		pin->first = conn->next ;
+		PUBLISH( pin->first, conn->next ) ;
 		-- pin->connections ;
 		--Inbound_Control.active ;
 	} else {
@@ -225,7 +380,7 @@ void RemoveIn( struct connection_in * conn )
 		for ( now = pin->first ; now != NO_CONNECTION ; now = now->next ) {
 			/* Works even if not linked, since won't match and will just fall through */
 			if ( now->next == conn ) {
-				now->next = conn->next ;
+				PUBLISH( now->next, conn->next ) ;
 				-- pin->connections ;
 				--Inbound_Control.active ;
 				break ;
@@ -236,11 +391,16 @@ void RemoveIn( struct connection_in * conn )
 	if ( conn->index == Inbound_Control.next_index-1 ) {
 		Inbound_Control.next_index-- ;
 	}
+	if ( linked ) {
+		Connection_Publish() ;
+	}
 
 	/* Now free up thread-sync resources */
 	_MUTEX_DESTROY(conn->bus_mutex);
 	_MUTEX_DESTROY(conn->dev_mutex);
+	_MUTEX_DESTROY(conn->convert_mutex);
 	SAFETDESTROY( conn->dev_db, owfree_func);
+	DirblobClear( &(conn->registry) ) ;
 
 	/* Close master-specific resources */
 	BUS_close(conn) ;
@@ -252,35 +412,52 @@ void RemoveIn( struct connection_in * conn )
 	owfree(conn);
 }
 
-void RemovePort( struct port_in * pin )
+/* Take a port out of the bus list, without freeing it
+ * Readers already on it can still follow its next pointer */
+void UnlinkPort( struct port_in * pin )
 {
-	/* NULL safe */
 	if ( pin == NULL ) {
 		return ;
 	}
 
-	/* Free port */
-	COM_free( pin->first ) ;
-
-	/* First delete connections */
-	while ( pin->first != NO_CONNECTION ) {
-		RemoveIn( pin->first ) ;
-	}
-
-	/* Next unlink from list */
 	if ( pin == Inbound_Control.head_port ) {
 		/* Head of list, easy */
-		Inbound_Control.head_port = pin->next ;
+		PUBLISH( Inbound_Control.head_port, pin->next ) ;
 	} else {
 		struct port_in * now ;
 		/* find in list and splice out */
 		for ( now = Inbound_Control.head_port ; now != NULL ; now = now->next ) {
-			/* Works even if not linked, since won't match and will just fall through */
 			if ( now->next == pin ) {
-				now->next = pin->next ;
+				PUBLISH( now->next, pin->next ) ;
 				break ;
 			}
 		}
+		if ( now == NULL ) {
+			// wasn't linked
+			return ;
+		}
+	}
+	Connection_Publish() ;
+}
+
+/* Unlink and free a port and its connections
+ * Same care as RemoveIn if readers could be using it */
+void RemovePort( struct port_in * pin )
+{
+	/* NULL safe */
+	if ( pin == NULL ) {
+		return ;
+	}
+
+	/* First unlink from list */
+	UnlinkPort( pin ) ;
+
+	/* Free port */
+	COM_free( pin->first ) ;
+
+	/* Next delete connections */
+	while ( pin->first != NO_CONNECTION ) {
+		RemoveIn( pin->first ) ;
 	}
 
 	/* Now free up thread-sync resources */
@@ -305,12 +482,15 @@ struct connection_in * AddtoPort( struct port_in * pin )
 	// Housekeeping to place in linked list
 	// Locking done at a higher level
 	
-	add_in->next = pin->first;	/* put in linked list at start */
-	pin->first = add_in;
 	add_in->pown = pin ;
-
 	add_in->channel = pin->connections ;
 	++pin->connections ;
 
+	add_in->next = pin->first;	/* put in linked list at start */
+	PUBLISH( pin->first, add_in ) ; // complete before readers see it
+	if ( PortLinked( pin ) ) {
+		Connection_Publish() ;
+	}
+
 	return add_in ;
 }
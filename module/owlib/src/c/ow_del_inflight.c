@@ -35,11 +35,17 @@ void Del_InFlight( GOOD_OR_BAD (*nomatch)(struct port_in * trial,struct port_in
 	}
 
 	CONNIN_WLOCK ;
-	for ( pin = Inbound_Control.head_port ; pin != NULL ; pin = pin->next ) {
+	pin = Inbound_Control.head_port ;
+	while ( pin != NULL ) {
+		struct port_in * next = pin->next ;
 		if ( BAD( nomatch( old_pin, pin )) ) {
 			LEVEL_DEBUG("Removing BUS index=%d %s",pin->first->index,SAFESTRING(DEVICENAME(pin->first)));
+			// requests already using it finish first, new ones don't see it
+			UnlinkPort(pin) ;
+			Connection_Synchronize() ;
 			RemovePort(pin) ;
 		}
+		pin = next ;
 	}
 	CONNIN_WUNLOCK ;
 }
@@ -19,6 +19,7 @@ struct devlock {
 	pthread_mutex_t lock;
 	BYTE sn[SERIAL_NUMBER_SIZE];
 	UINT users;
+	struct connection_in *in; // bus whose tree holds it
 };
 
 
@@ -47,26 +48,14 @@ static int dev_compare(const void *a, const void *b)
 	return memcmp(&((const struct devlock *) a)->sn, &((const struct devlock *) b)->sn, SERIAL_NUMBER_SIZE);
 }
 
-/* Grabs a device lock, either one already matching, or creates one */
-/* called per-adapter */
-/* The device locks (devlock) are kept in a tree */
-ZERO_OR_ERROR DeviceLockGet(struct parsedname *pn)
+/* Does this property need the device locked? */
+static int DeviceLockNeeded(const struct parsedname *pn)
 {
-	struct devlock *local_devicelock;
-	struct devlock *tree_devicelock;
-	struct dev_opaque *opaque;
-
 	if (pn->selected_device == DeviceSimultaneous) {
 		/* Shouldn't call DeviceLockGet() on DeviceSimultaneous. No sn exists */
 		return 0;
 	}
 
-	/* Cannot lock without knowing which bus since the device trees are bus-specific */
-	if (pn->selected_connection == NO_CONNECTION) {
-		return -EINVAL ;
-	}
-
-	/* Need locking? */
 	/* Exclude external */
 	if ( pn->selected_filetype->read == FS_r_external || pn->selected_filetype->write == FS_w_external ) {
 		return 0 ;
@@ -89,11 +78,20 @@ ZERO_OR_ERROR DeviceLockGet(struct parsedname *pn)
 		default:
 			break;
 	}
+	return 1;
+}
+
+/* Find (or create) the devlock of the device in its bus tree and add a user */
+static struct devlock * DeviceLockFind(struct parsedname *pn)
+{
+	struct devlock *local_devicelock;
+	struct devlock *tree_devicelock;
+	struct dev_opaque *opaque;
 
 	// Create a devlock block to add to the tree
 	local_devicelock = owmalloc(sizeof(struct devlock)) ;
 	if ( local_devicelock == NULL ) {
-		return -ENOMEM;
+		return NULL;
 	}
 	memcpy(local_devicelock->sn, pn->sn, SERIAL_NUMBER_SIZE);
 
@@ -103,7 +101,7 @@ ZERO_OR_ERROR DeviceLockGet(struct parsedname *pn)
 	if ( opaque == NULL ) {	// unfound and uncreatable
 		DEVTREE_UNLOCK(pn);
 		owfree(local_devicelock); // kill the allocated devlock
-		return -ENOMEM;
+		return NULL;
 	}
 	
 	tree_devicelock = opaque->key ;
@@ -112,11 +110,59 @@ ZERO_OR_ERROR DeviceLockGet(struct parsedname *pn)
 		// It will need to be freed later, when the user count returns to zero.
 		_MUTEX_INIT(tree_devicelock->lock);	// create a mutex
 		tree_devicelock->users = 0 ;
+		tree_devicelock->in = pn->selected_connection ;
 	} else {					// existing device slot
 		owfree(local_devicelock); // kill the locally allocated devlock (since there already is a matching devlock)	
 	}
 	++(tree_devicelock->users); // add our claim to the device
 	DEVTREE_UNLOCK(pn);
+	return tree_devicelock;
+}
+
+/* Remove a user of the devlock, and free it with the last one */
+static void DeviceLockDrop(struct devlock *devicelock)
+{
+	struct connection_in *in = devicelock->in;
+
+	_MUTEX_LOCK(in->dev_mutex);
+	--devicelock->users; // remove our interest
+	if (devicelock->users == 0) {
+		// Nobody's interested!
+		tdelete(devicelock, &(in->dev_db), dev_compare); /* Serg: Address 0x5A0D750 is 0 bytes inside a block of size 32 free'd */
+		_MUTEX_DESTROY(devicelock->lock);
+		owfree(devicelock);
+	}
+	_MUTEX_UNLOCK(in->dev_mutex);
+}
+
+/* Grabs a device lock, either one already matching, or creates one */
+/* called per-adapter */
+/* The device locks (devlock) are kept in a tree */
+ZERO_OR_ERROR DeviceLockGet(struct parsedname *pn)
+{
+	struct devlock *tree_devicelock;
+
+	/* Cannot lock without knowing which bus since the device trees are bus-specific */
+	if (pn->selected_device != DeviceSimultaneous && pn->selected_connection == NO_CONNECTION) {
+		return -EINVAL ;
+	}
+
+	/* Need locking? */
+	if ( ! DeviceLockNeeded(pn) ) {
+		return 0 ;
+	}
+
+	if ( pn->held_lock != NULL && pn->held_lock->in == pn->selected_connection ) {
+		// kept by a property handle, no tree search
+		_MUTEX_LOCK(pn->held_lock->lock);
+		pn->lock = pn->held_lock;
+		return 0;
+	}
+
+	tree_devicelock = DeviceLockFind(pn) ;
+	if ( tree_devicelock == NULL ) {
+		return -ENOMEM;
+	}
 	_MUTEX_LOCK(tree_devicelock->lock);	// now grab the device
 	pn->lock = tree_devicelock; // use this new devlock
 	return 0;
@@ -130,15 +176,35 @@ void DeviceLockRelease(struct parsedname *pn)
 		_MUTEX_UNLOCK(pn->lock->lock);		/* Serg: This coredump on his 64-bit server */
 
 		// Now mark our disinterest in the device tree (and possibly reap the node))
-		DEVTREE_LOCK(pn);
-		--pn->lock->users; // remove our interest
-		if (pn->lock->users == 0) {
-			// Nobody's interested!
-			tdelete(pn->lock, &(pn->selected_connection->dev_db), dev_compare); /* Serg: Address 0x5A0D750 is 0 bytes inside a block of size 32 free'd */
-			_MUTEX_DESTROY(pn->lock->lock);
-			owfree(pn->lock);
+		if (pn->lock != pn->held_lock) {
+			DeviceLockDrop(pn->lock);
 		}
-		DEVTREE_UNLOCK(pn);
 		pn->lock = NULL;
 	}
 }
+
+/* Keep the devlock of the device for repeated use (property handles, see ow_handle.c)
+ * Counts as a user until DeviceLockUnhold, so it stays in the bus tree
+ * and DeviceLockGet on pn takes it directly while on the same bus.
+ * Removing the bus frees it with the tree -- check the bus before Unhold */
+void DeviceLockHold(struct parsedname *pn)
+{
+	pn->held_lock = NULL;
+	if (pn->type != ePN_real || pn->selected_device == NO_DEVICE || pn->selected_filetype == NO_FILETYPE) {
+		return;
+	}
+	if (pn->selected_connection == NO_CONNECTION || BusIsServer(pn->selected_connection)) {
+		return;
+	}
+	if ( DeviceLockNeeded(pn) ) {
+		pn->held_lock = DeviceLockFind(pn);
+	}
+}
+
+void DeviceLockUnhold(struct parsedname *pn)
+{
+	if (pn->held_lock != NULL) {
+		DeviceLockDrop(pn->held_lock);
+		pn->held_lock = NULL;
+	}
+}
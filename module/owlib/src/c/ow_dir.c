@@ -103,10 +103,8 @@ static ZERO_OR_ERROR FS_dir_both(void (*dirfunc) (void *, const struct parsednam
 	
 	LEVEL_CALL("path=%s", SAFESTRING(pn_raw_directory->path));
 
-	STATLOCK;
 	AVERAGE_IN(&dir_avg);
 	AVERAGE_IN(&all_avg);
-	STATUNLOCK;
 
 	FSTATLOCK;
 	StateInfo.dir_time = NOW_TIME;	// protected by mutex
@@ -191,10 +189,8 @@ static ZERO_OR_ERROR FS_dir_both(void (*dirfunc) (void *, const struct parsednam
 
 	}
 
-	STATLOCK;
 	AVERAGE_OUT(&dir_avg);
 	AVERAGE_OUT(&all_avg);
-	STATUNLOCK;
 
 	LEVEL_DEBUG("ret=%d", ret);
 	return ret;
@@ -248,7 +244,6 @@ static void FS_simultaneous_entry(void (*dirfunc) (void *, const struct parsedna
 
 struct dir_all_connections_struct {
 	struct port_in * pin ;
-	struct connection_in * cin ;
 	struct parsedname pn_directory;
 	void (*dirfunc) (void *, const struct parsedname *);
 	void *v;
@@ -258,13 +253,9 @@ struct dir_all_connections_struct {
 
 /* Embedded function */
 /* Directory on a particular port's channel */
-static void FS_dir_all_connections_callback_conn( struct dir_all_connections_struct * dacs )
+static void FS_dir_all_connections_callback_conn( struct dir_all_connections_struct * dacs, struct connection_in * cin )
 {
-	if ( dacs->cin == NO_CONNECTION ) {
-		return ;
-	}
-
-	SetKnownBus(dacs->cin->index, &(dacs->pn_directory) );
+	SetKnownBus(cin->index, &(dacs->pn_directory) );
 
 	if ( BAD(TestConnection( &(dacs->pn_directory) )) ) {	// reconnect ok?
 		dacs->ret = -ECONNABORTED;
@@ -277,76 +268,64 @@ static void FS_dir_all_connections_callback_conn( struct dir_all_connections_str
 	} else {
 		dacs->ret = FS_cache_or_real(dacs->dirfunc, dacs->v, &(dacs->pn_directory), &(dacs->flags));
 	}
-	
-	// next channel
-	dacs->cin = dacs->cin->next ;
-	FS_dir_all_connections_callback_conn( dacs ) ;
 }
 
-/* Callback (thread) once per port */
-/* Will need  to probe each connection (channel) on this port */
-static void *FS_dir_all_connections_callback_port(void *v)
+/* Task once per port */
+/* Will need  to probe each connection (channel) on this port in turn */
+static void FS_dir_all_connections_callback_port(void *v)
 {
 	struct dir_all_connections_struct *dacs = v;
-	struct dir_all_connections_struct dacs_next ;
-	pthread_t thread;
-	int threadbad = 0;
+	struct connection_in * cin ;
 	
-	if ( dacs->pin == NULL ) {
-		return VOID_RETURN;
-	}
-
-	// set up structure
-	dacs_next.pin = dacs->pin->next ;
-
-	if ( dacs_next.pin == NULL ) {
-		threadbad = 1 ;
-	} else {
-		dacs_next.dirfunc = dacs->dirfunc ;
-		memcpy( &(dacs_next.pn_directory), &(dacs->pn_directory), sizeof(struct parsedname));	// shallow copy
-		dacs_next.v = dacs->v ;
-		dacs_next.flags = dacs->flags ;
-		dacs_next.ret = dacs->ret ;
-		threadbad = pthread_create(&thread, DEFAULT_THREAD_ATTR, FS_dir_all_connections_callback_port, (void *) (&dacs_next));
-	}
-
-	// First channel
-	dacs->cin = dacs->pin->first ;
-	FS_dir_all_connections_callback_conn( v ) ;
-		
-	//printf("FS_dir_all_connections4 pid=%ld adapter=%d ret=%d\n",pthread_self(), dacs->pn_directory->selected_connection->index,ret);
-	/* See if next bus was also queried */
-	if (threadbad == 0) {		/* was a thread created? */
-		if (pthread_join(thread, NULL)!= 0) {
-			return VOID_RETURN ;			/* cannot join, so return only this result */
-		}
-		if (dacs_next.ret >= 0) {
-			dacs->ret = dacs_next.ret;	/* is it an error return? Then return this one */
-		} else {
-			dacs->flags |= dacs_next.flags ;
-		}		
+	for ( cin = dacs->pin->first ; cin != NO_CONNECTION ; cin = cin->next ) {
+		FS_dir_all_connections_callback_conn( dacs, cin ) ;
 	}
-	return VOID_RETURN;
 }
 
 static ZERO_OR_ERROR
 FS_dir_all_connections(void (*dirfunc) (void *, const struct parsedname *), void *v, const struct parsedname *pn_directory, uint32_t * flags)
 {
-	struct dir_all_connections_struct dacs ;
+	struct task_group tg ;
+	struct dir_all_connections_struct * dacs ;
+	struct port_in * pin ;
+	ZERO_OR_ERROR ret = 0 ;
+	int count = 0 ;
+	int i ;
+
+	*flags = 0 ;
+	for ( pin = Inbound_Control.head_port ; pin != NULL ; pin = pin->next ) {
+		++count ;
+	}
+	if ( count == 0 ) {
+		return 0 ;
+	}
+	dacs = owcalloc( count, sizeof( struct dir_all_connections_struct ) ) ;
+	if ( dacs == NULL ) {
+		return -ENOMEM ;
+	}
 		
-	// set up structure
-	dacs.pin = Inbound_Control.head_port ; 
-	dacs.dirfunc = dirfunc ;
-	memcpy( &(dacs.pn_directory), pn_directory, sizeof(struct parsedname));	// shallow copy
-	dacs.v = v ;
-	dacs.flags = 0 ;
-	dacs.ret = 0 ;
-	
-	// Start iterating through buses
-	FS_dir_all_connections_callback_port(  (void *) (& dacs) ) ;
-	
-	*flags = dacs.flags ;	
-	return dacs.ret ;
+	// Start all the ports at once
+	Task_Group_Init( &tg, fanout_directory ) ;
+	for ( i = 0, pin = Inbound_Control.head_port ; pin != NULL && i < count ; pin = pin->next, ++i ) {
+		dacs[i].pin = pin ;
+		dacs[i].dirfunc = dirfunc ;
+		memcpy( &(dacs[i].pn_directory), pn_directory, sizeof(struct parsedname));	// shallow copy
+		dacs[i].v = v ;
+		dacs[i].flags = 0 ;
+		dacs[i].ret = 0 ;
+		Task_Add( &tg, FS_dir_all_connections_callback_port, &dacs[i] ) ;
+	}
+	Task_Wait( &tg ) ;
+
+	// an error only if no port answered
+	for ( i = 0 ; i < count ; ++i ) {
+		*flags |= dacs[i].flags ;
+		if ( i == 0 || dacs[i].ret >= 0 ) {
+			ret = dacs[i].ret ;
+		}
+	}
+	owfree( dacs ) ;
+	return ret ;
 }
 
 /* Device directory (i.e. show the properties) -- all from memory */
@@ -650,6 +629,7 @@ static ZERO_OR_ERROR FS_realdir(void (*dirfunc) (void *, const struct parsedname
 		/* Execute callback function */
 		if ( FS_dir_plus(dirfunc, v, flags, pn_whole_directory, dev) != 0 ) {
 			DirblobPoison(&db);
+			BUS_next_cleanup(&ds); // search abandoned part way
 			break ;
 		}
 		DirblobAdd(ds.sn, &db);
@@ -658,9 +638,7 @@ static ZERO_OR_ERROR FS_realdir(void (*dirfunc) (void *, const struct parsedname
 		ret = PossiblyLockedBusCall( BUS_next, &ds, pn_whole_directory) ;
 	} 
 
-	STATLOCK;
-	dir_main.entries += devices;
-	STATUNLOCK;
+	STAT_ADD(dir_main.entries, devices);
 
 	switch ( ret ) {
 		case search_done:
@@ -669,7 +647,13 @@ static ZERO_OR_ERROR FS_realdir(void (*dirfunc) (void *, const struct parsedname
 			}
 			/* Add to the cache (full list as a single element */
 			if (DirblobPure(&db) && (ret == search_done) ) {
+				// index it once, the cache and registry share it
+				DirblobFreeze(&db);
 				Cache_Add_Dir(&db, pn_whole_directory);
+				if ( RootNotBranch(pn_whole_directory) ) {
+					// compare with the last search and note changes
+					Registry_Update( pn_whole_directory->selected_connection, &db ) ;
+				}
 			}
 			DirblobClear(&db);
 			return 0 ;
@@ -720,7 +704,8 @@ static ZERO_OR_ERROR FS_cache_or_real(void (*dirfunc) (void *, const struct pars
 	if (
 		SpecifiedBus(pn_real_directory) 
 		|| IsUncachedDir(pn_real_directory) // asking for uncached
-		|| BAD( Cache_Get_Dir(&db, pn_real_directory)) // cache'd version isn't available (or old)
+		|| ( BAD( Cache_Get_Dir(&db, pn_real_directory)) // cache'd version isn't available (or old)
+			&& BAD( Registry_Get(&db, pn_real_directory)) ) // nor kept by the --registry thread
 		) {
 		// directly
 		return FS_realdir(dirfunc, v, pn_real_directory, flags);
@@ -740,11 +725,7 @@ static ZERO_OR_ERROR FS_cache_or_real(void (*dirfunc) (void *, const struct pars
 	}
 	DirblobClear(&db);			/* allocated in Cache_Get_Dir */
 
-	STATLOCK;
-
-	dir_main.entries += dindex;
-
-	STATUNLOCK;
+	STAT_ADD(dir_main.entries, dindex);
 	return 0;
 }
 
@@ -44,11 +44,103 @@ $Id$
     It is used for directory caches, and some "all at once" adapters types
 
     Most interestingly, it allocates memory dynamically.
+
+    A finished list can be frozen (DirblobFreeze) into a snapshot -- the
+    serial numbers and a hash index of them in one allocation, never changed
+    afterwards and shared by reference count. The directory cache, the bus
+    registry and the simulated buses hold snapshots, so a copy of a listing
+    (DirblobShare) costs a reference, and DirblobSearch is a hash lookup.
+    Adding to a frozen dirblob first gives it a private copy again.
 */
 
+struct dirblob_snapshot {
+	int references;
+	int devices;
+	UINT mask;		// index slots - 1 (slots a power of 2, at least twice the devices)
+	int *slot;		// device_index + 1, 0 for an empty slot
+	BYTE *snlist;
+};
+
+#if HAVE_SYNC_FETCH_AND_ADD
+#define SNAPSHOT_REFERENCE(s)	((void) __sync_fetch_and_add( &((s)->references), 1 ))
+#define SNAPSHOT_RELEASE(s)		__sync_sub_and_fetch( &((s)->references), 1 )
+#else							/* HAVE_SYNC_FETCH_AND_ADD */
+static pthread_mutex_t snapshot_mutex = PTHREAD_MUTEX_INITIALIZER ;
+static int Snapshot_References( struct dirblob_snapshot * snapshot, int change )
+{
+	int references ;
+	_MUTEX_LOCK( snapshot_mutex ) ;
+	references = ( snapshot->references += change ) ;
+	_MUTEX_UNLOCK( snapshot_mutex ) ;
+	return references ;
+}
+#define SNAPSHOT_REFERENCE(s)	((void) Snapshot_References( (s), 1 ))
+#define SNAPSHOT_RELEASE(s)		Snapshot_References( (s), -1 )
+#endif							/* HAVE_SYNC_FETCH_AND_ADD */
+
+static UINT DirblobHash(const BYTE * sn)
+{
+	// FNV-1a, simulated buses number their devices in only a few bytes
+	UINT hash = 2166136261u;
+	int i;
+	for (i = 0; i < DIRBLOB_ELEMENT_LENGTH - 1; ++i) {	// crc adds nothing
+		hash = (hash ^ sn[i]) * 16777619u;
+	}
+	return hash;
+}
+
+static struct dirblob_snapshot *DirblobSnapshot(const BYTE * snlist, int devices)
+{
+	struct dirblob_snapshot *snapshot;
+	UINT slots = 4;
+	int device_index;
+
+	while (slots < 2 * (UINT) devices) {
+		slots <<= 1;
+	}
+	snapshot = owmalloc(sizeof(struct dirblob_snapshot) + slots * sizeof(int) + devices * DIRBLOB_ELEMENT_LENGTH);
+	if (snapshot == NULL) {
+		return NULL;
+	}
+	snapshot->references = 1;
+	snapshot->devices = devices;
+	snapshot->mask = slots - 1;
+	snapshot->slot = (int *) (&snapshot[1]);
+	snapshot->snlist = (BYTE *) (&snapshot->slot[slots]);
+	memset(snapshot->slot, 0, slots * sizeof(int));
+	if (devices > 0) {
+		memcpy(snapshot->snlist, snlist, devices * DIRBLOB_ELEMENT_LENGTH);
+	}
+
+	// in order, so a duplicate is found at its first position (as a scan would)
+	for (device_index = 0; device_index < devices; ++device_index) {
+		UINT s = DirblobHash(&(snlist[DIRBLOB_ELEMENT_LENGTH * device_index])) & snapshot->mask;
+		while (snapshot->slot[s] != 0) {
+			s = (s + 1) & snapshot->mask;
+		}
+		snapshot->slot[s] = device_index + 1;
+	}
+	return snapshot;
+}
+
+static void DirblobUse(struct dirblob_snapshot *snapshot, struct dirblob *db)
+{
+	db->snapshot = snapshot;
+	db->snlist = snapshot->snlist;
+	db->allocated = db->devices = snapshot->devices;
+}
+
 void DirblobClear(struct dirblob *db)
 {
-	SAFEFREE(db->snlist) ;
+	if (db->snapshot != NULL) {
+		if (SNAPSHOT_RELEASE(db->snapshot) == 0) {
+			owfree(db->snapshot);
+		}
+		db->snapshot = NULL;
+		db->snlist = NULL;
+	} else {
+		SAFEFREE(db->snlist) ;
+	}
 	db->allocated = db->devices;
 	db->devices = 0;
 	db->troubled = 0;
@@ -60,6 +152,7 @@ void DirblobInit(struct dirblob *db)
 	db->allocated = 0;
 	db->snlist = 0;
 	db->troubled = 0;
+	db->snapshot = NULL;
 }
 
 int DirblobPure(const struct dirblob *db)
@@ -82,6 +175,16 @@ int DirblobAdd(const BYTE * sn, struct dirblob *db)
 	if ( db->troubled ) {
 		return -EINVAL ;
 	}
+	if ( db->snapshot != NULL ) {
+		// shared and read-only -- take a private copy
+		struct dirblob copy ;
+		if ( DirblobRecreate( db->snlist, db->devices * DIRBLOB_ELEMENT_LENGTH, &copy ) != 0 ) {
+			db->troubled = 1 ;
+			return -ENOMEM ;
+		}
+		DirblobClear( db ) ;
+		*db = copy ;
+	}
 	// make more room? -- blocks of 10 devices (80byte)
 	if ((db->devices >= db->allocated) || (db->snlist == NULL)) {
 		int newalloc = db->allocated + DIRBLOB_ALLOCATION_INCREMENT;
@@ -119,6 +222,18 @@ int DirblobSearch(BYTE * sn, const struct dirblob *db)
 	if (db == NULL || db->devices < 1) {
 		return INDEX_BAD;
 	}
+	if (db->snapshot != NULL) {
+		struct dirblob_snapshot *snapshot = db->snapshot;
+		UINT s = DirblobHash(sn) & snapshot->mask;
+		while (snapshot->slot[s] != 0) {
+			device_index = snapshot->slot[s] - 1;
+			if (memcmp(sn, &(snapshot->snlist[DIRBLOB_ELEMENT_LENGTH * device_index]), DIRBLOB_ELEMENT_LENGTH) == 0) {
+				return device_index;
+			}
+			s = (s + 1) & snapshot->mask;
+		}
+		return INDEX_BAD;
+	}
 	for (device_index = 0; device_index < db->devices; ++device_index) {
 		if (memcmp(sn, &(db->snlist[DIRBLOB_ELEMENT_LENGTH * device_index]), DIRBLOB_ELEMENT_LENGTH) == 0) {
 			return device_index;
@@ -148,3 +263,40 @@ int DirblobRecreate( BYTE * snlist, int size, struct dirblob *db)
 	return 0 ;
 }
 
+/* Turn a finished list into a shared snapshot with an index
+   return 0, or -ENOMEM (the dirblob is unchanged and still usable) */
+int DirblobFreeze(struct dirblob *db)
+{
+	struct dirblob_snapshot *snapshot;
+
+	if (db->snapshot != NULL) {
+		return 0;
+	}
+	snapshot = DirblobSnapshot(db->snlist, db->devices);
+	if (snapshot == NULL) {
+		return -ENOMEM;
+	}
+	SAFEFREE(db->snlist);
+	DirblobUse(snapshot, db);
+	return 0;
+}
+
+/* Copy of a list -- another reference if it is frozen, else a new snapshot
+   "to" is overwritten (not cleared) and must be cleared after use */
+int DirblobShare(struct dirblob *to, const struct dirblob *from)
+{
+	struct dirblob_snapshot *snapshot = from->snapshot;
+
+	DirblobInit(to);
+	if (snapshot != NULL) {
+		SNAPSHOT_REFERENCE(snapshot);
+	} else {
+		snapshot = DirblobSnapshot(from->snlist, from->devices);
+		if (snapshot == NULL) {
+			to->troubled = 1;
+			return -ENOMEM;
+		}
+	}
+	DirblobUse(snapshot, to);
+	return 0;
+}
@@ -212,6 +212,10 @@
 
 static RESET_TYPE DS2480_reset(const struct parsedname *pn);
 static enum search_status DS2480_next_both(struct device_search *ds, const struct parsedname *pn);
+static enum search_status DS2480_search_one(struct device_search *ds, const struct parsedname *pn);
+static GOOD_OR_BAD DS2480_search_verify(struct device_search *ds, const struct parsedname *pn);
+static size_t DS2480_search_stream(BYTE * stream, const BYTE * sn, int with_reset, BYTE search, struct connection_in * in);
+static int DS2480_search_branch(const BYTE * sn1, const BYTE * sn2);
 static GOOD_OR_BAD DS2480_PowerByte(const BYTE byte, BYTE * resp, const UINT delay, const struct parsedname *pn);
 static GOOD_OR_BAD DS2480_PowerBit(const BYTE byte, BYTE * resp, const UINT delay, const struct parsedname *pn);
 static GOOD_OR_BAD DS2480_ProgramPulse(const struct parsedname *pn);
@@ -411,6 +415,9 @@ static void DS2480_setroutines(struct connection_in *in)
 
 // Search defines
 #define SEARCH_BIT_ON		0x01
+// Longest command stream for one accelerated search:
+// mode, reset, mode, search, mode, search on, mode, 16 bitpair bytes (maybe doubled), mode, search off
+#define SEARCH_STREAM_SIZE	(8 + 2*2*SERIAL_NUMBER_SIZE + 2)
 #define	DS2404_family	0x04
 
 // Could probably be UART_FIFO_SIZE (160) but that will take some testing
@@ -430,6 +437,7 @@ GOOD_OR_BAD DS2480_detect(struct port_in *pin)
 
 	/* Set up low-level routines */
 	DS2480_setroutines(in);
+	DirblobInit( &(in->master.serial.search_tree) ) ;
 
 	in->overdrive = 0 ;
 	in->flex = Globals.serial_flextime ;
@@ -501,6 +509,8 @@ static void DS2480_adapter(struct connection_in *in)
 static GOOD_OR_BAD DS2480_reconnect(const struct parsedname * pn)
 {
 	LEVEL_DEBUG("Attempting reconnect on %s",SAFESTRING(DEVICENAME(pn->selected_connection)));
+	// devices may have come and gone
+	DirblobClear( &(pn->selected_connection->master.serial.search_tree) ) ;
 	return DS2480_big_reset(pn->selected_connection) ;
 }
 
@@ -815,7 +825,251 @@ static RESET_TYPE DS2480_reset_once(struct connection_in * in)
 
 #define SERIAL_NUMBER_BITS (8*SERIAL_NUMBER_SIZE)
 /* search = normal and alarm */
+/* Directory search
+ * A plain ROM search on the root of the bus is first checked against the
+ * devices found last time (DS2480_search_verify). If nothing changed the
+ * whole list is handed out of ds->gulp like the dir-at-once adapters.
+ * Otherwise fall back to one search pass per device, remembering the
+ * devices for the next time.
+ * ds->index counts the devices handed out so far.
+ * */
 static enum search_status DS2480_next_both(struct device_search *ds, const struct parsedname *pn)
+{
+	struct connection_in * in = pn->selected_connection ;
+	struct dirblob * tree = &(in->master.serial.search_tree) ;
+	int cacheable = ( ds->search == _1W_SEARCH_ROM ) && RootNotBranch(pn) ;
+
+	if (ds->LastDevice) {
+		return search_done;
+	}
+
+	if ( ds->index == -1 && cacheable && DirblobElements(tree) > 0 ) {
+		// first call of this listing
+		if ( BAD( DS2480_search_verify(ds, pn) ) ) {
+			DirblobClear( tree ) ;
+			DirblobClear( &(ds->gulp) ) ;
+		}
+	}
+
+	if ( ds->index + 1 < DirblobElements( &(ds->gulp) ) ) {
+		// verified list -- only reached after DS2480_search_verify
+		++ds->index ;
+		DirblobGet( ds->index, ds->sn, &(ds->gulp) ) ;
+		if ( ds->index + 1 == DirblobElements( &(ds->gulp) ) ) {
+			ds->LastDevice = 1 ;
+		}
+		LEVEL_DEBUG("SN found: " SNformat, SNvar(ds->sn));
+		return search_good ;
+	}
+
+	switch ( DS2480_search_one( ds, pn ) ) {
+		case search_good:
+			if ( cacheable ) {
+				DirblobAdd( ds->sn, &(ds->gulp) ) ;
+				++ds->index ;
+				if ( ds->LastDevice ) {
+					// complete list, keep it to check next time
+					DirblobClear( tree ) ;
+					if ( DirblobPure( &(ds->gulp) ) ) {
+						DirblobRecreate( ds->gulp.snlist, DirblobElements( &(ds->gulp) ) * SERIAL_NUMBER_SIZE, tree ) ;
+					}
+				}
+			}
+			return search_good ;
+		case search_done:
+			if ( cacheable ) {
+				DirblobClear( tree ) ;
+			}
+			return search_done ;
+		case search_error:
+		default:
+			return search_error ;
+	}
+}
+
+/* Check the devices of the last complete search in a few bundled writes
+ * For each known device a reset and an accelerated search that takes that
+ * device's bits at every discrepancy. The bus is unchanged if
+ *   each search found the device it was steered to, and
+ *   each search reported discrepancies exactly where another known device branches off.
+ * A new device would show up as a discrepancy with no known device behind it,
+ * a missing one as a search that ends elsewhere.
+ * On success ds->gulp holds the devices.
+ * */
+static GOOD_OR_BAD DS2480_search_verify(struct device_search *ds, const struct parsedname *pn)
+{
+	struct connection_in * in = pn->selected_connection ;
+	struct dirblob * tree = &(in->master.serial.search_tree) ;
+	int devices = DirblobElements(tree) ;
+	BYTE * bitpairs ;
+	int device_index ;
+	int segment_start ;
+
+	if ( ! DirblobPure(tree) ) {
+		return gbBAD ;
+	}
+
+	bitpairs = owmalloc( devices * SERIAL_NUMBER_SIZE * 2 ) ;
+	if ( bitpairs == NULL ) {
+		return gbBAD ;
+	}
+
+	// the reset here is the first device's
+	if ( BAD( BUS_select(pn) ) || in->AnyDevices == anydevices_no ) {
+		owfree( bitpairs ) ;
+		return gbBAD ;
+	}
+
+	DS2480_flush(in);
+
+	for ( segment_start = 0 ; segment_start < devices ; ) {
+		BYTE sendout[UART_FIFO_SIZE + SEARCH_STREAM_SIZE] ;
+		BYTE response[UART_FIFO_SIZE + SEARCH_STREAM_SIZE] ;
+		size_t send_length = 0 ;
+		size_t response_length = 0 ;
+		size_t response_index = 0 ;
+		int segment_end ;
+
+		// as many devices as fit in the uart fifo (at least one)
+		for ( segment_end = segment_start ; segment_end < devices ; ++segment_end ) {
+			BYTE sn[SERIAL_NUMBER_SIZE] ;
+			int with_reset = ( segment_end > 0 ) ;
+			if ( send_length > 0 && send_length + SEARCH_STREAM_SIZE > UART_FIFO_SIZE ) {
+				break ;
+			}
+			DirblobGet( segment_end, sn, tree ) ;
+			send_length += DS2480_search_stream( &sendout[send_length], sn, with_reset, ds->search, in ) ;
+			response_length += ( with_reset ? 1 : 0 ) + 1 + SERIAL_NUMBER_SIZE * 2 ;
+		}
+
+		if ( BAD( DS2480_write( sendout, send_length, in ) ) || BAD( DS2480_read( response, response_length, in ) ) ) {
+			owfree( bitpairs ) ;
+			DS2480_flush(in);
+			return gbBAD ;
+		}
+
+		for ( device_index = segment_start ; device_index < segment_end ; ++device_index ) {
+			if ( device_index > 0 ) {
+				switch ( response[response_index++] & RB_RESET_MASK ) {
+					case RB_PRESENCE:
+					case RB_ALARMPRESENCE:
+						break ;
+					default:
+						LEVEL_DEBUG("Bus reset without presence while verifying the last search") ;
+						owfree( bitpairs ) ;
+						return gbBAD ;
+				}
+			}
+			if ( response[response_index++] != ds->search ) {
+				owfree( bitpairs ) ;
+				return gbBAD ;
+			}
+			memcpy( &bitpairs[device_index * SERIAL_NUMBER_SIZE * 2], &response[response_index], SERIAL_NUMBER_SIZE * 2 ) ;
+			response_index += SERIAL_NUMBER_SIZE * 2 ;
+		}
+		segment_start = segment_end ;
+	}
+
+	for ( device_index = 0 ; device_index < devices ; ++device_index ) {
+		BYTE sn[SERIAL_NUMBER_SIZE] ;
+		BYTE found[SERIAL_NUMBER_SIZE] ;
+		BYTE branches[SERIAL_NUMBER_SIZE] ;
+		BYTE * pairs = &bitpairs[device_index * SERIAL_NUMBER_SIZE * 2] ;
+		int other ;
+		int i ;
+
+		DirblobGet( device_index, sn, tree ) ;
+
+		// where other known devices split from this one
+		memset( branches, 0, SERIAL_NUMBER_SIZE ) ;
+		for ( other = 0 ; other < devices ; ++other ) {
+			BYTE other_sn[SERIAL_NUMBER_SIZE] ;
+			if ( other != device_index ) {
+				DirblobGet( other, other_sn, tree ) ;
+				UT_setbit( branches, DS2480_search_branch( sn, other_sn ), 1 ) ;
+			}
+		}
+
+		for ( i = 0; i < SERIAL_NUMBER_BITS; i++ ) {
+			UT_setbit( found, i, UT_get2bit(pairs, i) >> 1 ) ;
+			if ( ( UT_get2bit(pairs, i) & SEARCH_BIT_ON ) != UT_getbit( branches, i ) ) {
+				LEVEL_DEBUG("Search tree changed at bit %d of " SNformat, i, SNvar(sn) ) ;
+				owfree( bitpairs ) ;
+				return gbBAD ;
+			}
+		}
+		if ( memcmp( found, sn, SERIAL_NUMBER_SIZE ) != 0 ) {
+			LEVEL_DEBUG("Device " SNformat " is gone", SNvar(sn) ) ;
+			owfree( bitpairs ) ;
+			return gbBAD ;
+		}
+	}
+	owfree( bitpairs ) ;
+
+	// unchanged -- hand out the whole list
+	DirblobClear( &(ds->gulp) ) ;
+	if ( DirblobRecreate( tree->snlist, devices * SERIAL_NUMBER_SIZE, &(ds->gulp) ) != 0 ) {
+		return gbBAD ;
+	}
+	LEVEL_DEBUG("Search of %d devices verified in one pass", devices ) ;
+	return gbGOOD ;
+}
+
+/* Command stream for one accelerated search steered along sn
+ * Tracks the DS2480 mode so the streams can be concatenated.
+ * Returns the bytes used (at most SEARCH_STREAM_SIZE) */
+static size_t DS2480_search_stream(BYTE * stream, const BYTE * sn, int with_reset, BYTE search, struct connection_in * in)
+{
+	BYTE bitpairs[SERIAL_NUMBER_SIZE*2];
+	size_t length = 0 ;
+	int i ;
+
+	memset( bitpairs, 0, SERIAL_NUMBER_SIZE*2 ) ;
+	for (i = 0; i < SERIAL_NUMBER_BITS; i++) {
+		UT_set2bit(bitpairs, i, UT_getbit(sn, i) << 1);
+	}
+
+	if ( with_reset ) {
+		if ( in->master.serial.mode != ds2480b_command_mode ) {
+			stream[length++] = MODE_COMMAND ;
+		}
+		stream[length++] = (BYTE) ( CMD_COMM | FUNCTSEL_RESET | DS2480b_speed_byte(in) ) ;
+		in->master.serial.mode = ds2480b_command_mode ;
+	}
+	if ( in->master.serial.mode != ds2480b_data_mode ) {
+		stream[length++] = MODE_DATA ;
+	}
+	stream[length++] = search ;
+	stream[length++] = MODE_COMMAND ;
+	stream[length++] = (BYTE) ( CMD_COMM | FUNCTSEL_SEARCHON | DS2480b_speed_byte(in) ) ;
+	stream[length++] = MODE_DATA ;
+	for ( i = 0 ; i < SERIAL_NUMBER_SIZE*2 ; ++i ) {
+		stream[length++] = bitpairs[i] ;
+		if ( bitpairs[i] == MODE_COMMAND ) {
+			// doubled to show it's data
+			stream[length++] = bitpairs[i] ;
+		}
+	}
+	stream[length++] = MODE_COMMAND ;
+	stream[length++] = (BYTE) ( CMD_COMM | FUNCTSEL_SEARCHOFF | DS2480b_speed_byte(in) ) ;
+	in->master.serial.mode = ds2480b_command_mode ;
+	return length ;
+}
+
+/* First bit (search order) where two serial numbers differ */
+static int DS2480_search_branch(const BYTE * sn1, const BYTE * sn2)
+{
+	int i ;
+	for ( i = 0 ; i < SERIAL_NUMBER_BITS - 1 ; ++i ) {
+		if ( UT_getbit( sn1, i ) != UT_getbit( sn2, i ) ) {
+			break ;
+		}
+	}
+	return i ;
+}
+
+/* One accelerated search pass, continuing from ds->sn / ds->LastDiscrepancy */
+static enum search_status DS2480_search_one(struct device_search *ds, const struct parsedname *pn)
 {
 	int mismatched;
 	BYTE sn[SERIAL_NUMBER_SIZE];
@@ -825,10 +1079,6 @@ static enum search_status DS2480_next_both(struct device_search *ds, const struc
 	BYTE searchoff = (BYTE) ( CMD_COMM | FUNCTSEL_SEARCHOFF | DS2480b_speed_byte(in) );
 	int i;
 
-	if (ds->LastDevice) {
-		return search_done;
-	}
-
 	if ( BAD( BUS_select(pn) ) ) {
 		return search_error;
 	}
@@ -1217,6 +1467,6 @@ static GOOD_OR_BAD DS2480_sendback_data(const BYTE * data, BYTE * resp, const si
 static void DS2480_close(struct connection_in *in)
 {
 	// the standard COM_free cleans up the connection
-	(void) in ;
+	DirblobClear( &(in->master.serial.search_tree) ) ;
 }
 
@@ -0,0 +1,323 @@
+/*
+    OWFS -- One-Wire filesystem
+    OWHTTPD -- One-Wire Web Server
+    Written 2003 Paul H Alfille
+    email: paul.alfille@gmail.com
+    Released under the GPL
+    See the header file: ow.h for full attribution
+    1wire/iButton system from Dallas Semiconductor
+*/
+
+/* Event mode for the servers (--workers n, owserver and owhttpd)
+ * One epoll thread watches every client socket and keeps the timers,
+ * a fixed pool of worker threads serves the connections queued for them.
+ *
+ * The server fills in what a connection is:
+ *   ready  -- a watched socket has something (usually Event_Queue it)
+ *   timers -- fire the expired entries of its timer lists
+ *   work   -- a worker serves one queued connection
+ * ready and timers run in the event thread with the loop mutex held,
+ * work runs in a worker without it.
+ * Sockets are watched one shot, so only one thread has a connection at a time.
+ * */
+
+#include <config.h>
+#include "owfs_config.h"
+#include "ow.h"
+
+#ifdef HAVE_SYS_EPOLL_H
+
+#include <sys/epoll.h>
+
+// events handled per epoll_wait call
+#define EVENT_BATCH   64
+// longest sleep so new connection timers are noticed (milliseconds)
+#define EVENT_TICK    1000
+
+static int Event_Timeout( struct event_loop * el ) ;
+static void * Event_Thread( void * v ) ;
+static void * Event_Worker( void * v ) ;
+static GOOD_OR_BAD Event_Arm( struct event_loop * el, int op, FILE_DESCRIPTOR_OR_ERROR file_descriptor, void * owner ) ;
+
+/* Append to timer list, deadline seconds from now */
+void Event_List_Add( struct event_list * list, struct event_timer * et, int seconds )
+{
+	gettimeofday( &(et->deadline), NULL ) ;
+	et->deadline.tv_sec += seconds ;
+
+	et->list = list ;
+	et->next = NULL ;
+	et->prev = list->tail ;
+	if ( list->tail ) {
+		list->tail->next = et ;
+	} else {
+		list->head = et ;
+	}
+	list->tail = et ;
+}
+
+void Event_List_Remove( struct event_timer * et )
+{
+	struct event_list * list = et->list ;
+
+	if ( list == NULL ) {
+		return ;
+	}
+	if ( et->prev ) {
+		et->prev->next = et->next ;
+	} else {
+		list->head = et->next ;
+	}
+	if ( et->next ) {
+		et->next->prev = et->prev ;
+	} else {
+		list->tail = et->prev ;
+	}
+	et->list = NULL ;
+	et->prev = et->next = NULL ;
+}
+
+/* Milliseconds until the next timer (capped) */
+/* Called with the loop mutex */
+static int Event_Timeout( struct event_loop * el )
+{
+	struct timeval now ;
+	struct timeval next = { EVENT_TICK / 1000, (EVENT_TICK % 1000) * 1000, } ;
+	struct event_list ** list ;
+
+	gettimeofday( &now, NULL ) ;
+	timeradd( &now, &next, &next ) ;
+
+	for ( list = el->lists ; list != NULL && *list != NULL ; ++list ) {
+		struct event_timer * et ;
+		for ( et = (*list)->head ; et != NULL ; et = (*list)->unsorted ? et->next : NULL ) {
+			if ( timercmp( &(et->deadline), &next, < ) ) {
+				next = et->deadline ;
+			}
+		}
+	}
+
+	if ( timercmp( &next, &now, <= ) ) {
+		return 0 ;
+	}
+	timersub( &next, &now, &next ) ;
+	return next.tv_sec * 1000 + next.tv_usec / 1000 + 1 ;
+}
+
+/* The single event thread */
+static void * Event_Thread( void * v )
+{
+	struct event_loop * el = v ;
+	struct epoll_event events[EVENT_BATCH] ;
+
+	while (1) {
+		struct timeval now ;
+		int timeout_ms ;
+		int nevents ;
+		int i ;
+
+		_MUTEX_LOCK( el->mutex ) ;
+		if ( el->shutdown ) {
+			_MUTEX_UNLOCK( el->mutex ) ;
+			break ;
+		}
+		timeout_ms = Event_Timeout( el ) ;
+		_MUTEX_UNLOCK( el->mutex ) ;
+
+		nevents = epoll_wait( el->epoll_fd, events, EVENT_BATCH, timeout_ms ) ;
+		if ( nevents < 0 ) {
+			if ( errno != EINTR ) {
+				ERROR_DEBUG("Event loop wait problem") ;
+			}
+			nevents = 0 ;
+		}
+
+		_MUTEX_LOCK( el->mutex ) ;
+		for ( i = 0 ; i < nevents ; ++i ) {
+			if ( events[i].data.ptr == NULL ) {
+				// wake pipe -- shutdown checked at top of loop
+				char buf[2] ;
+				ignore_result = read( el->wake_pipe[fd_pipe_read], buf, 1 ) ;
+			} else {
+				// readable, hangup or error -- the server sorts it out
+				el->ready( events[i].data.ptr ) ;
+			}
+		}
+		gettimeofday( &now, NULL ) ;
+		el->timers( &now ) ;
+		_MUTEX_UNLOCK( el->mutex ) ;
+	}
+
+	return VOID_RETURN ;
+}
+
+/* Worker pool thread -- one job at a time */
+static void * Event_Worker( void * v )
+{
+	struct event_loop * el = v ;
+
+	while (1) {
+		struct event_job * job ;
+
+		_MUTEX_LOCK( el->mutex ) ;
+		while ( el->job_head == NULL && ! el->shutdown ) {
+			my_pthread_cond_wait( &(el->job_cond), &(el->mutex) ) ;
+		}
+		job = el->job_head ;
+		if ( job == NULL ) {
+			// shutdown and queue drained
+			_MUTEX_UNLOCK( el->mutex ) ;
+			break ;
+		}
+		el->job_head = job->next ;
+		if ( el->job_head == NULL ) {
+			el->job_tail = NULL ;
+		}
+		_MUTEX_UNLOCK( el->mutex ) ;
+
+		el->work( job->owner ) ;
+	}
+
+	return VOID_RETURN ;
+}
+
+/* Start the event thread and workers, the callbacks and lists already set */
+/* Cleans up after itself if it can't */
+GOOD_OR_BAD Event_Loop_Start( struct event_loop * el, int workers )
+{
+	struct epoll_event ev ;
+	int i ;
+
+	el->job_head = el->job_tail = NULL ;
+	el->shutdown = 0 ;
+	el->loop_running = 0 ;
+	el->workers = 0 ;
+	el->worker_thread = NULL ;
+	Init_Pipe( el->wake_pipe ) ;
+
+	el->epoll_fd = epoll_create( EVENT_BATCH ) ; // size is only a hint
+	if ( FILE_DESCRIPTOR_NOT_VALID( el->epoll_fd ) ) {
+		ERROR_DEFAULT("Cannot create epoll set -- use a thread per connection") ;
+		return gbBAD ;
+	}
+
+	if ( pipe( el->wake_pipe ) != 0 ) {
+		ERROR_DEFAULT("Cannot create event wake pipe -- use a thread per connection") ;
+		Init_Pipe( el->wake_pipe ) ;
+		Test_and_Close( &(el->epoll_fd) ) ;
+		return gbBAD ;
+	}
+	memset( &ev, 0, sizeof(ev) ) ;
+	ev.events = EPOLLIN ;
+	ev.data.ptr = NULL ; // marks the wake pipe
+	epoll_ctl( el->epoll_fd, EPOLL_CTL_ADD, el->wake_pipe[fd_pipe_read], &ev ) ;
+
+	_MUTEX_INIT( el->mutex ) ;
+	my_pthread_cond_init( &(el->job_cond), NULL ) ;
+
+	el->worker_thread = owcalloc( workers, sizeof(pthread_t) ) ;
+	if ( el->worker_thread != NULL ) {
+		for ( i = 0 ; i < workers ; ++i ) {
+			if ( pthread_create( &(el->worker_thread[i]), DEFAULT_THREAD_ATTR, Event_Worker, el ) != 0 ) {
+				ERROR_DEBUG("Could only start %d of %d worker threads", i, workers) ;
+				break ;
+			}
+			++el->workers ;
+		}
+	}
+
+	if ( el->workers > 0 && pthread_create( &(el->loop_thread), DEFAULT_THREAD_ATTR, Event_Thread, el ) == 0 ) {
+		el->loop_running = 1 ;
+		LEVEL_CONNECT("Event mode with %d worker threads", el->workers) ;
+		return gbGOOD ;
+	}
+
+	LEVEL_DEFAULT("Cannot start event mode -- use a thread per connection") ;
+	Event_Loop_Stop( el ) ;
+	Event_Loop_Destroy( el ) ;
+	return gbBAD ;
+}
+
+/* Stop the event thread, workers finish the queued jobs first */
+/* Connections still on the server's lists are left for it to close */
+void Event_Loop_Stop( struct event_loop * el )
+{
+	int i ;
+
+	_MUTEX_LOCK( el->mutex ) ;
+	el->shutdown = 1 ;
+	my_pthread_cond_broadcast( &(el->job_cond) ) ;
+	_MUTEX_UNLOCK( el->mutex ) ;
+
+	if ( el->loop_running ) {
+		ignore_result = write( el->wake_pipe[fd_pipe_write], "X", 1 ) ; //dummy payload
+		pthread_join( el->loop_thread, NULL ) ;
+		el->loop_running = 0 ;
+	}
+
+	for ( i = 0 ; i < el->workers ; ++i ) {
+		pthread_join( el->worker_thread[i], NULL ) ;
+	}
+	el->workers = 0 ;
+	SAFEFREE( el->worker_thread ) ;
+}
+
+/* After Event_Loop_Stop and the server's own clean up */
+void Event_Loop_Destroy( struct event_loop * el )
+{
+	Test_and_Close_Pipe( el->wake_pipe ) ;
+	Test_and_Close( &(el->epoll_fd) ) ;
+	my_pthread_cond_destroy( &(el->job_cond) ) ;
+	_MUTEX_DESTROY( el->mutex ) ;
+}
+
+/* Watch socket for the next message (one shot, so only one thread gets it) */
+static GOOD_OR_BAD Event_Arm( struct event_loop * el, int op, FILE_DESCRIPTOR_OR_ERROR file_descriptor, void * owner )
+{
+	struct epoll_event ev ;
+
+	memset( &ev, 0, sizeof(ev) ) ;
+	ev.events = EPOLLIN | EPOLLONESHOT ;
+	ev.data.ptr = owner ;
+	if ( epoll_ctl( el->epoll_fd, op, file_descriptor, &ev ) != 0 ) {
+		ERROR_DEBUG("Cannot watch client socket %d", file_descriptor) ;
+		return gbBAD ;
+	}
+	return gbGOOD ;
+}
+
+/* New socket -- ready is called with owner */
+/* Called with the loop mutex */
+GOOD_OR_BAD Event_Watch( struct event_loop * el, FILE_DESCRIPTOR_OR_ERROR file_descriptor, void * owner )
+{
+	return Event_Arm( el, EPOLL_CTL_ADD, file_descriptor, owner ) ;
+}
+
+/* Socket already watched -- wait for the next message */
+/* Called with the loop mutex */
+GOOD_OR_BAD Event_Rearm( struct event_loop * el, FILE_DESCRIPTOR_OR_ERROR file_descriptor, void * owner )
+{
+	return Event_Arm( el, EPOLL_CTL_MOD, file_descriptor, owner ) ;
+}
+
+/* Called with the loop mutex, before the socket is closed */
+void Event_Unwatch( struct event_loop * el, FILE_DESCRIPTOR_OR_ERROR file_descriptor )
+{
+	epoll_ctl( el->epoll_fd, EPOLL_CTL_DEL, file_descriptor, NULL ) ;
+}
+
+/* Hand to a worker */
+/* Called with the loop mutex */
+void Event_Queue( struct event_loop * el, struct event_job * job )
+{
+	job->next = NULL ;
+	if ( el->job_tail ) {
+		el->job_tail->next = job ;
+	} else {
+		el->job_head = job ;
+	}
+	el->job_tail = job ;
+	my_pthread_cond_signal( &(el->job_cond) ) ;
+}
+
+#endif							/* HAVE_SYS_EPOLL_H */
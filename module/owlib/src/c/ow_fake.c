@@ -160,6 +160,8 @@ static void GetAllDeviceNames( struct port_in * pin )
 		GetDeviceName( &current_device_start, in ) ;
 	}
 	SAFEFREE( remember_location ) ;
+	// fixed from now on, index it for presence checks
+	DirblobFreeze( &(in->master.fake.main) ) ;
 	in->AnyDevices = (DirblobElements(&(in->master.fake.main)) > 0) ? anydevices_yes : anydevices_no ;
 }
 
@@ -70,3 +70,49 @@ size_t FullFileLength(const struct parsedname * pn)
 		}
 	}
 }
+
+/* Type of the binary value form (VALUE_BINARY) of a property */
+/* value_binary_none for text and binary data, which are sent as they are */
+enum value_binary_type ValueBinaryType(const struct parsedname *pn)
+{
+	if (pn->type == ePN_structure || IsDir(pn)) {
+		return value_binary_none;
+	}
+	if (pn->extension == EXTENSION_BYTE) {
+		return value_binary_unsigned;
+	}
+
+	switch (pn->selected_filetype->format) {
+	case ft_integer:
+		return value_binary_integer;
+	case ft_unsigned:
+		return value_binary_unsigned;
+	case ft_yesno:
+	case ft_bitfield:
+		return value_binary_yesno;
+	case ft_float:
+	case ft_pressure:
+	case ft_temperature:
+	case ft_tempgap:
+		return value_binary_float;
+	case ft_date:
+		return value_binary_date;
+	default:
+		return value_binary_none;
+	}
+}
+
+/* Buffer needed for a read -- the binary value form can be longer than the text */
+size_t ReadLength(const struct parsedname * pn)
+{
+	size_t length = FullFileLength(pn);
+
+	if (WantValueBinary(pn) && ValueBinaryType(pn) != value_binary_none) {
+		size_t elements = (pn->extension == EXTENSION_ALL) ? (size_t) pn->selected_filetype->ag->elements : 1;
+		size_t binary_length = 1 + VALUE_BINARY_ELEMENT * elements;
+		if (binary_length > length) {
+			length = binary_length;
+		}
+	}
+	return length;
+}
@@ -111,3 +111,53 @@ SIZE_OR_ERROR FS_get(const char *path, char **return_buffer, size_t * buffer_len
 	}
 	return size ;
 }
+
+/*
+  Get several values at once, each a copy (which must be free-ed elsewhere) in return_buffers[i]
+  return_lengths[i] is the length of each value, or <0 for error (return_buffers[i] is NULL)
+  Properties of the same device are read together (see FS_read_many)
+  return number of values read, or <0 for error
+ */
+SIZE_OR_ERROR FS_get_many(const char **paths, int count, char **return_buffers, SIZE_OR_ERROR * return_lengths)
+{
+	struct one_wire_query ** owq_array ;
+	int good_reads = 0 ;
+	int i ;
+
+	/* Check the parameters */
+	if (paths == NULL || return_buffers == NULL || return_lengths == NULL || count < 0) {
+		return -EINVAL;
+	}
+
+	owq_array = owcalloc( count+1, sizeof(struct one_wire_query *) ) ;
+	if ( owq_array == NULL ) {
+		return -ENOMEM ;
+	}
+
+	for ( i = 0 ; i < count ; ++i ) {
+		struct one_wire_query * owq = OWQ_create_from_path( (paths[i] == NULL) ? "/" : paths[i] ) ;
+		return_buffers[i] = NULL ;
+		if ( owq != NO_ONE_WIRE_QUERY && BAD( OWQ_allocate_read_buffer(owq) ) ) {
+			OWQ_destroy(owq) ;
+			owq = NO_ONE_WIRE_QUERY ;
+		}
+		owq_array[i] = owq ;
+	}
+
+	FS_read_many( owq_array, return_lengths, count ) ;
+
+	for ( i = 0 ; i < count ; ++i ) {
+		if ( return_lengths[i] >= 0 ) {
+			return_buffers[i] = copy_buffer( OWQ_buffer(owq_array[i]), return_lengths[i] ) ;
+			if ( return_buffers[i] == NULL ) {
+				return_lengths[i] = -ENOMEM ;
+			} else {
+				++good_reads ;
+			}
+		}
+		OWQ_destroy( owq_array[i] ) ;
+	}
+	owfree( owq_array ) ;
+
+	return good_reads ;
+}
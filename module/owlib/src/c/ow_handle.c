@@ -0,0 +1,195 @@
+/*
+    OWFS -- One-Wire filesystem
+    OWHTTPD -- One-Wire Web Server
+    Written 2003 Paul H Alfille
+    email: paul.alfille@gmail.com
+    Released under the GPL
+    See the header file: ow.h for full attribution
+    1wire/iButton system from Dallas Semiconductor
+*/
+
+/* Property handles -- the same path read over and over (owcapi OW_open_handle, owfs open files)
+ * The path is parsed and the device located once. The query is kept with
+ * the bus it was found on and its device lock held (DeviceLockHold), so a
+ * read skips the parsing, the presence lookup and the device lock tree.
+ *
+ * Between reads a handle is not a bus list reader, so adding or removing
+ * a bus isn't held up. Each read first checks the bus is still the same
+ * (index and instance) and parses the path again if it went away.
+ * If the device is no longer on its bus, the read looks again itself
+ * (ReCheckPresence) and the handle follows it to the new bus.
+ *
+ * A handle is for one thread at a time.
+ * */
+
+#include <config.h>
+#include "owfs_config.h"
+#include "ow.h"
+#include "ow_connection.h"
+
+struct property_handle {
+	char * path ;
+	struct one_wire_query * owq ; // NO_ONE_WIRE_QUERY to parse again
+	INDEX_OR_ERROR bus ; // where the device was found, INDEX_BAD for no bus
+	UINT instance ; // of that bus
+} ;
+
+static ZERO_OR_ERROR Handle_Resolve( struct property_handle * ph ) ;
+static void Handle_Hold( struct property_handle * ph ) ;
+static GOOD_OR_BAD Handle_Enter( struct property_handle * ph ) ;
+static void Handle_Leave( struct property_handle * ph ) ;
+
+ZERO_OR_ERROR FS_handle_open( const char * path, struct property_handle ** handle )
+{
+	struct property_handle * ph = owmalloc( sizeof( struct property_handle ) ) ;
+	ZERO_OR_ERROR resolve ;
+
+	*handle = NULL ;
+	if ( ph == NULL ) {
+		return -ENOMEM ;
+	}
+	ph->owq = NO_ONE_WIRE_QUERY ;
+	ph->path = owstrdup( path ) ;
+	if ( ph->path == NULL ) {
+		owfree( ph ) ;
+		return -ENOMEM ;
+	}
+
+	resolve = Handle_Resolve( ph ) ;
+	if ( resolve != 0 ) {
+		owfree( ph->path ) ;
+		owfree( ph ) ;
+		return resolve ;
+	}
+	Handle_Leave( ph ) ;
+	*handle = ph ;
+	return 0 ;
+}
+
+/* Read the whole property into buffer (like FS_read at offset 0) */
+SIZE_OR_ERROR FS_handle_read( struct property_handle * ph, char * buffer, size_t size )
+{
+	return FS_handle_read_offset( ph, buffer, size, 0 ) ;
+}
+
+/* Read part of the property (memory pages), like FS_read */
+SIZE_OR_ERROR FS_handle_read_offset( struct property_handle * ph, char * buffer, size_t size, off_t offset )
+{
+	struct parsedname * pn ;
+	struct connection_in * found_on ;
+	SIZE_OR_ERROR read_or_error ;
+
+	if ( ph->owq != NO_ONE_WIRE_QUERY && BAD( Handle_Enter( ph ) ) ) {
+		LEVEL_DEBUG("%s: bus.%d is gone", ph->path, (int) ph->bus ) ;
+		OWQ_destroy( ph->owq ) ;
+		ph->owq = NO_ONE_WIRE_QUERY ;
+	}
+	if ( ph->owq == NO_ONE_WIRE_QUERY ) {
+		ZERO_OR_ERROR resolve = Handle_Resolve( ph ) ;
+		if ( resolve != 0 ) {
+			return resolve ;
+		}
+	}
+
+	pn = PN( ph->owq ) ;
+	found_on = pn->selected_connection ;
+	OWQ_assign_read_buffer( buffer, size, offset, ph->owq ) ;
+	read_or_error = FS_read_postparse( ph->owq ) ;
+
+	if ( pn->selected_connection != found_on ) {
+		// the read looked for the device again (old bus still valid, we're a reader)
+		DeviceLockUnhold( pn ) ;
+		if ( pn->selected_connection == NO_CONNECTION ) {
+			// not found at all, start over next time
+			OWQ_destroy( ph->owq ) ;
+			ph->owq = NO_ONE_WIRE_QUERY ;
+			return read_or_error ;
+		}
+		LEVEL_DEBUG("%s: moved to bus.%d", ph->path, (int) pn->selected_connection->index ) ;
+		Handle_Hold( ph ) ;
+	}
+	Handle_Leave( ph ) ;
+	return read_or_error ;
+}
+
+void FS_handle_close( struct property_handle * ph )
+{
+	if ( ph == NULL ) {
+		return ;
+	}
+	if ( ph->owq != NO_ONE_WIRE_QUERY ) {
+		if ( GOOD( Handle_Enter( ph ) ) ) {
+			DeviceLockUnhold( PN( ph->owq ) ) ;
+		}
+		OWQ_destroy( ph->owq ) ;
+	}
+	owfree( ph->path ) ;
+	owfree( ph ) ;
+}
+
+/* Parse the path and locate the device -- leaves the query a bus list reader */
+static ZERO_OR_ERROR Handle_Resolve( struct property_handle * ph )
+{
+	ph->owq = OWQ_create_from_path( ph->path ) ;
+	if ( ph->owq == NO_ONE_WIRE_QUERY ) {
+		return -ENOENT ;
+	}
+	if ( IsDir( PN( ph->owq ) ) ) {
+		OWQ_destroy( ph->owq ) ;
+		ph->owq = NO_ONE_WIRE_QUERY ;
+		return -EISDIR ;
+	}
+	Handle_Hold( ph ) ;
+	return 0 ;
+}
+
+/* Remember the bus and keep the device lock */
+static void Handle_Hold( struct property_handle * ph )
+{
+	struct parsedname * pn = PN( ph->owq ) ;
+
+	DeviceLockHold( pn ) ;
+	if ( pn->selected_connection == NO_CONNECTION ) {
+		ph->bus = INDEX_BAD ;
+		ph->instance = 0 ;
+	} else {
+		ph->bus = pn->selected_connection->index ;
+		ph->instance = pn->selected_connection->instance ;
+	}
+}
+
+/* Become a bus list reader again and check the bus is still there */
+static GOOD_OR_BAD Handle_Enter( struct property_handle * ph )
+{
+	struct parsedname * pn = PN( ph->owq ) ;
+	struct connection_in * in ;
+
+	pn->connin_reader = Connection_Read_Begin() ;
+
+	// current settings (temperature scale...) as a new parse would have
+	CONTROLFLAGSLOCK;
+	pn->control_flags = LocalControlFlags | ( pn->control_flags & SHOULD_RETURN_BUS_LIST ) ;
+	CONTROLFLAGSUNLOCK;
+
+	if ( ph->bus == INDEX_BAD ) {
+		return gbGOOD ;
+	}
+	in = find_connection_in( ph->bus ) ;
+	if ( in == NO_CONNECTION || in->instance != ph->instance ) {
+		// removed, and its device locks with it
+		pn->held_lock = NULL ;
+		return gbBAD ;
+	}
+	return gbGOOD ;
+}
+
+/* No longer a bus list reader until the next read */
+static void Handle_Leave( struct property_handle * ph )
+{
+	struct parsedname * pn = PN( ph->owq ) ;
+
+	if ( pn->connin_reader >= 0 ) {
+		Connection_Read_End( pn->connin_reader ) ;
+		pn->connin_reader = -1 ;
+	}
+}
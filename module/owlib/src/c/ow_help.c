@@ -65,6 +65,8 @@ void ow_help_job(void)
 	"  --foreground\n"
 	"  --background\n"
 	"  --pid_file name  file to store pid number (for control scripts)\n"
+	"  --fanout_threads n Threads kept for requests spread over all buses (default 16)\n"
+	"                   0 to handle the buses one after another\n"
 	"\n"
 	" Configuration\n"
 	"  -c --configuration filename\n"
@@ -114,6 +116,10 @@ void ow_help_cache(void)
 	"  --uncached          Implicit /uncached in all requests\n"
 	"  --cached            Explicit /uncached needed. (Default action)\n"
 	"  --cache_size n   Size in bytes of max cache memory. 0 for no limit.\n"
+	"  --poll dev/prop[:s] Keep matching properties fresh in the cache (repeatable)\n"
+	"                      e.g. --poll 28.*/temperature:10 (default every timeout_volatile/2)\n"
+	"  --registry s        Search each bus every s seconds, list devices from the result\n"
+	"                      changes show in /system/registry\n"
 	"\n"
 	" Cache timing         [default] (in seconds)\n"
 	"  --timeout_volatile  [%3d] Expiration time for changing data (e.g. temperature)\n"
@@ -161,21 +167,28 @@ void ow_help_program(void)
 	"  --fuse_open_opt args  Special arguments to pass to FUSE (Quoted and escaped)\n"
 	"  --allow_other         Allow other users to see owfs file system\n"
 	"                         needs /etc/fuse.conf setting\n"
+	"  --fuse_workers n      Threads serving each 1-wire bus (default 2)\n"
+	"                         0 to serve requests in the FUSE threads\n"
 	"\n"
 	" owhttpd (web server)\n"
 	"  -p --port [ip:]port   TCP address and port number for access\n"
 	"  --zero                Announce service via zeroconf\n"
 	"  --announce name       Name for service given in zeroconf broadcast\n"
 	"  --nozero              Don't announce service via zeroconf\n"
+	"  --workers n           Event driven mode with n worker threads (epoll only)\n"
+	"                         HTTP/1.1 keep-alive and chunked replies\n"
 	"\n"
 	" owserver (OWFS server)\n"
 	"  -p --port [ip:]port   TCP address and port number for access\n"
+	"  --workers n           Event driven mode with n worker threads (epoll only)\n"
+	"                         default 0 is one thread per connection\n"
 	"\n"
 	" Development tests (owserver only)\n"
 	"  --pingcrazy      Add lots of keep-alive messages to the owserver protocol\n"
 	"  --no_dirall      DIRALL fails, drops back to older DIR (individual entries)\n"
 	"  --no_get         GET fails, drops back to DIRALL and READ\n"
 	"  --no_persistence persistent connections refused, drops back to non-persistent\n"
+	"  --no_pipeline    request ids refused, drops back to one request at a time\n"
 	"\n"
 	" owftpd (ftp server)\n"
 	"  -p --port [ip:]port   TCP address and port number for access\n"
@@ -228,6 +241,7 @@ void ow_help_device(void)
 	"\n"
 	" Network (address is form [ip:]port, ip DNS name or n.n.n.n, port is port number)\n"
 	"  -s address      owserver\n"
+	"  --server_pool n Persistent connections kept to each owserver (default 8)\n"
 	"  --LINK=address  LINK-HUB-E network LINK\n"
 	"  --HA7NET=address HA7NET bus master\n"
 	"  --HA7NET        HA7NET bus master address auto-discovered\n"
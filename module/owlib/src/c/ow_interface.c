@@ -256,6 +256,11 @@ static struct filetype interface_statistics[] = {
 	{"overdrive", PROPERTY_LENGTH_SUBDIR, NON_AGGREGATE, ft_subdir, fc_subdir, NO_READ_FUNCTION, NO_WRITE_FUNCTION, VISIBLE, NO_FILETYPE_DATA, },
 	{"overdrive/attempts", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat_p, NO_WRITE_FUNCTION, VISIBLE, {.i=e_bus_try_overdrive}, },
 	{"overdrive/failures", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat_p, NO_WRITE_FUNCTION, VISIBLE, {.i=e_bus_failed_overdrive}, },
+
+	{"queue", PROPERTY_LENGTH_SUBDIR, NON_AGGREGATE, ft_subdir, fc_subdir, NO_READ_FUNCTION, NO_WRITE_FUNCTION, VISIBLE, NO_FILETYPE_DATA, },
+	{"queue/depth", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat_p, NO_WRITE_FUNCTION, VISIBLE, {.i=e_bus_queue_depth}, },
+	{"queue/max_depth", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat_p, NO_WRITE_FUNCTION, VISIBLE, {.i=e_bus_queue_max}, },
+	{"queue/requests", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat_p, NO_WRITE_FUNCTION, VISIBLE, {.i=e_bus_queued}, },
 };
 
 struct device d_interface_statistics = { 
@@ -756,7 +761,7 @@ static ZERO_OR_ERROR FS_stat_p(struct one_wire_query *owq)
 
 static ZERO_OR_ERROR FS_bustime(struct one_wire_query *owq)
 {
-	OWQ_F(owq) = TVfloat( &(PN(owq)->selected_connection->bus_time) ) ;
+	OWQ_F(owq) = (_FLOAT) STAT_READ( PN(owq)->selected_connection->bus_time ) / 1000000. ;
 	return 0;
 }
 
@@ -19,6 +19,10 @@
 void LibStop(void)
 {
 	char *argv[1] = { NULL };
+	LEVEL_CALL("Stopping background threads");
+	Poll_Stop();
+	Registry_Stop();
+	Task_Stop();
 	LEVEL_CALL("Clear Cache");
 	Cache_Clear();
 	LEVEL_CALL("Closing input devices");
@@ -27,6 +31,7 @@ void LibStop(void)
 	FreeOutAll();
 	LEVEL_CALL("Clearing compiled expressions");
 	ow_regdestroy() ;
+	Parse_Cache_Clear() ;
 
 
 	/* Have to reset more internal variables, and this should be fixed
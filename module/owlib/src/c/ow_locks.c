@@ -79,6 +79,9 @@ void LockSetup(void)
 	_MUTEX_INIT(Mutex.externalcount_mutex);
 	_MUTEX_INIT(Mutex.timegm_mutex);
 	_MUTEX_INIT(Mutex.detail_mutex);
+	_MUTEX_INIT(Mutex.read_flight_mutex);
+	_MUTEX_INIT(Mutex.registry_mutex);
+	_MUTEX_INIT(Mutex.task_mutex);
 
 	RWLOCK_INIT(Mutex.lib);
 	RWLOCK_INIT(Mutex.cache);
@@ -26,6 +26,7 @@ pthread_mutex_t handler_thread_mutex ;
 int handler_thread_count ;
 int shutdown_in_progress ;
 FILE_DESCRIPTOR_OR_ERROR shutdown_pipe[2] ;
+int accept_inline = 0 ; // event mode -- handler called in listen thread and owns the socket
 
 
 /* Prototypes */
@@ -284,6 +285,18 @@ static void ProcessListenSocket( struct connection_out * out )
 		return ;
 	}
 
+	if ( accept_inline ) {
+		// Event mode: just hand over the socket, no thread
+		RWLOCK_RLOCK( shutdown_mutex_rw ) ;
+		if ( shutdown_in_progress ) {
+			close( acceptfd ) ;
+		} else {
+			out->HandlerRoutine( acceptfd ) ;
+		}
+		RWLOCK_RUNLOCK( shutdown_mutex_rw ) ;
+		return ;
+	}
+
 	// allocate space to pass variables to thread 
 	// MUST be cleaned up in thread handler, not in this routine
 	asd = owmalloc( sizeof(struct Accept_Socket_Data) ) ;
@@ -363,6 +376,16 @@ void ServerProcess(void (*HandlerRoutine) (FILE_DESCRIPTOR_OR_ERROR file_descrip
 	return;
 }
 
+/* Event driven variant of ServerProcess */
+/* AcceptRoutine is called in the listening thread for each new connection,
+   must not block, and takes ownership of the file descriptor */
+void ServerProcessEvents(void (*AcceptRoutine) (FILE_DESCRIPTOR_OR_ERROR file_descriptor))
+{
+	accept_inline = 1 ;
+	ServerProcess( AcceptRoutine ) ;
+	accept_inline = 0 ;
+}
+
 /* Call from elseware
  * specifically the configuration monitoring code
  * to stop the loops
@@ -120,9 +120,13 @@ const struct option owopts_long[] = {
 	{"fuse_open_opt", required_argument, NO_LINKED_VAR, e_fuse_open_opt},	/* owfs, fuse open option */
 	{"fuse-open-opt", required_argument, NO_LINKED_VAR, e_fuse_open_opt},	/* owfs, fuse open option */
 	{"fuseopenopt", required_argument, NO_LINKED_VAR, e_fuse_open_opt},	/* owfs, fuse open option */
+	{"fuse_workers", required_argument, NO_LINKED_VAR, e_fuse_workers},	/* owfs, threads per bus */
 	{"max_clients", required_argument, NO_LINKED_VAR, e_max_clients},	/* ftp max connections */
 	{"max-clients", required_argument, NO_LINKED_VAR, e_max_clients},	/* ftp max connections */
 	{"maxclients", required_argument, NO_LINKED_VAR, e_max_clients},	/* ftp max connections */
+	{"workers", required_argument, NO_LINKED_VAR, e_server_workers},	/* owserver and owhttpd event mode */
+	{"server_pool", required_argument, NO_LINKED_VAR, e_server_pool},	/* connections to each owserver */
+	{"fanout_threads", required_argument, NO_LINKED_VAR, e_fanout_threads},	/* threads for all-bus requests */
 
 	{"passive", required_argument, NO_LINKED_VAR, e_passive},	/* DS9097 passive */
 	{"PASSIVE", required_argument, NO_LINKED_VAR, e_passive},	/* DS9097 passive */
@@ -190,6 +194,8 @@ const struct option owopts_long[] = {
 	{"MASTERHUB", required_argument, NO_LINKED_VAR, e_masterhub},
 
 	{"announce", required_argument, NO_LINKED_VAR, e_announce},
+	{"poll", required_argument, NO_LINKED_VAR, e_poll},	/* background cache refresh */
+	{"registry", required_argument, NO_LINKED_VAR, e_registry},	/* background device registry */
 	{"allow_other", no_argument, &Globals.allow_other, 1},
 	{"altUSB", no_argument, &Globals.altUSB, 1},	/* Willy Robison's tweaks */
 	{"altusb", no_argument, &Globals.altUSB, 1},	/* Willy Robison's tweaks */
@@ -257,6 +263,7 @@ const struct option owopts_long[] = {
 	{"no_dirall", no_argument, &Globals.no_dirall, 1},
 	{"no_get", no_argument, &Globals.no_get, 1},
 	{"no_persistence", no_argument, &Globals.no_persistence, 1},
+	{"no_pipeline", no_argument, &Globals.no_pipeline, 1},
 	{"8bit", no_argument, &Globals.eightbit_serial, 1},
 	{"6bit", no_argument, &Globals.eightbit_serial, 0},
 	{"ActivePullUp", no_argument, &Globals.i2c_APU, 1},
@@ -756,6 +763,22 @@ GOOD_OR_BAD owopt(const int option_char, const char *arg)
 		RETURN_BAD_IF_BAD(OW_parsevalue_I(&arg_to_integer, arg)) ;
 		Globals.max_clients = (int) arg_to_integer;
 		break;
+	case e_server_workers:
+		RETURN_BAD_IF_BAD(OW_parsevalue_I(&arg_to_integer, arg)) ;
+		Globals.server_workers = (int) arg_to_integer;
+		break;
+	case e_server_pool:
+		RETURN_BAD_IF_BAD(OW_parsevalue_I(&arg_to_integer, arg)) ;
+		Globals.server_pool = (int) arg_to_integer;
+		break;
+	case e_fanout_threads:
+		RETURN_BAD_IF_BAD(OW_parsevalue_I(&arg_to_integer, arg)) ;
+		Globals.fanout_threads = (int) arg_to_integer;
+		break;
+	case e_fuse_workers:
+		RETURN_BAD_IF_BAD(OW_parsevalue_I(&arg_to_integer, arg)) ;
+		Globals.fuse_workers = (int) arg_to_integer;
+		break;
 	case e_want_background:
 		switch (Globals.daemon_status) {
 			case e_daemon_sd:
@@ -825,6 +848,12 @@ GOOD_OR_BAD owopt(const int option_char, const char *arg)
 	case e_announce:
 		Globals.announce_name = owstrdup(arg);
 		break;
+	case e_poll:
+		return Poll_Add(arg);
+	case e_registry:
+		RETURN_BAD_IF_BAD(OW_parsevalue_I(&arg_to_integer, arg)) ;
+		Globals.registry = (int) arg_to_integer;
+		break;
 		// Pressure scale
 	case e_pressure_mbar:
 		Globals.pressure_scale = pressure_mbar ;
@@ -16,38 +16,43 @@
 
 
 /* Fill get serikal number from a character string */ 
+/* Form: FF.IIIIIIIIIIII[.CC] dots optional, CRC optional */
 enum parse_serialnumber Parse_SerialNumber(char *sn_char, BYTE * sn)
 {
-	static regex_t rx_sn_parse ;
-	struct ow_regmatch orm ;
-	
-	ow_regcomp( &rx_sn_parse, "^([[:xdigit:]]{2})\\.?([[:xdigit:]]{12})\\.?([[:xdigit:]]{2}){0,1}$", 0 ) ;
-	orm.number = 3 ;
+	BYTE parsed_sn[SERIAL_NUMBER_SIZE] ;
+	const char * c = sn_char ;
+	int byte ;
 	
 	if ( sn_char == NULL ) {
 		return sn_null ;
 	}
 
-	if ( ow_regexec( &rx_sn_parse, sn_char, &orm ) != 0 ) {
-		return sn_not_sn ;
+	for ( byte = 0 ; byte < SERIAL_NUMBER_SIZE-1 ; ++byte ) {
+		if ( byte == 1 && c[0] == '.' ) {
+			++c ; // dot after family code
+		}
+		if ( ! isxdigit( (unsigned char) c[0] ) || ! isxdigit( (unsigned char) c[1] ) ) {
+			return sn_not_sn ;
+		}
+		parsed_sn[byte] = string2num( c ) ;
+		c += 2 ;
+	}
+	if ( c[0] == '.' ) {
+		++c ; // dot before CRC
 	}
-		
-	sn[0] = string2num(orm.match[1]);
-	sn[1] = string2num(&orm.match[2][0]);
-	sn[2] = string2num(&orm.match[2][2]);
-	sn[3] = string2num(&orm.match[2][4]);
-	sn[4] = string2num(&orm.match[2][6]);
-	sn[5] = string2num(&orm.match[2][8]);
-	sn[6] = string2num(&orm.match[2][10]);
-	sn[7] = CRC8compute(sn, SERIAL_NUMBER_SIZE-1, 0);
-	if (orm.match[3] != NULL) {
+	parsed_sn[SERIAL_NUMBER_SIZE-1] = CRC8compute(parsed_sn, SERIAL_NUMBER_SIZE-1, 0);
+
+	if ( c[0] != '\0' ) {
 		// CRC given
-		if ( string2num(orm.match[3]) != sn[7] ) {
-			ow_regexec_free( &orm ) ;
-			return sn_invalid;
+		if ( ! isxdigit( (unsigned char) c[0] ) || ! isxdigit( (unsigned char) c[1] ) || c[2] != '\0' ) {
+			return sn_not_sn ;
 		}
 	}
-	ow_regexec_free( &orm ) ;
+
+	memcpy( sn, parsed_sn, SERIAL_NUMBER_SIZE ) ;
+	if ( c[0] != '\0' && string2num( c ) != sn[SERIAL_NUMBER_SIZE-1] ) {
+		return sn_invalid;
+	}
 	return sn_valid ;
 }
 
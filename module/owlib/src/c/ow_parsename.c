@@ -37,6 +37,7 @@ static enum parse_enum Parse_Real(char *pathnow, enum parse_pass remote_status,
 static enum parse_enum Parse_NonReal(char *pathnow, struct parsedname *pn);
 static enum parse_enum Parse_RealDevice(char *filename, enum parse_pass remote_status, struct parsedname *pn);
 static enum parse_enum Parse_Property(char *filename, struct parsedname *pn);
+static int Parse_Extension_Number( const char * last_dot ) ;
 
 static enum parse_enum Parse_RealDeviceSN(enum parse_pass remote_status, struct parsedname *pn);
 static enum parse_enum Parse_NonRealDevice(char *filename, struct parsedname *pn);
@@ -46,9 +47,19 @@ static enum parse_enum Parse_Alias(char *filename, enum parse_pass remote_status
 static enum parse_enum Parse_Alias_Known( char *filename, enum parse_pass remote_status, struct parsedname *pn);
 static void ReplaceAliasInPath( char * filename, struct parsedname * pn);
 
+static enum parse_enum Parse_Presence(enum parse_pass remote_status, struct parsedname *pn);
+
 static ZERO_OR_ERROR FS_ParsedName_anywhere(const char *path, enum parse_pass remote_status, struct parsedname *pn);
 static ZERO_OR_ERROR FS_ParsedName_setup(struct parsedname_pointers *pp, const char *path, struct parsedname *pn);
 static char * find_segment_in_path( char * segment, char * path ) ;
+static int segment_is( const char * segment, const char * name ) ;
+static GOOD_OR_BAD Path_To_Server_Own( struct parsedname * pn ) ;
+
+// path of a placeholder (or destroyed) parsedname
+static char parsedname_no_path[] = "" ;
+
+static GOOD_OR_BAD Parse_Cache_Get( struct parsedname * pn ) ;
+static void Parse_Cache_Add( int dirlength, const struct parsedname * pn ) ;
 
 #define BRANCH_INCR (9)
 
@@ -61,20 +72,29 @@ void FS_ParsedName_destroy(struct parsedname *pn)
 		return;
 	}
 	LEVEL_DEBUG("%s", SAFESTRING(pn->path));
-	CONNIN_RUNLOCK ;
+	if ( pn->connin_reader >= 0 ) {
+		Connection_Read_End( pn->connin_reader ) ;
+		pn->connin_reader = -1 ;
+	}
 	Detail_Free( pn ) ;
 	SAFEFREE(pn->sparse_name);
 	SAFEFREE(pn->bp) ;
+	if ( pn->path_to_server != pn->path ) {
+		SAFEFREE(pn->path_to_server) ;
+	}
+	if ( pn->path != parsedname_no_path ) {
+		SAFEFREE(pn->path) ;
+	}
+	pn->path = pn->path_to_server = parsedname_no_path ;
 }
 
 /* 
  * Path is either NULL (in which case a minimal structure is created that doesn't need Destroy -- used for Bus Master setups)
  * or Path is a full "filename" type string of form: 10.1243Ab000 or uncached/bus.0/statistics etc.
  * 
- * The Path passed in isn't altered, but 2 copies are made -- one with the full path, the other (to_server) has the first bus.n removed.
- * An initial / is added to the path, and the full length has to be less than MAX_PATH (2048)
- * 
- * For efficiency, the two path copies are allocated in the same memory allocation call, and so can be removed together.
+ * The Path passed in isn't altered, but a copy is made (allocated to fit) with an initial / added. The full length has to be less than MAX_PATH (2048)
+ * path_to_server (the first bus.n removed, aliases replaced) is the same string until it actually differs,
+ * then it gets its own copy. This keeps struct parsedname small -- it is on the stack and shallow copied everywhere.
  * */
 
 /* Parse a path to check it's validity and attach to the propery data structures */
@@ -96,6 +116,7 @@ static ZERO_OR_ERROR FS_ParsedName_anywhere(const char *path, enum parse_pass re
 	struct parsedname_pointers *pp = &s_pp;
 	ZERO_OR_ERROR parse_error_status = 0;
 	enum parse_enum pe = parse_first;
+	int dirlength = -1 ; // property position for the parse cache
 
 	// To make the debug output useful it's cleared here.
 	// Even on normal glibc, errno isn't cleared on good system calls
@@ -109,6 +130,15 @@ static ZERO_OR_ERROR FS_ParsedName_anywhere(const char *path, enum parse_pass re
 		RETURN_CODE_RETURN( 0 ) ; // success (by default)
 	}
 
+	// Same path parsed recently? Only the presence check is left
+	if ( GOOD( Parse_Cache_Get( pn ) ) ) {
+		pp->pathnext = NULL ;
+		pe = Parse_Presence( remote_status, pn ) ;
+		if ( pe != parse_error ) {
+			pe = parse_done ;
+		}
+	}
+
 	while (1) {
 		// Check for extreme conditions (done, error)
 		switch (pe) {
@@ -127,6 +157,8 @@ static ZERO_OR_ERROR FS_ParsedName_anywhere(const char *path, enum parse_pass re
 				pe = parse_done;
 				continue;				
 			}
+
+			Parse_Cache_Add( dirlength, pn ) ;
 			
 			//printf("%s: Parse %s before corrections: %.4X -- state = %d\n",(back_from_remote)?"BACK":"FORE",pn->path,pn->state,pn->type) ;
 			// Play with remote levels
@@ -214,6 +246,7 @@ static ZERO_OR_ERROR FS_ParsedName_anywhere(const char *path, enum parse_pass re
 		case parse_prop:
 			//LEVEL_DEBUG("PARSENAME parse_prop") ;
 			pn->dirlength = pp->pathnow - pp->pathcpy + 1 ;
+			dirlength = pn->dirlength ;
 			//LEVEL_DEBUG("Dirlength=%d <%*s>",pn->dirlength,pn->dirlength,pn->path) ;
 			//printf("dirlength = %d which makes the path <%s> <%.*s>\n",pn->dirlength,pn->path,pn->dirlength,pn->path);
 			pp->pathlast = pp->pathnow;	/* Save for concatination if subdirectory later wanted */
@@ -243,6 +276,7 @@ static ZERO_OR_ERROR FS_ParsedName_setup(struct parsedname_pointers *pp, const c
 	}
 
 	memset(pn, 0, sizeof(struct parsedname));
+	pn->connin_reader = -1 ; // not yet
 	pn->known_bus = NULL;		/* all buses */
 	pn->sparse_name = NULL ;
 	RETURN_CODE_INIT(pn);
@@ -284,6 +318,7 @@ static ZERO_OR_ERROR FS_ParsedName_setup(struct parsedname_pointers *pp, const c
 
 	/* minimal structure for initial bus "detect" use -- really has connection and LocalControlFlags only */
 	pn->dirlength = -1 ;
+	pn->path = pn->path_to_server = parsedname_no_path ;
 	if (path == NO_PATH) {
 		return 0; // success
 	}
@@ -293,9 +328,14 @@ static ZERO_OR_ERROR FS_ParsedName_setup(struct parsedname_pointers *pp, const c
 	}
 
 	/* Have to save pn->path at once */
+	pn->path = owmalloc( strlen(path) + 2 ) ;
+	if ( pn->path == NULL ) {
+		pn->path = parsedname_no_path ;
+		RETURN_CODE_RETURN( 79 ) ; // unable to allocate memory
+	}
 	strcpy(pn->path, "/"); // initial slash
 	strcpy(pn->path+1, path[0]=='/'?path+1:path);
-	strcpy(pn->path_to_server, pn->path);
+	pn->path_to_server = pn->path ;
 
 	/* make a copy for destructive parsing  without initial '/'*/
 	strcpy(pp->pathcpy,&pn->path[1]);
@@ -311,11 +351,11 @@ static ZERO_OR_ERROR FS_ParsedName_setup(struct parsedname_pointers *pp, const c
 	/* -- This is important:     -- */
 	/* --     Buses can --          */
 	/* -- be added by Browse so  -- */
-	/* -- a reader/writer lock is - */
-	/* -- held until ParsedNameDestroy */
+	/* -- a read section (no lock) */
+	/* -- is held until ParsedNameDestroy */
 	/* ---------------------------- */
 
-	CONNIN_RLOCK;
+	pn->connin_reader = Connection_Read_Begin() ;
 	pn->selected_connection = NO_CONNECTION ; // Default bus assignment
 
 	return 0 ; // success
@@ -341,68 +381,48 @@ static enum parse_enum set_type( enum ePN_type epntype, struct parsedname * pn )
 // Early parsing -- only bus entries, uncached and text may have preceeded
 static enum parse_enum Parse_Unspecified(char *pathnow, enum parse_pass remote_status, struct parsedname *pn)
 {
-	static regex_t rx_bus ;
-	static regex_t rx_set ;
-	static regex_t rx_sta ;
-	static regex_t rx_str ;
-	static regex_t rx_sys ;
-	static regex_t rx_int ;
-	static regex_t rx_tex ;
-	static regex_t rx_jso ;
-	static regex_t rx_unc ;
-	static regex_t rx_una ;
-	
-	struct ow_regmatch orm ;
-	orm.number = 1 ; // for bus
-	
-	ow_regcomp( &rx_bus, "^bus\\.([[:digit:]]+)/?", REG_ICASE ) ;
-	ow_regcomp( &rx_set, "^settings/?", REG_ICASE | REG_NOSUB ) ;
-	ow_regcomp( &rx_sta, "^statistics/?", REG_ICASE | REG_NOSUB ) ;
-	ow_regcomp( &rx_str, "^structure/?", REG_ICASE | REG_NOSUB ) ;
-	ow_regcomp( &rx_sys, "^system/?", REG_ICASE | REG_NOSUB ) ;
-	ow_regcomp( &rx_int, "^interface/?", REG_ICASE | REG_NOSUB ) ;
-	ow_regcomp( &rx_tex, "^text/?", REG_ICASE | REG_NOSUB ) ;
-	ow_regcomp( &rx_jso, "^json/?", REG_ICASE | REG_NOSUB ) ;
-	ow_regcomp( &rx_unc, "^uncached/?", REG_ICASE | REG_NOSUB ) ;
-	ow_regcomp( &rx_una, "^unaliased/?", REG_ICASE | REG_NOSUB ) ;
-	
-	if ( ow_regexec( &rx_bus, pathnow, &orm ) == 0) {
-		INDEX_OR_ERROR bus_number = (INDEX_OR_ERROR) atoi(orm.match[1]) ;
-		ow_regexec_free( &orm ) ;
-		return Parse_Bus( bus_number, pn);
+	if ( strncasecmp( pathnow, "bus.", 4 ) == 0 && isdigit( (unsigned char) pathnow[4] ) ) {
+		char * digit = &pathnow[4] ;
+		while ( isdigit( (unsigned char) *digit ) ) {
+			++digit ;
+		}
+		if ( *digit != '\0' ) {
+			return parse_error ;
+		}
+		return Parse_Bus( (INDEX_OR_ERROR) atoi( &pathnow[4] ), pn);
 
-	} else if (ow_regexec( &rx_set, pathnow, NULL ) == 0) {
+	} else if ( segment_is( pathnow, "settings" ) ) {
 		return set_type( ePN_settings, pn ) ;
 
-	} else if (ow_regexec( &rx_sta, pathnow, NULL ) == 0) {
+	} else if ( segment_is( pathnow, "statistics" ) ) {
 		return set_type( ePN_statistics, pn ) ;
 
-	} else if (ow_regexec( &rx_str, pathnow, NULL ) == 0) {
+	} else if ( segment_is( pathnow, "structure" ) ) {
 		return set_type( ePN_structure, pn ) ;
 
-	} else if (ow_regexec( &rx_sys, pathnow, NULL ) == 0) {
+	} else if ( segment_is( pathnow, "system" ) ) {
 		return set_type( ePN_system, pn ) ;
 
-	} else if (ow_regexec( &rx_int, pathnow, NULL ) == 0) {
+	} else if ( segment_is( pathnow, "interface" ) ) {
 		if (!SpecifiedBus(pn)) {
 			return parse_error;
 		}
 		pn->type = ePN_interface;
 		return parse_nonreal;
 
-	} else if (ow_regexec( &rx_tex, pathnow, NULL ) == 0) {
+	} else if ( segment_is( pathnow, "text" ) ) {
 		pn->state |= ePS_text;
 		return parse_first;
 
-	} else if (ow_regexec( &rx_jso, pathnow, NULL ) == 0) {
+	} else if ( segment_is( pathnow, "json" ) ) {
 		pn->state |= ePS_json;
 		return parse_first;
 
-	} else if (ow_regexec( &rx_unc, pathnow, NULL ) == 0) {
+	} else if ( segment_is( pathnow, "uncached" ) ) {
 		pn->state |= ePS_uncached;
 		return parse_first;
 
-	} else if (ow_regexec( &rx_una, pathnow, NULL ) == 0) {
+	} else if ( segment_is( pathnow, "unaliased" ) ) {
 		pn->state |= ePS_unaliased;
 		return parse_first;
 
@@ -414,11 +434,7 @@ static enum parse_enum Parse_Unspecified(char *pathnow, enum parse_pass remote_s
 
 static enum parse_enum Parse_Branch(char *pathnow, enum parse_pass remote_status, struct parsedname *pn)
 {
-	static regex_t rx_ala ;
-	
-	ow_regcomp( &rx_ala, "^alarm\?", REG_ICASE | REG_NOSUB ) ;
-	
-	if (ow_regexec( &rx_ala, pathnow, NULL ) == 0) {
+	if ( segment_is( pathnow, "alarm" ) ) {
 		pn->state |= ePS_alarm;
 		pn->type = ePN_real;
 		return parse_real;
@@ -428,41 +444,27 @@ static enum parse_enum Parse_Branch(char *pathnow, enum parse_pass remote_status
 
 static enum parse_enum Parse_Real(char *pathnow, enum parse_pass remote_status, struct parsedname *pn)
 {
-	static regex_t rx_sim ;
-	static regex_t rx_the ;
-	static regex_t rx_tex ;
-	static regex_t rx_jso ;
-	static regex_t rx_unc ;
-	static regex_t rx_una ;
-	
-	ow_regcomp( &rx_sim, "^simultaneous/?", REG_ICASE | REG_NOSUB ) ;
-	ow_regcomp( &rx_the, "^thermostat/?", REG_ICASE | REG_NOSUB ) ;
-	ow_regcomp( &rx_tex, "^text/?", REG_ICASE | REG_NOSUB ) ;
-	ow_regcomp( &rx_jso, "^json/?", REG_ICASE | REG_NOSUB ) ;
-	ow_regcomp( &rx_unc, "^uncached/?", REG_ICASE | REG_NOSUB ) ;
-	ow_regcomp( &rx_una, "^unaliased/?", REG_ICASE | REG_NOSUB ) ;
-	
-	if (ow_regexec( &rx_sim, pathnow, NULL ) == 0) {
+	if ( segment_is( pathnow, "simultaneous" ) ) {
 		pn->selected_device = DeviceSimultaneous;
 		return parse_prop;
 
-	} else if (ow_regexec( &rx_tex, pathnow, NULL ) == 0) {
+	} else if ( segment_is( pathnow, "text" ) ) {
 		pn->state |= ePS_text;
 		return parse_real;
 
-	} else if (ow_regexec( &rx_jso, pathnow, NULL ) == 0) {
+	} else if ( segment_is( pathnow, "json" ) ) {
 		pn->state |= ePS_json;
 		return parse_real;
 
-	} else if (ow_regexec( &rx_the, pathnow, NULL ) == 0) {
+	} else if ( segment_is( pathnow, "thermostat" ) ) {
 		pn->selected_device = DeviceThermostat;
 		return parse_prop;
 
-	} else if (ow_regexec( &rx_unc, pathnow, NULL ) == 0) {
+	} else if ( segment_is( pathnow, "uncached" ) ) {
 		pn->state |= ePS_uncached;
 		return parse_real;
 
-	} else if (ow_regexec( &rx_una, pathnow, NULL ) == 0) {
+	} else if ( segment_is( pathnow, "unaliased" ) ) {
 		pn->state |= ePS_unaliased;
 		return parse_real;
 
@@ -473,29 +475,19 @@ static enum parse_enum Parse_Real(char *pathnow, enum parse_pass remote_status,
 
 static enum parse_enum Parse_NonReal(char *pathnow, struct parsedname *pn)
 {
-	static regex_t rx_tex ;
-	static regex_t rx_jso ;
-	static regex_t rx_unc ;
-	static regex_t rx_una ;
-	
-	ow_regcomp( &rx_tex, "^text/?", REG_ICASE | REG_NOSUB ) ;
-	ow_regcomp( &rx_jso, "^json/?", REG_ICASE | REG_NOSUB ) ;
-	ow_regcomp( &rx_unc, "^uncached/?", REG_ICASE | REG_NOSUB ) ;
-	ow_regcomp( &rx_una, "^unaliased/?", REG_ICASE | REG_NOSUB ) ;
-
-	if (ow_regexec( &rx_tex, pathnow, NULL )  == 0) {
+	if ( segment_is( pathnow, "text" ) ) {
 		pn->state |= ePS_text;
 		return parse_nonreal;
 
-	} else if (ow_regexec( &rx_jso, pathnow, NULL )  == 0) {
+	} else if ( segment_is( pathnow, "json" ) ) {
 		pn->state |= ePS_json;
 		return parse_nonreal;
 
-	} else if (ow_regexec( &rx_unc, pathnow, NULL )  == 0) {
+	} else if ( segment_is( pathnow, "uncached" ) ) {
 		pn->state |= ePS_uncached;
 		return parse_nonreal;
 
-	} else if (ow_regexec( &rx_una, pathnow, NULL )  == 0) {
+	} else if ( segment_is( pathnow, "unaliased" ) ) {
 		pn->state |= ePS_unaliased;
 		return parse_nonreal;
 
@@ -509,12 +501,6 @@ static enum parse_enum Parse_NonReal(char *pathnow, struct parsedname *pn)
 /* We've reached a /bus.n entry */
 static enum parse_enum Parse_Bus( INDEX_OR_ERROR bus_number, struct parsedname *pn)
 {
-	static regex_t rx_p_bus ;
-	struct ow_regmatch orm ;
-	
-	ow_regcomp( &rx_p_bus, "^/bus\\.[[:digit:]]+/?", REG_ICASE ) ;
-	orm.number = 0 ;
-
 	/* Processing for bus.X directories -- eventually will make this more generic */
 	if ( INDEX_NOT_VALID(bus_number) ) {
 		return parse_error;
@@ -545,15 +531,48 @@ static enum parse_enum Parse_Bus( INDEX_OR_ERROR bus_number, struct parsedname *
 	}
 
 	/* Create the path without the "bus.x" part in pn->path_to_server */
-	if ( ow_regexec( &rx_p_bus, pn->path, &orm ) == 0 ) {
-		strcpy( pn->path_to_server, orm.pre[0] ) ;
-		strcat( pn->path_to_server, "/" ) ;
-		strcat( pn->path_to_server, orm.post[0] ) ;
-		ow_regexec_free( &orm ) ;
+	/* only when the path starts with it */
+	if ( strncasecmp( pn->path, "/bus.", 5 ) == 0 && isdigit( (unsigned char) pn->path[5] ) ) {
+		const char * post_bus = &pn->path[5] ;
+		while ( isdigit( (unsigned char) *post_bus ) ) {
+			++post_bus ;
+		}
+		if ( *post_bus == '/' ) {
+			++post_bus ;
+		}
+		if ( BAD( Path_To_Server_Own( pn ) ) ) {
+			return parse_error ;
+		}
+		strcpy( pn->path_to_server, "/" ) ;
+		strcat( pn->path_to_server, post_bus ) ;
 	}
 	return parse_first;
 }
 
+/* path_to_server is about to differ from path -- give it its own copy */
+static GOOD_OR_BAD Path_To_Server_Own( struct parsedname * pn )
+{
+	char * path_to_server ;
+
+	if ( pn->path_to_server != pn->path ) {
+		// already
+		return gbGOOD ;
+	}
+	path_to_server = owmalloc( PATH_MAX+2 ) ;
+	if ( path_to_server == NULL ) {
+		return gbBAD ;
+	}
+	strcpy( path_to_server, pn->path ) ;
+	pn->path_to_server = path_to_server ;
+	return gbGOOD ;
+}
+
+// exact (case insensitive) match of a path segment to a directory name
+static int segment_is( const char * segment, const char * name )
+{
+	return strcasecmp( segment, name ) == 0 ;
+}
+
 // search path for this exact matching path segment
 static char * find_segment_in_path( char * segment, char * path )
 {
@@ -586,7 +605,7 @@ static void ReplaceAliasInPath( char * filename, struct parsedname * pn)
 	int alias_len = strlen(filename) ;
 	
 	// check total length
-	if ( strlen(pn->path_to_server) + 14 - alias_len <= PATH_MAX ) {
+	if ( strlen(pn->path_to_server) + 14 - alias_len <= PATH_MAX && GOOD( Path_To_Server_Own( pn ) ) ) {
 		// find the alias
 		char * alias_loc = find_segment_in_path( filename, pn->path_to_server ) ;
 		
@@ -686,6 +705,12 @@ static enum parse_enum Parse_RealDeviceSN(enum parse_pass remote_status, struct
 	/* Search for known 1-wire device -- keyed to device name (family code in HEX) */
 	pn->selected_device = FS_devicefindhex(pn->sn[0], pn);
 
+	return Parse_Presence( remote_status, pn ) ;
+}
+
+/* Find the bus for a device known by serial number */
+static enum parse_enum Parse_Presence(enum parse_pass remote_status, struct parsedname *pn)
+{
 	// returning from owserver -- don't need to check presence (it's implied)
 	if (remote_status == parse_pass_post_remote) {
 		return parse_prop;
@@ -730,22 +755,9 @@ static enum parse_enum Parse_Property(char *filename, struct parsedname *pn)
 {
 	struct device * pdev = pn->selected_device ;
 	struct filetype * ft ;
-	
-	static regex_t rx_extension ;
-	static regex_t rx_all ;
-	static regex_t rx_byte ;
-	static regex_t rx_number ;
-	static regex_t rx_letter ;
+	char * dot = strchr( filename, '.' ) ; // first dot separates name and extension
+	char * last_dot = strrchr( filename, '.' ) ;
 	int extension_given ;
-
-	struct ow_regmatch orm ;
-	orm.number = 0 ;
-	
-	ow_regcomp( &rx_extension, "\\.", 0 ) ; 
-	ow_regcomp( &rx_all, "\\.all$", REG_ICASE ) ; 
-	ow_regcomp( &rx_byte, "\\.byte$", REG_ICASE ) ; 
-	ow_regcomp( &rx_number, "\\.[[:digit:]]+$", 0 ) ; 
-	ow_regcomp( &rx_letter, "\\.[[:alpha:]]$", REG_ICASE ) ; 
 	
 	//printf("FilePart: %s %s\n", filename, pn->path);
 
@@ -756,14 +768,14 @@ static enum parse_enum Parse_Property(char *filename, struct parsedname *pn)
 	}
 
 	// separate filename.dot
-//	filename = strsep(&dot, ".");
-	if ( ow_regexec( &rx_extension, filename, &orm ) == 0 ) {
+	if ( dot != NULL ) {
 		// extension given
 		extension_given = 1 ;
+		dot[0] = '\0' ;
 		ft =
-			 bsearch(orm.pre[0], pdev->filetype_array,
+			 bsearch(filename, pdev->filetype_array,
 					 (size_t) pdev->count_of_filetypes, sizeof(struct filetype), filetype_cmp) ;
-		ow_regexec_free( &orm ) ;
+		dot[0] = '.' ;
 	} else {
 		// no extension given
 		extension_given = 0 ;
@@ -794,14 +806,11 @@ static enum parse_enum Parse_Property(char *filename, struct parsedname *pn)
 	} else if (ft->ag->combined==ag_sparse)  { /* Sparse */
 		if (ft->ag->letters == ag_letters) {	/* text string */
 			pn->extension = 0;	/* text extension, not number */
-			ow_regexec( &rx_extension, filename, &orm ) ; // don't need to test -- already succesful
-			pn->sparse_name = owstrdup(orm.post[0]) ;
-			ow_regexec_free( &orm ) ;
+			pn->sparse_name = owstrdup( &dot[1] ) ;
 			LEVEL_DEBUG("Sparse alpha extension found: <%s>",pn->sparse_name);
 		} else {			/* Numbers */
-			if ( ow_regexec( &rx_number, filename, &orm ) == 0 ) { 
-				pn->extension = atoi( &orm.match[0][1] );	/* Number conversion */
-				ow_regexec_free( &orm ) ;
+			if ( Parse_Extension_Number( last_dot ) ) { 
+				pn->extension = atoi( &last_dot[1] );	/* Number conversion */
 				LEVEL_DEBUG("Sparse numeric extension found: <%ld>",(long int) pn->extension);
 			} else {
 				LEVEL_DEBUG("Non numeric extension for %s",filename ) ;
@@ -810,12 +819,12 @@ static enum parse_enum Parse_Property(char *filename, struct parsedname *pn)
 		}
 
 	// Non-sparse "ALL"
-	} else if (ow_regexec( &rx_all, filename, NULL ) == 0) {
+	} else if ( strcasecmp( last_dot, ".all" ) == 0 ) {
 		//printf("FP ALL\n");
 		pn->extension = EXTENSION_ALL;	/* ALL */
 	
 	// Non-sparse "BYTE"
-	} else if (ft->format == ft_bitfield && ow_regexec( &rx_byte, filename, NULL) == 0) {
+	} else if (ft->format == ft_bitfield && strcasecmp( last_dot, ".byte" ) == 0 ) {
 		pn->extension = EXTENSION_BYTE;	/* BYTE */
 		//printf("FP BYTE\n") ;
 
@@ -823,16 +832,14 @@ static enum parse_enum Parse_Property(char *filename, struct parsedname *pn)
 	} else {				/* specific extension */
 		if (ft->ag->letters == ag_letters) {	/* Letters */
 			//printf("FP letters\n") ;
-			if ( ow_regexec( &rx_letter, filename, &orm ) == 0 ) {
-				pn->extension = toupper(orm.match[0][1]) - 'A';	/* Letter extension */
-				ow_regexec_free( &orm ) ;
+			if ( isalpha( (unsigned char) last_dot[1] ) && last_dot[2] == '\0' ) {
+				pn->extension = toupper( (unsigned char) last_dot[1] ) - 'A';	/* Letter extension */
 			} else {
 				return parse_error;
 			}
 		} else {			/* Numbers */
-			if ( ow_regexec( &rx_number, filename, &orm ) == 0 ) { 
-				pn->extension = atoi( &orm.match[0][1] );	/* Number conversion */
-				ow_regexec_free( &orm ) ;
+			if ( Parse_Extension_Number( last_dot ) ) { 
+				pn->extension = atoi( &last_dot[1] );	/* Number conversion */
 			} else {
 				return parse_error;
 			}
@@ -860,11 +867,7 @@ static enum parse_enum Parse_Property(char *filename, struct parsedname *pn)
 			return parse_error;
 		}
 		/* STATISTICS */
-		STATLOCK;
-		if (pn->ds2409_depth > dir_depth) {
-			dir_depth = pn->ds2409_depth;
-		}
-		STATUNLOCK;
+		StatMax( &dir_depth, pn->ds2409_depth ) ;
 		return parse_branch;
 	case ft_subdir:
 		//printf("PN %s is a subdirectory\n", filename);
@@ -876,6 +879,22 @@ static enum parse_enum Parse_Property(char *filename, struct parsedname *pn)
 	}
 }
 
+// extension is all digits: .0 .12
+static int Parse_Extension_Number( const char * last_dot )
+{
+	const char * digit = &last_dot[1] ;
+
+	if ( *digit == '\0' ) {
+		return 0 ;
+	}
+	for ( ; *digit != '\0' ; ++digit ) {
+		if ( ! isdigit( (unsigned char) *digit ) ) {
+			return 0 ;
+		}
+	}
+	return 1 ;
+}
+
 static ZERO_OR_ERROR BranchAdd(struct parsedname *pn)
 {
 	//printf("BRANCHADD\n");
@@ -964,3 +983,256 @@ void FS_ParsedName_Placeholder( struct parsedname * pn )
 {
 	FS_ParsedName( NULL, pn ) ; // minimal parsename -- no destroy needed
 }
+
+/* ---------------------------------------------- */
+/* Parsed path cache                              */
+/* ---------------------------------------------- */
+/* Most traffic is repeated reads of the same device properties.
+ * Remember how those paths parsed (device, property, extension)
+ * Only paths of a device given by serial number, without explicit bus,
+ * branch, alias or sparse extension are kept -- the presence check
+ * (which finds the bus) is still done every time.
+ * Least recently used entries (of the shard) are dropped when full.
+ * */
+
+#define PARSE_CACHE_SIZE     256
+#define PARSE_CACHE_BUCKETS  512
+#define PARSE_CACHE_SHARD_BITS	4
+#define PARSE_CACHE_SHARDS	(1<<PARSE_CACHE_SHARD_BITS)
+
+struct parse_cache_entry {
+	struct parse_cache_entry * next_in_bucket ;
+	struct parse_cache_entry * newer ; // LRU list
+	struct parse_cache_entry * older ;
+	unsigned int hash ;
+	enum ePS_state state ; // from the path (text, uncached, alarm...)
+	BYTE sn[SERIAL_NUMBER_SIZE] ;
+	struct device * selected_device ;
+	struct filetype * selected_filetype ;
+	struct filetype * subdir ;
+	int extension ;
+	int dirlength ;
+	int device_offset ; // device_name position in path
+	char path[] ; // key, allocated with the entry
+} ;
+
+/* Split like the value cache (ow_cache.c) -- shard chosen by a hash of the path,
+ * each with its own lock and LRU list, so parses of unrelated paths don't contend */
+struct parse_cache_shard {
+	pthread_mutex_t mutex ;
+	struct parse_cache_entry * bucket[PARSE_CACHE_BUCKETS/PARSE_CACHE_SHARDS] ;
+	struct parse_cache_entry * newest ;
+	struct parse_cache_entry * oldest ;
+	int count ;
+} ;
+static struct parse_cache_shard parse_cache_shard[PARSE_CACHE_SHARDS] ;
+
+#define PARSECACHELOCK(shard)     _MUTEX_LOCK(   (shard)->mutex )
+#define PARSECACHEUNLOCK(shard)   _MUTEX_UNLOCK( (shard)->mutex )
+
+static unsigned int Parse_Cache_Hash( const char * path )
+{
+	unsigned int hash = 5381 ;
+	for ( ; *path != '\0' ; ++path ) {
+		hash = ( hash * 33 ) ^ (unsigned char) *path ;
+	}
+	return hash ;
+}
+
+/* low bits pick the shard, the rest pick the bucket */
+static struct parse_cache_shard * Parse_Cache_Shard( unsigned int hash )
+{
+	return &parse_cache_shard[ hash & (PARSE_CACHE_SHARDS-1) ] ;
+}
+
+static struct parse_cache_entry ** Parse_Cache_Bucket( struct parse_cache_shard * shard, unsigned int hash )
+{
+	return &(shard->bucket[ (hash >> PARSE_CACHE_SHARD_BITS) % (PARSE_CACHE_BUCKETS/PARSE_CACHE_SHARDS) ]) ;
+}
+
+// called with shard lock held
+static struct parse_cache_entry * Parse_Cache_Find( struct parse_cache_shard * shard, unsigned int hash, const char * path )
+{
+	struct parse_cache_entry * pce ;
+	for ( pce = *Parse_Cache_Bucket( shard, hash ) ; pce != NULL ; pce = pce->next_in_bucket ) {
+		if ( pce->hash == hash && strcmp( pce->path, path ) == 0 ) {
+			return pce ;
+		}
+	}
+	return NULL ;
+}
+
+// called with shard lock held
+static void Parse_Cache_Unlink( struct parse_cache_shard * shard, struct parse_cache_entry * pce )
+{
+	if ( pce->newer != NULL ) {
+		pce->newer->older = pce->older ;
+	} else {
+		shard->newest = pce->older ;
+	}
+	if ( pce->older != NULL ) {
+		pce->older->newer = pce->newer ;
+	} else {
+		shard->oldest = pce->newer ;
+	}
+	pce->newer = pce->older = NULL ;
+}
+
+// called with shard lock held
+static void Parse_Cache_Link( struct parse_cache_shard * shard, struct parse_cache_entry * pce )
+{
+	pce->older = shard->newest ;
+	pce->newer = NULL ;
+	if ( shard->newest != NULL ) {
+		shard->newest->newer = pce ;
+	} else {
+		shard->oldest = pce ;
+	}
+	shard->newest = pce ;
+}
+
+// called with shard lock held
+static void Parse_Cache_Remove( struct parse_cache_shard * shard, struct parse_cache_entry * pce )
+{
+	struct parse_cache_entry ** bucket = Parse_Cache_Bucket( shard, pce->hash ) ;
+	for ( ; *bucket != NULL ; bucket = &((*bucket)->next_in_bucket) ) {
+		if ( *bucket == pce ) {
+			*bucket = pce->next_in_bucket ;
+			break ;
+		}
+	}
+	Parse_Cache_Unlink( shard, pce ) ;
+	--shard->count ;
+	owfree( pce ) ;
+}
+
+/* Fill in pn from the cache (pn->path already set up) */
+static GOOD_OR_BAD Parse_Cache_Get( struct parsedname * pn )
+{
+	unsigned int hash = Parse_Cache_Hash( pn->path ) ;
+	struct parse_cache_shard * shard = Parse_Cache_Shard( hash ) ;
+	struct parse_cache_entry * pce ;
+
+	PARSECACHELOCK( shard ) ;
+	pce = Parse_Cache_Find( shard, hash, pn->path ) ;
+	if ( pce == NULL ) {
+		PARSECACHEUNLOCK( shard ) ;
+		return gbBAD ;
+	}
+	// most recently used (of its shard)
+	Parse_Cache_Unlink( shard, pce ) ;
+	Parse_Cache_Link( shard, pce ) ;
+
+	pn->type = ePN_real ;
+	pn->state |= pce->state ;
+	memcpy( pn->sn, pce->sn, SERIAL_NUMBER_SIZE ) ;
+	pn->selected_device = pce->selected_device ;
+	pn->selected_filetype = pce->selected_filetype ;
+	pn->subdir = pce->subdir ;
+	pn->extension = pce->extension ;
+	pn->dirlength = pce->dirlength ;
+	pn->device_name = &(pn->path[pce->device_offset]) ;
+	PARSECACHEUNLOCK( shard ) ;
+
+	STAT_ADD1( parse_cache_hits ) ;
+	return gbGOOD ;
+}
+
+/* Remember a successful parse if it is a simple device property */
+static void Parse_Cache_Add( int dirlength, const struct parsedname * pn )
+{
+	unsigned int hash ;
+	struct parse_cache_shard * shard ;
+	struct parse_cache_entry ** bucket ;
+	size_t path_length ;
+	struct parse_cache_entry * pce ;
+	char device[OW_FULLNAME_MAX] ;
+	char * slash ;
+	BYTE sn[SERIAL_NUMBER_SIZE] ;
+
+	if ( pn->type != ePN_real
+		|| ( pn->state & ( ePS_buslocal | ePS_busremote | ePS_busveryremote ) )
+		|| pn->selected_filetype == NO_FILETYPE
+		|| pn->device_name == NULL
+		|| pn->ds2409_depth > 0
+		|| pn->sparse_name != NULL
+		|| dirlength < 0 ) {
+		return ;
+	}
+
+	// device by serial number, not alias or external
+	strncpy( device, pn->device_name, OW_FULLNAME_MAX-1 ) ;
+	device[OW_FULLNAME_MAX-1] = '\0' ;
+	slash = strchr( device, '/' ) ;
+	if ( slash != NULL ) {
+		slash[0] = '\0' ;
+	}
+	if ( Parse_SerialNumber( device, sn ) != sn_valid ) {
+		return ;
+	}
+
+	path_length = strlen( pn->path ) ;
+	pce = owmalloc( sizeof(struct parse_cache_entry) + path_length + 1 ) ;
+	if ( pce == NULL ) {
+		return ;
+	}
+	hash = Parse_Cache_Hash( pn->path ) ;
+	pce->hash = hash ;
+	pce->state = pn->state & ( ePS_uncached | ePS_alarm | ePS_text | ePS_unaliased | ePS_json ) ;
+	memcpy( pce->sn, pn->sn, SERIAL_NUMBER_SIZE ) ;
+	pce->selected_device = pn->selected_device ;
+	pce->selected_filetype = pn->selected_filetype ;
+	pce->subdir = pn->subdir ;
+	pce->extension = pn->extension ;
+	pce->dirlength = dirlength ;
+	pce->device_offset = pn->device_name - pn->path ;
+	memcpy( pce->path, pn->path, path_length + 1 ) ;
+
+	shard = Parse_Cache_Shard( hash ) ;
+	PARSECACHELOCK( shard ) ;
+	if ( Parse_Cache_Find( shard, hash, pn->path ) != NULL ) {
+		// another thread added it
+		PARSECACHEUNLOCK( shard ) ;
+		owfree( pce ) ;
+		return ;
+	}
+	if ( shard->count >= PARSE_CACHE_SIZE / PARSE_CACHE_SHARDS ) {
+		Parse_Cache_Remove( shard, shard->oldest ) ;
+	}
+	bucket = Parse_Cache_Bucket( shard, hash ) ;
+	pce->next_in_bucket = *bucket ;
+	*bucket = pce ;
+	Parse_Cache_Link( shard, pce ) ;
+	++shard->count ;
+	PARSECACHEUNLOCK( shard ) ;
+}
+
+/* Set up the empty shards (LibSetup) */
+/* Note: done in single-threaded mode so locking not yet needed */
+void Parse_Cache_Open( void )
+{
+	int shard_index ;
+
+	for ( shard_index = 0 ; shard_index < PARSE_CACHE_SHARDS ; ++shard_index ) {
+		struct parse_cache_shard * shard = &parse_cache_shard[shard_index] ;
+		memset( shard->bucket, 0, sizeof(shard->bucket) ) ;
+		shard->newest = shard->oldest = NULL ;
+		shard->count = 0 ;
+		_MUTEX_INIT( shard->mutex ) ;
+	}
+}
+
+/* Empty the parsed path cache (library restart) */
+void Parse_Cache_Clear( void )
+{
+	int shard_index ;
+
+	for ( shard_index = 0 ; shard_index < PARSE_CACHE_SHARDS ; ++shard_index ) {
+		struct parse_cache_shard * shard = &parse_cache_shard[shard_index] ;
+		PARSECACHELOCK( shard ) ;
+		while ( shard->oldest != NULL ) {
+			Parse_Cache_Remove( shard, shard->oldest ) ;
+		}
+		PARSECACHEUNLOCK( shard ) ;
+	}
+}
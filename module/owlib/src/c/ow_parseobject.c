@@ -251,7 +251,7 @@ void OWQ_assign_write_buffer(const char *buffer, size_t size, off_t offset, stru
 GOOD_OR_BAD OWQ_allocate_read_buffer(struct one_wire_query * owq )
 {
 	struct parsedname * pn = PN(owq) ;
-	size_t size = FullFileLength(pn);
+	size_t size = ReadLength(pn);
 
 	if ( size > 0 ) {
 		char * buffer = owmalloc(size+1) ;
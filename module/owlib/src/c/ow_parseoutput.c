@@ -28,6 +28,8 @@ static SIZE_OR_ERROR OWQ_parse_output_array_no_commas(struct one_wire_query *owq
 static SIZE_OR_ERROR OWQ_parse_output_ascii_array(struct one_wire_query *owq);
 static SIZE_OR_ERROR OWQ_parse_output_offset_and_size_z(const char *string, struct one_wire_query *owq) ;
 static SIZE_OR_ERROR OWQ_parse_output_offset_and_size(const char *string, size_t length, struct one_wire_query *owq) ;
+static _FLOAT OWQ_value_float(_FLOAT F, const struct parsedname *pn);
+static void OWQ_value_put(BYTE * buffer, uint64_t bits);
 
 /*
 Change in strategy 6/2006:
@@ -46,6 +48,11 @@ Can break down cases into:
 
 SIZE_OR_ERROR OWQ_parse_output(struct one_wire_query *owq)
 {
+	// numbers as they are, no text (numeric properties only)
+	if (WantValueBinary(PN(owq)) && ValueBinaryType(PN(owq)) != value_binary_none) {
+		return OWQ_value_output(owq);
+	}
+
 	// have to check if offset is beyond the filesize.
 	if (OWQ_offset(owq)) {
 		size_t file_length = 0;
@@ -201,6 +208,86 @@ static SIZE_OR_ERROR OWQ_parse_output_yesno(struct one_wire_query *owq)
 	return ShouldTrim(PN(owq))? 1 : PROPERTY_LENGTH_YESNO;
 }
 
+/* Binary value form of a numeric property (see ow_onewirequery.h)
+   Taken straight from the value_object, nothing printed or parsed */
+SIZE_OR_ERROR OWQ_value_output(struct one_wire_query *owq)
+{
+	struct parsedname *pn = PN(owq);
+	enum value_binary_type type = ValueBinaryType(pn);
+	union value_object *value = &OWQ_val(owq);
+	BYTE *buffer = (BYTE *) OWQ_buffer(owq);
+	size_t elements = 1;
+	size_t element;
+
+	if (type == value_binary_none) {
+		return -EINVAL;
+	}
+	if (OWQ_offset(owq) != 0) {
+		return 0;				// sent whole, nothing past the start
+	}
+	if (pn->extension == EXTENSION_ALL) {
+		elements = pn->selected_filetype->ag->elements;
+		value = OWQ_array(owq);
+	}
+	if (OWQ_size(owq) < 1 + VALUE_BINARY_ELEMENT * elements) {
+		return -EMSGSIZE;
+	}
+
+	buffer[0] = type;
+	for (element = 0; element < elements; ++element) {
+		uint64_t bits = 0;
+		switch (type) {
+		case value_binary_float: {
+				double F = OWQ_value_float(value[element].F, pn);
+				memcpy(&bits, &F, sizeof(bits));
+			}
+			break;
+		case value_binary_integer:
+			bits = (uint64_t) (int64_t) value[element].I;
+			break;
+		case value_binary_unsigned:
+			bits = value[element].U;
+			break;
+		case value_binary_yesno:
+			bits = value[element].Y & 0x1;
+			break;
+		case value_binary_date:
+			bits = (uint64_t) (int64_t) value[element].D;
+			break;
+		case value_binary_none:
+			break;
+		}
+		OWQ_value_put(&buffer[1 + VALUE_BINARY_ELEMENT * element], bits);
+	}
+	return 1 + VALUE_BINARY_ELEMENT * elements;
+}
+
+/* Same scale as the text output */
+static _FLOAT OWQ_value_float(_FLOAT F, const struct parsedname *pn)
+{
+	switch (pn->selected_filetype->format) {
+	case ft_pressure:
+		return Pressure(F, pn);
+	case ft_temperature:
+		return Temperature(F, pn);
+	case ft_tempgap:
+		return TemperatureGap(F, pn);
+	default:
+		return F;
+	}
+}
+
+/* most significant byte first */
+static void OWQ_value_put(BYTE * buffer, uint64_t bits)
+{
+	int i;
+
+	for (i = VALUE_BINARY_ELEMENT - 1; i >= 0; --i) {
+		buffer[i] = bits & 0xFF;
+		bits >>= 8;
+	}
+}
+
 ZERO_OR_ERROR OWQ_format_output_offset_and_size_z(const char *string, struct one_wire_query *owq)
 {
 	SIZE_OR_ERROR ret = OWQ_parse_output_offset_and_size_z(string,owq) ;
@@ -0,0 +1,474 @@
+/*
+    OWFS -- One-Wire filesystem
+    OWHTTPD -- One-Wire Web Server
+    Written 2003 Paul H Alfille
+    email: paul.alfille@gmail.com
+    Released under the GPL
+    See the header file: ow.h for full attribution
+    1wire/iButton system from Dallas Semiconductor
+*/
+
+/* Background poller
+ * Keeps chosen properties fresh in the cache so client reads are cache hits
+ * --poll device_glob/property[:seconds]  (may be repeated)
+ *   e.g. --poll 10.67C6697351FF/temperature:10
+ *   the device part is a shell glob (like "28.*") on the device name
+ * One thread per local bus master (stopped and joined by LibStop). Each round:
+ *   list the devices on the bus
+ *   start a simultaneous conversion if temperatures (or voltages) are wanted
+ *   read all matching properties together (FS_read_many) which refreshes the cache
+ * */
+
+#include <config.h>
+#include "owfs_config.h"
+#include "ow.h"
+#include "ow_connection.h"
+#include <fnmatch.h>
+
+struct poll_entry {
+	struct poll_entry * next ;
+	char * device ;		// glob matched against the device name
+	char * property ;	// property path below the device
+	int interval ;		// seconds, 0 for half of timeout_volatile
+} ;
+
+// set up while parsing options, then only read (kept for the life of the program)
+static struct poll_entry * poll_head = NULL ;
+
+// one per polled bus, joined by Poll_Stop (or once it has ended on its own)
+struct poll_thread {
+	struct poll_thread * next ;
+	pthread_t thread ;
+	INDEX_OR_ERROR bus ;
+	UINT instance ; // the bus number can be reused by a later bus
+	int done ;
+} ;
+
+static struct {
+	pthread_mutex_t mutex ;
+	pthread_cond_t cond ; // signalled to stop
+	int stop ;
+	int started ; // set by Poll_Start, buses added before that wait for it
+	struct poll_thread * head ;
+} Poll = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, 0, NULL, } ;
+
+struct poll_round {
+	INDEX_OR_ERROR bus ;
+	UINT instance ;
+	struct poll_entry ** due ;
+	int due_count ;
+	char ** paths ;
+	int path_count ;
+	int path_allocated ;
+} ;
+
+static void * Poll_Thread( void * v ) ;
+static int Poll_Sleep( void ) ;
+static GOOD_OR_BAD Poll_Round( struct poll_round * pr ) ;
+static void Poll_Device( void * v, const struct parsedname * pn_device ) ;
+static void Poll_Add_Path( struct poll_round * pr, const char * device, const char * property ) ;
+static int Poll_Interval( const struct poll_entry * pe ) ;
+
+/* Parse one --poll argument */
+GOOD_OR_BAD Poll_Add( const char * arg )
+{
+	struct poll_entry * pe ;
+	char * spec ;
+	char * slash ;
+	char * colon ;
+
+	if ( arg == NULL ) {
+		return gbBAD ;
+	}
+	while ( arg[0] == '/' ) {
+		++arg ;
+	}
+	spec = owstrdup( arg ) ;
+	if ( spec == NULL ) {
+		return gbBAD ;
+	}
+
+	pe = owcalloc( 1, sizeof( struct poll_entry ) ) ;
+	if ( pe == NULL ) {
+		owfree( spec ) ;
+		return gbBAD ;
+	}
+
+	colon = strrchr( spec, ':' ) ;
+	if ( colon != NULL ) {
+		char * end ;
+		long int seconds ;
+		colon[0] = '\0' ;
+		seconds = strtol( &colon[1], &end, 10 ) ;
+		if ( end == &colon[1] || end[0] != '\0' || seconds < 1 ) {
+			LEVEL_DEFAULT("Poll interval in %s should be a number of seconds", arg ) ;
+			owfree( spec ) ;
+			owfree( pe ) ;
+			return gbBAD ;
+		}
+		pe->interval = (int) seconds ;
+	}
+
+	slash = strchr( spec, '/' ) ;
+	if ( slash == NULL || slash == spec || slash[1] == '\0' ) {
+		LEVEL_DEFAULT("Poll %s should look like device/property, e.g. 28.*/temperature", arg ) ;
+		owfree( spec ) ;
+		owfree( pe ) ;
+		return gbBAD ;
+	}
+	slash[0] = '\0' ;
+	pe->device = spec ;
+	pe->property = &slash[1] ;
+
+	LEVEL_DEBUG("Poll devices %s property %s every %d seconds", pe->device, pe->property, Poll_Interval(pe) ) ;
+	pe->next = poll_head ;
+	poll_head = pe ;
+	return gbGOOD ;
+}
+
+/* Start a poller thread for each local bus master
+ * Called from LibStartThreads, after any fork into the background */
+void Poll_Start( void )
+{
+	struct port_in * pin ;
+	int reader ;
+
+	if ( poll_head == NULL ) {
+		return ;
+	}
+
+	_MUTEX_LOCK( Poll.mutex ) ;
+	Poll.started = 1 ;
+	_MUTEX_UNLOCK( Poll.mutex ) ;
+
+	reader = Connection_Read_Begin() ;
+	for ( pin = Inbound_Control.head_port ; pin != NULL ; pin = pin->next ) {
+		struct connection_in * in ;
+		for ( in = pin->first ; in != NO_CONNECTION ; in = in->next ) {
+			Poll_Start_Bus( in ) ;
+		}
+	}
+	Connection_Read_End( reader ) ;
+}
+
+/* Start the poller thread for one bus (at start up, or added later)
+ * Called with the bus list read-locked (or by the thread adding it) */
+void Poll_Start_Bus( struct connection_in * in )
+{
+	struct poll_thread ** ppt ;
+	struct poll_thread * pt ;
+
+	if ( poll_head == NULL || in == NO_CONNECTION ) {
+		return ;
+	}
+	switch ( in->Adapter ) {
+		case adapter_fake:
+		case adapter_tester:
+		case adapter_mock:
+		case adapter_w1_monitor:
+		case adapter_browse_monitor:
+		case adapter_usb_monitor:
+			// simulated values aren't cached, monitors have no devices
+			return ;
+		default:
+			break ;
+	}
+	if ( BusIsServer( in ) ) {
+		// let the remote owserver do its own polling
+		return ;
+	}
+
+	_MUTEX_LOCK( Poll.mutex ) ;
+	if ( ! Poll.started ) {
+		// Poll_Start will find it
+		_MUTEX_UNLOCK( Poll.mutex ) ;
+		return ;
+	}
+	ppt = &(Poll.head) ;
+	while ( (pt = *ppt) != NULL ) {
+		if ( pt->done ) {
+			// ended on its own (bus removed) -- reap it
+			*ppt = pt->next ;
+			pthread_join( pt->thread, NULL ) ;
+			owfree( pt ) ;
+			continue ;
+		}
+		if ( pt->instance == in->instance ) {
+			// already polled
+			_MUTEX_UNLOCK( Poll.mutex ) ;
+			return ;
+		}
+		ppt = &(pt->next) ;
+	}
+
+	pt = owcalloc( 1, sizeof(struct poll_thread) ) ;
+	if ( pt == NULL ) {
+		_MUTEX_UNLOCK( Poll.mutex ) ;
+		return ;
+	}
+	pt->bus = in->index ;
+	pt->instance = in->instance ;
+	if ( pthread_create( &(pt->thread), DEFAULT_THREAD_ATTR, Poll_Thread, pt ) != 0 ) {
+		ERROR_DEBUG("Cannot start poller for bus.%d", (int) in->index ) ;
+		owfree( pt ) ;
+	} else {
+		LEVEL_DEBUG("Poller started for bus.%d", (int) in->index ) ;
+		pt->next = Poll.head ;
+		Poll.head = pt ;
+	}
+	_MUTEX_UNLOCK( Poll.mutex ) ;
+}
+
+/* Stop the poller threads and wait for them
+ * Called from LibStop before the buses are closed */
+void Poll_Stop( void )
+{
+	struct poll_thread * pt ;
+
+	_MUTEX_LOCK( Poll.mutex ) ;
+	Poll.stop = 1 ;
+	Poll.started = 0 ;
+	my_pthread_cond_broadcast( &(Poll.cond) ) ;
+	pt = Poll.head ;
+	Poll.head = NULL ;
+	_MUTEX_UNLOCK( Poll.mutex ) ;
+
+	while ( pt != NULL ) {
+		struct poll_thread * next = pt->next ;
+		pthread_join( pt->thread, NULL ) ;
+		owfree( pt ) ;
+		pt = next ;
+	}
+
+	// ready for another LibStart
+	_MUTEX_LOCK( Poll.mutex ) ;
+	Poll.stop = 0 ;
+	_MUTEX_UNLOCK( Poll.mutex ) ;
+}
+
+/* Wait a second between checks, returns non-zero once told to stop */
+static int Poll_Sleep( void )
+{
+	struct timeval now ;
+	struct timespec deadline ;
+	int stop ;
+
+	gettimeofday( &now, NULL ) ;
+	deadline.tv_sec = now.tv_sec + 1 ;
+	deadline.tv_nsec = now.tv_usec * 1000 ;
+
+	_MUTEX_LOCK( Poll.mutex ) ;
+	if ( ! Poll.stop ) {
+		// a timeout is expected here, so not my_pthread_cond_timedwait
+		pthread_cond_timedwait( &(Poll.cond), &(Poll.mutex), &deadline ) ;
+	}
+	stop = Poll.stop ;
+	_MUTEX_UNLOCK( Poll.mutex ) ;
+	return stop ;
+}
+
+static int Poll_Interval( const struct poll_entry * pe )
+{
+	if ( pe->interval > 0 ) {
+		return pe->interval ;
+	}
+	// refresh before volatile data expires
+	return ( Globals.timeout_volatile > 2 ) ? Globals.timeout_volatile / 2 : 1 ;
+}
+
+/* Only the bus index and instance are kept, the connection could go away */
+static void * Poll_Thread( void * v )
+{
+	struct poll_thread * pt = v ;
+	struct poll_round pr ;
+	struct poll_entry * pe ;
+	time_t * next_due ;
+	int entries = 0 ;
+
+	for ( pe = poll_head ; pe != NULL ; pe = pe->next ) {
+		++entries ;
+	}
+	next_due = owcalloc( entries, sizeof(time_t) ) ;
+	pr.due = owcalloc( entries, sizeof(struct poll_entry *) ) ;
+	if ( next_due == NULL || pr.due == NULL ) {
+		SAFEFREE( next_due ) ;
+		SAFEFREE( pr.due ) ;
+		_MUTEX_LOCK( Poll.mutex ) ;
+		pt->done = 1 ;
+		_MUTEX_UNLOCK( Poll.mutex ) ;
+		return VOID_RETURN ;
+	}
+	pr.bus = pt->bus ;
+	pr.instance = pt->instance ;
+
+	while ( ! StateInfo.shutting_down ) {
+		time_t now = NOW_TIME ;
+		int i ;
+
+		pr.due_count = 0 ;
+		for ( pe = poll_head, i = 0 ; pe != NULL ; pe = pe->next, ++i ) {
+			if ( next_due[i] <= now ) {
+				next_due[i] = now + Poll_Interval( pe ) ;
+				pr.due[pr.due_count++] = pe ;
+			}
+		}
+		if ( pr.due_count > 0 && BAD( Poll_Round( &pr ) ) ) {
+			// the bus is gone
+			break ;
+		}
+		if ( Poll_Sleep() ) {
+			break ;
+		}
+	}
+
+	owfree( next_due ) ;
+	owfree( pr.due ) ;
+	_MUTEX_LOCK( Poll.mutex ) ;
+	pt->done = 1 ;
+	_MUTEX_UNLOCK( Poll.mutex ) ;
+	return VOID_RETURN ;
+}
+
+/* Read the due properties on one bus, gbBAD only if the bus is gone or replaced */
+static GOOD_OR_BAD Poll_Round( struct poll_round * pr )
+{
+	char bus_path[PATH_MAX] ;
+	struct parsedname s_pn_bus ;
+	struct parsedname * pn_bus = &s_pn_bus ;
+	struct one_wire_query ** owq_array ;
+	SIZE_OR_ERROR * read_results ;
+	int simul_temperature = 0 ;
+	int simul_voltage = 0 ;
+	int good_reads = 0 ;
+	int i ;
+
+	snprintf( bus_path, PATH_MAX, "/bus.%d", (int) pr->bus ) ;
+	if ( FS_ParsedName( bus_path, pn_bus ) != 0 ) {
+		LEVEL_DEBUG("Poller: %s is gone", bus_path ) ;
+		return gbBAD ;
+	}
+	if ( pn_bus->selected_connection->instance != pr->instance ) {
+		// another bus took the number, it has a poller of its own
+		LEVEL_DEBUG("Poller: %s was replaced", bus_path ) ;
+		FS_ParsedName_destroy( pn_bus ) ;
+		return gbBAD ;
+	}
+
+	pr->paths = NULL ;
+	pr->path_count = 0 ;
+	pr->path_allocated = 0 ;
+	FS_dir( Poll_Device, pr, pn_bus ) ;
+	FS_ParsedName_destroy( pn_bus ) ;
+
+	if ( pr->path_count == 0 ) {
+		SAFEFREE( pr->paths ) ;
+		return gbGOOD ;
+	}
+
+	owq_array = owcalloc( pr->path_count, sizeof(struct one_wire_query *) ) ;
+	read_results = owcalloc( pr->path_count, sizeof(SIZE_OR_ERROR) ) ;
+	if ( owq_array == NULL || read_results == NULL ) {
+		SAFEFREE( owq_array ) ;
+		SAFEFREE( read_results ) ;
+		for ( i = 0 ; i < pr->path_count ; ++i ) {
+			owfree( pr->paths[i] ) ;
+		}
+		owfree( pr->paths ) ;
+		return gbGOOD ;
+	}
+
+	for ( i = 0 ; i < pr->path_count ; ++i ) {
+		struct one_wire_query * owq = OWQ_create_from_path( pr->paths[i] ) ;
+		if ( owq != NO_ONE_WIRE_QUERY && BAD( OWQ_allocate_read_buffer(owq) ) ) {
+			OWQ_destroy(owq) ;
+			owq = NO_ONE_WIRE_QUERY ;
+		}
+		if ( owq != NO_ONE_WIRE_QUERY ) {
+			struct parsedname * pn = PN(owq) ;
+			switch ( pn->selected_filetype->change ) {
+				case fc_simultaneous_temperature:
+					// the simultaneous conversion makes the cached value stale
+					simul_temperature = 1 ;
+					break ;
+				case fc_simultaneous_voltage:
+					simul_voltage = 1 ;
+					break ;
+				default:
+					// bypass the cache for the read, the result is still stored
+					pn->state |= ePS_uncached ;
+					break ;
+			}
+		}
+		owq_array[i] = owq ;
+	}
+
+	// one conversion for the whole bus instead of one per device
+	if ( simul_temperature ) {
+		snprintf( bus_path, PATH_MAX, "/bus.%d/simultaneous/temperature", (int) pr->bus ) ;
+		FS_write( bus_path, "1", 1, 0 ) ;
+	}
+	if ( simul_voltage ) {
+		snprintf( bus_path, PATH_MAX, "/bus.%d/simultaneous/voltage", (int) pr->bus ) ;
+		FS_write( bus_path, "1", 1, 0 ) ;
+	}
+
+	FS_read_many( owq_array, read_results, pr->path_count ) ;
+
+	for ( i = 0 ; i < pr->path_count ; ++i ) {
+		if ( read_results[i] >= 0 ) {
+			++good_reads ;
+		} else {
+			LEVEL_DEBUG("Poller: cannot read %s (%d)", pr->paths[i], (int) read_results[i] ) ;
+		}
+		OWQ_destroy( owq_array[i] ) ;
+		owfree( pr->paths[i] ) ;
+	}
+	LEVEL_DEBUG("Poller: bus.%d refreshed %d of %d properties", (int) pr->bus, good_reads, pr->path_count ) ;
+
+	owfree( owq_array ) ;
+	owfree( read_results ) ;
+	owfree( pr->paths ) ;
+	return gbGOOD ;
+}
+
+/* FS_dir callback -- queue the wanted properties of each device */
+static void Poll_Device( void * v, const struct parsedname * pn_device )
+{
+	struct poll_round * pr = v ;
+	const char * device ;
+	int i ;
+
+	if ( pn_device->selected_device == NO_DEVICE
+		|| pn_device->selected_device == DeviceSimultaneous
+		|| IsAlarmDir( pn_device ) ) {
+		return ;
+	}
+	device = FS_DirName( pn_device ) ;
+
+	for ( i = 0 ; i < pr->due_count ; ++i ) {
+		if ( fnmatch( pr->due[i]->device, device, 0 ) == 0 ) {
+			Poll_Add_Path( pr, device, pr->due[i]->property ) ;
+		}
+	}
+}
+
+static void Poll_Add_Path( struct poll_round * pr, const char * device, const char * property )
+{
+	char path[PATH_MAX] ;
+
+	if ( pr->path_count == pr->path_allocated ) {
+		int allocated = pr->path_allocated + 16 ;
+		char ** paths = owrealloc( pr->paths, allocated * sizeof(char *) ) ;
+		if ( paths == NULL ) {
+			return ;
+		}
+		pr->paths = paths ;
+		pr->path_allocated = allocated ;
+	}
+
+	snprintf( path, PATH_MAX, "/bus.%d/%s/%s", (int) pr->bus, device, property ) ;
+	pr->paths[pr->path_count] = owstrdup( path ) ;
+	if ( pr->paths[pr->path_count] != NULL ) {
+		++pr->path_count ;
+	}
+}
@@ -123,83 +123,70 @@ INDEX_OR_ERROR ReCheckPresence(struct parsedname *pn)
 }
 
 /* Check if device exists -- -1 no, >=0 yes (bus number) */
-/* lower level, cycle through the devices */
+/* lower level, every connection at once (fan-out task pool) */
 struct checkpresence_struct {
-	struct port_in * pin;
+	struct task_group * tg ;
 	struct connection_in * cin;
 	struct parsedname *pn;
 	INDEX_OR_ERROR bus_nr;
 };
 
-static void * CheckPresence_callback_conn(void * v)
+static void CheckPresence_task(void * v)
 {
 	struct checkpresence_struct * cps = (struct checkpresence_struct *) v ;
-	struct checkpresence_struct cps_next ;
-	pthread_t thread;
-	int threadbad = 0 ;
-	
-	cps_next.cin = cps->cin->next ;
-	if ( cps_next.cin == NO_CONNECTION ) {
-		threadbad = 1 ;
-	} else {
-		cps_next.pin = cps->pin ;
-		cps_next.pn = cps->pn ;
-		cps_next.bus_nr = INDEX_BAD ;
-		threadbad = pthread_create(&thread, DEFAULT_THREAD_ATTR, CheckPresence_callback_conn, (void *) (&cps_next)) ;
-	}
-	
+
 	cps->bus_nr = CheckThisConnection( cps->cin->index, cps->pn ) ;
-	
-	if (threadbad == 0) {		/* was a thread created? */
-		if (pthread_join(thread, NULL)==0) {
-			if ( INDEX_VALID(cps_next.bus_nr) ) {
-				cps->bus_nr = cps_next.bus_nr ;
-			}
-		}
+	if ( INDEX_VALID( cps->bus_nr ) ) {
+		// found -- don't start on the other buses
+		Task_Cancel( cps->tg ) ;
 	}
-	return VOID_RETURN ;
 }
 
-static void * CheckPresence_callback_port(void * v)
+static INDEX_OR_ERROR CheckPresence_low(struct parsedname *pn)
 {
-	struct checkpresence_struct * cps = (struct checkpresence_struct *) v ;
-	struct checkpresence_struct cps_next ;
-	pthread_t thread;
-	int threadbad = 0 ;
-	
-	cps_next.pin = cps->pin->next ;
-	if ( cps_next.pin == NULL ) {
-		threadbad = 1 ;
-	} else {
-		cps_next.pn = cps->pn ;
-		cps_next.bus_nr = INDEX_BAD ;
-		threadbad = pthread_create(&thread, DEFAULT_THREAD_ATTR, CheckPresence_callback_port, (void *) (&cps_next)) ;
+	struct task_group tg ;
+	struct checkpresence_struct * cps ;
+	struct port_in * pin ;
+	struct connection_in * cin ;
+	INDEX_OR_ERROR bus_nr = INDEX_BAD ;
+	int count = 0 ;
+	int i ;
+
+	for ( pin = Inbound_Control.head_port ; pin != NULL ; pin = pin->next ) {
+		for ( cin = pin->first ; cin != NO_CONNECTION ; cin = cin->next ) {
+			++count ;
+		}
 	}
-	
-	cps->cin = cps->pin->first ;
-	if ( cps->cin != NO_CONNECTION ) {
-		CheckPresence_callback_conn(v) ;
+	if ( count == 0 ) {
+		return INDEX_BAD ;
 	}
-			
-	if (threadbad == 0) {		/* was a thread created? */
-		if (pthread_join(thread, NULL)==0) {
-			if ( INDEX_VALID(cps_next.bus_nr) ) {
-				cps->bus_nr = cps_next.bus_nr ;
-			}
-		}
+	cps = owcalloc( count, sizeof( struct checkpresence_struct ) ) ;
+	if ( cps == NULL ) {
+		return INDEX_BAD ;
 	}
-	return VOID_RETURN ;
-}
 
-static INDEX_OR_ERROR CheckPresence_low(struct parsedname *pn)
-{
-	struct checkpresence_struct cps = { Inbound_Control.head_port, NULL, pn, INDEX_BAD };
-		
-	if ( cps.pin != NULL ) {
-		CheckPresence_callback_port( (void *) (&cps) ) ;
+	Task_Group_Init( &tg, fanout_presence ) ;
+	i = 0 ;
+	for ( pin = Inbound_Control.head_port ; pin != NULL ; pin = pin->next ) {
+		for ( cin = pin->first ; cin != NO_CONNECTION && i < count ; cin = cin->next ) {
+			cps[i].tg = &tg ;
+			cps[i].cin = cin ;
+			cps[i].pn = pn ;
+			cps[i].bus_nr = INDEX_BAD ;
+			Task_Add( &tg, CheckPresence_task, &cps[i] ) ;
+			++i ;
+		}
 	}
+	Task_Wait( &tg ) ;
 
-	return cps.bus_nr;
+	for ( i = 0 ; i < count ; ++i ) {
+		if ( INDEX_VALID( cps[i].bus_nr ) ) {
+			bus_nr = cps[i].bus_nr ;
+			break ;
+		}
+	}
+	owfree( cps ) ;
+	return bus_nr;
 }
 
 ZERO_OR_ERROR FS_present(struct one_wire_query *owq)
@@ -280,6 +267,17 @@ static INDEX_OR_ERROR CheckThisConnection(int bus_nr, struct parsedname *pn)
 static GOOD_OR_BAD PresenceFromDirblob( struct parsedname * pn )
 {
 	struct dirblob db;	// cached dirblob
+
+	switch ( get_busmode(pn->selected_connection) ) {
+		case bus_fake:
+		case bus_tester:
+		case bus_mock:
+			// fixed list, indexed at setup
+			return ( DirblobSearch(pn->sn, &(pn->selected_connection->master.fake.main) ) >= 0 ) ? gbGOOD : gbBAD ;
+		default:
+			break ;
+	}
+
 	if ( GOOD( Cache_Get_Dir( &db , pn ) ) ) {
 		// Use the dirblob from the cache
 		GOOD_OR_BAD ret = ( DirblobSearch(pn->sn, &db ) >= 0 ) ? gbGOOD : gbBAD ;
@@ -29,6 +29,12 @@ static SIZE_OR_ERROR FS_read_distribute(struct one_wire_query *owq) ;
 static ZERO_OR_ERROR FS_read_all( struct one_wire_query *owq_all ); 
 static ZERO_OR_ERROR FS_read_a_part( struct one_wire_query *owq_part );
 static ZERO_OR_ERROR FS_read_in_parts( struct one_wire_query *owq_all );
+static int read_many_batchable( struct one_wire_query *owq ) ;
+static int read_many_compare( const void * a, const void * b ) ;
+static SIZE_OR_ERROR FS_read_many_locked( struct one_wire_query *owq ) ;
+static ZERO_OR_ERROR FS_r_locked( struct one_wire_query *owq ) ;
+static ZERO_OR_ERROR FS_r_single_flight( struct one_wire_query *owq ) ;
+static size_t read_flight_size( struct one_wire_query *owq ) ;
 
 /*
 Change in strategy 6/2006:
@@ -75,28 +81,191 @@ SIZE_OR_ERROR FS_read_postparse(struct one_wire_query *owq)
 
 	/* Normal read. Try three times */
 	LEVEL_DEBUG("%s", pn->path);
-	STATLOCK;
 	AVERAGE_IN(&read_avg);
 	AVERAGE_IN(&all_avg);
-	STATUNLOCK;
 
 	/* First try */
 	STAT_ADD1(read_tries[0]);
 
 	read_or_error = (pn->type == ePN_real) ? FS_read_real(owq) : FS_r_virtual(owq);
 
-	STATLOCK;
 	if (read_or_error >= 0) {
-		++read_success;			/* statistics */
-		read_bytes += read_or_error;	/* statistics */
+		STAT_ADD1(read_success);			/* statistics */
+		STAT_ADD(read_bytes, read_or_error);	/* statistics */
 	}
 	AVERAGE_OUT(&read_avg);
 	AVERAGE_OUT(&all_avg);
-	STATUNLOCK;
 	LEVEL_DEBUG("%s return %d", pn->path, read_or_error);
 	return read_or_error;
 }
 
+/* Several reads at once (owserver msg_readmany and OW_readmany) */
+struct read_many_item {
+	struct one_wire_query * owq ;
+	int index ; // position in the caller's list
+	int batch ; // local device read that can share the device lock
+} ;
+
+/* Local, real device property -- can be read with the device lock already held */
+static int read_many_batchable( struct one_wire_query *owq )
+{
+	struct parsedname *pn = PN(owq);
+
+	if ( pn->type != ePN_real ) {
+		return 0 ;
+	}
+	if ( pn->selected_device == NO_DEVICE || pn->selected_device == DeviceSimultaneous ) {
+		return 0 ;
+	}
+	if ( pn->selected_filetype == NO_FILETYPE ) {
+		return 0 ;
+	}
+	if ( ! KnownBus(pn) || BusIsServer(pn->selected_connection) ) {
+		return 0 ;
+	}
+	return 1 ;
+}
+
+/* Order: batchable items grouped by bus and device, otherwise request order */
+static int read_many_compare( const void * a, const void * b )
+{
+	const struct read_many_item * item_a = a ;
+	const struct read_many_item * item_b = b ;
+
+	if ( item_a->batch != item_b->batch ) {
+		return item_b->batch - item_a->batch ;
+	}
+	if ( item_a->batch ) {
+		const struct parsedname * pn_a = PN(item_a->owq) ;
+		const struct parsedname * pn_b = PN(item_b->owq) ;
+		int sn_compare ;
+		if ( pn_a->selected_connection->index != pn_b->selected_connection->index ) {
+			return pn_a->selected_connection->index - pn_b->selected_connection->index ;
+		}
+		sn_compare = memcmp( pn_a->sn, pn_b->sn, SERIAL_NUMBER_SIZE ) ;
+		if ( sn_compare != 0 ) {
+			return sn_compare ;
+		}
+	}
+	return item_a->index - item_b->index ;
+}
+
+/* First try of a batched read -- device already locked */
+static SIZE_OR_ERROR FS_read_many_locked( struct one_wire_query *owq )
+{
+	SIZE_OR_ERROR read_or_error ;
+
+	LEVEL_DEBUG("%s", PN(owq)->path);
+	AVERAGE_IN(&read_avg);
+	AVERAGE_IN(&all_avg);
+	STAT_ADD1(read_tries[0]);
+	STAT_ADD1(read_calls);
+
+	read_or_error = FS_r_local(owq);	// this returns status
+	if (read_or_error >= 0) {
+		// local success -- now format in buffer
+		read_or_error = OWQ_parse_output(owq);	// this returns nr. bytes
+	}
+	if (read_or_error >= 0) {
+		STAT_ADD1(read_success);			/* statistics */
+		STAT_ADD(read_bytes, read_or_error);	/* statistics */
+	}
+	AVERAGE_OUT(&read_avg);
+	AVERAGE_OUT(&all_avg);
+	LEVEL_DEBUG("%s return %d", PN(owq)->path, read_or_error);
+	return read_or_error;
+}
+
+/* Read a list of already parsed queries
+ * owq_array entries may be NO_ONE_WIRE_QUERY (unparseable path)
+ * read_results gets the bytes read or error for each entry
+ * Properties of the same local device are read consecutively under one device lock
+ * (so the device and its branch stay selected on the bus)
+ * Failures are repeated afterwards through the normal read path */
+void FS_read_many( struct one_wire_query ** owq_array, SIZE_OR_ERROR * read_results, int count )
+{
+	struct read_many_item * items ;
+	int used = 0 ;
+	int i ;
+
+	if ( count <= 0 ) {
+		return ;
+	}
+
+	items = owmalloc( count * sizeof(struct read_many_item) ) ;
+	if ( items == NULL ) {
+		// no memory for sorting -- one at a time
+		for ( i = 0 ; i < count ; ++i ) {
+			read_results[i] = ( owq_array[i] == NO_ONE_WIRE_QUERY ) ? -ENOENT : FS_read_postparse( owq_array[i] ) ;
+		}
+		return ;
+	}
+
+	for ( i = 0 ; i < count ; ++i ) {
+		if ( owq_array[i] == NO_ONE_WIRE_QUERY ) {
+			read_results[i] = -ENOENT ;
+			continue ;
+		}
+		items[used].owq = owq_array[i] ;
+		items[used].index = i ;
+		items[used].batch = read_many_batchable( owq_array[i] ) ;
+		++used ;
+	}
+	qsort( items, used, sizeof(struct read_many_item), read_many_compare ) ;
+
+	i = 0 ;
+	while ( i < used ) {
+		struct parsedname * pn_first = PN(items[i].owq) ;
+		struct parsedname * pn_lock = NULL ;
+		int group_end ;
+
+		if ( ! items[i].batch ) {
+			read_results[items[i].index] = FS_read_postparse( items[i].owq ) ;
+			++i ;
+			continue ;
+		}
+
+		// find the extent of this device's group
+		for ( group_end = i + 1 ; group_end < used ; ++group_end ) {
+			struct parsedname * pn = PN(items[group_end].owq) ;
+			if ( ! items[group_end].batch
+				|| pn->selected_connection != pn_first->selected_connection
+				|| memcmp( pn->sn, pn_first->sn, SERIAL_NUMBER_SIZE ) != 0 ) {
+				break ;
+			}
+		}
+		LEVEL_DEBUG("Read %d properties of %s together", group_end - i, pn_first->path ) ;
+
+		// one device lock for the group
+		// static and statistic properties don't lock, so take it from the first that does
+		for ( ; i < group_end ; ++i ) {
+			struct parsedname * pn = PN(items[i].owq) ;
+			if ( pn_lock == NULL ) {
+				if ( DeviceLockGet(pn) != 0 ) {
+					LEVEL_DEBUG("Cannot lock device for %s", pn->path) ;
+					read_results[items[i].index] = -EADDRINUSE ;
+					continue ;
+				}
+				if ( pn->lock != NULL ) {
+					pn_lock = pn ;
+				}
+			}
+			read_results[items[i].index] = FS_read_many_locked( items[i].owq ) ;
+		}
+		if ( pn_lock != NULL ) {
+			DeviceLockRelease(pn_lock) ;
+		}
+	}
+
+	// Repeat the failures (bus search, retries) without the group lock
+	for ( i = 0 ; i < used ; ++i ) {
+		if ( items[i].batch && read_results[items[i].index] < 0 ) {
+			read_results[items[i].index] = FS_read_postparse( items[i].owq ) ;
+		}
+	}
+	owfree( items ) ;
+}
+
 /* Read real device (Non-virtual). Will repeat 3 times if needed */
 static SIZE_OR_ERROR FS_read_real(struct one_wire_query *owq)
 {
@@ -195,10 +364,8 @@ static SIZE_OR_ERROR FS_read_distribute(struct one_wire_query *owq)
 	SIZE_OR_ERROR read_or_error = 0;
 
 	LEVEL_DEBUG("%s", PN(owq)->path);
-	STATLOCK;
 	AVERAGE_IN(&read_avg);
 	AVERAGE_IN(&all_avg);
-	STATUNLOCK;
 
 	/* handle DeviceSimultaneous */
 	if (PN(owq)->selected_device == DeviceSimultaneous) {
@@ -207,14 +374,12 @@ static SIZE_OR_ERROR FS_read_distribute(struct one_wire_query *owq)
 		read_or_error = FS_r_given_bus(owq);
 	}
 
-	STATLOCK;
 	if (read_or_error >= 0) {
-		++read_success;			/* statistics */
-		read_bytes += read_or_error;		/* statistics */
+		STAT_ADD1(read_success);			/* statistics */
+		STAT_ADD(read_bytes, read_or_error);	/* statistics */
 	}
 	AVERAGE_OUT(&read_avg);
 	AVERAGE_OUT(&all_avg);
-	STATUNLOCK;
 
 	LEVEL_DEBUG("%s returns %d", PN(owq)->path, read_or_error);
 	//printf("FS_read_distribute: pid=%ld return %d\n", pthread_self(), read_or_error);
@@ -240,17 +405,11 @@ static SIZE_OR_ERROR FS_r_given_bus(struct one_wire_query *owq)
 		//printf("FS_r_given_bus pid=%ld r=%d\n",pthread_self(), read_or_error);
 	} else {
 		STAT_ADD1(read_calls);	/* statistics */
-		if (DeviceLockGet(pn) == 0) {
-			read_or_error = FS_r_local(owq);	// this returns status
-			DeviceLockRelease(pn);
-			LEVEL_DEBUG("return=%d", read_or_error);
-			if (read_or_error >= 0) {
-				// local success -- now format in buffer
-				read_or_error = OWQ_parse_output(owq);	// this returns nr. bytes
-			}
-		} else {
-			LEVEL_DEBUG("Cannot lock bus to perform read") ;
-			read_or_error = -EADDRINUSE;
+		read_or_error = FS_r_single_flight(owq);	// this returns status
+		LEVEL_DEBUG("return=%d", read_or_error);
+		if (read_or_error >= 0) {
+			// local success -- now format in buffer
+			read_or_error = OWQ_parse_output(owq);	// this returns nr. bytes
 		}
 	}
 	LEVEL_DEBUG("After read is performed (bytes or error %d)", read_or_error);
@@ -258,6 +417,164 @@ static SIZE_OR_ERROR FS_r_given_bus(struct one_wire_query *owq)
 	return read_or_error;
 }
 
+/* Local read with the device locked -- returns status */
+static ZERO_OR_ERROR FS_r_locked( struct one_wire_query *owq )
+{
+	struct parsedname *pn = PN(owq);
+	ZERO_OR_ERROR read_status ;
+
+	if (DeviceLockGet(pn) != 0) {
+		LEVEL_DEBUG("Cannot lock bus to perform read") ;
+		return -EADDRINUSE;
+	}
+	read_status = FS_r_local(owq);	// this returns status
+	DeviceLockRelease(pn);
+	return read_status ;
+}
+
+/* Single-flight reads
+ * Identical local reads in progress (same cache key: sn, filetype, extension,
+ * and the same bus and uncached state) share one bus read. The first thread (leader) reads, the others wait and
+ * copy its value. Only values kept as value_objects (numbers) are shared,
+ * output formatting is still done by each reader */
+struct read_flight {
+	struct read_flight * next ;
+	BYTE sn[SERIAL_NUMBER_SIZE] ;
+	struct filetype * ft ;
+	int extension ;
+	int uncached ; // /uncached reads never share with cached ones
+	UINT bus ; // connection instance -- one serial number can be on two buses
+	int done ;
+	int followers ;
+	ZERO_OR_ERROR read_status ;
+	pthread_cond_t cond ;
+	size_t size ;
+	// followed by size bytes of data
+} ;
+
+// in-flight list, protected by Mutex.read_flight_mutex
+static struct read_flight * read_flight_head = NULL ;
+
+/* bytes to share for this read, 0 if it can't be shared */
+static size_t read_flight_size( struct one_wire_query *owq )
+{
+	struct parsedname *pn = PN(owq);
+
+	switch (pn->selected_filetype->format) {
+	case ft_integer:
+	case ft_unsigned:
+	case ft_yesno:
+	case ft_date:
+	case ft_float:
+	case ft_pressure:
+	case ft_temperature:
+	case ft_tempgap:
+		break ;
+	default:
+		return 0 ;
+	}
+	if (pn->extension == EXTENSION_ALL) {
+		return pn->selected_filetype->ag->elements * sizeof(union value_object) ;
+	}
+	return sizeof(union value_object) ;
+}
+
+/* bus part of the key (0 for none) */
+static UINT read_flight_bus( const struct parsedname *pn )
+{
+	return ( pn->selected_connection == NO_CONNECTION ) ? 0 : pn->selected_connection->instance ;
+}
+
+static ZERO_OR_ERROR FS_r_single_flight( struct one_wire_query *owq )
+{
+	struct parsedname *pn = PN(owq);
+	size_t size = read_flight_size(owq) ;
+	void * data = (pn->extension == EXTENSION_ALL) ? (void *) OWQ_array(owq) : (void *) &OWQ_val(owq) ;
+	struct read_flight * flight ;
+	ZERO_OR_ERROR read_status ;
+
+	if ( size == 0 ) {
+		return FS_r_locked(owq) ;
+	}
+
+	_MUTEX_LOCK(Mutex.read_flight_mutex) ;
+	for ( flight = read_flight_head ; flight != NULL ; flight = flight->next ) {
+		if ( flight->ft == pn->selected_filetype
+			&& flight->extension == pn->extension
+			&& flight->uncached == ! NotUncachedDir(pn)
+			&& flight->bus == read_flight_bus(pn)
+			&& memcmp( flight->sn, pn->sn, SERIAL_NUMBER_SIZE ) == 0 ) {
+			break ;
+		}
+	}
+
+	if ( flight != NULL ) {
+		// follower -- wait for the leader's result
+		++flight->followers ;
+		while ( ! flight->done ) {
+			my_pthread_cond_wait( &(flight->cond), &(Mutex.read_flight_mutex) ) ;
+		}
+		read_status = flight->read_status ;
+		if ( read_status >= 0 ) {
+			memcpy( data, &flight[1], size ) ;
+			STAT_ADD1(read_shared) ;
+			LEVEL_DEBUG("Shared the read of %s", pn->path) ;
+		}
+		if ( --flight->followers == 0 ) {
+			my_pthread_cond_destroy( &(flight->cond) ) ;
+			owfree( flight ) ;
+		}
+		_MUTEX_UNLOCK(Mutex.read_flight_mutex) ;
+		return read_status ;
+	}
+
+	// leader
+	flight = owmalloc( sizeof(struct read_flight) + size ) ;
+	if ( flight == NULL ) {
+		_MUTEX_UNLOCK(Mutex.read_flight_mutex) ;
+		return FS_r_locked(owq) ;
+	}
+	memcpy( flight->sn, pn->sn, SERIAL_NUMBER_SIZE ) ;
+	flight->ft = pn->selected_filetype ;
+	flight->extension = pn->extension ;
+	flight->uncached = ! NotUncachedDir(pn) ;
+	flight->bus = read_flight_bus(pn) ;
+	flight->done = 0 ;
+	flight->followers = 0 ;
+	flight->size = size ;
+	my_pthread_cond_init( &(flight->cond), NULL ) ;
+	flight->next = read_flight_head ;
+	read_flight_head = flight ;
+	_MUTEX_UNLOCK(Mutex.read_flight_mutex) ;
+
+	read_status = FS_r_locked(owq) ;
+
+	_MUTEX_LOCK(Mutex.read_flight_mutex) ;
+	// take out of the list -- later reads start a new flight
+	if ( read_flight_head == flight ) {
+		read_flight_head = flight->next ;
+	} else {
+		struct read_flight * previous ;
+		for ( previous = read_flight_head ; previous->next != flight ; previous = previous->next ) {
+		}
+		previous->next = flight->next ;
+	}
+	flight->read_status = read_status ;
+	if ( read_status >= 0 ) {
+		memcpy( &flight[1], data, size ) ;
+	}
+	flight->done = 1 ;
+	if ( flight->followers == 0 ) {
+		my_pthread_cond_destroy( &(flight->cond) ) ;
+		owfree( flight ) ;
+	} else {
+		my_pthread_cond_broadcast( &(flight->cond) ) ;
+	}
+	_MUTEX_UNLOCK(Mutex.read_flight_mutex) ;
+
+	return read_status ;
+}
+
 // This function should return number of bytes read... not status.
 // Works for all the virtual directories, like statistics, interface, ...
 // Doesn't need three-peat and bus was already set or not needed.
@@ -288,8 +605,7 @@ static SIZE_OR_ERROR FS_r_virtual(struct one_wire_query *owq)
 			// reading /statistics/read/tries.ALL
 			// will cause a deadlock since it calls STAT_ADD1(read_array);
 			// Should perhaps create a new mutex for this.
-			// Comment out this STATLOCK until it's solved.
-			// STATLOCK now done at time of actual read in ow_stats.c
+			// Statistics are read (lock-free) at time of actual read in ow_stats.c
 			read_status = FS_r_local(owq);	// this returns status
 			break;
 		default:
@@ -312,7 +628,7 @@ static void adjust_file_size(struct one_wire_query *owq)
 
 	/* Adjust file length -- especially important for fuse which uses 4k buffers */
 	/* First file filelength */
-	file_length = FullFileLength(PN(owq));
+	file_length = ReadLength(PN(owq));
 
 	/* next adjust for offset */
 	if ((unsigned long) OWQ_offset(owq) >= (unsigned long) file_length) {
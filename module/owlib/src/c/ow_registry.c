@@ -0,0 +1,415 @@
+/*
+    OWFS -- One-Wire filesystem
+    OWHTTPD -- One-Wire Web Server
+    Written 2003 Paul H Alfille
+    email: paul.alfille@gmail.com
+    Released under the GPL
+    See the header file: ow.h for full attribution
+    1wire/iButton system from Dallas Semiconductor
+*/
+
+/* Device registry
+ * Each bus keeps the devices found by its last complete root search.
+ * Every such search (any uncached listing, or the --registry thread) is
+ * compared with the registry and the differences become events:
+ *   kept in a short ring, shown as /system/registry/sequence and events
+ *   passed to watchers registered with Registry_Watch (e.g. owfs)
+ * With --registry seconds a thread per local bus repeats the search
+ * (started with the bus, also for buses added later, and joined by LibStop)
+ * (on a DS2480 that is the one pass verification of the known devices)
+ * and root directory listings are answered from the registry instead
+ * of the bus while it is fresh.
+ * The first search of a bus fills the registry without events.
+ * */
+
+#include <config.h>
+#include "owfs_config.h"
+#include "ow.h"
+#include "ow_connection.h"
+
+#define REGISTRY_EVENTS	64
+#define REGISTRY_WATCHERS	4
+
+struct registry_event {
+	UINT sequence ;
+	INDEX_OR_ERROR bus ;
+	BYTE sn[SERIAL_NUMBER_SIZE] ;
+	int present ;
+} ;
+
+struct registry_watch {
+	void (*notify) (void * v, INDEX_OR_ERROR bus, const BYTE * sn, int present) ;
+	void * v ;
+} ;
+
+// protected by Mutex.registry_mutex (as are the per bus registry fields)
+static struct registry_event registry_ring[REGISTRY_EVENTS] ;
+static UINT registry_sequence = 0 ;
+static struct registry_watch registry_watch[REGISTRY_WATCHERS] ;
+static int registry_watchers = 0 ;
+
+#define REGISTRYLOCK    _MUTEX_LOCK(   Mutex.registry_mutex )
+#define REGISTRYUNLOCK  _MUTEX_UNLOCK( Mutex.registry_mutex )
+
+// one per watched bus, joined by Registry_Stop (or once it has ended on its own)
+struct registry_thread {
+	struct registry_thread * next ;
+	pthread_t thread ;
+	INDEX_OR_ERROR bus ;
+	UINT instance ; // the bus number can be reused by a later bus
+	int done ;
+} ;
+
+// not Mutex.registry_mutex -- the watchers take that in Registry_Update
+static struct {
+	pthread_mutex_t mutex ;
+	pthread_cond_t cond ; // signalled to stop
+	int stop ;
+	int started ; // set by Registry_Start, buses added before that wait for it
+	struct registry_thread * head ;
+} Watchers = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, 0, NULL, } ;
+
+static void * Registry_Thread( void * v ) ;
+static int Registry_Sleep( void ) ;
+static void Registry_Ignore( void * v, const struct parsedname * pn_entry ) ;
+static void Registry_Event( INDEX_OR_ERROR bus, const BYTE * sn, int present ) ;
+static void Registry_Notify( INDEX_OR_ERROR bus, const struct dirblob * changed, int present ) ;
+
+/* Record a complete root search of a bus and report the changes */
+void Registry_Update( struct connection_in * in, const struct dirblob * db )
+{
+	struct dirblob added ;
+	struct dirblob removed ;
+	struct dirblob current ;
+	BYTE sn[SERIAL_NUMBER_SIZE] ;
+	int device_index ;
+	int first ;
+
+	// indexed (and normally the same snapshot as the directory cache)
+	if ( DirblobShare( &current, db ) != 0 ) {
+		return ;
+	}
+	DirblobInit( &added ) ;
+	DirblobInit( &removed ) ;
+
+	REGISTRYLOCK ;
+	first = ( in->registry_time == 0 ) ;
+	if ( ! first ) {
+		for ( device_index = 0 ; DirblobGet( device_index, sn, db ) == 0 ; ++device_index ) {
+			if ( DirblobSearch( sn, &(in->registry) ) == INDEX_BAD ) {
+				Registry_Event( in->index, sn, 1 ) ;
+				DirblobAdd( sn, &added ) ;
+			}
+		}
+		for ( device_index = 0 ; DirblobGet( device_index, sn, &(in->registry) ) == 0 ; ++device_index ) {
+			if ( DirblobSearch( sn, &current ) == INDEX_BAD ) {
+				Registry_Event( in->index, sn, 0 ) ;
+				DirblobAdd( sn, &removed ) ;
+			}
+		}
+	}
+	DirblobClear( &(in->registry) ) ;
+	in->registry = current ;
+	in->registry_time = NOW_TIME ;
+	REGISTRYUNLOCK ;
+
+	// outside the lock, watchers may well read the filesystem
+	Registry_Notify( in->index, &added, 1 ) ;
+	Registry_Notify( in->index, &removed, 0 ) ;
+	DirblobClear( &added ) ;
+	DirblobClear( &removed ) ;
+}
+
+/* Called with the registry locked */
+static void Registry_Event( INDEX_OR_ERROR bus, const BYTE * sn, int present )
+{
+	struct registry_event * re = &registry_ring[ registry_sequence % REGISTRY_EVENTS ] ;
+
+	re->sequence = ++registry_sequence ;
+	re->bus = bus ;
+	memcpy( re->sn, sn, SERIAL_NUMBER_SIZE ) ;
+	re->present = present ;
+	LEVEL_DEBUG("Device " SNformat " %s bus.%d", SNvar(sn), present ? "added to" : "removed from", (int) bus ) ;
+}
+
+static void Registry_Notify( INDEX_OR_ERROR bus, const struct dirblob * changed, int present )
+{
+	struct registry_watch watch[REGISTRY_WATCHERS] ;
+	int watchers ;
+	BYTE sn[SERIAL_NUMBER_SIZE] ;
+	int device_index ;
+
+	if ( DirblobElements( changed ) == 0 ) {
+		return ;
+	}
+
+	// a copy, so watchers can be added while the old ones are called
+	REGISTRYLOCK ;
+	watchers = registry_watchers ;
+	memcpy( watch, registry_watch, watchers * sizeof(struct registry_watch) ) ;
+	REGISTRYUNLOCK ;
+
+	for ( device_index = 0 ; DirblobGet( device_index, sn, changed ) == 0 ; ++device_index ) {
+		int watcher ;
+
+		if ( ! present ) {
+			// no longer where the presence cache says
+			struct parsedname s_pn ;
+			FS_ParsedName_Placeholder( &s_pn ) ;
+			memcpy( s_pn.sn, sn, SERIAL_NUMBER_SIZE ) ;
+			Cache_Del_Device( &s_pn ) ;
+		}
+		for ( watcher = 0 ; watcher < watchers ; ++watcher ) {
+			watch[watcher].notify( watch[watcher].v, bus, sn, present ) ;
+		}
+	}
+}
+
+/* Call notify for every device added or removed from now on
+ * There is no way to stop watching, so only for the life of the program */
+GOOD_OR_BAD Registry_Watch( void (*notify) (void * v, INDEX_OR_ERROR bus, const BYTE * sn, int present), void * v )
+{
+	GOOD_OR_BAD ret = gbBAD ;
+
+	REGISTRYLOCK ;
+	if ( registry_watchers < REGISTRY_WATCHERS ) {
+		registry_watch[registry_watchers].notify = notify ;
+		registry_watch[registry_watchers].v = v ;
+		++registry_watchers ;
+		ret = gbGOOD ;
+	}
+	REGISTRYUNLOCK ;
+	return ret ;
+}
+
+/* Root directory of a bus from the registry, if kept fresh by the --registry thread */
+GOOD_OR_BAD Registry_Get( struct dirblob * db, const struct parsedname * pn )
+{
+	struct connection_in * in = pn->selected_connection ;
+	GOOD_OR_BAD ret = gbBAD ;
+
+	if ( Globals.registry <= 0 || in == NO_CONNECTION || ! RootNotBranch(pn) ) {
+		return gbBAD ;
+	}
+
+	REGISTRYLOCK ;
+	if ( in->registry_time != 0 && NOW_TIME - in->registry_time <= 2 * Globals.registry ) {
+		if ( DirblobShare( db, &(in->registry) ) == 0 ) {
+			ret = gbGOOD ;
+		}
+	}
+	REGISTRYUNLOCK ;
+	return ret ;
+}
+
+/* Latest event number -- compare with earlier reads to notice changes */
+UINT Registry_Sequence( void )
+{
+	UINT sequence ;
+
+	REGISTRYLOCK ;
+	sequence = registry_sequence ;
+	REGISTRYUNLOCK ;
+	return sequence ;
+}
+
+/* Recent events, oldest first, one per line:
+ *   sequence,bus.n,device,added|removed
+ * Returns the length written */
+size_t Registry_Events( char * buffer, size_t size )
+{
+	size_t length = 0 ;
+	UINT sequence ;
+
+	if ( size == 0 ) {
+		return 0 ;
+	}
+	buffer[0] = '\0' ;
+
+	REGISTRYLOCK ;
+	sequence = ( registry_sequence > REGISTRY_EVENTS ) ? registry_sequence - REGISTRY_EVENTS : 0 ;
+	for ( ++sequence ; sequence <= registry_sequence ; ++sequence ) {
+		struct registry_event * re = &registry_ring[ (sequence - 1) % REGISTRY_EVENTS ] ;
+		int written = snprintf( &buffer[length], size - length, "%u,bus.%d,%.2X.%.2X%.2X%.2X%.2X%.2X%.2X,%s\n",
+			re->sequence, (int) re->bus,
+			re->sn[0], re->sn[1], re->sn[2], re->sn[3], re->sn[4], re->sn[5], re->sn[6],
+			re->present ? "added" : "removed" ) ;
+		if ( written < 0 || (size_t) written >= size - length ) {
+			buffer[length] = '\0' ;
+			break ;
+		}
+		length += written ;
+	}
+	REGISTRYUNLOCK ;
+	return length ;
+}
+
+/* Start a registry thread for each local bus master
+ * Called from LibStartThreads, after any fork into the background */
+void Registry_Start( void )
+{
+	struct port_in * pin ;
+	int reader ;
+
+	if ( Globals.registry <= 0 ) {
+		return ;
+	}
+
+	_MUTEX_LOCK( Watchers.mutex ) ;
+	Watchers.started = 1 ;
+	_MUTEX_UNLOCK( Watchers.mutex ) ;
+
+	reader = Connection_Read_Begin() ;
+	for ( pin = Inbound_Control.head_port ; pin != NULL ; pin = pin->next ) {
+		struct connection_in * in ;
+		for ( in = pin->first ; in != NO_CONNECTION ; in = in->next ) {
+			Registry_Start_Bus( in ) ;
+		}
+	}
+	Connection_Read_End( reader ) ;
+}
+
+/* Start the registry thread for one bus (at start up, or added later)
+ * Called with the bus list read-locked (or by the thread adding it) */
+void Registry_Start_Bus( struct connection_in * in )
+{
+	struct registry_thread ** prt ;
+	struct registry_thread * rt ;
+
+	if ( Globals.registry <= 0 || in == NO_CONNECTION ) {
+		return ;
+	}
+	if ( BusIsServer( in ) || ( in->iroutines.flags & ADAP_FLAG_sham ) ) {
+		// remote owserver keeps its own, monitors have no devices
+		return ;
+	}
+
+	_MUTEX_LOCK( Watchers.mutex ) ;
+	if ( ! Watchers.started ) {
+		// Registry_Start will find it
+		_MUTEX_UNLOCK( Watchers.mutex ) ;
+		return ;
+	}
+	prt = &(Watchers.head) ;
+	while ( (rt = *prt) != NULL ) {
+		if ( rt->done ) {
+			// ended on its own (bus removed) -- reap it
+			*prt = rt->next ;
+			pthread_join( rt->thread, NULL ) ;
+			owfree( rt ) ;
+			continue ;
+		}
+		if ( rt->instance == in->instance ) {
+			// already watched
+			_MUTEX_UNLOCK( Watchers.mutex ) ;
+			return ;
+		}
+		prt = &(rt->next) ;
+	}
+
+	rt = owcalloc( 1, sizeof(struct registry_thread) ) ;
+	if ( rt == NULL ) {
+		_MUTEX_UNLOCK( Watchers.mutex ) ;
+		return ;
+	}
+	rt->bus = in->index ;
+	rt->instance = in->instance ;
+	if ( pthread_create( &(rt->thread), DEFAULT_THREAD_ATTR, Registry_Thread, rt ) != 0 ) {
+		ERROR_DEBUG("Cannot start registry thread for bus.%d", (int) in->index ) ;
+		owfree( rt ) ;
+	} else {
+		LEVEL_DEBUG("Registry thread started for bus.%d", (int) in->index ) ;
+		rt->next = Watchers.head ;
+		Watchers.head = rt ;
+	}
+	_MUTEX_UNLOCK( Watchers.mutex ) ;
+}
+
+/* Stop the registry threads and wait for them
+ * Called from LibStop before the buses are closed */
+void Registry_Stop( void )
+{
+	struct registry_thread * rt ;
+
+	_MUTEX_LOCK( Watchers.mutex ) ;
+	Watchers.stop = 1 ;
+	Watchers.started = 0 ;
+	my_pthread_cond_broadcast( &(Watchers.cond) ) ;
+	rt = Watchers.head ;
+	Watchers.head = NULL ;
+	_MUTEX_UNLOCK( Watchers.mutex ) ;
+
+	while ( rt != NULL ) {
+		struct registry_thread * next = rt->next ;
+		pthread_join( rt->thread, NULL ) ;
+		owfree( rt ) ;
+		rt = next ;
+	}
+
+	// ready for another LibStart
+	_MUTEX_LOCK( Watchers.mutex ) ;
+	Watchers.stop = 0 ;
+	_MUTEX_UNLOCK( Watchers.mutex ) ;
+}
+
+/* Wait out the --registry interval, returns non-zero once told to stop */
+static int Registry_Sleep( void )
+{
+	struct timeval now ;
+	struct timespec deadline ;
+	int stop ;
+
+	gettimeofday( &now, NULL ) ;
+	deadline.tv_sec = now.tv_sec + Globals.registry ;
+	deadline.tv_nsec = now.tv_usec * 1000 ;
+
+	_MUTEX_LOCK( Watchers.mutex ) ;
+	if ( ! Watchers.stop ) {
+		// a timeout is expected here, so not my_pthread_cond_timedwait
+		pthread_cond_timedwait( &(Watchers.cond), &(Watchers.mutex), &deadline ) ;
+	}
+	stop = Watchers.stop ;
+	_MUTEX_UNLOCK( Watchers.mutex ) ;
+	return stop ;
+}
+
+/* Only the bus number and instance are kept, the connection could go away */
+static void * Registry_Thread( void * v )
+{
+	struct registry_thread * rt = v ;
+	char bus_path[PATH_MAX] ;
+
+	snprintf( bus_path, PATH_MAX, "/uncached/bus.%d", (int) rt->bus ) ;
+	while ( ! StateInfo.shutting_down ) {
+		struct parsedname s_pn ;
+
+		// the root search lands in Registry_Update
+		if ( FS_ParsedName( bus_path, &s_pn ) != 0 ) {
+			LEVEL_DEBUG("Registry: %s is gone", bus_path ) ;
+			break ;
+		}
+		if ( s_pn.selected_connection->instance != rt->instance ) {
+			// another bus took the number, it has a thread of its own
+			LEVEL_DEBUG("Registry: %s was replaced", bus_path ) ;
+			FS_ParsedName_destroy( &s_pn ) ;
+			break ;
+		}
+		FS_dir( Registry_Ignore, NULL, &s_pn ) ;
+		FS_ParsedName_destroy( &s_pn ) ;
+
+		if ( Registry_Sleep() ) {
+			break ;
+		}
+	}
+
+	_MUTEX_LOCK( Watchers.mutex ) ;
+	rt->done = 1 ;
+	_MUTEX_UNLOCK( Watchers.mutex ) ;
+	return VOID_RETURN ;
+}
+
+static void Registry_Ignore( void * v, const struct parsedname * pn_entry )
+{
+	(void) v ;
+	(void) pn_entry ;
+}
@@ -81,103 +81,77 @@ static INDEX_OR_ERROR ServerAlias( BYTE * sn, struct connection_in * in, struct
 }	
 
 struct remotealias_struct {
-	struct port_in * pin;
+	struct task_group * tg ;
 	struct connection_in *cin;
 	struct parsedname *pn;
 	BYTE sn[SERIAL_NUMBER_SIZE] ;
 	INDEX_OR_ERROR bus_nr;
 };
 
-static void * RemoteAlias_callback_conn(void * v)
+static void RemoteAlias_task(void * v)
 {
 	struct remotealias_struct * ras = (struct remotealias_struct *) v ;
-	struct remotealias_struct ras_next ;
-	pthread_t thread;
-	int threadbad = 0;
-	
-	// set up for next server connection
-	ras_next.cin = NextServer(ras->cin->next) ;
-	if ( ras_next.cin == NO_CONNECTION ) {
-		threadbad = 1 ;
-	} else {
-		ras_next.pin = ras->pin ;
-		ras_next.pn = ras->pn ;
-		ras_next.bus_nr = INDEX_BAD ;
-		memset( ras_next.sn, 0, SERIAL_NUMBER_SIZE) ;
-		threadbad = pthread_create(&thread, DEFAULT_THREAD_ATTR, RemoteAlias_callback_conn, (void *) (&ras_next)) ;
-	}
-	
-	// Result for this server connection (while next one is processing)
+
 	ras->bus_nr = ServerAlias( ras->sn, ras->cin, ras->pn ) ;
-	
-	if (threadbad == 0) {		/* was a thread created? */
-		if (pthread_join(thread, NULL)==0) {
-			// Set answer to the next bus if it's found
-			// else use current answer
-			if ( INDEX_VALID(ras_next.bus_nr) ) {
-				ras->bus_nr = ras_next.bus_nr ;
-				memcpy( ras->sn, ras_next.sn, SERIAL_NUMBER_SIZE ) ;
-			}
-		}
+	if ( INDEX_VALID( ras->bus_nr ) ) {
+		// found -- don't ask the other servers
+		Task_Cancel( ras->tg ) ;
 	}
-	return VOID_RETURN ;
 }
 
-static void * RemoteAlias_callback_port(void * v)
+INDEX_OR_ERROR RemoteAlias(struct parsedname *pn)
 {
-	struct remotealias_struct * ras = (struct remotealias_struct *) v ;
-	struct remotealias_struct ras_next ;
-	pthread_t thread;
-	int threadbad = 0;
-	
-	// set up for next server connection
-	ras_next.pin = ras->pin->next ;
-	if ( ras_next.pin == NULL ) {
-		threadbad = 1 ;
-	} else {
-		ras_next.pn = ras->pn ;
-		ras_next.bus_nr = INDEX_BAD ;
-		memset( ras_next.sn, 0, SERIAL_NUMBER_SIZE) ;
-		threadbad = pthread_create(&thread, DEFAULT_THREAD_ATTR, RemoteAlias_callback_port, (void *) (&ras_next)) ;
+	struct task_group tg ;
+	struct remotealias_struct * ras = NULL ;
+	struct port_in * pin ;
+	struct connection_in * cin ;
+	INDEX_OR_ERROR bus_nr = INDEX_BAD ;
+	BYTE sn[SERIAL_NUMBER_SIZE] ;
+	int count = 0 ;
+	int i ;
+
+	memset( sn, 0, SERIAL_NUMBER_SIZE) ;
+
+	// one task per owserver connection
+	for ( pin = Inbound_Control.head_port ; pin != NULL ; pin = pin->next ) {
+		for ( cin = NextServer( pin->first ) ; cin != NO_CONNECTION ; cin = NextServer( cin->next ) ) {
+			++count ;
+		}
 	}
-	
-	ras->cin = NextServer( ras->pin->first ) ;
-	if ( ras->cin != NO_CONNECTION ) {
-		RemoteAlias_callback_conn(v) ;
+	if ( count > 0 ) {
+		ras = owcalloc( count, sizeof( struct remotealias_struct ) ) ;
 	}
-	
-	if (threadbad == 0) {		/* was a thread created? */
-		if (pthread_join(thread, NULL)==0) {
-			// Set answer to the next bus if it's found
-			// else use current answer
-			if ( INDEX_VALID(ras_next.bus_nr) ) {
-				ras->bus_nr = ras_next.bus_nr ;
-				memcpy( ras->sn, ras_next.sn, SERIAL_NUMBER_SIZE ) ;
+	if ( ras != NULL ) {
+		Task_Group_Init( &tg, fanout_alias ) ;
+		i = 0 ;
+		for ( pin = Inbound_Control.head_port ; pin != NULL ; pin = pin->next ) {
+			for ( cin = NextServer( pin->first ) ; cin != NO_CONNECTION && i < count ; cin = NextServer( cin->next ) ) {
+				ras[i].tg = &tg ;
+				ras[i].cin = cin ;
+				ras[i].pn = pn ;
+				ras[i].bus_nr = INDEX_BAD ;
+				Task_Add( &tg, RemoteAlias_task, &ras[i] ) ;
+				++i ;
 			}
 		}
-	}
-	return VOID_RETURN ;
-}
+		Task_Wait( &tg ) ;
 
-INDEX_OR_ERROR RemoteAlias(struct parsedname *pn)
-{
-	struct remotealias_struct ras ; 
-	
-	ras.pin = Inbound_Control.head_port ;
-	ras.pn = pn ;
-	ras.bus_nr = INDEX_BAD ;
-	memset( ras.sn, 0, SERIAL_NUMBER_SIZE) ;
-
-	if ( ras.pin != NULL ) {
-		RemoteAlias_callback_port( (void *) (&ras) ) ;
+		for ( i = 0 ; i < count ; ++i ) {
+			if ( INDEX_VALID( ras[i].bus_nr ) ) {
+				bus_nr = ras[i].bus_nr ;
+				memcpy( sn, ras[i].sn, SERIAL_NUMBER_SIZE ) ;
+				break ;
+			}
+		}
+		owfree( ras ) ;
 	}
 	
-	memcpy( pn->sn, ras.sn, SERIAL_NUMBER_SIZE ) ;
+	memcpy( pn->sn, sn, SERIAL_NUMBER_SIZE ) ;
 
-	if ( INDEX_VALID( ras.bus_nr ) ) {
-		LEVEL_DEBUG("Remote alias for %s bus=%d "SNformat,pn->path_to_server,ras.bus_nr,SNvar(ras.sn));
+	if ( INDEX_VALID( bus_nr ) ) {
+		LEVEL_DEBUG("Remote alias for %s bus=%d "SNformat,pn->path_to_server,bus_nr,SNvar(sn));
 	} else {
 		LEVEL_DEBUG("Remote alias for %s not found",pn->path_to_server);
 	}
-	return ras.bus_nr;		
+	return bus_nr;		
 }
@@ -103,6 +103,8 @@ GOOD_OR_BAD Server_detect(struct port_in *pin)
 // actual connections opened and closed independently
 static void Server_close(struct connection_in *in)
 {
+	ServerPipelineClose(in) ;
+	ServerPoolClose(in) ;
 	SAFEFREE(in->master.server.type) ;
 	SAFEFREE(in->master.server.domain) ;
 	SAFEFREE(in->master.server.name) ;
@@ -42,12 +42,58 @@ static ZERO_OR_ERROR Directory_Element( char * current_file, struct directory_el
 static void Close_Persistent( struct server_connection_state * scs) ;
 static void Release_Persistent( struct server_connection_state * scs, int granted ) ;
 
+/* Pool of persistent connections to an owserver (non-pipelined requests) */
+/* At most Globals.server_pool connections are open, idle ones are reused */
+struct server_pool {
+	pthread_mutex_t mutex ;
+	pthread_cond_t cond ; // a connection was returned or closed
+	int open ; // persistent connections open (idle and in use)
+	int idle ; // entries in idle_fd
+	FILE_DESCRIPTOR_OR_ERROR * idle_fd ; // most recently used last
+	time_t * idle_since ;
+} ;
+
+#define POOLLOCK(pool)     _MUTEX_LOCK(   (pool)->mutex )
+#define POOLUNLOCK(pool)   _MUTEX_UNLOCK( (pool)->mutex )
+
+static struct server_pool * Pool_Find( struct connection_in * in ) ;
+static FILE_DESCRIPTOR_OR_ERROR Pool_Get( struct server_connection_state * scs ) ;
+static GOOD_OR_BAD Pool_Healthy( FILE_DESCRIPTOR_OR_ERROR file_descriptor ) ;
+
 static GOOD_OR_BAD To_Server( struct server_connection_state * scs, struct server_msg * sm, struct serverpackage *sp) ;
-static SIZE_OR_ERROR WriteToServer(int file_descriptor, struct server_msg *sm, struct serverpackage *sp);
+static SIZE_OR_ERROR WriteToServer(int file_descriptor, struct server_msg *sm, struct serverpackage *sp, uint32_t * request_id);
 
 static SIZE_OR_ERROR From_Server( struct server_connection_state * scs, struct client_msg *cm, char *msg, size_t size) ;
 static void *From_ServerAlloc(struct server_connection_state * scs, struct client_msg *cm) ;
 
+/* Pipelined connection to an owserver -- many requests outstanding on one socket */
+/* Responses are matched by request id and may arrive in any order */
+struct pipeline_wait {
+	uint32_t request_id ;
+	int done ;
+	struct client_msg cm ;
+	BYTE * payload ; // allocated, caller frees
+	struct pipeline_wait * next ;
+} ;
+
+struct server_pipeline {
+	FILE_DESCRIPTOR_OR_ERROR file_descriptor ;
+	pthread_mutex_t mutex ; // socket writes, wait list and reader role
+	pthread_cond_t cond ; // a response was delivered or the reader role is free
+	uint32_t next_id ;
+	int reader ; // one waiting thread reads the socket for everyone
+	int broken ; // socket failed, close once the reader lets go
+	struct pipeline_wait * waiting ;
+} ;
+
+#define PIPELINELOCK(pipe)     _MUTEX_LOCK(   (pipe)->mutex )
+#define PIPELINEUNLOCK(pipe)   _MUTEX_UNLOCK( (pipe)->mutex )
+
+static GOOD_OR_BAD Pipeline_Available( struct connection_in * in ) ;
+static void Pipeline_Fail( struct server_pipeline * pipe ) ;
+static GOOD_OR_BAD Pipeline_ReadFrame( FILE_DESCRIPTOR_OR_ERROR file_descriptor, struct client_msg * cm, uint32_t * request_id, BYTE ** payload ) ;
+static GOOD_OR_BAD Pipeline_Transaction( struct connection_in * in, struct server_msg * sm, struct serverpackage * sp, struct client_msg * cm, BYTE ** payload ) ;
+
 
 // Send to an owserver using the READ message
 SIZE_OR_ERROR ServerRead(struct one_wire_query *owq)
@@ -78,6 +124,20 @@ SIZE_OR_ERROR ServerRead(struct one_wire_query *owq)
 
 	// Send to owserver
 	sm.control_flags = SetupControlFlags(pn_file_entry);
+
+	// Pipelined connection if the owserver supports it
+	if ( GOOD( Pipeline_Available( scs.in ) ) ) {
+		BYTE * payload ;
+		if ( GOOD( Pipeline_Transaction( scs.in, &sm, &sp, &cm, &payload ) ) ) {
+			if ( payload != NULL ) {
+				memcpy( OWQ_buffer(owq), payload, cm.payload < (ssize_t) OWQ_size(owq) ? (size_t) cm.payload : OWQ_size(owq) ) ;
+				owfree( payload ) ;
+			}
+			return cm.ret;
+		}
+		// else fall back to a connection of our own
+	}
+
 	if ( BAD( To_Server( &scs, &sm, &sp) ) ) {
 		Release_Persistent( &scs, 0);
 		return -EIO ;
@@ -113,6 +173,21 @@ INDEX_OR_ERROR ServerPresence( struct parsedname *pn_file_entry)
 
 	// Send to owserver
 	sm.control_flags = SetupControlFlags( pn_file_entry);
+
+	// Pipelined connection if the owserver supports it
+	if ( GOOD( Pipeline_Available( scs.in ) ) ) {
+		if ( GOOD( Pipeline_Transaction( scs.in, &sm, &sp, &cm, &serial_number ) ) ) {
+			if ( serial_number != NULL ) {
+				if ( cm.ret >= 0 && cm.payload >= SERIAL_NUMBER_SIZE ) {
+					memcpy( pn_file_entry->sn, serial_number, SERIAL_NUMBER_SIZE ) ;
+				}
+				owfree( serial_number ) ;
+			}
+			return INDEX_VALID(cm.ret) ? pn_file_entry->selected_connection->index : INDEX_BAD;
+		}
+		// else fall back to a connection of our own
+	}
+
 	if ( BAD( To_Server( &scs, &sm, &sp) ) ) {
 		Release_Persistent( &scs, 0 ) ;
 		return INDEX_BAD ;
@@ -158,6 +233,19 @@ ZERO_OR_ERROR ServerWrite(struct one_wire_query *owq)
 
 	// Send to owserver
 	sm.control_flags = SetupControlFlags( pn_file_entry);
+
+	// Pipelined connection if the owserver supports it
+	if ( GOOD( Pipeline_Available( scs.in ) ) ) {
+		BYTE * payload ;
+		if ( GOOD( Pipeline_Transaction( scs.in, &sm, &sp, &cm, &payload ) ) ) {
+			SAFEFREE( payload ) ;
+			scs.persistence = persistent_no ;
+			scs.file_descriptor = FILE_DESCRIPTOR_BAD ;
+			goto CONTROL_FLAGS ;
+		}
+		// else fall back to a connection of our own
+	}
+
 	if ( BAD( To_Server( &scs, &sm, &sp) ) ) {
 		Release_Persistent( &scs, 0 ) ;
 		return -EIO ;
@@ -168,6 +256,8 @@ ZERO_OR_ERROR ServerWrite(struct one_wire_query *owq)
 		Release_Persistent( &scs, 0 ) ;
 		return -EIO ;
 	}
+
+CONTROL_FLAGS:
 	{
 		int32_t control_flags = cm.control_flags & ~(SHOULD_RETURN_BUS_LIST | PERSISTENT_MASK | SAFEMODE);
 		// keep current safemode
@@ -295,13 +385,21 @@ static ZERO_OR_ERROR ServerDIRALL(void (*dirfunc) (void *, const struct parsedna
 
 	// Send to owserver
 	sm.control_flags = SetupControlFlags( pn_whole_directory);
-	if ( BAD( To_Server( &scs, &sm, &sp) ) ) {
-		Release_Persistent( &scs, 0 ) ;
-		return -EIO ;
-	}
 
-	// Receive from owserver
-	comma_separated_list = From_ServerAlloc(&scs, &cm);
+	// Pipelined connection if the owserver supports it
+	if ( GOOD( Pipeline_Available( in ) ) && GOOD( Pipeline_Transaction( in, &sm, &sp, &cm, (BYTE **) &comma_separated_list ) ) ) {
+		// no connection of our own to release
+		scs.persistence = persistent_no ;
+		scs.file_descriptor = FILE_DESCRIPTOR_BAD ;
+	} else {
+		if ( BAD( To_Server( &scs, &sm, &sp) ) ) {
+			Release_Persistent( &scs, 0 ) ;
+			return -EIO ;
+		}
+
+		// Receive from owserver
+		comma_separated_list = From_ServerAlloc(&scs, &cm);
+	}
 	LEVEL_DEBUG("got %s", SAFESTRING(comma_separated_list));
 	if (cm.ret == 0) {
 		ASCII *current_file;
@@ -359,6 +457,7 @@ static void Directory_Element_Finish( struct directory_element_structure * des )
 {
 	/* Add to the cache (full list as a single element */
 	if ( DirblobPure( &(des->db) ) ) {
+		DirblobFreeze( &(des->db) ) ; // shared with the cache
 		Cache_Add_Dir( &(des->db), des->pn_whole_directory);	// end with a null entry
 		if (RootNotBranch(des->pn_whole_directory)) {
 			BUSLOCK(des->pn_whole_directory);
@@ -437,6 +536,7 @@ static void *From_ServerAlloc(struct server_connection_state * scs, struct clien
 			cm->ret = -EIO;
 			return NO_PATH;
 		}
+		cm->version = ntohl(cm->version);
 		cm->payload = ntohl(cm->payload);
 		cm->size = ntohl(cm->size);
 		cm->ret = ntohl(cm->ret);
@@ -488,6 +588,7 @@ static SIZE_OR_ERROR From_Server( struct server_connection_state * scs, struct c
 			return -EIO;
 		}
 
+		cm->version = ntohl(cm->version);
 		cm->payload = ntohl(cm->payload);
 		cm->size = ntohl(cm->size);
 		cm->ret = ntohl(cm->ret);
@@ -515,11 +616,6 @@ static SIZE_OR_ERROR From_Server( struct server_connection_state * scs, struct c
 static GOOD_OR_BAD To_Server( struct server_connection_state * scs, struct server_msg * sm, struct serverpackage *sp)
 {
 	struct connection_in * in = scs->in ; // for convenience
-	struct port_in * pin = in->pown ;
-	BYTE test_read[1] ;
-	int old_flags ;
-	ssize_t rcv_value ;
-	int saved_errno ;
 	
 	// initialize the variables
 	scs->file_descriptor = FILE_DESCRIPTOR_BAD ;
@@ -530,68 +626,8 @@ static GOOD_OR_BAD To_Server( struct server_connection_state * scs, struct serve
 		// no persistence wanted
 		scs->file_descriptor = ClientConnect(in);
 	} else {
-		// Persistence desired
-		BUSLOCKIN(in);
-		switch ( pin->file_descriptor ) {
-			case FILE_DESCRIPTOR_PERSISTENT_IN_USE:
-				// Currently in use, so make new non-persistent connection
-				scs->file_descriptor = ClientConnect(in);
-				scs->persistence = persistent_no ;
-				break ;
-			case FILE_DESCRIPTOR_BAD:
-				// no conection currently, so make a new one
-				scs->file_descriptor = ClientConnect(in);
-				if ( FILE_DESCRIPTOR_VALID( scs->file_descriptor ) ) {
-					pin->file_descriptor = FILE_DESCRIPTOR_PERSISTENT_IN_USE ;
-				}	
-				break ;
-			default:
-				// persistent connection idle and waiting for use
-				// connection_in is locked so this is safe
-				scs->file_descriptor = pin->file_descriptor;
-				pin->file_descriptor = FILE_DESCRIPTOR_PERSISTENT_IN_USE;
-			break ;
-		}
-		BUSUNLOCKIN(in);
-	}
-	
-	// Check if the server closed the connection
-	// This is contributed by Jacob Joseph to fix a timeout problem.
-	// http://permalink.gmane.org/gmane.comp.file-systems.owfs.devel/7306
-	//rcv_value = recv(scs->file_descriptor, test_read, 1, MSG_DONTWAIT | MSG_PEEK) ;
-	old_flags = fcntl( scs->file_descriptor, F_GETFL, 0 ) ; // save socket flags
-	if ( old_flags == -1 ) {
-		rcv_value = -2 ;
-	} else if ( fcntl( scs->file_descriptor, F_SETFL, old_flags | O_NONBLOCK ) == -1 ) { // set non-blocking
-		rcv_value = -2 ;
-	} else {
-		rcv_value = recv(scs->file_descriptor, test_read, 1, MSG_PEEK) ; // test read the socket to see if closed
-		saved_errno = errno ;
-		if ( fcntl( scs->file_descriptor, F_SETFL, old_flags ) == -1 ) { // restore  socket flags
-			rcv_value = -2 ;
-		}
-	}
-
-	switch ( rcv_value ) {
-		case -1:
-			if ( saved_errno==EAGAIN || saved_errno==EWOULDBLOCK ) {
-				// No data to be read -- so connection healthy
-				break ;
-			}
-			// real error, fall through to close connection case
-		case -2:
-			// fnctl error, fall through again
-		case 0:
-			LEVEL_DEBUG("Server connection was closed.  Reconnecting.");
-			Close_Persistent( scs);
-			scs->file_descriptor = ClientConnect(in);
-			if ( FILE_DESCRIPTOR_VALID( scs->file_descriptor ) ) {
-				in->pown->file_descriptor = FILE_DESCRIPTOR_PERSISTENT_IN_USE ;
-			}
-			break ;
-		default:
-			// data to be read, so a good connection
-			break ;
+		// Persistence desired -- from the pool (may fall back to non-persistent)
+		scs->file_descriptor = Pool_Get( scs ) ;
 	}
 
 	// Now test
@@ -602,7 +638,7 @@ static GOOD_OR_BAD To_Server( struct server_connection_state * scs, struct serve
 	}
 
 	// Do the real work
-	if (WriteToServer(scs->file_descriptor, sm, sp) >= 0) {
+	if (WriteToServer(scs->file_descriptor, sm, sp, NULL) >= 0) {
 		// successful message
 		return gbGOOD;
 	}
@@ -615,7 +651,8 @@ static GOOD_OR_BAD To_Server( struct server_connection_state * scs, struct serve
 	}
 	
 	// perhaps the persistent connection is stale?
-	// Make a new one
+	// Make a new one (it keeps the pool place of the old one)
+	Test_and_Close( &(scs->file_descriptor) ) ;
 	scs->file_descriptor = ClientConnect(in) ;
 
 	// Now retest
@@ -626,10 +663,8 @@ static GOOD_OR_BAD To_Server( struct server_connection_state * scs, struct serve
 		return gbBAD ;
 	}
 	
-	// Leave in->file_descriptor = FILE_DESCRIPTOR_PERSISTENT_IN_USE
-
 	// Second attempt at the write, now with new connection
-	if (WriteToServer(scs->file_descriptor, sm, sp) >= 0) {
+	if (WriteToServer(scs->file_descriptor, sm, sp, NULL) >= 0) {
 		// successful message
 		return gbGOOD;
 	}
@@ -643,10 +678,13 @@ static void Close_Persistent( struct server_connection_state * scs)
 {
 	// First set up the file descriptor based on persistent state
 	if (scs->persistence == persistent_yes) {
-		// no persistence wanted
-		BUSLOCKIN(scs->in);
-			scs->in->pown->file_descriptor = FILE_DESCRIPTOR_BAD ;
-		BUSUNLOCKIN(scs->in);
+		// give up its place in the pool
+		struct server_pool * pool = scs->in->master.server.pool ;
+		POOLLOCK(pool) ;
+		--pool->open ;
+		STAT_SUB(server_pool_open,1) ;
+		my_pthread_cond_signal( &(pool->cond) ) ;
+		POOLUNLOCK(pool) ;
 	}
 	
 	scs->persistence = persistent_no ;
@@ -654,7 +692,8 @@ static void Close_Persistent( struct server_connection_state * scs)
 }
 
 // should be const char * data but iovec has problems with const arguments
-static SIZE_OR_ERROR WriteToServer(int file_descriptor, struct server_msg *sm, struct serverpackage *sp)
+// request_id is only for pipelined connections (else NULL)
+static SIZE_OR_ERROR WriteToServer(int file_descriptor, struct server_msg *sm, struct serverpackage *sp, uint32_t * request_id)
 {
 	int payload = 0;
 	int tokens = 0;
@@ -662,9 +701,11 @@ static SIZE_OR_ERROR WriteToServer(int file_descriptor, struct server_msg *sm, s
 
 	// We use vector write -- several ranges
 	int nio = 0;
-	struct iovec io[5] = { {NULL, 0}, {NULL, 0}, {NULL, 0}, {NULL, 0}, {NULL, 0}, };
+	struct iovec io[6] = { {NULL, 0}, {NULL, 0}, {NULL, 0}, {NULL, 0}, {NULL, 0}, {NULL, 0}, };
 
 	struct server_msg net_sm ;
+	uint32_t net_request_id ;
+	size_t id_length = 0 ;
 
 	// Set the version
 	sm->version = MakeServerprotocol(OWSERVER_PROTOCOL_VERSION);
@@ -673,6 +714,15 @@ static SIZE_OR_ERROR WriteToServer(int file_descriptor, struct server_msg *sm, s
 	// We'll do this last since the header values (e.g. payload) change
 	nio++;
 
+	// Pipelined -- request id right after the header
+	if ( request_id != NULL ) {
+		sm->version |= MakeServerprotocol(OWSERVER_PROTOCOL_PIPELINE);
+		net_request_id = htonl( *request_id ) ;
+		io[nio].iov_base = &net_request_id ;
+		io[nio].iov_len = id_length = sizeof(uint32_t) ;
+		nio++;
+	}
+
 	// Next block, the path
 	if (sp->path != 0) {	// send path (if not null)
 		// writev should take const data pointers, but I can't fix the library
@@ -747,6 +797,10 @@ static SIZE_OR_ERROR WriteToServer(int file_descriptor, struct server_msg *sm, s
 		int traffic_counter ;
 		traffic_counter = 0 ;
 		TrafficOutFD("write header" ,io[traffic_counter].iov_base,io[traffic_counter].iov_len,file_descriptor);
+		if ( request_id != NULL ) {
+			++traffic_counter;
+			TrafficOutFD("write request id" ,io[traffic_counter].iov_base,io[traffic_counter].iov_len,file_descriptor);
+		}
 		++traffic_counter;
 		TrafficOutFD("write path"  ,io[traffic_counter].iov_base,io[traffic_counter].iov_len,file_descriptor);
 		if ((sp->datasize>0) && (sp->data!=NULL)) {	// send data only for writes (if datasize not zero)
@@ -765,7 +819,290 @@ static SIZE_OR_ERROR WriteToServer(int file_descriptor, struct server_msg *sm, s
 	// End traffic display code
 
 	// Actual write of data to owserver
-	return writev(file_descriptor, io, nio) != (ssize_t) (payload + sizeof(struct server_msg) + tokens * sizeof(struct antiloop));
+	return writev(file_descriptor, io, nio) != (ssize_t) (payload + sizeof(struct server_msg) + id_length + tokens * sizeof(struct antiloop));
+}
+
+/* Can requests to this owserver be pipelined?
+   First use asks with a msg_nop -- newer owservers set the pipeline protocol bit in the reply */
+static GOOD_OR_BAD Pipeline_Available( struct connection_in * in )
+{
+	struct server_pipeline * pipe ;
+
+	if ( Globals.no_pipeline || Globals.no_persistence ) {
+		return gbBAD ;
+	}
+
+	switch ( in->master.server.pipeline ) {
+		case server_pipeline_yes:
+			return gbGOOD ;
+		case server_pipeline_no:
+			return gbBAD ;
+		case server_pipeline_unknown:
+		default:
+			break ;
+	}
+
+	// Ask the server (on an ordinary connection)
+	{
+		struct server_msg sm;
+		struct client_msg cm;
+		struct serverpackage sp = { NULL, NULL, 0, NULL, 0, };
+		struct server_connection_state scs ;
+
+		scs.in = in ;
+		memset(&sm, 0, sizeof(struct server_msg));
+		memset(&cm, 0, sizeof(struct client_msg));
+		sm.type = msg_nop;
+		sm.control_flags = PERSISTENT_MASK ;
+
+		if ( BAD( To_Server( &scs, &sm, &sp) ) ) {
+			Release_Persistent( &scs, 0 ) ;
+			return gbBAD ; // try again next time
+		}
+		if ( From_Server( &scs, &cm, NULL, 0) < 0 ) {
+			Release_Persistent( &scs, 0 ) ;
+			return gbBAD ; // try again next time
+		}
+		Release_Persistent( &scs, cm.control_flags & PERSISTENT_MASK ) ;
+
+		if ( ! isServerpipeline( cm.version ) ) {
+			LEVEL_DEBUG("Server %s doesn't accept pipelined requests", SAFESTRING(DEVICENAME(in)) ) ;
+			in->master.server.pipeline = server_pipeline_no ;
+			return gbBAD ;
+		}
+	}
+
+	pipe = owcalloc( 1, sizeof(struct server_pipeline) ) ;
+	if ( pipe == NULL ) {
+		return gbBAD ;
+	}
+	pipe->file_descriptor = FILE_DESCRIPTOR_BAD ;
+	_MUTEX_INIT( pipe->mutex ) ;
+	my_pthread_cond_init( &(pipe->cond), NULL ) ;
+
+	BUSLOCKIN(in);
+	if ( in->master.server.pipe == NULL ) {
+		in->master.server.pipe = pipe ;
+		pipe = NULL ;
+	}
+	in->master.server.pipeline = server_pipeline_yes ;
+	BUSUNLOCKIN(in);
+
+	if ( pipe != NULL ) {
+		// another thread got there first
+		my_pthread_cond_destroy( &(pipe->cond) ) ;
+		_MUTEX_DESTROY( pipe->mutex ) ;
+		owfree( pipe ) ;
+	}
+	LEVEL_DEBUG("Server %s accepts pipelined requests", SAFESTRING(DEVICENAME(in)) ) ;
+	return gbGOOD ;
+}
+
+/* Socket problem -- every waiting request fails */
+/* Called with PIPELINELOCK */
+static void Pipeline_Fail( struct server_pipeline * pipe )
+{
+	struct pipeline_wait * w ;
+
+	for ( w = pipe->waiting ; w != NULL ; w = w->next ) {
+		w->done = -1 ;
+	}
+	pipe->waiting = NULL ;
+
+	if ( FILE_DESCRIPTOR_VALID( pipe->file_descriptor ) ) {
+		if ( pipe->reader ) {
+			// wake the reader, it closes the socket
+			shutdown( pipe->file_descriptor, SHUT_RDWR ) ;
+			pipe->broken = 1 ;
+		} else {
+			Test_and_Close( &(pipe->file_descriptor) ) ;
+			pipe->broken = 0 ;
+		}
+	}
+	my_pthread_cond_broadcast( &(pipe->cond) ) ;
+}
+
+/* Read one response (header, request id, payload) -- pings have a negative payload */
+static GOOD_OR_BAD Pipeline_ReadFrame( FILE_DESCRIPTOR_OR_ERROR file_descriptor, struct client_msg * cm, uint32_t * request_id, BYTE ** payload )
+{
+	struct timeval tv = { Globals.timeout_network + 1, 0, };
+	size_t actual_size ;
+
+	*payload = NULL ;
+
+	tcp_read(file_descriptor, (BYTE *) cm, sizeof(struct client_msg), &tv, &actual_size);
+	if (actual_size != sizeof(struct client_msg)) {
+		return gbBAD ;
+	}
+	cm->version = ntohl(cm->version);
+	cm->payload = ntohl(cm->payload);
+	cm->size = ntohl(cm->size);
+	cm->ret = ntohl(cm->ret);
+	cm->control_flags = ntohl(cm->control_flags);
+	cm->offset = ntohl(cm->offset);
+
+	if ( ! isServerpipeline( cm->version ) ) {
+		LEVEL_DEBUG("Response without request id on a pipelined connection");
+		return gbBAD ;
+	}
+	tcp_read(file_descriptor, (BYTE *) request_id, sizeof(uint32_t), &tv, &actual_size);
+	if (actual_size != sizeof(uint32_t)) {
+		return gbBAD ;
+	}
+	*request_id = ntohl( *request_id ) ;
+
+	if ( cm->payload <= 0 ) {
+		// no data (or a ping)
+		return gbGOOD ;
+	}
+	if ( cm->payload > MAX_OWSERVER_PROTOCOL_PAYLOAD_SIZE ) {
+		return gbBAD ;
+	}
+
+	*payload = owmalloc( (size_t) cm->payload + 1 ) ;
+	if ( *payload == NULL ) {
+		return gbBAD ;
+	}
+	tcp_read(file_descriptor, *payload, (size_t) cm->payload, &tv, &actual_size);
+	if ( (ssize_t) actual_size != cm->payload ) {
+		owfree( *payload ) ;
+		*payload = NULL ;
+		return gbBAD ;
+	}
+	(*payload)[cm->payload] = '\0' ; // safety NULL
+	return gbGOOD ;
+}
+
+/* Send a request on the shared connection and wait for its response
+   Whoever is waiting reads the socket and hands responses to their owners
+   gbBAD means the request never reached the server -- use an ordinary connection instead
+   A request lost after it was sent may already have been acted on (a write),
+   so it is not sent again: it gets an -EIO response and the caller decides */
+static GOOD_OR_BAD Pipeline_Transaction( struct connection_in * in, struct server_msg * sm, struct serverpackage * sp, struct client_msg * cm, BYTE ** payload )
+{
+	struct server_pipeline * pipe = in->master.server.pipe ;
+	struct pipeline_wait w ;
+	int written = 1 ;
+
+	memset( &w, 0, sizeof(struct pipeline_wait) ) ;
+	*payload = NULL ;
+
+	PIPELINELOCK(pipe) ;
+	if ( pipe->broken ) {
+		PIPELINEUNLOCK(pipe) ;
+		return gbBAD ;
+	}
+	if ( FILE_DESCRIPTOR_NOT_VALID( pipe->file_descriptor ) ) {
+		pipe->file_descriptor = ClientConnect(in) ;
+		if ( FILE_DESCRIPTOR_NOT_VALID( pipe->file_descriptor ) ) {
+			PIPELINEUNLOCK(pipe) ;
+			STAT_ADD1(in->reconnect_state);
+			return gbBAD ;
+		}
+	}
+
+	w.request_id = ++pipe->next_id ;
+	w.next = pipe->waiting ;
+	pipe->waiting = &w ;
+
+	if ( WriteToServer( pipe->file_descriptor, sm, sp, &w.request_id ) != 0 ) {
+		// not (completely) sent, so the server can't have acted on it
+		LEVEL_DEBUG("Cannot send pipelined request");
+		written = 0 ;
+		Pipeline_Fail( pipe ) ;
+	}
+
+	while ( w.done == 0 ) {
+		FILE_DESCRIPTOR_OR_ERROR file_descriptor = pipe->file_descriptor ;
+		struct client_msg frame_cm ;
+		uint32_t request_id ;
+		BYTE * frame_payload ;
+		GOOD_OR_BAD frame ;
+		struct pipeline_wait ** pw ;
+
+		if ( pipe->reader ) {
+			// someone else is reading, they'll hand over our response
+			my_pthread_cond_wait( &(pipe->cond), &(pipe->mutex) ) ;
+			continue ;
+		}
+
+		// take the reader role
+		pipe->reader = 1 ;
+		PIPELINEUNLOCK(pipe) ;
+		frame = Pipeline_ReadFrame( file_descriptor, &frame_cm, &request_id, &frame_payload ) ;
+		PIPELINELOCK(pipe) ;
+		pipe->reader = 0 ;
+
+		if ( pipe->broken ) {
+			// failed while we were reading
+			SAFEFREE( frame_payload ) ;
+			Test_and_Close( &(pipe->file_descriptor) ) ;
+			pipe->broken = 0 ;
+		} else if ( BAD( frame ) ) {
+			LEVEL_DEBUG("Pipelined connection problem");
+			Pipeline_Fail( pipe ) ;
+		} else if ( frame_cm.payload < 0 ) {
+			// keep-alive ping, keep waiting
+			LEVEL_DEBUG("Ping for pipelined request id=%u", request_id);
+		} else {
+			// find the owner
+			for ( pw = &(pipe->waiting) ; *pw != NULL ; pw = &((*pw)->next) ) {
+				if ( (*pw)->request_id == request_id ) {
+					struct pipeline_wait * owner = *pw ;
+					*pw = owner->next ;
+					owner->cm = frame_cm ;
+					owner->payload = frame_payload ;
+					owner->done = 1 ;
+					frame_payload = NULL ;
+					break ;
+				}
+			}
+			if ( frame_payload != NULL ) {
+				LEVEL_DEBUG("Response for unknown request id=%u", request_id);
+				owfree( frame_payload ) ;
+			}
+			if ( (frame_cm.control_flags & PERSISTENT_MASK) == 0 ) {
+				// server won't keep the connection open
+				Pipeline_Fail( pipe ) ;
+			}
+		}
+		// let another waiter read
+		my_pthread_cond_broadcast( &(pipe->cond) ) ;
+	}
+	PIPELINEUNLOCK(pipe) ;
+
+	if ( w.done < 0 ) {
+		if ( ! written ) {
+			return gbBAD ;
+		}
+		LEVEL_DEBUG("Pipelined request id=%u lost after it was sent", w.request_id);
+		memset( cm, 0, sizeof(struct client_msg) ) ;
+		cm->ret = -EIO ;
+		// no news from the server -- keep the current flags
+		CONTROLFLAGSLOCK;
+		cm->control_flags = LocalControlFlags ;
+		CONTROLFLAGSUNLOCK;
+		return gbGOOD ;
+	}
+	*cm = w.cm ;
+	*payload = w.payload ;
+	return gbGOOD ;
+}
+
+/* Free the shared connection (connection_in closing) */
+void ServerPipelineClose(struct connection_in *in)
+{
+	struct server_pipeline * pipe = in->master.server.pipe ;
+
+	if ( pipe == NULL ) {
+		return ;
+	}
+	in->master.server.pipe = NULL ;
+	in->master.server.pipeline = server_pipeline_unknown ;
+	Test_and_Close( &(pipe->file_descriptor) ) ;
+	my_pthread_cond_destroy( &(pipe->cond) ) ;
+	_MUTEX_DESTROY( pipe->mutex ) ;
+	owfree( pipe ) ;
 }
 
 /* flag the sg for "virtual root" -- the remote bus was specifically requested */
@@ -811,10 +1148,181 @@ static void Release_Persistent( struct server_connection_state * scs, int grante
 		return ;
 	}
 
-	// mark as available
-	BUSLOCKIN(scs->in);
-	scs->in->pown->file_descriptor = scs->file_descriptor;
-	BUSUNLOCKIN(scs->in);
+	// back in the pool as available
+	{
+		struct server_pool * pool = scs->in->master.server.pool ;
+		POOLLOCK(pool) ;
+		pool->idle_fd[pool->idle] = scs->file_descriptor ;
+		pool->idle_since[pool->idle] = NOW_TIME ;
+		++pool->idle ;
+		STAT_ADD1(server_pool_idle) ;
+		my_pthread_cond_signal( &(pool->cond) ) ;
+		POOLUNLOCK(pool) ;
+	}
 	scs->persistence = persistent_no ; // we no longer own this connection
 	scs->file_descriptor = FILE_DESCRIPTOR_BAD ;
 }
+
+/* Pool for this owserver, created on first use
+ * Adopts the connection opened by Server_detect */
+static struct server_pool * Pool_Find( struct connection_in * in )
+{
+	struct server_pool * pool = in->master.server.pool ;
+	int size = ( Globals.server_pool > 0 ) ? Globals.server_pool : 1 ;
+
+	if ( pool != NULL ) {
+		return pool ;
+	}
+
+	pool = owcalloc( 1, sizeof(struct server_pool) ) ;
+	if ( pool == NULL ) {
+		return NULL ;
+	}
+	pool->idle_fd = owcalloc( size, sizeof(FILE_DESCRIPTOR_OR_ERROR) ) ;
+	pool->idle_since = owcalloc( size, sizeof(time_t) ) ;
+	if ( pool->idle_fd == NULL || pool->idle_since == NULL ) {
+		SAFEFREE( pool->idle_fd ) ;
+		SAFEFREE( pool->idle_since ) ;
+		owfree( pool ) ;
+		return NULL ;
+	}
+	_MUTEX_INIT( pool->mutex ) ;
+	my_pthread_cond_init( &(pool->cond), NULL ) ;
+
+	BUSLOCKIN(in);
+	if ( in->master.server.pool == NULL ) {
+		struct port_in * pin = in->pown ;
+		if ( FILE_DESCRIPTOR_VALID( pin->file_descriptor ) ) {
+			pool->idle_fd[0] = pin->file_descriptor ;
+			pool->idle_since[0] = NOW_TIME ;
+			pool->idle = pool->open = 1 ;
+			STAT_ADD1(server_pool_open) ;
+			STAT_ADD1(server_pool_idle) ;
+			pin->file_descriptor = FILE_DESCRIPTOR_BAD ;
+		}
+		in->master.server.pool = pool ;
+		pool = NULL ;
+	}
+	BUSUNLOCKIN(in);
+
+	if ( pool != NULL ) {
+		// another thread got there first
+		my_pthread_cond_destroy( &(pool->cond) ) ;
+		_MUTEX_DESTROY( pool->mutex ) ;
+		owfree( pool->idle_fd ) ;
+		owfree( pool->idle_since ) ;
+		owfree( pool ) ;
+	}
+	return in->master.server.pool ;
+}
+
+/* Cheap check that the owserver hasn't closed an idle connection
+ * One non-blocking peek, no change of the socket flags */
+static GOOD_OR_BAD Pool_Healthy( FILE_DESCRIPTOR_OR_ERROR file_descriptor )
+{
+	BYTE test_read[1] ;
+	ssize_t rcv_value = recv( file_descriptor, test_read, 1, MSG_PEEK | MSG_DONTWAIT ) ;
+
+	if ( rcv_value < 0 && ( errno == EAGAIN || errno == EWOULDBLOCK ) ) {
+		// nothing to read -- healthy
+		return gbGOOD ;
+	}
+	// closed (0), error, or stray data from an old exchange
+	return gbBAD ;
+}
+
+/* A connection for this request:
+ * a healthy idle one, a new one if the pool has room,
+ * else wait (up to timeout_network) for one to be returned,
+ * else an extra non-persistent connection */
+static FILE_DESCRIPTOR_OR_ERROR Pool_Get( struct server_connection_state * scs )
+{
+	struct connection_in * in = scs->in ;
+	struct server_pool * pool = Pool_Find( in ) ;
+	int size = ( Globals.server_pool > 0 ) ? Globals.server_pool : 1 ;
+	struct timeval now ;
+	struct timespec deadline ;
+	int waited = 0 ;
+
+	if ( pool == NULL ) {
+		scs->persistence = persistent_no ;
+		return ClientConnect(in) ;
+	}
+
+	gettimeofday( &now, NULL ) ;
+	deadline.tv_sec = now.tv_sec + Globals.timeout_network ;
+	deadline.tv_nsec = now.tv_usec * 1000 ;
+
+	POOLLOCK(pool) ;
+	while (1) {
+		// idle connections, most recently used first
+		while ( pool->idle > 0 ) {
+			FILE_DESCRIPTOR_OR_ERROR file_descriptor ;
+			time_t idle_time ;
+
+			--pool->idle ;
+			STAT_SUB(server_pool_idle,1) ;
+			file_descriptor = pool->idle_fd[pool->idle] ;
+			idle_time = NOW_TIME - pool->idle_since[pool->idle] ;
+
+			// the owserver drops persistent connections idle too long
+			if ( idle_time < Globals.timeout_persistent_low && GOOD( Pool_Healthy( file_descriptor ) ) ) {
+				POOLUNLOCK(pool) ;
+				STAT_ADD1(server_pool_reused) ;
+				return file_descriptor ;
+			}
+			LEVEL_DEBUG("Server connection was closed (idle %d seconds). Discard it.", (int) idle_time);
+			STAT_ADD1(server_pool_stale) ;
+			Test_and_Close( &file_descriptor ) ;
+			--pool->open ;
+			STAT_SUB(server_pool_open,1) ;
+		}
+
+		if ( pool->open < size ) {
+			// room for another
+			++pool->open ;
+			STAT_ADD1(server_pool_open) ;
+			POOLUNLOCK(pool) ;
+			STAT_ADD1(server_pool_new) ;
+			return ClientConnect(in) ; // failure handled by caller (Close_Persistent)
+		}
+
+		if ( ! waited ) {
+			waited = 1 ;
+			STAT_ADD1(server_pool_waits) ;
+		}
+		// a timeout is expected here, so not my_pthread_cond_timedwait
+		if ( pthread_cond_timedwait( &(pool->cond), &(pool->mutex), &deadline ) == ETIMEDOUT ) {
+			break ;
+		}
+	}
+	POOLUNLOCK(pool) ;
+
+	// pool exhausted too long -- a connection of our own
+	LEVEL_DEBUG("All %d connections to %s in use. Open an extra one.", size, SAFESTRING(DEVICENAME(in)) ) ;
+	STAT_ADD1(server_pool_timeouts) ;
+	scs->persistence = persistent_no ;
+	return ClientConnect(in) ;
+}
+
+/* Close the idle pooled connections (connection_in closing) */
+void ServerPoolClose(struct connection_in *in)
+{
+	struct server_pool * pool = in->master.server.pool ;
+
+	if ( pool == NULL ) {
+		return ;
+	}
+	in->master.server.pool = NULL ;
+	while ( pool->idle > 0 ) {
+		--pool->idle ;
+		STAT_SUB(server_pool_idle,1) ;
+		STAT_SUB(server_pool_open,1) ;
+		Test_and_Close( &(pool->idle_fd[pool->idle]) ) ;
+	}
+	my_pthread_cond_destroy( &(pool->cond) ) ;
+	_MUTEX_DESTROY( pool->mutex ) ;
+	owfree( pool->idle_fd ) ;
+	owfree( pool->idle_since ) ;
+	owfree( pool ) ;
+}
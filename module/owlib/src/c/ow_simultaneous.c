@@ -98,6 +98,136 @@ GOOD_OR_BAD FS_Test_Simultaneous( const struct internal_prop *ip, UINT delay, co
 	return gbGOOD ;
 }
 
+/* Coalesced temperature conversions
+ * Several clients reading different powered temperature chips on the same bus
+ * at about the same time share a single SKIP_ROM CONVERT_T instead of
+ * converting (and waiting) one device after the other.
+ * The bookkeeping is per connection_in, protected by convert_mutex */
+
+/* msec left of the latest bus-wide conversion for a chip needing "delay"
+ * 0 if none is still running. Call with convert_mutex held */
+static UINT FS_Convert_Remaining( UINT delay, struct connection_in * in )
+{
+	struct timeval now ;
+	struct timeval elapsed ;
+	long elapsed_msec ;
+
+	if ( in->convert_generation == 0 ) {
+		return 0 ; // never converted
+	}
+	timernow( &now ) ;
+	timersub( &now, &(in->convert_start), &elapsed ) ;
+	elapsed_msec = elapsed.tv_sec * 1000 + elapsed.tv_usec / 1000 ;
+	if ( elapsed_msec < 0 || elapsed_msec >= (long) delay ) {
+		return 0 ;
+	}
+	return delay - elapsed_msec ;
+}
+
+/* SKIP_ROM CONVERT_T, but only if every chip on the bus is powered
+ * (a parasitic chip would need the strong pullup and an idle bus)
+ * Call with convert_mutex held */
+static GOOD_OR_BAD FS_Convert_All( const struct parsedname * pn )
+{
+	struct parsedname s_pn_directory;
+	struct parsedname * pn_directory = &s_pn_directory ;
+	struct connection_in * in = pn->selected_connection ;
+
+	const BYTE cmd_temp[] = { _1W_SKIP_ROM, _1W_CONVERT_T };
+	const BYTE cmd_powermode[] = { _1W_SKIP_ROM, _1W_READ_POWERMODE, };
+	BYTE pow[1] ;
+	struct transaction_log tpower[] = {
+		TRXN_START,
+		TRXN_WRITE2(cmd_powermode),
+		TRXN_READ1(pow),
+		TRXN_END,
+	};
+	struct transaction_log tconvert[] = {
+		TRXN_START,
+		TRXN_WRITE2(cmd_temp),
+		TRXN_END,
+	};
+
+	FS_LoadDirectoryOnly(pn_directory, pn);
+
+	BUSLOCK(pn_directory);
+	if ( BAD( BUS_transaction_nolock(tpower, pn_directory) ) || pow[0] == 0 ) {
+		BUSUNLOCK(pn_directory);
+		LEVEL_DEBUG("Parasitic chips on bus -- no shared conversion");
+		return gbBAD ;
+	}
+	// the bus lock is held throughout, so no parasite could have appeared since
+	if ( BAD( BUS_transaction_nolock(tconvert, pn_directory) ) ) {
+		BUSUNLOCK(pn_directory);
+		return gbBAD ;
+	}
+	timernow( &(in->convert_start) ) ;
+	BUSUNLOCK(pn_directory);
+
+	++in->convert_generation ;
+	// Readers relying on the simultaneous cache can use this conversion too
+	Cache_Add_Simul(SlaveSpecificTag(S_T), pn_directory);
+	return gbGOOD ;
+}
+
+/* Enter the temperature conversion for a powered chip
+ * gbGOOD: a bus-wide conversion was shared and has finished
+ * gbOTHER: caller is alone and should convert just its chip,
+ *   then call FS_Convert_Leave with the returned generation
+ * Either way the reader is counted as pending until FS_Convert_Leave
+ * Only for chips on the main line (no DS2409 branches) */
+GOOD_OR_BAD FS_Convert_Join( UINT delay, UINT * generation, const struct parsedname * pn)
+{
+	struct connection_in * in = pn->selected_connection ;
+	UINT remaining ;
+
+	_MUTEX_LOCK( in->convert_mutex ) ;
+	++in->convert_pending ;
+	remaining = FS_Convert_Remaining( delay, in ) ;
+	if ( remaining == 0 && in->convert_pending > 1 ) {
+		// a burst of readers on this bus -- convert them all at once
+		if ( GOOD( FS_Convert_All( pn ) ) ) {
+			LEVEL_DEBUG("Shared temperature conversion for %d readers", in->convert_pending);
+			remaining = delay ;
+		}
+	}
+	generation[0] = in->convert_generation ;
+	_MUTEX_UNLOCK( in->convert_mutex ) ;
+
+	if ( remaining == 0 ) {
+		return gbOTHER ;
+	}
+
+	LEVEL_DEBUG("Wait %d msec for shared temperature conversion", remaining);
+	UT_delay( remaining ) ;
+	FS_Convert_Leave( delay, generation[0], pn ) ;
+	return gbGOOD ;
+}
+
+/* Done converting. If a shared conversion was started meanwhile it restarted
+ * this chip as well, so wait that one out before the scratchpad is read */
+void FS_Convert_Leave( UINT delay, UINT generation, const struct parsedname * pn)
+{
+	struct connection_in * in = pn->selected_connection ;
+
+	while (1) {
+		UINT remaining ;
+
+		_MUTEX_LOCK( in->convert_mutex ) ;
+		remaining = ( in->convert_generation == generation ) ? 0 : FS_Convert_Remaining( delay, in ) ;
+		if ( remaining == 0 ) {
+			--in->convert_pending ;
+			_MUTEX_UNLOCK( in->convert_mutex ) ;
+			return ;
+		}
+		generation = in->convert_generation ;
+		_MUTEX_UNLOCK( in->convert_mutex ) ;
+
+		LEVEL_DEBUG("Conversion restarted by a shared one -- wait %d msec", remaining);
+		UT_delay( remaining ) ;
+	}
+}
+
 static ZERO_OR_ERROR FS_w_convert_temp(struct one_wire_query *owq)
 {
 	struct parsedname *pn = PN(owq);
@@ -50,7 +50,9 @@
 /* ---- Globalss ---- */
 /* ----------------- */
 UINT cache_flips = 0;
+UINT cache_reclaims = 0;
 UINT cache_adds = 0;
+UINT parse_cache_hits = 0;
 struct average old_avg = { 0L, 0L, 0L, 0L, };
 struct average new_avg = { 0L, 0L, 0L, 0L, };
 struct average store_avg = { 0L, 0L, 0L, 0L, };
@@ -67,6 +69,7 @@ UINT read_cachebytes = 0;
 UINT read_array = 0;
 UINT read_tries[3] = { 0, 0, 0, };
 UINT read_success = 0;
+UINT read_shared = 0;
 struct average read_avg = { 0L, 0L, 0L, 0L, };
 
 UINT write_calls = 0;
@@ -76,6 +79,20 @@ UINT write_tries[3] = { 0, 0, 0, };
 UINT write_success = 0;
 struct average write_avg = { 0L, 0L, 0L, 0L, };
 
+UINT server_pool_open = 0;
+UINT server_pool_idle = 0;
+UINT server_pool_reused = 0;
+UINT server_pool_new = 0;
+UINT server_pool_stale = 0;
+UINT server_pool_waits = 0;
+UINT server_pool_timeouts = 0;
+
+UINT fanout_threads = 0;
+UINT fanout_idle = 0;
+UINT fanout_tasks = 0;
+UINT fanout_skipped = 0;
+UINT fanout_latency[fanout_kinds][FANOUT_BUCKETS];
+
 struct directory dir_main = { 0L, 0L, };
 struct directory dir_dev = { 0L, 0L, };
 UINT dir_depth = 0;
@@ -132,6 +149,8 @@ READ_FUNCTION(FS_return_code);
 static struct filetype stats_cache[] = {
 	{"flips", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&cache_flips}, },
 	{"additions", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&cache_adds}, },
+	{"reclaimed", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&cache_reclaims}, },
+	{"parsed_paths", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&parse_cache_hits}, },
 
 	{"primary", PROPERTY_LENGTH_SUBDIR, NON_AGGREGATE, ft_subdir, fc_subdir, NO_READ_FUNCTION, NO_WRITE_FUNCTION, VISIBLE, NO_FILETYPE_DATA, },
 	{"primary/now", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&new_avg.current}, },
@@ -192,6 +211,7 @@ static struct filetype stats_read[] = {
 	{"success", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&read_success}, },
 	{"bytes", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&read_bytes}, },
 	{"tries", PROPERTY_LENGTH_UNSIGNED, &Aread, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&read_tries}, },
+	{"shared", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&read_shared}, },
 };
 
 struct device d_stats_read = { "read", "read", 0, COUNT_OF_FILETYPES(stats_read), stats_read, NO_GENERIC_READ, NO_GENERIC_WRITE };
@@ -205,6 +225,33 @@ static struct filetype stats_write[] = {
 
 struct device d_stats_write = { "write", "write", 0, COUNT_OF_FILETYPES(stats_write), stats_write, NO_GENERIC_READ, NO_GENERIC_WRITE };
 
+static struct filetype stats_server[] = {
+	{"pool_open", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&server_pool_open}, },
+	{"pool_idle", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&server_pool_idle}, },
+	{"reused", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&server_pool_reused}, },
+	{"new", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&server_pool_new}, },
+	{"stale", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&server_pool_stale}, },
+	{"waits", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&server_pool_waits}, },
+	{"wait_timeouts", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&server_pool_timeouts}, },
+};
+
+struct device d_stats_server = { "server", "server", 0, COUNT_OF_FILETYPES(stats_server), stats_server, NO_GENERIC_READ, NO_GENERIC_WRITE };
+
+// latency buckets: <1ms <10ms <100ms <1s <10s longer
+static struct aggregate Afanout = { FANOUT_BUCKETS, ag_numbers, ag_separate, };
+static struct filetype stats_fanout[] = {
+	{"threads", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&fanout_threads}, },
+	{"idle", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&fanout_idle}, },
+	{"tasks", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&fanout_tasks}, },
+	{"skipped", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&fanout_skipped}, },
+	{"directory", PROPERTY_LENGTH_UNSIGNED, &Afanout, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&fanout_latency[fanout_directory]}, },
+	{"presence", PROPERTY_LENGTH_UNSIGNED, &Afanout, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&fanout_latency[fanout_presence]}, },
+	{"simultaneous", PROPERTY_LENGTH_UNSIGNED, &Afanout, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&fanout_latency[fanout_simultaneous]}, },
+	{"alias", PROPERTY_LENGTH_UNSIGNED, &Afanout, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&fanout_latency[fanout_alias]}, },
+};
+
+struct device d_stats_fanout = { "fanout", "fanout", 0, COUNT_OF_FILETYPES(stats_fanout), stats_fanout, NO_GENERIC_READ, NO_GENERIC_WRITE };
+
 static struct filetype stats_directory[] = {
 	{"maxdepth", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_stat, NO_WRITE_FUNCTION, VISIBLE, {.v=&dir_depth}, },
 
@@ -311,6 +358,79 @@ struct device d_stats_errors = {
 
 /* ------- Functions ------------ */
 
+/* Average counters are a "current" level with running sum/count and peak */
+/* Each field is updated on its own, so a reader may see them momentarily out of step */
+#if HAVE_SYNC_FETCH_AND_ADD
+void StatMax(UINT * max, UINT value)
+{
+	UINT old_max = *max ;
+	while ( value > old_max ) {
+		UINT seen = __sync_val_compare_and_swap( max, old_max, value ) ;
+		if ( seen == old_max ) {
+			break ;
+		}
+		old_max = seen ;
+	}
+}
+
+void StatAverageIn(struct average *a)
+{
+	UINT current = __sync_add_and_fetch( &(a->current), 1 ) ;
+	STAT_ADD1( a->count ) ;
+	STAT_ADD( a->sum, current ) ;
+	StatMax( &(a->max), current ) ;
+}
+
+void StatAverageOut(struct average *a)
+{
+	STAT_SUB( a->current, 1 ) ;
+}
+
+void StatAverageMark(struct average *a)
+{
+	STAT_ADD1( a->count ) ;
+	STAT_ADD( a->sum, STAT_READ( a->current ) ) ;
+}
+
+#else							/* HAVE_SYNC_FETCH_AND_ADD */
+void StatMax(UINT * max, UINT value)
+{
+	STATLOCK;
+	if ( value > *max ) {
+		*max = value ;
+	}
+	STATUNLOCK;
+}
+
+void StatAverageIn(struct average *a)
+{
+	STATLOCK;
+	++a->current;
+	++a->count;
+	a->sum += a->current;
+	if (a->current > a->max) {
+		++a->max;
+	}
+	STATUNLOCK;
+}
+
+void StatAverageOut(struct average *a)
+{
+	STATLOCK;
+	--a->current;
+	STATUNLOCK;
+}
+
+void StatAverageMark(struct average *a)
+{
+	STATLOCK;
+	++a->count;
+	a->sum += a->current;
+	STATUNLOCK;
+}
+#endif							/* HAVE_SYNC_FETCH_AND_ADD */
+
+
 static ZERO_OR_ERROR FS_stat(struct one_wire_query *owq)
 {
 	struct parsedname *pn = PN(owq);
@@ -324,9 +444,7 @@ static ZERO_OR_ERROR FS_stat(struct one_wire_query *owq)
 	if (pn->selected_filetype->data.v == NULL) {
 		return -ENOENT;
 	}
-	STATLOCK;
-	OWQ_U(owq) = ((UINT *) pn->selected_filetype->data.v)[dindex];
-	STATUNLOCK;
+	OWQ_U(owq) = STAT_READ( ((UINT *) pn->selected_filetype->data.v)[dindex] );
 	return 0;
 }
 
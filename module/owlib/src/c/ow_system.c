@@ -56,8 +56,11 @@ READ_FUNCTION(FS_out);
 READ_FUNCTION(FS_define);
 READ_FUNCTION(FS_trim);
 READ_FUNCTION(FS_version);
+READ_FUNCTION(FS_registry_sequence);
+READ_FUNCTION(FS_registry_events);
 
 #define VERSION_LENGTH 20
+#define REGISTRY_EVENTS_LENGTH 4096
 
 /* -------- Structures ---------- */
 /* special entry -- picked off by parsing before filetypes tried */
@@ -93,6 +96,16 @@ struct device d_sys_configure = { "configuration", "configuration", ePN_system,
 	sys_configure, NO_GENERIC_READ, NO_GENERIC_WRITE
 };
 
+/* device registry changes, see ow_registry.c */
+static struct filetype sys_registry[] = {
+	{"sequence", PROPERTY_LENGTH_UNSIGNED, NON_AGGREGATE, ft_unsigned, fc_statistic, FS_registry_sequence, NO_WRITE_FUNCTION, VISIBLE, NO_FILETYPE_DATA, },
+	{"events", REGISTRY_EVENTS_LENGTH, NON_AGGREGATE, ft_vascii, fc_statistic, FS_registry_events, NO_WRITE_FUNCTION, VISIBLE, NO_FILETYPE_DATA, },
+};
+struct device d_sys_registry = { "registry", "registry", ePN_system,
+	COUNT_OF_FILETYPES(sys_registry),
+	sys_registry, NO_GENERIC_READ, NO_GENERIC_WRITE
+};
+
 /* ------- Functions ------------ */
 
 static ZERO_OR_ERROR FS_pidfile(struct one_wire_query *owq)
@@ -141,3 +154,16 @@ static ZERO_OR_ERROR FS_define(struct one_wire_query *owq)
 	OWQ_Y(owq) = OWQ_pn(owq).selected_filetype->data.i;
 	return 0;
 }
+
+static ZERO_OR_ERROR FS_registry_sequence(struct one_wire_query *owq)
+{
+	OWQ_U(owq) = Registry_Sequence();
+	return 0;
+}
+
+static ZERO_OR_ERROR FS_registry_events(struct one_wire_query *owq)
+{
+	char events[REGISTRY_EVENTS_LENGTH+1] ;
+	Registry_Events( events, REGISTRY_EVENTS_LENGTH+1 ) ;
+	return OWQ_format_output_offset_and_size_z(events, owq);
+}
@@ -0,0 +1,263 @@
+/*
+    OWFS -- One-Wire filesystem
+    OWHTTPD -- One-Wire Web Server
+    Written 2003 Paul H Alfille
+    email: paul.alfille@gmail.com
+    Released under the GPL
+    See the header file: ow.h for full attribution
+    1wire/iButton system from Dallas Semiconductor
+*/
+
+/* Task pool for requests spread over all the buses
+ * (root directory, presence search, simultaneous writes, remote alias)
+ * Instead of a new thread per port or channel for each request,
+ * the tasks go to a queue served by long-lived threads
+ * (up to --fanout_threads, started as needed and kept until LibStop).
+ *
+ *   Task_Group_Init( &tg, fanout_presence ) ;
+ *   Task_Add( &tg, function, argument ) ; ... once per bus
+ *   Task_Wait( &tg ) ;
+ *
+ * Task_Wait runs queued tasks of its own group itself, so a fan-out
+ * started from inside a task (or with every thread busy) still finishes.
+ * Task_Cancel drops the tasks not yet started -- the first bus to find
+ * a device ends the search. Running tasks are always waited for.
+ * The time of each fan-out is kept in /statistics/fanout
+ * */
+
+#include <config.h>
+#include "owfs_config.h"
+#include "ow.h"
+#include "ow_counters.h"
+
+struct task {
+	struct task * next ;
+	struct task_group * group ;
+	void (*run) (void *) ;
+	void * v ;
+} ;
+
+// pool threads, joined by Task_Stop
+struct task_thread {
+	struct task_thread * next ;
+	pthread_t thread ;
+} ;
+
+// queue, counts and thread list protected by Mutex.task_mutex
+static struct task * task_head = NULL ;
+static struct task * task_tail = NULL ;
+static struct task_thread * task_thread_head = NULL ;
+static int task_threads = 0 ;
+static int task_idle = 0 ;
+static int task_queued = 0 ; // tasks in the queue, not yet taken
+static int task_shutdown = 0 ;
+static pthread_cond_t task_cond = PTHREAD_COND_INITIALIZER ;
+
+#define TASKLOCK    _MUTEX_LOCK(   Mutex.task_mutex )
+#define TASKUNLOCK  _MUTEX_UNLOCK( Mutex.task_mutex )
+
+static void * Task_Thread( void * v ) ;
+static void Task_Done( struct task_group * tg ) ;
+static struct task * Task_Unlink( struct task_group * tg ) ;
+static void Task_Latency( struct task_group * tg ) ;
+
+void Task_Group_Init( struct task_group * tg, enum task_fanout fanout )
+{
+	tg->fanout = fanout ;
+	tg->pending = 0 ;
+	tg->cancelled = 0 ;
+	my_pthread_cond_init( &(tg->done), NULL ) ;
+	timernow( &(tg->start) ) ;
+}
+
+/* Queue run(v) for the pool, starting another thread if none is free */
+void Task_Add( struct task_group * tg, void (*run) (void *), void * v )
+{
+	struct task * t = owmalloc( sizeof( struct task ) ) ;
+
+	if ( t == NULL ) {
+		// no memory, do it here
+		run( v ) ;
+		return ;
+	}
+	t->next = NULL ;
+	t->group = tg ;
+	t->run = run ;
+	t->v = v ;
+
+	TASKLOCK ;
+	if ( tg->cancelled ) {
+		TASKUNLOCK ;
+		owfree( t ) ;
+		STAT_ADD1( fanout_skipped ) ;
+		return ;
+	}
+	if ( task_tail == NULL ) {
+		task_head = t ;
+	} else {
+		task_tail->next = t ;
+	}
+	task_tail = t ;
+	++task_queued ;
+	++tg->pending ;
+	STAT_ADD1( fanout_tasks ) ;
+
+	// signalled idle threads still count as idle until they run,
+	// so a burst needs more threads once the queue outgrows them
+	if ( task_queued > task_idle && task_threads < Globals.fanout_threads && ! task_shutdown ) {
+		struct task_thread * tt = owmalloc( sizeof( struct task_thread ) ) ;
+		if ( tt != NULL && pthread_create( &(tt->thread), DEFAULT_THREAD_ATTR, Task_Thread, NULL ) == 0 ) {
+			tt->next = task_thread_head ;
+			task_thread_head = tt ;
+			++task_threads ;
+			STAT_ADD1( fanout_threads ) ;
+		} else {
+			// Task_Wait will run it
+			SAFEFREE( tt ) ;
+			ERROR_DEBUG("Cannot start a fanout thread (%d running)", task_threads ) ;
+		}
+	}
+	my_pthread_cond_signal( &task_cond ) ;
+	TASKUNLOCK ;
+}
+
+/* Skip the tasks of this group not yet started */
+void Task_Cancel( struct task_group * tg )
+{
+	struct task * t ;
+
+	TASKLOCK ;
+	tg->cancelled = 1 ;
+	while ( (t = Task_Unlink( tg )) != NULL ) {
+		owfree( t ) ;
+		STAT_ADD1( fanout_skipped ) ;
+		Task_Done( tg ) ;
+	}
+	TASKUNLOCK ;
+}
+
+/* Wait for (and help with) all the tasks of the group, then close it */
+void Task_Wait( struct task_group * tg )
+{
+	TASKLOCK ;
+	while ( tg->pending > 0 ) {
+		struct task * t = Task_Unlink( tg ) ;
+		if ( t == NULL ) {
+			// all started elsewhere
+			my_pthread_cond_wait( &(tg->done), &(Mutex.task_mutex) ) ;
+			continue ;
+		}
+		TASKUNLOCK ;
+		t->run( t->v ) ;
+		owfree( t ) ;
+		TASKLOCK ;
+		Task_Done( tg ) ;
+	}
+	TASKUNLOCK ;
+
+	my_pthread_cond_destroy( &(tg->done) ) ;
+	Task_Latency( tg ) ;
+}
+
+/* Stop the pool threads and wait for them
+ * Queued tasks are finished first (Task_Wait would run them anyway)
+ * Called from LibStop */
+void Task_Stop( void )
+{
+	struct task_thread * tt ;
+
+	TASKLOCK ;
+	task_shutdown = 1 ;
+	my_pthread_cond_broadcast( &task_cond ) ;
+	tt = task_thread_head ;
+	task_thread_head = NULL ;
+	TASKUNLOCK ;
+
+	while ( tt != NULL ) {
+		struct task_thread * next = tt->next ;
+		pthread_join( tt->thread, NULL ) ;
+		owfree( tt ) ;
+		tt = next ;
+	}
+
+	// ready for another LibStart
+	TASKLOCK ;
+	task_threads = 0 ;
+	task_shutdown = 0 ;
+	TASKUNLOCK ;
+}
+
+/* Called locked: first queued task of the group (or any if tg is NULL) */
+static struct task * Task_Unlink( struct task_group * tg )
+{
+	struct task ** link ;
+	struct task * previous = NULL ;
+
+	for ( link = &task_head ; *link != NULL ; link = &((*link)->next) ) {
+		struct task * t = *link ;
+		if ( tg == NULL || t->group == tg ) {
+			*link = t->next ;
+			if ( task_tail == t ) {
+				task_tail = previous ;
+			}
+			--task_queued ;
+			return t ;
+		}
+		previous = t ;
+	}
+	return NULL ;
+}
+
+/* Called locked */
+static void Task_Done( struct task_group * tg )
+{
+	if ( --tg->pending == 0 ) {
+		my_pthread_cond_signal( &(tg->done) ) ;
+	}
+}
+
+static void * Task_Thread( void * v )
+{
+	(void) v ;
+
+	TASKLOCK ;
+	while ( 1 ) {
+		struct task * t = Task_Unlink( NULL ) ;
+		if ( t == NULL ) {
+			if ( task_shutdown ) {
+				break ;
+			}
+			++task_idle ;
+			STAT_ADD1( fanout_idle ) ;
+			my_pthread_cond_wait( &task_cond, &(Mutex.task_mutex) ) ;
+			--task_idle ;
+			STAT_SUB( fanout_idle, 1 ) ;
+			continue ;
+		}
+		// a cancelled group has nothing left in the queue
+		TASKUNLOCK ;
+		t->run( t->v ) ;
+		TASKLOCK ;
+		Task_Done( t->group ) ;
+		owfree( t ) ;
+	}
+	TASKUNLOCK ;
+	return VOID_RETURN ;
+}
+
+static void Task_Latency( struct task_group * tg )
+{
+	struct timeval now ;
+	struct timeval elapsed ;
+	long milliseconds ;
+	int bucket ;
+
+	timernow( &now ) ;
+	timersub( &now, &(tg->start), &elapsed ) ;
+	milliseconds = elapsed.tv_sec * 1000 + elapsed.tv_usec / 1000 ;
+
+	for ( bucket = 0 ; bucket < FANOUT_BUCKETS - 1 && milliseconds >= 1 ; ++bucket ) {
+		milliseconds /= 10 ;
+	}
+	STAT_ADD1( fanout_latency[tg->fanout][bucket] ) ;
+}
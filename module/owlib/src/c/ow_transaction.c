@@ -32,6 +32,8 @@ struct transaction_bundle {
 
 // static int BUS_transaction_length( const struct transaction_log * tl, const struct parsedname * pn ) ;
 static GOOD_OR_BAD BUS_transaction_single(const struct transaction_log *t, const struct parsedname *pn);
+static const struct transaction_log * BUS_transaction_release_point(const struct transaction_log *tl);
+static GOOD_OR_BAD BUS_transaction_segment(const struct transaction_log *tl, const struct parsedname *pn);
 
 static GOOD_OR_BAD Bundle_pack(const struct transaction_log *tl, const struct parsedname *pn);
 static GOOD_OR_BAD Pack_item(const struct transaction_log *tl, struct transaction_bundle *tb);
@@ -46,22 +48,65 @@ static void Bundle_init(struct transaction_bundle *tb, const struct parsedname *
 /* Bus transaction */
 /* Encapsulates communication with a device, including locking the bus, reset and selection */
 /* Then a series of bytes is sent and returned, including sending data and reading the return data */
+/* At each trxn_release the bus is unlocked for the delay, so other queued transactions can run */
 GOOD_OR_BAD BUS_transaction(const struct transaction_log *tl, const struct parsedname *pn)
 {
 	GOOD_OR_BAD ret ;
+	const struct transaction_log *t = tl;
 
 	if (tl == NULL) {
 		return gbGOOD;
 	}
 	BUSLOCK(pn);
-	ret = BUS_transaction_nolock(tl, pn);
+	ret = BUS_transaction_segment(t, pn);
+	while ( GOOD(ret) && (t = BUS_transaction_release_point(t)) != NULL ) {
+		BUSUNLOCK(pn);
+		LEVEL_DEBUG("Bus released for %d msec", (int) t->size);
+		if (t->size > 0) {
+			UT_delay(t->size);
+		}
+		BUSLOCK(pn);
+		++t;
+		ret = BUS_transaction_segment(t, pn);
+	}
 	BUSUNLOCK(pn);
 
 	return ret;
 }
 
+/* Find the release point ending this segment, NULL if the segment ends the transaction */
+static const struct transaction_log * BUS_transaction_release_point(const struct transaction_log *tl)
+{
+	const struct transaction_log *t;
+
+	for (t = tl; t->type != trxn_end; ++t) {
+		if (t->type == trxn_release) {
+			return t;
+		}
+	}
+	return NULL;
+}
+
 /* A few sequences start with teh bus already locked */
+/* The caller holds the bus, so a trxn_release is just a delay here */
 GOOD_OR_BAD BUS_transaction_nolock(const struct transaction_log *tl, const struct parsedname *pn)
+{
+	const struct transaction_log *t = tl;
+	GOOD_OR_BAD ret = BUS_transaction_segment(t, pn);
+
+	while ( GOOD(ret) && (t = BUS_transaction_release_point(t)) != NULL ) {
+		LEVEL_DEBUG("Bus kept locked, delay %d msec", (int) t->size);
+		if (t->size > 0) {
+			UT_delay(t->size);
+		}
+		++t;
+		ret = BUS_transaction_segment(t, pn);
+	}
+	return ret;
+}
+
+/* Runs up to the end or the first trxn_release, bus already locked */
+static GOOD_OR_BAD BUS_transaction_segment(const struct transaction_log *tl, const struct parsedname *pn)
 {
 	const struct transaction_log *t = tl;
 	GOOD_OR_BAD ret = gbGOOD;
@@ -207,6 +252,9 @@ static GOOD_OR_BAD BUS_transaction_single(const struct transaction_log *t, const
 	case trxn_end:
 		LEVEL_DEBUG("end = %d", ret);
 		return gbOTHER;			// special "end" flag
+	case trxn_release:
+		LEVEL_DEBUG("release = %d", ret);
+		return gbOTHER;			// end of this locked segment
 	case trxn_verify:
 		{
 			struct parsedname pn2;
@@ -245,7 +293,7 @@ static GOOD_OR_BAD Bundle_pack(const struct transaction_log *tl, const struct pa
 
 	Bundle_init(tb, pn);
 
-	for (t_index = tl; t_index->type != trxn_end; ++t_index) {
+	for (t_index = tl; t_index->type != trxn_end && t_index->type != trxn_release; ++t_index) {
 		switch (Pack_item(t_index, tb)) {
 		case gbGOOD:
 			LEVEL_DEBUG("Item added");
@@ -375,8 +423,9 @@ static GOOD_OR_BAD Pack_item(const struct transaction_log *tl, struct transactio
 		break;
 	case trxn_reset:
 	case trxn_end:
+	case trxn_release:
 	case trxn_verify:
-		LEVEL_DEBUG("pack=RESET END VERIFY");
+		LEVEL_DEBUG("pack=RESET END RELEASE VERIFY");
 		return gbBAD;
 	case trxn_nop:
 		LEVEL_DEBUG("pack=NOP");
@@ -471,9 +520,10 @@ static GOOD_OR_BAD Bundle_unpack(struct transaction_bundle *tb)
 			break;
 		case trxn_reset:
 		case trxn_end:
+		case trxn_release:
 		case trxn_verify:
 			// should never get here
-			LEVEL_DEBUG("unpacking #%d RESET END VERIFY", packet_index);
+			LEVEL_DEBUG("unpacking #%d RESET END RELEASE VERIFY", packet_index);
 			ret = gbBAD;
 			break;
 		case trxn_nop:
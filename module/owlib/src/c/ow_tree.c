@@ -174,7 +174,9 @@ void DeviceSort(void)
 	Device2Tree( & d_stats_cache,          ePN_statistics);
 	Device2Tree( & d_stats_directory,      ePN_statistics);
 	Device2Tree( & d_stats_errors,         ePN_statistics);
+	Device2Tree( & d_stats_fanout,         ePN_statistics);
 	Device2Tree( & d_stats_read,           ePN_statistics);
+	Device2Tree( & d_stats_server,         ePN_statistics);
 	Device2Tree( & d_stats_thread,         ePN_statistics);
 	Device2Tree( & d_stats_write,          ePN_statistics);
 	Device2Tree( & d_stats_return_code,    ePN_statistics);
@@ -187,6 +189,7 @@ void DeviceSort(void)
 	Device2Tree( & d_sys_process,          ePN_system);
 	Device2Tree( & d_sys_connections,      ePN_system);
 	Device2Tree( & d_sys_configure,        ePN_system);
+	Device2Tree( & d_sys_registry,         ePN_system);
 
 	Device2Tree( & d_interface_settings,   ePN_interface);
 	Device2Tree( & d_interface_statistics, ePN_interface);
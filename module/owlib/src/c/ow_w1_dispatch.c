@@ -88,10 +88,11 @@ static void Dispatch_Packet( struct netlink_parse * nlp)
 		Dispatch_Packet_root( nlp ) ;
 	} else {
 		// non-root w1 message -- individual bus master messages
+		int reader ;
 		LEVEL_DEBUG("Netlink message directed to W1 bus master %d",bus);
-		CONNIN_RLOCK ;
+		reader = Connection_Read_Begin() ;
 		Dispatch_Packet_nonroot( nlp ) ;
-		CONNIN_RUNLOCK ;
+		Connection_Read_End( reader ) ;
 	}
 }
 
@@ -100,7 +101,7 @@ static void Dispatch_Packet_root( struct netlink_parse * nlp)
 {
 	// root w1 master message -- add and remove
 
-	/* Need to run the add/remove in a separate thread so that netlink messages can still be parsed and CONNIN_RLOCK won't deadlock */
+	/* Need to run the add/remove in a separate thread so that netlink messages can still be parsed while the bus list change waits for readers */
 	pthread_t thread ;
 
 	// make a copy for the new thread (which we will have to destroy)
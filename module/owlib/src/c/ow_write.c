@@ -96,15 +96,12 @@ SIZE_OR_ERROR FS_write_postparse(struct one_wire_query *owq)
 		return -EISDIR;			// not a file
 	}
 
-	STATLOCK;
 	AVERAGE_IN(&write_avg);
 	AVERAGE_IN(&all_avg);
-	++write_calls;				/* statistics */
-	STATUNLOCK;
+	STAT_ADD1(write_calls);				/* statistics */
 
 	write_or_error = FS_write_post_stats( owq ) ;
 
-	STATLOCK;
 	// write_or_error is still ZERO_OR_ERROR mode
 	if ( write_or_error == 0 ) {
 		LEVEL_DEBUG("Successful write to %s",pn->path) ;
@@ -112,14 +109,13 @@ SIZE_OR_ERROR FS_write_postparse(struct one_wire_query *owq)
 		LEVEL_DEBUG("Error writing to %s",pn->path) ;
 	}
 	if (write_or_error == 0) {
-		++write_success;		/* statistics */
-		write_bytes += OWQ_size(owq);	/* statistics */
+		STAT_ADD1(write_success);		/* statistics */
+		STAT_ADD(write_bytes, OWQ_size(owq));	/* statistics */
 		// write_or_error now SIZE_OR_ERROR mode
 		write_or_error = OWQ_size(owq);	/* here's where the size is used! */
 	}
 	AVERAGE_OUT(&write_avg);
 	AVERAGE_OUT(&all_avg);
-	STATUNLOCK;
 
 	return write_or_error;
 }
@@ -269,68 +265,17 @@ static ZERO_OR_ERROR FS_write_real(int depth, struct one_wire_query *owq)
 }
 
 struct simultaneous_struct {
-	struct port_in * pin ;
 	struct connection_in * cin;
 	struct one_wire_query owq ;
 };
 
-static void * Simultaneous_write_callback_conn(void * v)
+static void Simultaneous_write_task(void * v)
 {
 	struct simultaneous_struct *ss = (struct simultaneous_struct *) v;
-	struct simultaneous_struct ss_next ;
-	pthread_t thread;
-	int threadbad = 0;
-	
-	if ( ss->cin == NULL ) {
-		return VOID_RETURN;
-	}
-	
-	ss_next.cin = ss->cin->next ;
-	if ( ss_next.cin == NO_CONNECTION ) {
-		threadbad = 1 ;
-	} else {
-		ss_next.pin = ss->pin ;
-		memcpy( &(ss_next.owq), &(ss->owq), sizeof(struct one_wire_query));	// shallow copy
-		threadbad = pthread_create(&thread, DEFAULT_THREAD_ATTR, Simultaneous_write_callback_conn, (void *) (&ss_next)) ;
-	}
-	
+
 	SetKnownBus(ss->cin->index, PN( &(ss->owq)) );
 	
 	FS_w_given_bus( &(ss->owq) );
-
-	if (threadbad == 0) {		/* was a thread created? */
-		pthread_join(thread, NULL) ;
-	}
-	return VOID_RETURN ;
-}
-
-static void * Simultaneous_write_callback_port(void * v)
-{
-	struct simultaneous_struct *ss = (struct simultaneous_struct *) v;
-	struct simultaneous_struct ss_next ;
-	pthread_t thread;
-	int threadbad = 0;
-
-	if ( ss->pin == NULL ) {
-		return VOID_RETURN;
-	}
-	
-	ss_next.pin = ss->pin->next ;
-	if ( ss_next.pin == NULL ) {
-		threadbad = 1 ;
-	} else {
-		memcpy( &(ss_next.owq), &(ss->owq), sizeof(struct one_wire_query));	// shallow copy
-		threadbad = pthread_create(&thread, DEFAULT_THREAD_ATTR, Simultaneous_write_callback_port, (void *) (&ss_next)) ;
-	}
-	
-	ss->cin = ss->pin->first ;
-	
-	Simultaneous_write_callback_conn(v) ;
-
-	if (threadbad == 0) {		/* was a thread created? */
-		pthread_join(thread, NULL) ;
-	}
-	return VOID_RETURN ;
 }
 
 /* This function is only used by "Simultaneous" */
@@ -339,10 +284,39 @@ static ZERO_OR_ERROR FS_w_simultaneous(struct one_wire_query *owq)
 	if (SpecifiedBus(PN(owq))) {
 		return FS_w_given_bus(owq);
 	} else {
-		struct simultaneous_struct ss ;
-		ss.pin = Inbound_Control.head_port ; 
-		memcpy( &(ss.owq), owq, sizeof(struct one_wire_query));	// shallow copy
-		Simultaneous_write_callback_port( (void *) (&ss) ) ;
+		// every connection at once (fan-out task pool)
+		struct task_group tg ;
+		struct simultaneous_struct * ss ;
+		struct port_in * pin ;
+		struct connection_in * cin ;
+		int count = 0 ;
+		int i ;
+
+		for ( pin = Inbound_Control.head_port ; pin != NULL ; pin = pin->next ) {
+			for ( cin = pin->first ; cin != NO_CONNECTION ; cin = cin->next ) {
+				++count ;
+			}
+		}
+		if ( count == 0 ) {
+			return 0 ;
+		}
+		ss = owcalloc( count, sizeof( struct simultaneous_struct ) ) ;
+		if ( ss == NULL ) {
+			return -ENOMEM ;
+		}
+
+		Task_Group_Init( &tg, fanout_simultaneous ) ;
+		i = 0 ;
+		for ( pin = Inbound_Control.head_port ; pin != NULL ; pin = pin->next ) {
+			for ( cin = pin->first ; cin != NO_CONNECTION && i < count ; cin = cin->next ) {
+				ss[i].cin = cin ;
+				memcpy( &(ss[i].owq), owq, sizeof(struct one_wire_query));	// shallow copy
+				Task_Add( &tg, Simultaneous_write_task, &ss[i] ) ;
+				++i ;
+			}
+		}
+		Task_Wait( &tg ) ;
+		owfree( ss ) ;
 	}
 	return 0;
 }
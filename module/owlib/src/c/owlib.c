@@ -52,9 +52,24 @@ GOOD_OR_BAD LibStart(void* v)
 		LEVEL_DEFAULT("No valid 1-wire buses found");
 		return gbBAD ;
 	}
+
+	// owfs forks later (fuse_daemonize) and starts them from its init callback
+	if ( Globals.program_type != program_type_filesystem ) {
+		LibStartThreads() ;
+	}
 	return gbGOOD ;
 }
 
+/* Start the threads that keep running in the background
+ * Must be after any fork, threads don't survive it */
+void LibStartThreads(void)
+{
+	// Keep the --poll properties fresh in the cache
+	Poll_Start() ;
+	// and the --registry device lists
+	Registry_Start() ;
+}
+
 // only changes FAKE and MOCK temp limits
 // do it here after options are parsed to allow correction forr temperature scale
 static void SetupTemperatureLimits( void )
@@ -225,13 +240,13 @@ static GOOD_OR_BAD SetupSingleInboundConnection( struct port_in * pin )
 		}
 		break;
 
-	case bus_pbm:
-		if ( BAD( PBM_detect(pin) )) {
-			LEVEL_CONNECT("Cannot open PBM bus master at %s", DEVICENAME(in));
-			return gbBAD ;
-		}
-		break;
-
+	case bus_pbm:
+		if ( BAD( PBM_detect(pin) )) {
+			LEVEL_CONNECT("Cannot open PBM bus master at %s", DEVICENAME(in));
+			return gbBAD ;
+		}
+		break;
+
 	case bus_etherweather:
 		if ( BAD( EtherWeather_detect(pin) )) {
 			LEVEL_CONNECT("Cannot detect an EtherWeather server on %s", DEVICENAME(in));
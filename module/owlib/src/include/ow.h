@@ -277,6 +277,15 @@ time_t timegm(struct tm *tm);
 // regular expressions
 #include "ow_regex.h"
 
+// requests spread over all the buses
+#include "ow_taskpool.h"
+
+// epoll loop for the servers' event mode
+#include "ow_event.h"
+
+// property handles (owcapi)
+#include "ow_handle.h"
+
 /* Special checks for config file changes -- OS specific */
  #ifdef HAVE_SYS_EVENT_H
   /* BSD and OSX */
@@ -206,6 +206,10 @@ void Del_InFlight( GOOD_OR_BAD (*nomatch)(struct port_in * trial,struct port_in
 struct connection_in *find_connection_in(int nr);
 int SetKnownBus( int bus_number, struct parsedname * pn) ;
 
+int Connection_Read_Begin( void ) ;
+void Connection_Read_End( int reader ) ;
+void Connection_Synchronize( void ) ;
+
 struct connection_out *NewOut(void);
 
 /* Bonjour registration */
@@ -217,6 +221,6 @@ GOOD_OR_BAD TestConnection(const struct parsedname *pn);
 void ZeroAdd(const char * name, const char * type, const char * domain, const char * host, const char * service) ;
 void ZeroDel(const char * name, const char * type, const char * domain ) ;
 
-#define STAT_ADD1_BUS( err, in )     STATLOCK; ++((in)->bus_stat[err]) ; STATUNLOCK
+#define STAT_ADD1_BUS( err, in )     STAT_ADD1( (in)->bus_stat[err] )
 
 #endif							/* OW_CONNECTION_H */
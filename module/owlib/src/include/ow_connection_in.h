@@ -114,6 +114,9 @@ enum e_bus_stat {
 	e_bus_select_errors,
 	e_bus_try_overdrive,
 	e_bus_failed_overdrive,
+	e_bus_queue_depth, // owfs requests waiting for this bus
+	e_bus_queue_max,
+	e_bus_queued,
 	e_bus_stat_last_marker
 };
 
@@ -124,6 +127,7 @@ struct connection_in {
 	struct connection_in *next;
 	struct port_in * pown ; // pointer to port_in that owns us.
 	INDEX_OR_ERROR index; // general index number across all ports
+	UINT instance; // tells this bus from a later one with the same index (or address)
 	int channel ; // index (0-based) in this port's channels
 	
 	// Formerly Serial / tcp / telnet / i2c abstraction
@@ -135,10 +139,17 @@ struct connection_in {
 	void *dev_db;				// dev-lock tree
 	enum e_reconnect reconnect_state;
 	struct timeval last_lock;	/* statistics */
+	UINT bus_waiting;			/* threads waiting for the bus lock (see BUS_waiting) */
+
+	/* temperature conversions shared by concurrent readers (see FS_Convert_Join) */
+	pthread_mutex_t convert_mutex;
+	UINT convert_pending;		// readers waiting on a conversion
+	UINT convert_generation;	// bus-wide conversions issued so far
+	struct timeval convert_start;	// start of the latest bus-wide conversion
 
 	UINT bus_stat[e_bus_stat_last_marker];
 
-	struct timeval bus_time;
+	uint64_t bus_time;			/* statistics, microseconds held (STAT_ADD) */
 
 	struct interface_routines iroutines;
 	enum adapter_type Adapter;
@@ -150,6 +161,8 @@ struct connection_in {
 	int ds2404_found;
 	int ProgramAvailable;
 	size_t last_root_devs;
+	struct dirblob registry;		// devices of the last complete root search (see ow_registry.c)
+	time_t registry_time;			// when it was made, 0 for never
 	struct ds2409_hubs branch;		// ds2409 branch currently selected
 			// or the special eBranch_bad and eBranch_cleared
 
@@ -171,11 +184,22 @@ struct connection_in {
 #define flow_first	( (Globals.serial_hardflow) ? flow_hard : flow_none )
 #define flow_second	( (Globals.serial_hardflow) ? flow_none : flow_first )
 
+/* Bus number -> connection, replaced whole when a bus comes or goes
+ * (see ow_connect.c) */
+struct connection_table {
+	struct connection_table * retired ; // replaced, freed once no reader can see it
+	int size ;
+	struct connection_in * in[] ;
+} ;
+
 extern struct inbound_control {
 	int active ; // how many "bus" entries are currently in linked list
 	int next_index ; // increasing sequence number
+	UINT next_instance ; // never reused, unlike the bus index
 	struct port_in * head_port ; // head of a linked list of "bus" entries
 	my_rwlock_t lock; // RW lock of linked list
+	struct connection_table * table ; // current bus index
+	struct connection_table * retired ; // older tables, maybe still being read
 	int next_fake ; // count of fake buses
 	int next_tester ; // count tester buses
 	int next_mock ; // count mock buses
@@ -76,13 +76,36 @@ struct directory {
 	UINT entries;
 };
 
-#define AVERAGE_IN(pA)  ++(pA)->current; ++(pA)->count; (pA)->sum+=(pA)->current; if ((pA)->current>(pA)->max)++(pA)->max;
-#define AVERAGE_OUT(pA) --(pA)->current;
-#define AVERAGE_MARK(pA)  ++(pA)->count; (pA)->sum+=(pA)->current;
-#define AVERAGE_CLEAR(pA)  (pA)->current=0;
+/* Statistics are bumped on every read, write, CRC check and bus unlock.
+   Where the compiler has atomic builtins the counters are updated in place
+   without Mutex.stat_mutex; otherwise fall back to the lock.
+   Readers (ow_stats.c) use STAT_READ */
+#if HAVE_SYNC_FETCH_AND_ADD
+#define STAT_ADD(x,n)   ((void) __sync_fetch_and_add( &(x), (n) ))
+#define STAT_SUB(x,n)   ((void) __sync_fetch_and_sub( &(x), (n) ))
+#define STAT_READ(x)    __sync_fetch_and_add( &(x), 0 )
+#else							/* HAVE_SYNC_FETCH_AND_ADD */
+#define STAT_ADD(x,n)   do { STATLOCK ; (x) += (n) ; STATUNLOCK ; } while (0)
+#define STAT_SUB(x,n)   do { STATLOCK ; (x) -= (n) ; STATUNLOCK ; } while (0)
+#define STAT_READ(x)    (x)
+#endif							/* HAVE_SYNC_FETCH_AND_ADD */
+
+#define STAT_ADD1(x)    STAT_ADD(x,1)
+
+/* average counters -- self-locking, see ow_stats.c */
+void StatAverageIn(struct average *a);
+void StatAverageOut(struct average *a);
+void StatAverageMark(struct average *a);
+void StatMax(UINT * max, UINT value);
+
+#define AVERAGE_IN(pA)     StatAverageIn(pA)
+#define AVERAGE_OUT(pA)    StatAverageOut(pA)
+#define AVERAGE_MARK(pA)   StatAverageMark(pA)
 
 extern UINT cache_flips;
+extern UINT cache_reclaims;
 extern UINT cache_adds;
+extern UINT parse_cache_hits;
 extern struct average new_avg;
 extern struct average old_avg;
 extern struct average store_avg;
@@ -99,6 +122,7 @@ extern UINT read_bytes;
 extern UINT read_array;
 extern UINT read_tries[3];
 extern UINT read_success;
+extern UINT read_shared;
 extern struct average read_avg;
 
 extern UINT write_calls;
@@ -108,6 +132,22 @@ extern UINT write_tries[3];
 extern UINT write_success;
 extern struct average write_avg;
 
+// ow_server_message.c connection pool
+extern UINT server_pool_open;
+extern UINT server_pool_idle;
+extern UINT server_pool_reused;
+extern UINT server_pool_new;
+extern UINT server_pool_stale;
+extern UINT server_pool_waits;
+extern UINT server_pool_timeouts;
+
+// ow_taskpool.c requests spread over all the buses
+extern UINT fanout_threads;
+extern UINT fanout_idle;
+extern UINT fanout_tasks;
+extern UINT fanout_skipped;
+extern UINT fanout_latency[fanout_kinds][FANOUT_BUCKETS];
+
 extern struct directory dir_main;
 extern struct directory dir_dev;
 extern UINT dir_depth;
@@ -151,6 +191,5 @@ extern UINT DS2480_read_read;
 extern UINT DS2480_level_docheck_errors;
 extern UINT DS2480_databit_errors;
 
-#define STAT_ADD1(x)    STATLOCK ; ++x ; STATUNLOCK
 
 #endif							/* OW_COUNTERS_H */
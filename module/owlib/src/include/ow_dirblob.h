@@ -32,11 +32,14 @@
 #ifndef OW_DIRBLOB_H			/* tedious wrapper */
 #define OW_DIRBLOB_H
 
+struct dirblob_snapshot ;
+
 struct dirblob {
 	int troubled;
 	int allocated;
 	int devices;
 	BYTE *snlist;
+	struct dirblob_snapshot *snapshot; // shared read-only list with index, or NULL
 };
 
 void DirblobClear(struct dirblob *db);
@@ -48,5 +51,7 @@ int DirblobAdd(const BYTE * sn, struct dirblob *db);
 int DirblobGet(int dev, BYTE * sn, const struct dirblob *db);
 int DirblobSearch(BYTE * sn, const struct dirblob *db);
 int DirblobRecreate( BYTE * snlist, int size, struct dirblob *db);
+int DirblobFreeze(struct dirblob *db);
+int DirblobShare(struct dirblob *to, const struct dirblob *from);
 
 #endif							/* OW_DIRBLOB_H */
@@ -0,0 +1,83 @@
+/*
+    OW -- One-Wire filesystem
+    version 0.4 7/2/2003
+
+    Written 2003 Paul H Alfille
+    GPL license
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+*/
+
+// Not intended to be stand-alone -- called from ow.h
+#ifndef OW_EVENT_H			/* tedious wrapper */
+#define OW_EVENT_H
+
+#ifdef HAVE_SYS_EPOLL_H
+
+struct event_list ;
+
+/* Timer entry -- on one list at a time */
+struct event_timer {
+	struct event_list * list ;
+	struct event_timer * prev ;
+	struct event_timer * next ;
+	struct timeval deadline ;
+	void * owner ;
+} ;
+
+/* Timer list -- each list has a single wait interval so appending keeps it sorted */
+struct event_list {
+	struct event_timer * head ;
+	struct event_timer * tail ;
+	int unsorted ; // deadlines are moved in place, every entry counts for the wait
+} ;
+
+/* Place in the worker queue */
+struct event_job {
+	struct event_job * next ;
+	void * owner ;
+} ;
+
+/* Event mode of a server (see ow_event.c) */
+struct event_loop {
+	// set by the server before Event_Loop_Start
+	void (*ready) (void * owner) ; // socket is ready -- called with the lock
+	void (*timers) (const struct timeval * now) ; // fire expired timers -- called with the lock
+	void (*work) (void * owner) ; // serve a queued job -- called without the lock
+	struct event_list ** lists ; // timer lists (NULL terminated) for the wait
+
+	pthread_mutex_t mutex ; // protects the loop, and the server's lists and queue
+	pthread_cond_t job_cond ;
+	FILE_DESCRIPTOR_OR_ERROR epoll_fd ;
+	FILE_DESCRIPTOR_OR_ERROR wake_pipe[2] ;
+	struct event_job * job_head ;
+	struct event_job * job_tail ;
+	int shutdown ;
+	int loop_running ;
+	int workers ;
+	pthread_t loop_thread ;
+	pthread_t * worker_thread ;
+} ;
+
+void Event_List_Add( struct event_list * list, struct event_timer * et, int seconds ) ;
+void Event_List_Remove( struct event_timer * et ) ;
+
+GOOD_OR_BAD Event_Loop_Start( struct event_loop * el, int workers ) ;
+void Event_Loop_Stop( struct event_loop * el ) ;
+void Event_Loop_Destroy( struct event_loop * el ) ;
+
+GOOD_OR_BAD Event_Watch( struct event_loop * el, FILE_DESCRIPTOR_OR_ERROR file_descriptor, void * owner ) ;
+GOOD_OR_BAD Event_Rearm( struct event_loop * el, FILE_DESCRIPTOR_OR_ERROR file_descriptor, void * owner ) ;
+void Event_Unwatch( struct event_loop * el, FILE_DESCRIPTOR_OR_ERROR file_descriptor ) ;
+void Event_Queue( struct event_loop * el, struct event_job * job ) ;
+
+#endif							/* HAVE_SYS_EPOLL_H */
+
+#endif							/* OW_EVENT_H */
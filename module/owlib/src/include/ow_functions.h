@@ -51,11 +51,28 @@
 /* Prototypes for owlib.c -- libow overall control */
 void LibSetup(enum enum_program_type op);
 GOOD_OR_BAD LibStart(void * v);
+void LibStartThreads(void);
 void HandleSignals(void);
 void LibStop(void);
 void LibClose(void);
 GOOD_OR_BAD EnterBackground(void);
 
+/* Background poller to keep the cache fresh -- ow_poll.c */
+GOOD_OR_BAD Poll_Add( const char * arg ) ;
+void Poll_Start( void ) ;
+void Poll_Start_Bus( struct connection_in * in ) ;
+void Poll_Stop( void ) ;
+
+/* Per bus device registry and add/remove events -- ow_registry.c */
+void Registry_Update( struct connection_in * in, const struct dirblob * db ) ;
+GOOD_OR_BAD Registry_Get( struct dirblob * db, const struct parsedname * pn ) ;
+GOOD_OR_BAD Registry_Watch( void (*notify) (void * v, INDEX_OR_ERROR bus, const BYTE * sn, int present), void * v ) ;
+UINT Registry_Sequence( void ) ;
+size_t Registry_Events( char * buffer, size_t size ) ;
+void Registry_Start( void ) ;
+void Registry_Start_Bus( struct connection_in * in ) ;
+void Registry_Stop( void ) ;
+
 /* Initial sorting or the device and filetype lists */
 void DeviceSort(void);
 void DeviceDestroy(void);
@@ -68,9 +85,13 @@ ZERO_OR_ERROR FS_ParsedName(const char *fn, struct parsedname *pn);
 ZERO_OR_ERROR FS_ParsedName_BackFromRemote(const char *fn, struct parsedname *pn);
 void FS_ParsedName_destroy(struct parsedname *pn);
 void FS_ParsedName_Placeholder( struct parsedname * pn ) ;
+void Parse_Cache_Open( void ) ;
+void Parse_Cache_Clear( void ) ;
 
 size_t FileLength(const struct parsedname *pn);
 size_t FullFileLength(const struct parsedname *pn);
+size_t ReadLength(const struct parsedname *pn);
+enum value_binary_type ValueBinaryType(const struct parsedname *pn);
 INDEX_OR_ERROR CheckPresence(struct parsedname *pn);
 INDEX_OR_ERROR ReCheckPresence(struct parsedname *pn);
 INDEX_OR_ERROR RemoteAlias(struct parsedname *pn);
@@ -86,6 +107,7 @@ BYTE CRC8seeded(const BYTE * bytes, const size_t length, const UINT seed);
 BYTE CRC8compute(const BYTE * bytes, const size_t length, const UINT seed);
 int CRC16(const BYTE * bytes, const size_t length);
 int CRC16seeded(const BYTE * bytes, const size_t length, const UINT seed);
+UINT CRC16compute(const BYTE * bytes, const size_t length, const UINT seed);
 BYTE char2num(const char *s);
 BYTE string2num(const char *s);
 char num2char(const BYTE n);
@@ -114,11 +136,15 @@ void Init_Pipe( FILE_DESCRIPTOR_OR_ERROR * pipe_fd ) ;
 void FS_LoadDirectoryOnly(struct parsedname *pn_directory, const struct parsedname *pn_original);
 
 GOOD_OR_BAD FS_Test_Simultaneous( const struct internal_prop *ip, UINT delay, const struct parsedname * pn) ;
+GOOD_OR_BAD FS_Convert_Join( UINT delay, UINT * generation, const struct parsedname * pn) ;
+void FS_Convert_Leave( UINT delay, UINT generation, const struct parsedname * pn) ;
 
 // ow_locks.c
 void LockSetup(void);
 ZERO_OR_ERROR DeviceLockGet(struct parsedname *pn);
 void DeviceLockRelease(struct parsedname *pn);
+void DeviceLockHold(struct parsedname *pn);
+void DeviceLockUnhold(struct parsedname *pn);
 
 /* 1-wire lowlevel */
 void UT_delay(const UINT len);
@@ -134,6 +160,7 @@ FILE_DESCRIPTOR_OR_ERROR ClientConnect(struct connection_in *in);
 void FreeClientAddr(struct connection_in *in);
 
 void ServerProcess(void (*HandlerRoutine) (FILE_DESCRIPTOR_OR_ERROR file_descriptor));
+void ServerProcessEvents(void (*AcceptRoutine) (FILE_DESCRIPTOR_OR_ERROR file_descriptor));
 GOOD_OR_BAD ServerOutSetup(struct connection_out *out);
 void InterruptListening( void ) ;
 
@@ -153,6 +180,8 @@ INDEX_OR_ERROR ServerPresence( struct parsedname *pn);
 SIZE_OR_ERROR ServerRead(struct one_wire_query *owq);
 ZERO_OR_ERROR ServerWrite(struct one_wire_query *owq);
 ZERO_OR_ERROR ServerDir(void (*dirfunc) (void *, const struct parsedname *), void *v, const struct parsedname *pn, uint32_t * flags);
+void ServerPipelineClose(struct connection_in *in);
+void ServerPoolClose(struct connection_in *in);
 
 /* High-level callback functions */
 ZERO_OR_ERROR FS_dir(void (*dirfunc) (void *, const struct parsedname *), void *v, struct parsedname *pn);
@@ -164,9 +193,11 @@ SIZE_OR_ERROR FS_write_postparse(struct one_wire_query *owq);
 ZERO_OR_ERROR FS_write_local(struct one_wire_query *owq);
 
 SIZE_OR_ERROR FS_get(const char *path, char **return_buffer, size_t * buffer_length) ;
+SIZE_OR_ERROR FS_get_many(const char **paths, int count, char **return_buffers, SIZE_OR_ERROR * return_lengths) ;
 
 SIZE_OR_ERROR FS_read(const char *path, char *buf, const size_t size, const off_t offset);
 SIZE_OR_ERROR FS_read_postparse(struct one_wire_query *owq);
+void FS_read_many(struct one_wire_query **owq_array, SIZE_OR_ERROR *read_results, int count);
 ZERO_OR_ERROR FS_read_fake(struct one_wire_query *owq);
 ZERO_OR_ERROR FS_read_tester(struct one_wire_query *owq);
 ZERO_OR_ERROR FS_r_aggregate_all(struct one_wire_query *owq);
@@ -203,6 +234,7 @@ void BUS_lock(const struct parsedname *pn);
 void BUS_unlock(const struct parsedname *pn);
 void BUS_lock_in(struct connection_in *in);
 void BUS_unlock_in(struct connection_in *in);
+int BUS_waiting(const struct parsedname *pn);
 void CHANNEL_lock_in(struct connection_in *in);
 void CHANNEL_unlock_in(struct connection_in *in);
 void PORT_lock_in(struct connection_in *in);
@@ -99,6 +99,11 @@ struct global {
 	ASCII *fatal_debug_file;
 	int readonly;
 	int max_clients;			// for ftp
+	int server_workers;			// owserver and owhttpd event mode worker threads (0 for thread per connection)
+	int server_pool;			// persistent connections kept to each owserver bus master
+	int fanout_threads;			// threads kept for requests spread over all the buses
+	int fuse_workers;			// owfs threads serving each bus (0 to serve in the FUSE threads)
+	int registry;				// seconds between background bus searches (0 for none)
 	size_t cache_size;			// max cache size (or 0 for no max) ;
 	int one_device;				// Single device, use faster ROM comands
 	/* Special parameter to trigger William Robison <ibutton@n952.dyndns.ws> timings */
@@ -127,6 +132,7 @@ struct global {
 	int no_dirall;
 	int no_get;
 	int no_persistence;
+	int no_pipeline;
 	int eightbit_serial;
 	int trim;
 	enum zero_support zero ;
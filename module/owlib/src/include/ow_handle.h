@@ -0,0 +1,30 @@
+/*
+    OW -- One-Wire filesystem
+    version 0.4 7/2/2003
+
+    Written 2003 Paul H Alfille
+    GPL license
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+*/
+
+// Not intended to be stand-alone -- called from ow.h
+#ifndef OW_HANDLE_H			/* tedious wrapper */
+#define OW_HANDLE_H
+
+/* One property path, parsed and located once, read many times (see ow_handle.c) */
+struct property_handle ;
+
+ZERO_OR_ERROR FS_handle_open( const char * path, struct property_handle ** handle ) ;
+SIZE_OR_ERROR FS_handle_read( struct property_handle * ph, char * buffer, size_t size ) ;
+SIZE_OR_ERROR FS_handle_read_offset( struct property_handle * ph, char * buffer, size_t size, off_t offset ) ;
+void FS_handle_close( struct property_handle * ph ) ;
+
+#endif							/* OW_HANDLE_H */
@@ -25,16 +25,23 @@
 
 /* included in ow_connection.h as the bus-master specific portion of the connection_in structure */
 
+struct server_pipeline ;
+struct server_pool ;
+
 struct master_server {
 	char *type;					// for zeroconf
 	char *domain;				// for zeroconf
 	char *name;					// zeroconf name
 	int no_dirall;				// flag that server doesn't support DIRALL
+	enum { server_pipeline_unknown, server_pipeline_no, server_pipeline_yes, } pipeline ; // server accepts request ids
+	struct server_pipeline * pipe ;	// shared connection for pipelined requests
+	struct server_pool * pool ;	// persistent connections for the other requests
 } ;
 
 struct master_serial {
 	enum ds2480b_mode { ds2480b_data_mode, ds2480b_command_mode, } mode ;
 	int reverse_polarity ;
+	struct dirblob search_tree ; // devices found by the last complete search, verified all at once next time
 };
 
 struct master_fake {
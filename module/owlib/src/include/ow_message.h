@@ -41,6 +41,7 @@ enum msg_classification {
 	msg_get,
 	msg_dirallslash,
 	msg_getslash,
+	msg_readmany,
 };
 /* message to owserver */
 struct server_msg {
@@ -52,6 +53,17 @@ struct server_msg {
 	int32_t offset;
 };
 
+/* msg_readmany -- several reads in one message */
+/* Request payload: the paths, each null terminated, one after another */
+/*   size and offset apply to each path as in msg_read */
+/* Response payload: for each path (in request order) a readmany_item header */
+/*   in network order, followed by length bytes of data */
+/*   ret in the client_msg is the number of items */
+struct readmany_item {
+	int32_t ret;
+	int32_t length;
+};
+
 /* message to client */
 struct client_msg {
 	int32_t version;
@@ -92,4 +104,12 @@ struct serverpackage {
 #define Serverprotocol(version) (((version) & ServerprotocolMASK) >> 17 )
 #define MakeServerprotocol(protocol) ((protocol) << 17)
 
+// Pipelining -- a protocol bit
+// Request: the header is followed by a 32 bit request id (network order)
+// Response (including pings): same bit, and the request id follows the header
+// Responses may come back in any order
+// Advertised by the owserver in the reply to a msg_nop
+#define OWSERVER_PROTOCOL_PIPELINE	0x01
+#define isServerpipeline(version)	((Serverprotocol(version) & OWSERVER_PROTOCOL_PIPELINE) != 0)
+
 #endif							/* OW_MESSAGE_H */
@@ -70,6 +70,9 @@ extern struct mutexes {
 	pthread_mutex_t externalcount_mutex;
 	pthread_mutex_t timegm_mutex;
 	pthread_mutex_t detail_mutex;
+	pthread_mutex_t read_flight_mutex; // identical reads in progress (ow_read.c)
+	pthread_mutex_t registry_mutex; // device registry and events (ow_registry.c)
+	pthread_mutex_t task_mutex; // fan-out task queue (ow_taskpool.c)
 	
 	pthread_mutexattr_t mattr; // mutex attribute -- used for all mutexes
 	my_rwlock_t lib;
@@ -122,10 +125,9 @@ extern struct mutexes {
 #define PERSISTENT_RLOCK    RWLOCK_RLOCK(   Mutex.persistent_cache )
 #define PERSISTENT_RUNLOCK  RWLOCK_RUNLOCK( Mutex.persistent_cache )
 
+/* Only changes to the bus list lock, readers use Connection_Read_Begin */
 #define CONNIN_WLOCK      	RWLOCK_WLOCK(   Mutex.connin )
 #define CONNIN_WUNLOCK    	RWLOCK_WUNLOCK( Mutex.connin )
-#define CONNIN_RLOCK      	RWLOCK_RLOCK(   Mutex.connin )
-#define CONNIN_RUNLOCK    	RWLOCK_RUNLOCK( Mutex.connin )
 
 #define MONITOR_WLOCK      	RWLOCK_WLOCK(   Mutex.monitor )
 #define MONITOR_WUNLOCK    	RWLOCK_WUNLOCK( Mutex.monitor )
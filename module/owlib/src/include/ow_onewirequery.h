@@ -20,6 +20,25 @@ enum owq_cleanup {
 	owq_simultaneous    = 0x1000,
 	} ;
 
+/* Binary value form of a numeric read (VALUE_BINARY control flag)
+ * one type byte, then 8 bytes per element (just one, or all for .ALL)
+ * most significant byte first:
+ *   float    IEEE double, in the requested temperature/pressure scale
+ *   integer  signed
+ *   unsigned
+ *   yesno    0 or 1
+ *   date     signed seconds since the epoch
+ * The type bytes are not printable, so a text reply can't be mistaken for one */
+enum value_binary_type {
+	value_binary_none = 0x00,
+	value_binary_float = 0x01,
+	value_binary_integer = 0x02,
+	value_binary_unsigned = 0x03,
+	value_binary_yesno = 0x04,
+	value_binary_date = 0x05,
+} ;
+#define VALUE_BINARY_ELEMENT	8
+
 union value_object {
 	int I;
 	unsigned int U;
@@ -107,6 +126,7 @@ struct one_wire_query * BYTEtoALL( struct one_wire_query *owq_byte );
 
 int OWQ_parse_input(struct one_wire_query *owq);
 SIZE_OR_ERROR OWQ_parse_output(struct one_wire_query *owq);
+SIZE_OR_ERROR OWQ_value_output(struct one_wire_query *owq);
 void _print_owq(struct one_wire_query *owq);
 
 #endif							/* OW_ONEWIREQUERY_H */
@@ -126,8 +126,8 @@ enum ePS_state {
 };
 
 struct parsedname {
-	char path[2*PATH_MAX+2];				// full device name
-	char path_to_server[PATH_MAX+2];			// path without first bus
+	char * path;				// full device name (allocated to fit)
+	char * path_to_server;			// path without first bus (same string as path unless changed)
 	char * device_name ;		// for external name
 	struct connection_in *known_bus;	// where this device is located
 	enum ePN_type type;			// real? settings? ...
@@ -144,10 +144,12 @@ struct parsedname {
 	struct connection_in *selected_connection;	// which bus is assigned to this item
 	uint32_t control_flags;				// more state info, packed for network transmission
 	struct devlock *lock;			// pointer to a device-specific lock
+	struct devlock *held_lock;		// device lock kept by a property handle (see DeviceLockHold)
 	int return_code ; // return (error) code
 	int detail_flag ; // matches a detail request
 	int tokens;				// for anti-loop work
 	BYTE *tokenstring;			// List of tokens from owservers passed
+	int connin_reader ;			// bus list read section held (or -1), see ow_connect.c
 };
 
 /* ---- end Parsedname ----------------- */
@@ -159,6 +161,7 @@ struct parsedname {
 #define UNCACHED                    ( (UINT) 0x00000020 )
 #define TRIM                        ( (UINT) 0x00000040 )
 #define OWNET                       ( (UINT) 0x00000100 )
+#define VALUE_BINARY                ( (UINT) 0x00000200 )
 #define TEMPSCALE_MASK              ( (UINT) 0x00030000 )
 #define TEMPSCALE_BIT      16
 #define PRESSURESCALE_MASK          ( (UINT) 0x001C0000 )
@@ -193,6 +196,7 @@ struct parsedname {
 #define     InSafeMode(pn)    ( (((pn)->control_flags) & SAFEMODE ) != 0 )
 
 #define     ShouldTrim(pn)    ( (((pn)->control_flags) & TRIM ) != 0 )
+#define WantValueBinary(pn)    ( (((pn)->control_flags) & VALUE_BINARY ) != 0 )
 
 #define KnownBus(pn)          ((((pn)->state) & ePS_bus) != 0 )
 #define UnsetKnownBus(pn)           do { (pn)->state &= ~ePS_bus; \
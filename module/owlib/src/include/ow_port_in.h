@@ -126,6 +126,7 @@ struct port_in {
 enum bus_mode get_busmode(const struct connection_in *c);
 
 void RemovePort( struct port_in * pin ) ;
+void UnlinkPort( struct port_in * pin ) ;
 struct port_in * AllocPort( const struct port_in * old_pin ) ;
 struct port_in *LinkPort(struct port_in *pin) ;
 struct port_in *NewPort(const struct port_in *pin) ;
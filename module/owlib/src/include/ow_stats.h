@@ -21,6 +21,8 @@ $Id$
 DeviceHeader(stats_cache);
 DeviceHeader(stats_read);
 DeviceHeader(stats_write);
+DeviceHeader(stats_server);
+DeviceHeader(stats_fanout);
 DeviceHeader(stats_directory);
 DeviceHeader(stats_errors);
 DeviceHeader(stats_thread);
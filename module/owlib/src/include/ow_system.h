@@ -20,5 +20,6 @@
 DeviceHeader(sys_process);
 DeviceHeader(sys_connections);
 DeviceHeader(sys_configure);
+DeviceHeader(sys_registry);
 
 #endif							/* OW_SYSTEM_H */
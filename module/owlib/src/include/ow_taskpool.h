@@ -0,0 +1,49 @@
+/*
+    OW -- One-Wire filesystem
+    version 0.4 7/2/2003
+
+    Written 2003 Paul H Alfille
+    GPL license
+    This program is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public License
+    as published by the Free Software Foundation; either version 2
+    of the License, or (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+*/
+
+// Not intended to be stand-alone -- called from ow.h
+#ifndef OW_TASKPOOL_H			/* tedious wrapper */
+#define OW_TASKPOOL_H
+
+/* One request spread over all the buses (see ow_taskpool.c) */
+enum task_fanout {
+	fanout_directory,
+	fanout_presence,
+	fanout_simultaneous,
+	fanout_alias,
+	fanout_kinds, // number of kinds
+} ;
+
+/* latency buckets: <1ms <10ms <100ms <1s <10s longer */
+#define FANOUT_BUCKETS	6
+
+/* Lives on the caller's stack from Task_Group_Init to Task_Wait */
+struct task_group {
+	enum task_fanout fanout ;
+	int pending ; // added and not yet finished
+	int cancelled ; // skip the tasks not yet started
+	pthread_cond_t done ;
+	struct timeval start ;
+} ;
+
+void Task_Group_Init( struct task_group * tg, enum task_fanout fanout ) ;
+void Task_Add( struct task_group * tg, void (*run) (void *), void * v ) ;
+void Task_Cancel( struct task_group * tg ) ;
+void Task_Wait( struct task_group * tg ) ;
+void Task_Stop( void ) ;
+
+#endif							/* OW_TASKPOOL_H */
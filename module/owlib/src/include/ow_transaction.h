@@ -78,6 +78,7 @@ enum transaction_type {
 	trxn_nop,
 	trxn_delay,
 	trxn_udelay,
+	trxn_release,
 };
 struct transaction_log {
 	const BYTE *out;
@@ -113,6 +114,10 @@ struct transaction_log {
 #define TRXN_POWER_BIT(byte_pointer, msec)  { byte_pointer, byte_pointer, msec, trxn_bitpower, }
 
 #define TRXN_DELAY(msec) { NULL, NULL, msec, trxn_delay }
+/* Delay with the bus unlocked so other transactions can run (a powered device converting) */
+/* Usually the last item before TRXN_END. Anything after it is a new bus conversation, */
+/* so it has to select the device again (TRXN_START). BUS_transaction_nolock keeps the bus and just waits */
+#define TRXN_RELEASE_DELAY(msec) { NULL, NULL, msec, trxn_release }
 
 #define TRXN_WRITE1(writedata)  TRXN_WRITE(writedata,1)
 #define TRXN_READ1(readdata)    TRXN_READ(readdata,1)
@@ -98,6 +98,60 @@ int ServerRead(struct request_packet *rp)
 	return cm.ret;
 }
 
+// Send to an owserver using the READMANY message
+// rp->write_value holds the null-terminated paths (rp->data_length bytes)
+// rp->data_offset applies to each path
+// *response is set to the allocated reply (must be free-ed): a readmany_item and data for each path
+// *response_length is its length
+// returns the number of items or <0 for error
+int ServerReadMany(struct request_packet *rp, char **response, int *response_length)
+{
+	struct server_msg sm;
+	struct client_msg cm;
+#if ( __GNUC__ > 4 ) || (__GNUC__ == 4 && __GNUC_MINOR__ > 4 )
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wcast-qual"
+	struct serverpackage sp = { NULL, (BYTE *) rp->write_value, rp->data_length, rp->tokenstring, rp->tokens, };
+#pragma GCC diagnostic pop	
+#else
+	struct serverpackage sp = { NULL, (BYTE *) rp->write_value, rp->data_length, rp->tokenstring, rp->tokens, };
+#endif
+	int persistent = 1;
+	struct server_connection_state scs ;
+
+	memset(&sm, 0, sizeof(struct server_msg));
+	memset(&cm, 0, sizeof(struct client_msg));
+	sm.type = msg_readmany;
+	sm.size = MAX_READ_BUFFER_SIZE;
+	sm.offset = rp->data_offset;
+	scs.persistence = persistent_yes ;
+	scs.in =rp->owserver ;
+
+	*response = NULL ;
+	*response_length = 0 ;
+	LEVEL_CALL("SERVER READMANY length=%d\n", (int) rp->data_length);
+
+	// Send to owserver
+	sm.control_flags = SetupSemi(persistent);
+	if ( To_Server( &scs, &sm, &sp) == 1 ) {
+		Release_Persistent( &scs, 0);
+		return -EIO ;
+	}
+
+	// Receive from owserver
+	*response = From_ServerAlloc(&scs, &cm);
+	if ( cm.ret >= 0 && *response == NULL ) {
+		// items promised but no data
+		Release_Persistent( &scs, 0);
+		return -EIO ;
+	}
+	if ( *response != NULL ) {
+		*response_length = cm.payload ;
+	}
+	Release_Persistent( &scs, cm.control_flags & PERSISTENT_MASK);
+	return cm.ret;
+}
+
 // Send to an owserver using the PRESENT message
 int ServerPresence(struct request_packet *rp)
 {
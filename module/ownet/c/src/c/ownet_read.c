@@ -76,3 +76,140 @@ int OWNET_lread(OWNET_HANDLE h, const char *onewire_path, char *return_string, s
 	CONNIN_RUNLOCK;
 	return return_value;
 }
+
+/* One path at a time, for owservers without READMANY */
+static int OWNET_readmany_single(struct request_packet *rp, int count, const char **onewire_paths, char **return_strings, int *return_lengths)
+{
+	int good_reads = 0;
+	int i;
+
+	for (i = 0; i < count; ++i) {
+		unsigned char buffer[MAX_READ_BUFFER_SIZE];
+		int return_value;
+
+		rp->path = (onewire_paths[i] == NULL) ? "/" : onewire_paths[i];
+		rp->read_value = buffer;
+		rp->data_length = MAX_READ_BUFFER_SIZE;
+		rp->data_offset = 0;
+
+		return_value = ServerRead(rp);
+		if (return_value >= 0) {
+			return_strings[i] = malloc(return_value+1);
+			if (return_strings[i] == NULL) {
+				return_value = -ENOMEM;
+			} else {
+				memcpy(return_strings[i], buffer, return_value);
+				return_strings[i][return_value] = '\0' ;
+				++good_reads;
+			}
+		}
+		return_lengths[i] = return_value;
+	}
+	return good_reads;
+}
+
+int OWNET_readmany(OWNET_HANDLE h, int count, const char **onewire_paths, char **return_strings, int *return_lengths)
+{
+	struct request_packet s_request_packet;
+	struct request_packet *rp = &s_request_packet;
+	char *path_list;
+	char *response = NULL;
+	int response_length = 0;
+	size_t list_length = 0;
+	int return_value;
+	int i;
+
+	if (onewire_paths == NULL || return_strings == NULL || return_lengths == NULL || count < 0) {
+		return -EINVAL;
+	}
+	for (i = 0; i < count; ++i) {
+		return_strings[i] = NULL;
+		return_lengths[i] = -ENOENT;
+		list_length += strlen((onewire_paths[i] == NULL) ? "/" : onewire_paths[i]) + 1;
+	}
+	if (count == 0) {
+		return 0;
+	}
+
+	memset(rp, 0, sizeof(struct request_packet));
+
+	CONNIN_RLOCK;
+	rp->owserver = find_connection_in(h);
+	if (rp->owserver == NULL) {
+		CONNIN_RUNLOCK;
+		return -EBADF;
+	}
+
+	// Do we know this server doesn't support READMANY?
+	if (rp->owserver->tcp.no_readmany || list_length > MAX_OWSERVER_PROTOCOL_PAYLOAD_SIZE) {
+		return_value = OWNET_readmany_single(rp, count, onewire_paths, return_strings, return_lengths);
+		CONNIN_RUNLOCK;
+		return return_value;
+	}
+
+	// paths back to back, each null terminated
+	path_list = malloc(list_length);
+	if (path_list == NULL) {
+		CONNIN_RUNLOCK;
+		return -ENOMEM;
+	}
+	list_length = 0;
+	for (i = 0; i < count; ++i) {
+		const char *path = (onewire_paths[i] == NULL) ? "/" : onewire_paths[i];
+		size_t path_length = strlen(path) + 1;
+		memcpy(&path_list[list_length], path, path_length);
+		list_length += path_length;
+	}
+	rp->write_value = (unsigned char *) path_list;
+	rp->data_length = list_length;
+	rp->data_offset = 0;
+
+	// try READMANY and see if supported
+	return_value = ServerReadMany(rp, &response, &response_length);
+	free(path_list);
+
+	if (return_value == -ENOMSG) {
+		rp->owserver->tcp.no_readmany = 1;
+		return_value = OWNET_readmany_single(rp, count, onewire_paths, return_strings, return_lengths);
+	} else if (return_value == count) {
+		// unpack each item
+		int position = 0;
+		return_value = 0;
+		for (i = 0; i < count; ++i) {
+			struct readmany_item item;
+			if (position + (int) sizeof(struct readmany_item) > response_length) {
+				return_value = -EPROTO;
+				break;
+			}
+			memcpy(&item, &response[position], sizeof(struct readmany_item));
+			position += sizeof(struct readmany_item);
+			item.ret = ntohl(item.ret);
+			item.length = ntohl(item.length);
+			if (item.length < 0 || position + item.length > response_length) {
+				return_value = -EPROTO;
+				break;
+			}
+			return_lengths[i] = item.ret;
+			if (item.ret >= 0) {
+				return_strings[i] = malloc(item.length+1);
+				if (return_strings[i] == NULL) {
+					return_lengths[i] = -ENOMEM;
+				} else {
+					memcpy(return_strings[i], &response[position], item.length);
+					return_strings[i][item.length] = '\0' ;
+					return_lengths[i] = item.length;
+					++return_value;
+				}
+			}
+			position += item.length;
+		}
+	} else if (return_value >= 0) {
+		return_value = -EPROTO;
+	}
+
+	if (response != NULL) {
+		free(response);
+	}
+	CONNIN_RUNLOCK;
+	return return_value;
+}
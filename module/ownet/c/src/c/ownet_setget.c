@@ -103,3 +103,14 @@ int OWNET_get_trim( void )
 {
 	return (ow_Global.control_flags & TRIM) != 0 ;
 }
+
+void OWNET_set_binary( int binary_state )
+{
+	ow_Global.control_flags &= ~VALUE_BINARY ; // clear binary values
+	ow_Global.control_flags |= binary_state ? VALUE_BINARY : 0 ;
+}
+
+int OWNET_get_binary( void )
+{
+	return (ow_Global.control_flags & VALUE_BINARY) != 0 ;
+}
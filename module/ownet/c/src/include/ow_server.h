@@ -55,6 +55,7 @@ extern struct ow_global {
 #define DEVFORMAT_MASK ( (UINT) 0xFF000000 )
 #define DEVFORMAT_BIT  24
 #define TRIM                        ( (UINT) 0x00000040 )
+#define VALUE_BINARY                ( (UINT) 0x00000200 )
 #define IsPersistent         ( ow_Global.control_flags & PERSISTENT_MASK )
 #define SetPersistent(b)      UT_Setbit(ow_Global.control_flags,PERSISTENT_BIT,(b))
 #define TemperatureScale     ( (enum temp_type) ((ow_Global.control_flags & TEMPSCALE_MASK) >> TEMPSCALE_BIT) )
@@ -64,6 +65,7 @@ extern struct ow_global {
 
 int ServerPresence(struct request_packet *rp);
 int ServerRead(struct request_packet *rp);
+int ServerReadMany(struct request_packet *rp, char **response, int *response_length);
 int ServerWrite(struct request_packet *rp);
 int ServerDir(void (*dirfunc) (void *, const char *), void *v, struct request_packet *rp);
 
@@ -99,6 +99,18 @@ extern "C" {
 */
 	int OWNET_lread(OWNET_HANDLE h, const char *onewire_path, char *return_string, size_t size, off_t offset);
 
+/* int OWNET_readmany( OWNET_HANDLE h, int count, const char ** onewire_paths,
+        char ** return_strings, int * return_lengths )
+   Read several one-wire device properties in a single owserver message
+   (owservers without that message are read one property at a time)
+   return_strings[i] has each result (or NULL on error) and must be free-ed by the calling program.
+   return_lengths[i] has the length of each result, or <0 for that property's error
+
+   returns number of properties read successfully,
+   returns <0 on error
+*/
+	int OWNET_readmany(OWNET_HANDLE h, int count, const char **onewire_paths, char **return_strings, int *return_lengths);
+
 /* int OWNET_put( OWNET_HANDLE h, const char * onewire_path, 
         const unsigned char * value_string, size_t size)
    Write a value to a one-wire device property,
@@ -167,6 +179,22 @@ extern "C" {
 	void OWNET_set_trim( int trim_state ) ;
 	int OWNET_get_trim( void ) ;
 
+/* get and set binary value state
+ * Numeric reads (OWNET_read, OWNET_lread) come back unformatted:
+ * one type byte, then 8 bytes per element (one, or all for .ALL)
+ * most significant byte first
+ *   1 float (IEEE double, in the temperature scale)
+ *   2 integer (signed)
+ *   3 unsigned
+ *   4 yes/no (0 or 1)
+ *   5 date (signed seconds since the epoch)
+ * Other properties, and owservers without binary values, still send text
+ * (the first byte tells them apart)
+   Note that binary state applies to all HANDLES
+*/
+	void OWNET_set_binary( int binary_state ) ;
+	int OWNET_get_binary( void ) ;
+
 
 #ifdef __cplusplus
 }
@@ -118,6 +118,11 @@ void *DataHandler(void *v)
 				// client wants unaliased
 				pn->state |= ePS_unaliased;
 			}
+			if ( hd->sm.type != msg_read || ValueBinaryType(pn) == value_binary_none ) {
+				// binary values only for a numeric read -- the returned flag tells the client
+				pn->control_flags &= ~VALUE_BINARY ;
+				cm.control_flags &= ~VALUE_BINARY ;
+			}
 			
 
 			/* Antilooping tags */
@@ -193,9 +198,23 @@ void *DataHandler(void *v)
 			LEVEL_DEBUG("DataHandler: FS_ParsedName_destroy done");
 		}
 		break;
+	case msg_readmany:			// good message -- list of paths
+		if (hd->sm.payload == 0) {	/* Bad query -- no data after header */
+			LEVEL_DEBUG("No payload -- ignore.") ;
+			cm.ret = -EBADMSG;
+		} else {
+			LEVEL_CALL("Read many message");
+			retbuffer = ReadManyHandler(hd, &cm);
+			LEVEL_DEBUG("Read many message done value=%p", retbuffer);
+		}
+		break;
 	case msg_nop:				// "bad" message
 		LEVEL_CALL("NOP message");
 		cm.ret = 0;
+		// advertise pipelining (request ids) when persistent connections are allowed
+		if ( Globals.no_pipeline == 0 && Globals.no_persistence == 0 ) {
+			cm.version |= MakeServerprotocol(OWSERVER_PROTOCOL_PIPELINE);
+		}
 		break;
 	case msg_size:				// no longer used
 	case msg_error:
@@ -208,7 +227,7 @@ void *DataHandler(void *v)
 
 	TOCLIENTLOCK(hd);
 	if (cm.ret != -EIO) {
-		ToClient(hd->file_descriptor, &cm, retbuffer);
+		ToClient(hd, &cm, retbuffer);
 	} else {
 		ErrorToClient(hd, &cm) ;
 	}
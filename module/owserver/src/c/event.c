@@ -0,0 +1,346 @@
+/*
+    OW_HTML -- OWFS used for the web
+    OW -- One-Wire filesystem
+
+    Written 2004 Paul H Alfille
+
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+
+/* owserver event mode (--workers n)
+         The shared event loop (ow_event.c) watches every client socket:
+                 keep-alive pings for requests in progress (sent without blocking)
+                 idle expiry for persistent connections
+         Its fixed pool of worker threads reads and processes the messages.
+         An idle client costs a file descriptor and a small structure -- no thread, stack or pipe.
+*/
+
+#include "owserver.h"
+
+#ifdef HAVE_SYS_EPOLL_H
+
+/* One accepted client socket */
+struct eventconn {
+	FILE_DESCRIPTOR_OR_ERROR file_descriptor ;
+	struct handlerconn hc ;
+	int persistent ; // holds a slot in persistent_connections
+	int outstanding ; // requests being processed
+	int closing ; // close when the last request finishes
+	struct event_timer timer ; // idle lists
+	struct event_job job ; // worker queue
+} ;
+
+/* One message being processed */
+struct eventreq {
+	struct handlerdata hd ;
+	struct eventconn * ec ;
+	struct event_timer timer ; // busy list (pings)
+} ;
+
+static struct {
+	struct event_loop loop ; // its mutex protects the lists and connection counts
+	struct event_list busy ; // requests being processed -- ping timers
+	struct event_list idle_new ; // accepted, waiting for first message
+	struct event_list idle_low ; // persistent, short wait
+	struct event_list idle_high ; // persistent, longer wait
+	struct event_list * lists[5] ;
+} Event ;
+
+#define EVENTLOCK     _MUTEX_LOCK(   Event.loop.mutex )
+#define EVENTUNLOCK   _MUTEX_UNLOCK( Event.loop.mutex )
+
+static void EventArm( struct eventconn * ec ) ;
+static void EventIdle( struct eventconn * ec ) ;
+static void EventClose( struct eventconn * ec ) ;
+static void EventExpire( struct eventconn * ec ) ;
+static void EventReady( void * v ) ;
+static void EventPing( struct eventreq * er, const struct timeval * now ) ;
+static void EventTimers( const struct timeval * now ) ;
+static void EventRequest( void * v ) ;
+
+/* Watch socket for the next message (one shot, so only one worker reads it) */
+/* Called with EVENTLOCK */
+static void EventArm( struct eventconn * ec )
+{
+	if ( BAD( Event_Rearm( &Event.loop, ec->file_descriptor, ec ) ) ) {
+		EventExpire( ec ) ;
+	}
+}
+
+/* Persistent connection -- wait for the next message */
+/* Called with EVENTLOCK */
+static void EventIdle( struct eventconn * ec )
+{
+	LEVEL_DEBUG("OWSERVER tcp connection persistence -- wait for next message.");
+	Event_List_Add( &Event.idle_low, &(ec->timer), Globals.timeout_persistent_low ) ;
+	EventArm( ec ) ;
+}
+
+/* Called with EVENTLOCK, no requests outstanding */
+static void EventClose( struct eventconn * ec )
+{
+	Event_List_Remove( &(ec->timer) ) ;
+	Event_Unwatch( &Event.loop, ec->file_descriptor ) ;
+	Test_and_Close( &(ec->file_descriptor) ) ;
+	PersistenceRelease( &(ec->persistent) ) ;
+	HandlerConnDestroy( &(ec->hc) ) ;
+	owfree( ec ) ;
+}
+
+/* Stop reading this connection, close now or when the last request finishes */
+/* Called with EVENTLOCK */
+static void EventExpire( struct eventconn * ec )
+{
+	if ( ec->outstanding > 0 ) {
+		ec->closing = 1 ;
+		Event_List_Remove( &(ec->timer) ) ;
+		Event_Unwatch( &Event.loop, ec->file_descriptor ) ;
+	} else {
+		EventClose( ec ) ;
+	}
+}
+
+/* Message arriving -- queue the connection for a worker to read */
+/* readable, hangup or error -- FromClient sorts it out */
+/* Called with EVENTLOCK */
+static void EventReady( void * v )
+{
+	struct eventconn * ec = v ;
+
+	Event_List_Remove( &(ec->timer) ) ;
+	Event_Queue( &Event.loop, &(ec->job) ) ;
+}
+
+/* Keep-alive timer for a request in progress -- same logic as Ping_or_Send */
+/* Never waits on the client: the socket lock is only tried and the ping is sent non-blocking */
+/* Called with EVENTLOCK */
+static void EventPing( struct eventreq * er, const struct timeval * now )
+{
+	if ( pthread_mutex_trylock( &(er->hd.hc->to_client) ) != 0 ) {
+		// a worker is writing to this client -- try again soon
+		timeradd( now, &tv_short, &(er->timer.deadline) ) ;
+		return ;
+	}
+	switch ( er->hd.toclient ) {
+		case toclient_complete:
+			// crossed paths, worker will take it off the busy list
+			timeradd( now, &tv_long, &(er->timer.deadline) ) ;
+			break ;
+		case toclient_postmessage:
+			LEVEL_DEBUG("Ping forestalled by a directory element");
+			er->hd.toclient = toclient_postping ;
+			timeradd( now, &tv_short, &(er->timer.deadline) ) ;
+			break ;
+		case toclient_postping:
+			LEVEL_DEBUG("Taking too long, send a keep-alive pulse");
+			if ( PingClientNonblocking( &(er->hd) ) ) {
+				// client isn't reading, send the rest soon
+				timeradd( now, &tv_short, &(er->timer.deadline) ) ;
+			} else {
+				timeradd( now, &tv_long, &(er->timer.deadline) ) ;
+			}
+			break ;
+	}
+	TOCLIENTUNLOCK( &(er->hd) ) ;
+}
+
+/* Fire expired timers */
+/* Called with EVENTLOCK */
+static void EventTimers( const struct timeval * now )
+{
+	struct event_timer * et ;
+
+	// pings (busy list is no longer than the worker pool)
+	for ( et = Event.busy.head ; et != NULL ; et = et->next ) {
+		if ( timercmp( &(et->deadline), now, <= ) ) {
+			EventPing( et->owner, now ) ;
+		}
+	}
+
+	// never sent a message
+	while ( (et = Event.idle_new.head) != NULL && timercmp( &(et->deadline), now, <= ) ) {
+		LEVEL_DEBUG("No message from new connection");
+		EventExpire( et->owner ) ;
+	}
+
+	// persistent connections past the short wait
+	while ( (et = Event.idle_low.head) != NULL && timercmp( &(et->deadline), now, <= ) ) {
+		if ( PersistenceExtend() ) {
+			Event_List_Remove( et ) ;
+			Event_List_Add( &Event.idle_high, et, Globals.timeout_persistent_high - Globals.timeout_persistent_low ) ;
+		} else {
+			LEVEL_DEBUG("Too many persistent connections -- close idle one");
+			EventExpire( et->owner ) ;
+		}
+	}
+
+	// persistent connections past the longer wait
+	while ( (et = Event.idle_high.head) != NULL && timercmp( &(et->deadline), now, <= ) ) {
+		LEVEL_DEBUG("Persistent connection idle too long");
+		EventExpire( et->owner ) ;
+	}
+}
+
+/* Worker -- read and process one message from a readable connection */
+static void EventRequest( void * v )
+{
+	struct eventconn * ec = v ;
+	int loop_persistent ;
+	int pipelined ;
+	struct eventreq * er = owcalloc( 1, sizeof(struct eventreq) ) ;
+
+	if ( er == NULL ) {
+		LEVEL_DEBUG("Could not allocate memory to handle this request");
+		EVENTLOCK ;
+		EventExpire( ec ) ;
+		EVENTUNLOCK ;
+		return ;
+	}
+	er->ec = ec ;
+	er->timer.owner = er ;
+	er->hd.file_descriptor = ec->file_descriptor ;
+	er->hd.hc = &(ec->hc) ;
+
+	if ( FromClient( &(er->hd) ) != 0 ) {
+		EVENTLOCK ;
+		EventExpire( ec ) ;
+		EVENTUNLOCK ;
+		owfree( er ) ;
+		return ;
+	}
+
+	loop_persistent = PersistenceRequest( &(er->hd), &(ec->persistent) ) ;
+	pipelined = er->hd.pipelined && loop_persistent ;
+
+	EVENTLOCK ;
+	++ec->outstanding ;
+	er->hd.toclient = toclient_postping ;
+	Event_List_Add( &Event.busy, &(er->timer), 0 ) ;
+	timeradd( &(er->timer.deadline), &tv_long, &(er->timer.deadline) ) ;
+	if ( pipelined ) {
+		if ( Event.loop.shutdown ) {
+			ec->closing = 1 ;
+		} else {
+			// answered out of order, another worker can read the next request now
+			EventIdle( ec ) ;
+		}
+	}
+	EVENTUNLOCK ;
+
+	SingleHandler( &(er->hd), DirectLoop ) ;
+
+	EVENTLOCK ;
+	Event_List_Remove( &(er->timer) ) ; // off busy list
+	--ec->outstanding ;
+	if ( ! pipelined && loop_persistent && ! Event.loop.shutdown ) {
+		EventIdle( ec ) ;
+	} else {
+		if ( ! pipelined ) {
+			ec->closing = 1 ;
+		}
+		if ( ec->closing && ec->outstanding == 0 ) {
+			EventClose( ec ) ;
+		}
+	}
+	EVENTUNLOCK ;
+
+	owfree( er ) ;
+}
+
+/* Called from the listening thread for each accepted socket */
+void EventAccept(FILE_DESCRIPTOR_OR_ERROR file_descriptor)
+{
+	struct eventconn * ec = owcalloc( 1, sizeof(struct eventconn) ) ;
+
+	if ( ec == NULL ) {
+		LEVEL_DEBUG("Could not allocate memory to handle this connection");
+		close( file_descriptor ) ;
+		return ;
+	}
+
+	ec->file_descriptor = file_descriptor ;
+	ec->timer.owner = ec ;
+	ec->job.owner = ec ;
+	HandlerConnInit( &(ec->hc) ) ;
+
+	EVENTLOCK ;
+	if ( Event.loop.shutdown ) {
+		EventClose( ec ) ;
+	} else {
+		Event_List_Add( &Event.idle_new, &(ec->timer), Globals.timeout_server ) ;
+		if ( BAD( Event_Watch( &Event.loop, ec->file_descriptor, ec ) ) ) {
+			EventClose( ec ) ;
+		}
+	}
+	EVENTUNLOCK ;
+}
+
+GOOD_OR_BAD EventSetup(void)
+{
+	memset( &Event, 0, sizeof(Event) ) ;
+	Event.busy.unsorted = 1 ; // pings are rescheduled in place
+	Event.lists[0] = &Event.busy ;
+	Event.lists[1] = &Event.idle_new ;
+	Event.lists[2] = &Event.idle_low ;
+	Event.lists[3] = &Event.idle_high ;
+	Event.lists[4] = NULL ;
+	Event.loop.lists = Event.lists ;
+	Event.loop.ready = EventReady ;
+	Event.loop.timers = EventTimers ;
+	Event.loop.work = EventRequest ;
+
+	return Event_Loop_Start( &Event.loop, Globals.server_workers ) ;
+}
+
+void EventCleanup(void)
+{
+	struct event_list * idle[] = { &Event.idle_new, &Event.idle_low, &Event.idle_high, } ;
+	size_t l ;
+
+	// workers finish the queued messages first
+	Event_Loop_Stop( &Event.loop ) ;
+
+	EVENTLOCK ;
+	for ( l = 0 ; l < sizeof(idle)/sizeof(idle[0]) ; ++l ) {
+		while ( idle[l]->head != NULL ) {
+			EventClose( idle[l]->head->owner ) ;
+		}
+	}
+	EVENTUNLOCK ;
+
+	Event_Loop_Destroy( &Event.loop ) ;
+}
+
+#else /* HAVE_SYS_EPOLL_H */
+
+GOOD_OR_BAD EventSetup(void)
+{
+	LEVEL_DEFAULT("Event mode (--workers) needs epoll -- use a thread per connection") ;
+	return gbBAD ;
+}
+
+void EventAccept(FILE_DESCRIPTOR_OR_ERROR file_descriptor)
+{
+	// never called without EventSetup
+	close( file_descriptor ) ;
+}
+
+void EventCleanup(void)
+{
+}
+
+#endif /* HAVE_SYS_EPOLL_H */
@@ -47,6 +47,8 @@ int FromClient(struct handlerdata *hd)
 
 	/* Clear return structure */
 	memset(&hd->sp, 0, sizeof(struct serverpackage));
+	hd->pipelined = 0 ;
+	hd->request_id = 0 ;
 
 	/* read header */
 	tcp_read(hd->file_descriptor, (BYTE *) &hd->sm, sizeof(struct server_msg), &tv, &actual_read) ;
@@ -65,6 +67,19 @@ int FromClient(struct handlerdata *hd)
 
 	LEVEL_DEBUG("FromClient payload=%d size=%d type=%d sg=0x%X offset=%d", hd->sm.payload, hd->sm.size, hd->sm.type, hd->sm.control_flags, hd->sm.offset);
 
+	/* pipelined request -- request id follows the header */
+	if ( isServerpipeline(hd->sm.version) ) {
+		uint32_t request_id ;
+		tcp_read(hd->file_descriptor, (BYTE *) &request_id, sizeof(uint32_t), &tv, &actual_read) ;
+		if (actual_read != sizeof(uint32_t)) {
+			hd->sm.type = msg_error;
+			return -EIO;
+		}
+		hd->pipelined = 1 ;
+		hd->request_id = ntohl(request_id) ;
+		LEVEL_DEBUG("FromClient pipelined request id=%u", hd->request_id);
+	}
+
 	/* figure out length of rest of message: payload plus tokens */
 	trueload = hd->sm.payload;
 	if (isServermessage(hd->sm.version)) {
@@ -41,7 +41,157 @@ $Id$
 int persistent_connections = 0;
 int handler_count = 0 ;
 
-static void SingleHandler(struct handlerdata *hd);
+/* Pipelined requests answered at once on one connection -- the reader waits above this */
+#define PIPELINE_MAX 8
+
+/*
+ * Persistence decision for the message just read
+ * *persistent is the connection toggle (holds a slot in persistent_connections)
+ * Sets the control flag for the response and returns whether to keep the connection
+ */
+int PersistenceRequest(struct handlerdata *hd, int *persistent)
+{
+	// Was persistence requested?
+	int loop_persistent = ((hd->sm.control_flags & PERSISTENT_MASK) != 0);
+
+	/* Persistence suppression? */
+	if (Globals.no_persistence) {
+		loop_persistent = 0;
+	}
+
+	/* Persistence logic */
+	if (loop_persistent) {	/* Requested persistence */
+		LEVEL_DEBUG("Persistence requested");
+		if (*persistent) {	/* already had persistence granted */
+			hd->persistent = 1;	/* so keep it */
+		} else {			/* See if available */
+
+			PERSISTENCELOCK;
+
+			if (persistent_connections < Globals.clients_persistent_high) {	/* ok */
+				++persistent_connections;	/* global count */
+				*persistent = 1;	/* connection toggle */
+				hd->persistent = 1;	/* for responses */
+			} else {
+				loop_persistent = 0;	/* denied! */
+				hd->persistent = 0;	/* for responses */
+			}
+
+			PERSISTENCEUNLOCK;
+
+		}
+	} else {				/* No persistence requested this time */
+		hd->persistent = 0;	/* for responses */
+	}
+
+	/* now set the sg flag because it usually is copied back to the client */
+	if (loop_persistent) {
+		hd->sm.control_flags |= PERSISTENT_MASK;
+	} else {
+		hd->sm.control_flags &= ~PERSISTENT_MASK;
+	}
+
+	return loop_persistent ;
+}
+
+/* After the short wait, is a longer wait allowed? */
+int PersistenceExtend(void)
+{
+	int loop_persistent ;
+
+	PERSISTENCELOCK;
+
+	/* store the test because the mutex locks the variable */
+	loop_persistent = (persistent_connections < Globals.clients_persistent_low);
+
+	PERSISTENCEUNLOCK;
+
+	return loop_persistent ;
+}
+
+/* restore the persistent count */
+void PersistenceRelease(int *persistent)
+{
+	if (*persistent) {
+
+		PERSISTENCELOCK;
+
+		--persistent_connections;
+
+		PERSISTENCEUNLOCK;
+
+		*persistent = 0 ;
+	}
+}
+
+void HandlerConnInit(struct handlerconn *hc)
+{
+	_MUTEX_INIT(hc->to_client);
+	_MUTEX_INIT(hc->pipeline_mutex);
+	my_pthread_cond_init(&(hc->pipeline_cond), NULL);
+	hc->outstanding = 0 ;
+	hc->ping_rest_length = 0 ;
+}
+
+/* Waits for any pipelined requests still in progress */
+void HandlerConnDestroy(struct handlerconn *hc)
+{
+	_MUTEX_LOCK(hc->pipeline_mutex);
+	while ( hc->outstanding > 0 ) {
+		my_pthread_cond_wait(&(hc->pipeline_cond), &(hc->pipeline_mutex));
+	}
+	_MUTEX_UNLOCK(hc->pipeline_mutex);
+
+	my_pthread_cond_destroy(&(hc->pipeline_cond));
+	_MUTEX_DESTROY(hc->pipeline_mutex);
+	_MUTEX_DESTROY(hc->to_client);
+}
+
+/* Thread for a pipelined request -- owns its copy of handlerdata */
+static void * PipelineThread(void *v)
+{
+	struct handlerdata *hd = v;
+	struct handlerconn *hc = hd->hc;
+
+	DETACH_THREAD;
+
+	SingleHandler(hd, PingLoop);
+	owfree(hd);
+
+	_MUTEX_LOCK(hc->pipeline_mutex);
+	--hc->outstanding ;
+	my_pthread_cond_signal(&(hc->pipeline_cond));
+	_MUTEX_UNLOCK(hc->pipeline_mutex);
+
+	return VOID_RETURN;
+}
+
+/* Answer a pipelined request in its own thread so the connection can keep reading (up to PIPELINE_MAX at once) */
+static void PipelineHandler(struct handlerdata *hd)
+{
+	pthread_t thread;
+	struct handlerdata *hd_copy = owmalloc(sizeof(struct handlerdata));
+
+	if (hd_copy == NULL) {
+		SingleHandler(hd, PingLoop);
+		return;
+	}
+	memcpy(hd_copy, hd, sizeof(struct handlerdata));
+	hd->sp.path = NULL ; // now owned by the copy
+
+	_MUTEX_LOCK(hd->hc->pipeline_mutex);
+	while ( hd->hc->outstanding >= PIPELINE_MAX ) {
+		// the client is ahead of us, stop reading until one finishes
+		my_pthread_cond_wait(&(hd->hc->pipeline_cond), &(hd->hc->pipeline_mutex));
+	}
+	++hd->hc->outstanding ;
+	_MUTEX_UNLOCK(hd->hc->pipeline_mutex);
+
+	if (pthread_create(&thread, DEFAULT_THREAD_ATTR, PipelineThread, hd_copy) != 0) {
+		LEVEL_DEBUG("Cannot create thread for pipelined request -- handle in order");
+		PipelineThread(hd_copy);
+	}
+}
 
 /*
  * Main routine for actually handling a request
@@ -50,59 +200,28 @@ static void SingleHandler(struct handlerdata *hd);
 void Handler(FILE_DESCRIPTOR_OR_ERROR file_descriptor)
 {
 	struct handlerdata hd;
+	struct handlerconn hc;
 	struct timeval tv_low = { Globals.timeout_persistent_low, 0, };
 	struct timeval tv_high = { Globals.timeout_persistent_high, 0, };
 	int persistent = 0;
 
 	hd.file_descriptor = file_descriptor;
-	_MUTEX_INIT(hd.to_client);
+	hd.hc = &hc;
+	HandlerConnInit(&hc);
 
 	timersub(&tv_high, &tv_low, &tv_high);	// just the delta
 
 	while (FromClient(&hd) == 0) {
-		// Was persistence requested?
-		int loop_persistent = ((hd.sm.control_flags & PERSISTENT_MASK) != 0);
-
-		/* Persistence suppression? */
-		if (Globals.no_persistence) {
-			loop_persistent = 0;
-		}
-
-		/* Persistence logic */
-		if (loop_persistent) {	/* Requested persistence */
-			LEVEL_DEBUG("Persistence requested");
-			if (persistent) {	/* already had persistence granted */
-				hd.persistent = 1;	/* so keep it */
-			} else {			/* See if available */
-
-				PERSISTENCELOCK;
+		int loop_persistent = PersistenceRequest( &hd, &persistent ) ;
 
-				if (persistent_connections < Globals.clients_persistent_high) {	/* ok */
-					++persistent_connections;	/* global count */
-					persistent = 1;	/* connection toggle */
-					hd.persistent = 1;	/* for responses */
-				} else {
-					loop_persistent = 0;	/* denied! */
-					hd.persistent = 0;	/* for responses */
-				}
-
-				PERSISTENCEUNLOCK;
-
-			}
-		} else {				/* No persistence requested this time */
-			hd.persistent = 0;	/* for responses */
-		}
-
-		/* now set the sg flag because it usually is copied back to the client */
-		if (loop_persistent) {
-			hd.sm.control_flags |= PERSISTENT_MASK;
+		/* Do the real work */
+		if ( hd.pipelined && loop_persistent ) {
+			// answered out of order, go back to reading the next request
+			PipelineHandler(&hd);
 		} else {
-			hd.sm.control_flags &= ~PERSISTENT_MASK;
+			SingleHandler(&hd, PingLoop);
 		}
 
-		/* Do the real work */
-		SingleHandler(&hd);
-
 		/* Now see if we should reloop */
 		if (loop_persistent == 0) {
 			break;				/* easiest one */
@@ -111,15 +230,7 @@ void Handler(FILE_DESCRIPTOR_OR_ERROR file_descriptor)
 		/* Shorter wait */
 		if ( BAD(tcp_wait(file_descriptor, &tv_low)) ) {	// timed out
 			/* test if below threshold for longer wait */
-
-			PERSISTENCELOCK;
-
-			/* store the test because the mutex locks the variable */
-			loop_persistent = (persistent_connections < Globals.clients_persistent_low);
-
-			PERSISTENCEUNLOCK;
-
-			if (loop_persistent == 0) {
+			if ( PersistenceExtend() == 0 ) {
 				break;			/* too many connections and we're slow */
 			}
 
@@ -133,20 +244,13 @@ void Handler(FILE_DESCRIPTOR_OR_ERROR file_descriptor)
 	}
 
 	LEVEL_DEBUG("OWSERVER handler done");
-	_MUTEX_DESTROY(hd.to_client);
-	// restore the persistent count
-	if (persistent) {
-
-		PERSISTENCELOCK;
-
-		--persistent_connections;
-
-		PERSISTENCEUNLOCK;
-
-	}
+	HandlerConnDestroy(&hc);
+	PersistenceRelease( &persistent ) ;
 }
 
-static void SingleHandler(struct handlerdata *hd)
+/* Process one message already read by FromClient
+ * Dispatch is PingLoop (threaded keep-alive) or DirectLoop (event mode) */
+void SingleHandler(struct handlerdata *hd, void (*Dispatch)(struct handlerdata *hd))
 {
 	timerclear(&hd->tv);
 
@@ -155,11 +259,13 @@ static void SingleHandler(struct handlerdata *hd)
 	gettimeofday(&(hd->tv), NULL);
 		
 	if (Globals.pingcrazy) {	// extra pings
+		TOCLIENTLOCK(hd);
 		PingClient(hd);	// send the ping
+		TOCLIENTUNLOCK(hd);
 		LEVEL_DEBUG("Extra ping (pingcrazy mode)");
 	}
 
-	PingLoop( hd ) ;
+	Dispatch( hd ) ;
 
 	if (hd->sp.path) {
 #if ( __GNUC__ > 4 ) || (__GNUC__ == 4 && __GNUC_MINOR__ > 4 )
@@ -156,3 +156,10 @@ void PingLoop(struct handlerdata *hd)
 		LoopCleanup(hd);
 	}
 }
+
+/* No ping thread -- event mode, keep-alive pulses are sent by the event loop timers */
+void DirectLoop(struct handlerdata *hd)
+{
+	Init_Pipe( hd->ping_pipe ) ;
+	DataHandler(hd);
+}
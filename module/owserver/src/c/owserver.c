@@ -98,7 +98,13 @@ int main(int argc, char **argv)
 	SetupAntiloop( argc, argv );
 	
 	/* Call up main processing routine -- waits for network queries */ 
-	ServerProcess( Handler );
+	if ( Globals.server_workers > 0 && GOOD( EventSetup() ) ) {
+		// event mode -- accepted sockets go to the epoll loop and worker pool
+		ServerProcessEvents( EventAccept );
+		EventCleanup() ;
+	} else {
+		ServerProcess( Handler );
+	}
 	LEVEL_DEBUG("ServerProcess done");
 
 	_MUTEX_DESTROY(persistence_mutex);
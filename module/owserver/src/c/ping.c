@@ -52,5 +52,80 @@ struct client_msg ping_cm = {
 
 void PingClient(struct handlerdata *hd)
 {
-		ToClient(hd->file_descriptor, &ping_cm, NULL);	// send the ping
+		ToClient(hd, &ping_cm, NULL);	// send the ping
+}
+
+/* The ping as ToClient would send it, kept in the connection */
+static void PingPrepare(struct handlerdata *hd)
+{
+	struct handlerconn *hc = hd->hc;
+	struct client_msg network_order_cm;
+	int32_t version = ping_cm.version;
+
+	if ( hd->pipelined ) {
+		version |= MakeServerprotocol( OWSERVER_PROTOCOL_PIPELINE ) ;
+	}
+	network_order_cm.version       = htonl( version                 );
+	network_order_cm.payload       = htonl( ping_cm.payload         );
+	network_order_cm.ret           = htonl( ping_cm.ret             );
+	network_order_cm.control_flags = htonl( ping_cm.control_flags   );
+	network_order_cm.size          = htonl( ping_cm.size            );
+	network_order_cm.offset        = htonl( ping_cm.offset          );
+
+	memcpy(hc->ping_rest, &network_order_cm, sizeof(struct client_msg));
+	hc->ping_rest_length = sizeof(struct client_msg);
+	if ( hd->pipelined ) {
+		uint32_t network_order_id = htonl( hd->request_id ) ;
+		memcpy(hc->ping_rest + hc->ping_rest_length, &network_order_id, sizeof(uint32_t));
+		hc->ping_rest_length += sizeof(uint32_t);
+	}
+}
+
+/* Event mode ping -- sends only what the socket takes without waiting
+ * The rest goes on the next try, or ahead of the next ToClient
+ * Called with TOCLIENTLOCK, returns non-zero while part of a ping is unsent
+ */
+int PingClientNonblocking(struct handlerdata *hd)
+{
+	struct handlerconn *hc = hd->hc;
+	ssize_t sent;
+
+	if ( hc->ping_rest_length == 0 ) {
+		PingPrepare(hd);
+	}
+
+	sent = send(hd->file_descriptor, hc->ping_rest, hc->ping_rest_length, MSG_DONTWAIT);
+	if ( sent < 0 ) {
+		if ( errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR ) {
+			return 1;
+		}
+		// broken connection -- the reply will find out
+		hc->ping_rest_length = 0;
+		return 0;
+	}
+
+	hc->ping_rest_length -= sent;
+	memmove(hc->ping_rest, hc->ping_rest + sent, hc->ping_rest_length);
+	return hc->ping_rest_length != 0;
+}
+
+/* Send the rest of a partly sent ping before anything else
+ * Called with TOCLIENTLOCK by the worker (blocking is fine there)
+ */
+void PingClientFinish(struct handlerdata *hd)
+{
+	struct handlerconn *hc = hd->hc;
+	size_t done = 0;
+
+	while ( done < hc->ping_rest_length ) {
+		ssize_t sent = write(hd->file_descriptor, hc->ping_rest + done, hc->ping_rest_length - done);
+		if ( sent < 0 ) {
+			if ( errno == EINTR ) {
+				continue;
+			}
+			break;
+		}
+		done += sent;
+	}
+	hc->ping_rest_length = 0;
 }
@@ -0,0 +1,164 @@
+/*
+    OW_HTML -- OWFS used for the web
+    OW -- One-Wire filesystem
+
+    Written 2004 Paul H Alfille
+
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License as published by
+ *   the Free Software Foundation; either version 2 of the License, or
+ *   (at your option) any later version.
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+/* owserver -- responds to requests over a network socket, and processes them on the 1-wire bus/
+         Basic idea: control the 1-wire bus and answer queries over a network socket
+         Clients can be owperl, owfs, owhttpd, etc...
+         Clients can be local or remote
+                 Eventually will also allow bounce servers.
+
+         syntax:
+                 owserver
+                 -u (usb)
+                 -d /dev/ttyS1 (serial)
+                 -p tcp port
+                 e.g. 3001 or 10.183.180.101:3001 or /tmp/1wire
+*/
+
+#include "owserver.h"
+
+/* Read many, called from Handler with the following caveates: */
+/* hd->sp.path holds hd->sm.payload bytes of null-terminated paths */
+/* sm has been read, cm has been zeroed */
+/* Read many, will return: */
+/* cm fully constructed, cm->ret is the number of items or an error <0 */
+/* a malloc'ed buffer, that must be free'd by Handler */
+/* holding a struct readmany_item and the data for each path, in request order */
+/* The length of buffer is cm.payload */
+void *ReadManyHandler(struct handlerdata *hd, struct client_msg *cm)
+{
+	const char * path_end = hd->sp.path + hd->sm.payload ;
+	const char * path ;
+	struct one_wire_query ** owq_array = NULL ;
+	SIZE_OR_ERROR * read_results = NULL ;
+	BYTE * retbuffer = NULL ;
+	size_t total_size = 0 ;
+	int count = 0 ;
+	int i ;
+
+	LEVEL_DEBUG("ReadManyHandler: From Client sm->payload=%d sm->size=%d sm->offset=%d", hd->sm.payload, hd->sm.size, hd->sm.offset);
+
+	if ((hd->sm.size <= 0) || (hd->sm.size > MAX_OWSERVER_PROTOCOL_PAYLOAD_SIZE)) {
+		LEVEL_DEBUG("ReadManyHandler: error hd->sm.size == %d", hd->sm.size);
+		cm->ret = -EMSGSIZE;
+		return NULL;
+	}
+
+	cm->control_flags &= ~VALUE_BINARY ;
+
+	/* count the paths */
+	for ( path = hd->sp.path ; path < path_end ; path += strlen(path) + 1 ) {
+		++count ;
+	}
+
+	owq_array = owcalloc( count, sizeof(struct one_wire_query *) ) ;
+	read_results = owcalloc( count, sizeof(SIZE_OR_ERROR) ) ;
+	if ( owq_array == NULL || read_results == NULL ) {
+		LEVEL_DEBUG("ReadManyHandler: can't allocate memory");
+		cm->ret = -ENOBUFS;
+		goto ReadManyCleanup ;
+	}
+
+	/* parse each path and set up its query like a single read */
+	for ( i = 0, path = hd->sp.path ; i < count ; ++i, path += strlen(path) + 1 ) {
+		struct one_wire_query * owq = OWQ_create_from_path(path) ;
+		struct parsedname * pn ;
+
+		if ( owq == NO_ONE_WIRE_QUERY ) {
+			LEVEL_DEBUG("ReadManyHandler: cannot parse %s", path);
+			continue ;
+		}
+		pn = PN(owq) ;
+		// one reply flag for all the values, so always text
+		pn->control_flags = hd->sm.control_flags & ~VALUE_BINARY;
+		if ( (pn->control_flags & UNCACHED) != 0 ) {
+			pn->state |= ePS_uncached;
+		}
+		if ( (pn->control_flags & ALIAS_REQUEST) == 0 ) {
+			pn->state |= ePS_unaliased;
+		}
+		pn->tokens = hd->sp.tokens;
+		pn->tokenstring = hd->sp.tokenstring;
+
+		if ( BAD( OWQ_allocate_read_buffer(owq)) ) {
+			OWQ_destroy(owq) ;
+			continue ;
+		}
+		if ( OWQ_size(owq) > (size_t) hd->sm.size ) {
+			OWQ_size(owq) = hd->sm.size ;
+		}
+		OWQ_offset(owq) = hd->sm.offset ;
+		owq_array[i] = owq ;
+	}
+
+	FS_read_many( owq_array, read_results, count ) ;
+
+	/* assemble the response */
+	for ( i = 0 ; i < count ; ++i ) {
+		total_size += sizeof(struct readmany_item) ;
+		if ( read_results[i] > 0 ) {
+			total_size += read_results[i] ;
+		}
+	}
+	if ( total_size > MAX_OWSERVER_PROTOCOL_PAYLOAD_SIZE ) {
+		LEVEL_DEBUG("ReadManyHandler: response too large (%d bytes)", (int) total_size);
+		cm->ret = -EMSGSIZE;
+		goto ReadManyCleanup ;
+	}
+	retbuffer = owmalloc( total_size ) ;
+	if ( retbuffer == NULL ) {
+		LEVEL_DEBUG("ReadManyHandler: can't allocate memory");
+		cm->ret = -ENOBUFS;
+		goto ReadManyCleanup ;
+	} else {
+		BYTE * position = retbuffer ;
+		for ( i = 0 ; i < count ; ++i ) {
+			struct readmany_item item ;
+			int length = ( read_results[i] > 0 ) ? read_results[i] : 0 ;
+			item.ret = htonl( read_results[i] ) ;
+			item.length = htonl( length ) ;
+			memcpy( position, &item, sizeof(struct readmany_item) ) ;
+			position += sizeof(struct readmany_item) ;
+			if ( length > 0 ) {
+				memcpy( position, OWQ_buffer(owq_array[i]), length ) ;
+				position += length ;
+			}
+		}
+	}
+	cm->payload = total_size ;
+	cm->size = total_size ;
+	cm->offset = 0 ;
+	cm->ret = count ;
+
+ReadManyCleanup:
+	if ( owq_array != NULL ) {
+		for ( i = 0 ; i < count ; ++i ) {
+			OWQ_destroy( owq_array[i] ) ;
+		}
+		owfree( owq_array ) ;
+	}
+	if ( read_results != NULL ) {
+		owfree( read_results ) ;
+	}
+	LEVEL_DEBUG("ReadManyHandler: To Client cm->payload=%d items=%d", cm->payload, count);
+	return retbuffer;
+}
@@ -40,12 +40,16 @@ $Id$
 /* Send fully configured message back to client.
    data is optional and length depends on "payload"
  */
-int ToClient(int file_descriptor, struct client_msg *machine_order_cm, const char *data)
+int ToClient(struct handlerdata *hd, struct client_msg *machine_order_cm, const char *data)
 {
 	struct client_msg s_cm;
 	struct client_msg *network_order_cm = &s_cm;
+	uint32_t network_order_id = htonl( hd->request_id ) ;
+	int file_descriptor = hd->file_descriptor ;
+	int32_t version = machine_order_cm->version ;
 	
 	int nio = 1; // at least header
+	int nid = 0; // request id (pipelined only)
 
 #if ( __GNUC__ > 4 ) || (__GNUC__ == 4 && __GNUC_MINOR__ > 4 )
 #pragma GCC diagnostic push
@@ -53,6 +57,7 @@ int ToClient(int file_descriptor, struct client_msg *machine_order_cm, const cha
 	// note data should be (const char *) but iovec complains about const arguments
 	struct iovec io[] = {
 		{network_order_cm, sizeof(struct client_msg),},
+		{&network_order_id, sizeof(uint32_t),},
 		{ (char *) data, machine_order_cm->payload,},
 	};
 #pragma GCC diagnostic pop
@@ -60,12 +65,24 @@ int ToClient(int file_descriptor, struct client_msg *machine_order_cm, const cha
 	// note data should be (const char *) but iovec complains about const arguments
 	struct iovec io[] = {
 		{network_order_cm, sizeof(struct client_msg),},
+		{&network_order_id, sizeof(uint32_t),},
 		{ (char *) data, machine_order_cm->payload,},
 	};
 #endif
 
+	// Event mode: the rest of a ping goes first
+	if ( hd->hc->ping_rest_length > 0 ) {
+		PingClientFinish(hd) ;
+	}
+
+	// Pipelined request: echo the request id right after the header
+	if ( hd->pipelined ) {
+		version |= MakeServerprotocol( OWSERVER_PROTOCOL_PIPELINE ) ;
+		nid = 1 ;
+	}
+
 	// Prep header
-	network_order_cm->version       = htonl( machine_order_cm->version       );
+	network_order_cm->version       = htonl( version                         );
 	network_order_cm->payload       = htonl( machine_order_cm->payload       );
 	network_order_cm->ret           = htonl( machine_order_cm->ret           );
 	network_order_cm->control_flags = htonl( machine_order_cm->control_flags );
@@ -87,8 +104,15 @@ int ToClient(int file_descriptor, struct client_msg *machine_order_cm, const cha
 		LEVEL_DEBUG("Bad data pointer -- NULL") ;
 	} else {
 		nio = 2; // add data segment
-		TrafficOutFD("to server data",io[1].iov_base,io[1].iov_len,file_descriptor);
+		TrafficOutFD("to server data",io[2].iov_base,io[2].iov_len,file_descriptor);
+	}
+
+	if ( nid ) {
+		// header, id, then (optional) data
+		return writev(file_descriptor, io, nio+1) != (ssize_t) (io[0].iov_len + io[1].iov_len + (nio>1 ? io[2].iov_len : 0));
 	}
 
-	return writev(file_descriptor, io, nio) != (ssize_t) (io[0].iov_len + io[1].iov_len);
+	// no id segment
+	io[1] = io[2] ;
+	return writev(file_descriptor, io, nio) != (ssize_t) (io[0].iov_len + (nio>1 ? io[1].iov_len : 0));
 }
@@ -23,8 +23,8 @@ pthread_mutex_t persistence_mutex ;
 #define PERSISTENCELOCK    _MUTEX_LOCK(   persistence_mutex ) ;
 #define PERSISTENCEUNLOCK  _MUTEX_UNLOCK( persistence_mutex ) ;
 
-#define TOCLIENTLOCK(hd) _MUTEX_LOCK( (hd)->to_client )
-#define TOCLIENTUNLOCK(hd) _MUTEX_UNLOCK( (hd)->to_client )
+#define TOCLIENTLOCK(hd) _MUTEX_LOCK( (hd)->hc->to_client )
+#define TOCLIENTUNLOCK(hd) _MUTEX_UNLOCK( (hd)->hc->to_client )
 
 enum toclient_state {
 	toclient_postping , // also initial state
@@ -32,11 +32,23 @@ enum toclient_state {
 	toclient_complete, // final payload has been sent
 } ;
 
+// shared by all the requests on one client connection
+struct handlerconn {
+	pthread_mutex_t to_client; // socket writes and toclient state
+	pthread_mutex_t pipeline_mutex;
+	pthread_cond_t pipeline_cond; // signalled as pipelined requests finish
+	int outstanding; // pipelined requests still being processed
+	char ping_rest[sizeof(struct client_msg) + sizeof(uint32_t)]; // event mode ping the socket didn't take yet
+	size_t ping_rest_length;
+};
+
 // this structure holds the data needed for the handler function called in a separate thread by the ping wrapper
 struct handlerdata {
 	int file_descriptor;
 	int persistent;
-	pthread_mutex_t to_client;
+	struct handlerconn * hc;
+	int pipelined; // request carried a request_id (answer may be out of order)
+	uint32_t request_id;
 	int ping_pipe[2] ;
 	enum toclient_state toclient ;
 	struct timeval tv;
@@ -44,14 +56,19 @@ struct handlerdata {
 	struct serverpackage sp;
 };
 
+/* keep-alive ping intervals (loop.c) */
+extern struct timeval tv_long ;
+extern struct timeval tv_short ;
+
 /* read from client, free return pointer if not Null */
 int FromClient(struct handlerdata *hd);
 
 /* Send fully configured message back to client */
-int ToClient(int file_descriptor, struct client_msg *cm, const char *data);
+int ToClient(struct handlerdata *hd, struct client_msg *cm, const char *data);
 
 /* Read from 1-wire bus and return file contents */
 void *ReadHandler(struct handlerdata *hd, struct client_msg *cm, struct one_wire_query *owq);
+void *ReadManyHandler(struct handlerdata *hd, struct client_msg *cm);
 
 /* write a new value ot a 1-wire device */
 void WriteHandler(struct handlerdata *hd, struct client_msg *cm, struct one_wire_query *owq);
@@ -71,15 +88,37 @@ void *DataHandler(void *v);
 /* Handle a client request, including timeout pings */
 void Handler(FILE_DESCRIPTOR_OR_ERROR file_descriptor);
 
+/* Connection state shared by pipelined requests */
+void HandlerConnInit(struct handlerconn *hc);
+void HandlerConnDestroy(struct handlerconn *hc);
+
+/* Process a single message already read from the client */
+void SingleHandler(struct handlerdata *hd, void (*Dispatch)(struct handlerdata *hd));
+
+/* Persistent connection bookkeeping shared by threaded and event modes */
+int PersistenceRequest(struct handlerdata *hd, int *persistent);
+int PersistenceExtend(void);
+void PersistenceRelease(int *persistent);
+
 /* Send a response to client of an error */
 void ErrorToClient(struct handlerdata *hd, struct client_msg * cm ) ;
 
 /* Send a timeout ping */
 void PingClient(struct handlerdata *hd);
+int PingClientNonblocking(struct handlerdata *hd);
+void PingClientFinish(struct handlerdata *hd);
 
 /* Loop waiting for finish sending pings */
 void PingLoop(struct handlerdata *hd) ;
 
+/* Handle the request in this thread, pings come from the event loop */
+void DirectLoop(struct handlerdata *hd) ;
+
+/* Event driven server (epoll) with a fixed worker pool */
+GOOD_OR_BAD EventSetup(void) ;
+void EventAccept(FILE_DESCRIPTOR_OR_ERROR file_descriptor) ;
+void EventCleanup(void) ;
+
 /* Create a md5 hash (for the token) */
 void md5(const uint8_t *initial_msg, size_t initial_len, uint8_t *digest) ;
 
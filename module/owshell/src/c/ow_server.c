@@ -76,6 +76,101 @@ int ServerRead(ASCII * path)
 	return ret;
 }
 
+/* Read several paths with one READMANY message */
+/* returns the last path's result (like ServerRead on each) */
+/* or -ENOMSG if the owserver doesn't know READMANY */
+int ServerReadMany(int count, ASCII ** paths)
+{
+	struct server_msg sm;
+	struct client_msg cm;
+	struct serverpackage sp = { NULL, NULL, 0, NULL, 0, };
+	int connectfd ;
+	char *path_list ;
+	char *response = NULL ;
+	size_t list_length = 0 ;
+	int ret = 0;
+	int i ;
+
+	for ( i = 0 ; i < count ; ++i ) {
+		list_length += strlen(paths[i]) + 1 ;
+	}
+	if ( list_length > MAX_OWSERVER_PROTOCOL_PAYLOAD_SIZE ) {
+		return -ENOMSG ; // too long, read one at a time
+	}
+	path_list = malloc(list_length) ;
+	if ( path_list == NULL ) {
+		return -ENOMEM ;
+	}
+	list_length = 0 ;
+	for ( i = 0 ; i < count ; ++i ) {
+		size_t path_length = strlen(paths[i]) + 1 ;
+		memcpy( &path_list[list_length], paths[i], path_length ) ;
+		list_length += path_length ;
+	}
+	sp.data = (BYTE *) path_list ;
+	sp.datasize = list_length ;
+
+	connectfd = ClientConnect();
+	if (connectfd < 0) {
+		free(path_list) ;
+		return -EIO;
+	}
+	memset(&sm, 0, sizeof(struct server_msg));
+	memset(&cm, 0, sizeof(struct client_msg));
+	sm.type = msg_readmany;
+	sm.size = 65536;
+	sm.offset = offset_into_data;
+
+	if ( size_of_data >=0 && size_of_data <= 65536 ) {
+		sm.size = size_of_data ;
+	}
+
+	if (ToServer(connectfd, &sm, &sp)) {
+		PRINT_ERROR("ServerReadMany: Error sending request\n");
+		ret = -EIO;
+	} else if ((response = FromServerAlloc(connectfd, &cm)) == NULL) {
+		ret = (cm.ret < 0) ? cm.ret : -EIO ;
+		if ( ret != -ENOMSG ) {
+			PRINT_ERROR("ServerReadMany: Error receiving data\n");
+		}
+	} else if ( cm.ret != count ) {
+		PRINT_ERROR("ServerReadMany: Data error\n");
+		ret = -EIO;
+	} else {
+		int position = 0 ;
+		for ( i = 0 ; i < count ; ++i ) {
+			struct readmany_item item ;
+			if ( position + (int) sizeof(struct readmany_item) > cm.payload ) {
+				PRINT_ERROR("ServerReadMany: Data error\n");
+				ret = -EIO ;
+				break ;
+			}
+			memcpy( &item, &response[position], sizeof(struct readmany_item) ) ;
+			position += sizeof(struct readmany_item) ;
+			item.ret = ntohl(item.ret) ;
+			item.length = ntohl(item.length) ;
+			if ( item.length < 0 || position + item.length > cm.payload ) {
+				PRINT_ERROR("ServerReadMany: Data error\n");
+				ret = -EIO ;
+				break ;
+			}
+			ret = item.ret ;
+			if ( ret < 0 ) {
+				PRINT_ERROR("ServerRead: Data error on %s\n", paths[i]);
+			} else {
+				Write( &response[position], item.length ) ;
+			}
+			position += item.length ;
+		}
+	}
+	if ( response != NULL ) {
+		free(response) ;
+	}
+	free(path_list) ;
+	close(connectfd);
+	return ret;
+}
+
 int ServerWrite(ASCII * path, ASCII * data, int size)
 {
 	struct server_msg sm;
@@ -39,6 +39,13 @@ int main(int argc, char *argv[])
 	Server_detect();
 
 	/* non-option arguments */
+	/* several paths -- ask for them all in one message */
+	if ( argc - optind > 1 ) {
+		rc = ServerReadMany( argc - optind, &argv[optind] ) ;
+		if ( rc != -ENOMSG ) {
+			optind = argc ;
+		}
+	}
 	while (optind < argc) {
 		rc = ServerRead(argv[optind]);
 		++optind;
@@ -211,6 +211,7 @@ enum msg_classification {
 	msg_get,
 	msg_dirallslash,
 	msg_getslash,
+	msg_readmany,
 };
 /* message to owserver */
 struct server_msg {
@@ -222,6 +223,12 @@ struct server_msg {
 	int32_t offset;
 };
 
+/* msg_readmany response item header, followed by length bytes of data */
+struct readmany_item {
+	int32_t ret;
+	int32_t length;
+};
+
 /* message to client */
 struct client_msg {
 	int32_t version;
@@ -272,6 +279,7 @@ void OW_Browse(void);
 
 void Server_detect(void);
 int ServerRead(ASCII * path);
+int ServerReadMany(int count, ASCII ** paths);
 int ServerWrite(ASCII * path, ASCII * data, int size);
 int ServerDir(ASCII * path);
 int ServerDirall(ASCII * path);